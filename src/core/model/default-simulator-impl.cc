@@ -22,13 +22,19 @@
 #include "default-simulator-impl.h"
 #include "scheduler.h"
 #include "event-impl.h"
+#include "event-profiler.h"
 
 #include "ptr.h"
 #include "pointer.h"
+#include "boolean.h"
+#include "string.h"
 #include "assert.h"
+#include "abort.h"
 #include "log.h"
 
 #include <cmath>
+#include <fstream>
+#include <iostream>
 
 
 /**
@@ -53,6 +59,28 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("EnableEventProfiler",
+                   "Attribute the wall clock time of the events to their "
+                   "targets and contexts, and report it at Simulator::Destroy.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DefaultSimulatorImpl::m_profilerEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("EventProfilerReport",
+                   "The file of the event profile report, the standard output if empty.",
+                   StringValue (""),
+                   MakeStringAccessor (&DefaultSimulatorImpl::m_profilerReport),
+                   MakeStringChecker ())
+    .AddAttribute ("EventProfilerCsv",
+                   "The CSV file where the cumulative event profile is written "
+                   "periodically, none if empty.",
+                   StringValue (""),
+                   MakeStringAccessor (&DefaultSimulatorImpl::m_profilerCsv),
+                   MakeStringChecker ())
+    .AddAttribute ("EventProfilerCsvInterval",
+                   "The simulation time between the rows of the CSV file.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&DefaultSimulatorImpl::m_profilerCsvInterval),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -73,11 +101,14 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_unscheduledEvents = 0;
   m_eventsWithContextEmpty = true;
   m_main = SystemThread::Self();
+  m_profilerEnabled = false;
+  m_profiler = 0;
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
 {
   NS_LOG_FUNCTION (this);
+  delete m_profiler;
 }
 
 void
@@ -108,6 +139,19 @@ DefaultSimulatorImpl::Destroy ()
           ev->Invoke ();
         }
     }
+  if (m_profiler != 0)
+    {
+      if (m_profilerReport.empty ())
+        {
+          m_profiler->Report (std::cout);
+        }
+      else
+        {
+          std::ofstream report (m_profilerReport.c_str ());
+          NS_ABORT_MSG_IF (!report.is_open (), "Could not open the event profile report " << m_profilerReport);
+          m_profiler->Report (report);
+        }
+    }
 }
 
 void
@@ -146,7 +190,14 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
-  next.impl->Invoke ();
+  if (m_profiler == 0)
+    {
+      next.impl->Invoke ();
+    }
+  else
+    {
+      m_profiler->Invoke (next.impl, m_currentContext, TimeStep (m_currentTs));
+    }
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
@@ -197,6 +248,19 @@ DefaultSimulatorImpl::Run (void)
   ProcessEventsWithContext ();
   m_stop = false;
 
+  if (m_profilerEnabled && m_profiler == 0)
+    {
+      m_profiler = new EventProfiler ();
+      if (!m_profilerCsv.empty ())
+        {
+          m_profiler->SetCsv (m_profilerCsv, m_profilerCsvInterval);
+        }
+    }
+  if (m_profiler != 0)
+    {
+      m_profiler->Start ();
+    }
+
   while (!m_events->IsEmpty () && !m_stop) 
     {
       ProcessOneEvent ();
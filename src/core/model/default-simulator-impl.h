@@ -30,6 +30,7 @@
 #include "ptr.h"
 
 #include <list>
+#include <string>
 
 /**
  * \file
@@ -39,10 +40,16 @@
 
 namespace ns3 {
 
+class EventProfiler;
+
 /**
  * \ingroup simulator
  *
  * The default single process simulator implementation.
+ *
+ * When the EnableEventProfiler attribute is set, the events are
+ * invoked through an EventProfiler, which reports the wall clock time
+ * of the events by target and by context at Destroy().
  */
 class DefaultSimulatorImpl : public SimulatorImpl
 {
@@ -132,6 +139,17 @@ private:
 
   /** Main execution thread. */
   SystemThread::ThreadId m_main;
+
+  /** Profile the events. */
+  bool m_profilerEnabled;
+  /** File of the profile report, the standard output if empty. */
+  std::string m_profilerReport;
+  /** Periodic CSV file of the profile, none if empty. */
+  std::string m_profilerCsv;
+  /** Simulation time between the rows of the CSV file. */
+  Time m_profilerCsvInterval;
+  /** The profiler of the events, 0 if the events are not profiled. */
+  EventProfiler *m_profiler;
 };
 
 } // namespace ns3
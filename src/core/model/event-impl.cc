@@ -20,6 +20,9 @@
 
 #include "event-impl.h"
 #include "log.h"
+#include "global-value.h"
+#include "boolean.h"
+#include <new>
 
 /**
  * \file
@@ -31,6 +34,150 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+/**
+ * \ingroup events
+ * Recycle the memory of the events through free lists.
+ */
+static GlobalValue g_eventImplPoolEnabled = GlobalValue
+  ("EventImplPoolEnabled",
+   "Keep the memory of the deleted events in per-thread free lists of size classes and reuse it",
+   BooleanValue (true),
+   MakeBooleanChecker ());
+
+/** Size classes of the event free lists, in bytes. */
+static const std::size_t EVENT_POOL_GRANULARITY = 16;
+/** Number of size classes, the largest one holds events of up to 256 bytes. */
+static const std::size_t EVENT_POOL_CLASSES = 16;
+/** Maximum number of blocks kept in the free list of a size class. */
+static const uint32_t EVENT_POOL_MAX_CACHED = 4096;
+
+/** A block in the free list of a size class. */
+struct EventPoolBlock
+{
+  EventPoolBlock *m_next;   //!< The next free block of the same class.
+};
+
+/**
+ * The event free lists of a thread.
+ *
+ * It is trivially destructible, so it can be used by the events deleted
+ * while the thread or the program exits, after EventPoolDestructor ran.
+ */
+struct EventPool
+{
+  bool m_initialized;       //!< The global value has been read.
+  bool m_enabled;           //!< The free lists are in use.
+  bool m_destroyed;         //!< The thread is exiting.
+  EventPoolBlock *m_free[EVENT_POOL_CLASSES];   //!< Free list of each size class.
+  uint32_t m_count[EVENT_POOL_CLASSES];         //!< Blocks in each free list.
+  EventImpl::PoolStats m_stats;                 //!< Statistics of the thread.
+};
+
+/** The event free lists of the thread, zero-initialized. */
+static thread_local EventPool g_eventPool;
+
+/**
+ * Release the memory of the free lists when the thread exits, and
+ * stop using them.
+ */
+struct EventPoolDestructor
+{
+  ~EventPoolDestructor ();
+};
+
+/** The destructor of the free lists of the thread. */
+static thread_local EventPoolDestructor g_eventPoolDestructor;
+
+EventPoolDestructor::~EventPoolDestructor ()
+{
+  EventImpl::ReleasePool ();
+  g_eventPool.m_destroyed = true;
+}
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  // no logging in the allocator, which is called for every event
+  EventPool &pool = g_eventPool;
+  if (!pool.m_initialized)
+    {
+      BooleanValue enabled;
+      g_eventImplPoolEnabled.GetValue (enabled);
+      pool.m_enabled = enabled.Get () && !pool.m_destroyed;
+      pool.m_initialized = true;
+      // register the destructor of the free lists of the thread
+      (void)&g_eventPoolDestructor;
+    }
+  pool.m_stats.m_allocations++;
+  std::size_t sizeClass = (size - 1) / EVENT_POOL_GRANULARITY;
+  if (sizeClass >= EVENT_POOL_CLASSES)
+    {
+      pool.m_stats.m_oversized++;
+      return ::operator new (size);
+    }
+  EventPoolBlock *block = pool.m_free[sizeClass];
+  if (pool.m_enabled && block != 0)
+    {
+      pool.m_free[sizeClass] = block->m_next;
+      pool.m_count[sizeClass]--;
+      pool.m_stats.m_cached--;
+      pool.m_stats.m_hits++;
+      return block;
+    }
+  // the block can hold any event of its class, even if the pool is
+  // enabled only when it is deleted
+  return ::operator new ((sizeClass + 1) * EVENT_POOL_GRANULARITY);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  EventPool &pool = g_eventPool;
+  std::size_t sizeClass = (size - 1) / EVENT_POOL_GRANULARITY;
+  if (sizeClass < EVENT_POOL_CLASSES && pool.m_enabled && !pool.m_destroyed
+      && pool.m_count[sizeClass] < EVENT_POOL_MAX_CACHED)
+    {
+      EventPoolBlock *block = static_cast<EventPoolBlock *> (p);
+      block->m_next = pool.m_free[sizeClass];
+      pool.m_free[sizeClass] = block;
+      pool.m_count[sizeClass]++;
+      pool.m_stats.m_cached++;
+      return;
+    }
+  ::operator delete (p);
+}
+
+struct EventImpl::PoolStats
+EventImpl::GetPoolStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_eventPool.m_stats;
+}
+
+void
+EventImpl::ReleasePool (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  EventPool &pool = g_eventPool;
+  NS_LOG_INFO ("events allocated " << pool.m_stats.m_allocations <<
+               " from the free lists " << pool.m_stats.m_hits <<
+               " oversized " << pool.m_stats.m_oversized <<
+               " released " << pool.m_stats.m_cached);
+  for (std::size_t sizeClass = 0; sizeClass < EVENT_POOL_CLASSES; sizeClass++)
+    {
+      while (pool.m_free[sizeClass] != 0)
+        {
+          EventPoolBlock *block = pool.m_free[sizeClass];
+          pool.m_free[sizeClass] = block->m_next;
+          ::operator delete (block);
+        }
+      pool.m_count[sizeClass] = 0;
+    }
+  pool.m_stats.m_cached = 0;
+  pool.m_enabled = false;
+  pool.m_initialized = false;
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
@@ -66,4 +213,10 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+const void *
+EventImpl::GetFunction (void) const
+{
+  return 0;
+}
+
 } // namespace ns3
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -65,6 +66,54 @@ public:
    * Checked by the simulation engine before calling Invoke().
    */
   bool IsCancelled (void);
+  /**
+   * Get the code run by this event, to attribute the time spent in the
+   * events to their targets (see the EventProfiler).
+   *
+   * \returns The address of the function or class method bound by
+   * MakeEvent(), or 0 if it is not known.
+   */
+  virtual const void * GetFunction (void) const;
+
+  /**
+   * Allocate the memory of an event.
+   *
+   * Events are allocated and deleted for every Simulator::Schedule call,
+   * so the memory of the deleted events is kept in per-thread free lists,
+   * one per size class, and reused by the next events of the same class
+   * (see the EventImplPoolEnabled global value).
+   *
+   * \param [in] size The size of the event object.
+   * \returns The memory of the event.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release the memory of an event to the free list of its size class.
+   *
+   * \param [in] p The memory of the event.
+   * \param [in] size The size of the event object.
+   */
+  static void operator delete (void *p, std::size_t size);
+
+  /** Statistics of the event free lists of a thread. */
+  struct PoolStats
+  {
+    uint64_t m_allocations;   //!< Events allocated.
+    uint64_t m_hits;          //!< Allocations served from a free list.
+    uint64_t m_oversized;     //!< Allocations larger than the largest size class.
+    uint64_t m_cached;        //!< Blocks currently held in the free lists.
+  };
+  /**
+   * \returns The statistics of the event free lists of the calling thread.
+   */
+  static struct PoolStats GetPoolStats (void);
+  /**
+   * Release the memory held in the event free lists of the calling thread.
+   *
+   * Called by Simulator::Destroy. The EventImplPoolEnabled global value
+   * is read again by the next allocation.
+   */
+  static void ReleasePool (void);
 
 protected:
   /**
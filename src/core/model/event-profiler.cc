@@ -0,0 +1,299 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-profiler.h"
+#include "event-impl.h"
+#include "simulator.h"
+#include "abort.h"
+#include "log.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#ifdef HAVE_CXXABI_H
+#include <cxxabi.h>
+#endif
+#ifdef HAVE_DLADDR
+#include <dlfcn.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::EventProfiler implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EventProfiler");
+
+/**
+ * \ingroup simulator
+ * Demangle a C++ symbol or type name.
+ *
+ * \param [in] mangled The mangled name.
+ * \returns The demangled name, or \p mangled if it cannot be demangled.
+ */
+static std::string
+Demangle (const char *mangled)
+{
+#ifdef HAVE_CXXABI_H
+  int status;
+  char *demangled = abi::__cxa_demangle (mangled, NULL, NULL, &status);
+  std::string name = (status == 0) ? demangled : mangled;
+  std::free (demangled);
+  return name;
+#else
+  return mangled;
+#endif
+}
+
+/**
+ * \ingroup simulator
+ * A row of the report: the name of a target or context, its number of
+ * events and its wall clock time.
+ */
+typedef std::pair<std::string, std::pair<uint64_t, std::chrono::steady_clock::duration> > ProfileRow;
+
+/**
+ * \ingroup simulator
+ * Order of the report, from the longest to the shortest time.
+ *
+ * \param [in] a The first row.
+ * \param [in] b The second row.
+ * \returns \c true if \p a took longer than \p b.
+ */
+static bool
+IsLonger (const ProfileRow &a, const ProfileRow &b)
+{
+  return a.second.second > b.second.second;
+}
+
+/**
+ * \ingroup simulator
+ * Write the rows of a report.
+ *
+ * \param [in,out] os The output stream.
+ * \param [in] rows The rows, sorted.
+ * \param [in] total The total wall clock time.
+ */
+static void
+WriteRows (std::ostream &os, const std::vector<ProfileRow> &rows,
+           std::chrono::steady_clock::duration total)
+{
+  os << std::setw (12) << "time (s)" << std::setw (8) << "%"
+     << std::setw (12) << "events" << std::setw (12) << "mean (us)" << std::endl;
+  for (uint32_t i = 0; i < rows.size (); i++)
+    {
+      double seconds = std::chrono::duration<double> (rows[i].second.second).count ();
+      os << std::fixed << std::setprecision (3) << std::setw (12) << seconds
+         << std::setprecision (2) << std::setw (8)
+         << (total.count () > 0 ? 100.0 * rows[i].second.second.count () / total.count () : 0.0)
+         << std::setw (12) << rows[i].second.first
+         << std::setprecision (3) << std::setw (12)
+         << (rows[i].second.first > 0 ? 1e6 * seconds / rows[i].second.first : 0.0)
+         << "  " << rows[i].first << std::endl;
+    }
+}
+
+EventProfiler::Entry::Entry ()
+  : m_events (0),
+    m_time (Clock::duration::zero ()),
+    m_function (0),
+    m_type (0)
+{
+}
+
+EventProfiler::EventProfiler ()
+  : m_last (Clock::now ()),
+    m_start (m_last)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+EventProfiler::~EventProfiler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+EventProfiler::SetCsv (std::string fileName, Time interval)
+{
+  NS_LOG_FUNCTION (this << fileName << interval);
+  NS_ABORT_MSG_IF (interval <= Time (0), "The interval of the CSV file must be positive");
+  m_csv.open (fileName.c_str ());
+  NS_ABORT_MSG_IF (!m_csv.is_open (), "Could not open the CSV file " << fileName);
+  m_csv << "simulationTime,wallTime,target,events,seconds" << std::endl;
+  m_csvInterval = interval;
+  m_nextCsv = interval;
+}
+
+void
+EventProfiler::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_last = Clock::now ();
+}
+
+void
+EventProfiler::Invoke (EventImpl *event, uint32_t context, Time now)
+{
+  if (m_csv.is_open () && now >= m_nextCsv)
+    {
+      WriteCsv (now);
+    }
+  Clock::time_point start = Clock::now ();
+  m_queue.m_events++;
+  m_queue.m_time += start - m_last;
+  if (event->IsCancelled ())
+    {
+      // cancelled events take no time but the time of the queue
+      event->Invoke ();
+      m_last = start;
+      return;
+    }
+
+  // resolve the target first: the event is not touched once its code, which may release it, has run
+  const void *function = event->GetFunction ();
+  const std::type_info &type = typeid (*event);
+  event->Invoke ();
+  m_last = Clock::now ();
+  Clock::duration time = m_last - start;
+
+  Entry &target = m_targets[function != 0 ? function : &type];
+  if (target.m_events == 0)
+    {
+      target.m_function = function;
+      target.m_type = &type;
+    }
+  target.m_events++;
+  target.m_time += time;
+  Entry &ctx = m_contexts[context];
+  ctx.m_events++;
+  ctx.m_time += time;
+}
+
+std::string
+EventProfiler::GetName (const Entry &entry)
+{
+#ifdef HAVE_DLADDR
+  Dl_info info;
+  if (entry.m_function != 0 && dladdr (entry.m_function, &info) != 0
+      && info.dli_sname != 0 && info.dli_saddr == entry.m_function)
+    {
+      return Demangle (info.dli_sname);
+    }
+#endif
+  // unknown or local code, or no dladdr: the type of the event holds
+  // the signature, and the raw address tells the targets apart
+  std::ostringstream oss;
+  oss << Demangle (entry.m_type->name ());
+  if (entry.m_function != 0)
+    {
+      oss << " [" << entry.m_function << "]";
+    }
+  return oss.str ();
+}
+
+void
+EventProfiler::GetTotals (Totals &totals)
+{
+  for (std::map<const void *, Entry>::const_iterator it = m_targets.begin (); it != m_targets.end (); it++)
+    {
+      std::map<const void *, std::string>::iterator name = m_names.find (it->first);
+      if (name == m_names.end ())
+        {
+          name = m_names.insert (std::make_pair (it->first, GetName (it->second))).first;
+        }
+      std::pair<uint64_t, Clock::duration> &total = totals[name->second];
+      total.first += it->second.m_events;
+      total.second += it->second.m_time;
+    }
+  totals["[event queue]"] = std::make_pair (m_queue.m_events, m_queue.m_time);
+}
+
+void
+EventProfiler::WriteCsv (Time now)
+{
+  NS_LOG_FUNCTION (this << now);
+  double wall = std::chrono::duration<double> (Clock::now () - m_start).count ();
+  Totals totals;
+  GetTotals (totals);
+  for (Totals::const_iterator it = totals.begin (); it != totals.end (); it++)
+    {
+      std::string target = it->first;
+      std::string::size_type quote = 0;
+      while ((quote = target.find ('"', quote)) != std::string::npos)
+        {
+          target.insert (quote, 1, '"');
+          quote += 2;
+        }
+      m_csv << now.GetSeconds () << "," << wall << ",\"" << target << "\","
+            << it->second.first << "," << std::chrono::duration<double> (it->second.second).count ()
+            << std::endl;
+    }
+  while (m_nextCsv <= now)
+    {
+      m_nextCsv += m_csvInterval;
+    }
+}
+
+void
+EventProfiler::Report (std::ostream &os)
+{
+  NS_LOG_FUNCTION (this);
+  Totals totals;
+  GetTotals (totals);
+  std::vector<ProfileRow> targets (totals.begin (), totals.end ());
+  std::sort (targets.begin (), targets.end (), IsLonger);
+  Clock::duration total = Clock::duration::zero ();
+  for (std::vector<ProfileRow>::const_iterator it = targets.begin (); it != targets.end (); it++)
+    {
+      total += it->second.second;
+    }
+
+  std::vector<ProfileRow> contexts;
+  for (std::map<uint32_t, Entry>::const_iterator it = m_contexts.begin (); it != m_contexts.end (); it++)
+    {
+      std::ostringstream name;
+      if (it->first == Simulator::NO_CONTEXT)
+        {
+          name << "no context";
+        }
+      else
+        {
+          name << "context " << it->first;
+        }
+      contexts.push_back (std::make_pair (name.str (), std::make_pair (it->second.m_events, it->second.m_time)));
+    }
+  std::sort (contexts.begin (), contexts.end (), IsLonger);
+
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << "Event profile: " << m_queue.m_events << " events, "
+     << std::chrono::duration<double> (total).count () << " s of wall clock time" << std::endl
+     << std::endl << "By target:" << std::endl;
+  WriteRows (os, targets, total);
+  os << std::endl << "By context:" << std::endl;
+  WriteRows (os, contexts, total);
+  os.flags (flags);
+  os.precision (precision);
+}
+
+} // namespace ns3
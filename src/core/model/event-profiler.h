@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include "nstime.h"
+
+#include <stdint.h>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::EventProfiler declaration.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup simulator
+ *
+ * \brief Wall clock profiler of the simulation events.
+ *
+ * The profiler invokes the events on behalf of the simulator and
+ * attributes the wall clock time they take, and their number, to:
+ *
+ *  - their target: the function or class method bound by MakeEvent(),
+ *    such as \c ns3::MmWaveUePhy::StartSlot(), named from the symbols of
+ *    the libraries. The events whose code cannot be resolved, or all of
+ *    them if the platform lacks dladdr(), are named after the type of the
+ *    event, which holds the signature of the method, and the raw address
+ *    of their code. The names are demangled if <cxxabi.h> is available.
+ *  - their context, which is the id of the node for the events of the
+ *    nodes.
+ *
+ * The time between the events, spent to dequeue them from the scheduler,
+ * to delete them and to move the events of other threads, is attributed
+ * to the "[event queue]" target.
+ *
+ * The profiler is enabled with the EnableEventProfiler attribute of
+ * ns3::DefaultSimulatorImpl, e.g.
+ * \verbatim
+   ./waf --run "mmwave-simple-epc --ns3::DefaultSimulatorImpl::EnableEventProfiler=true" \endverbatim
+ * The simulator does not use it otherwise. The report is written at
+ * Simulator::Destroy(), and a CSV file with the cumulative time of every
+ * target can be written periodically during long runs.
+ */
+class EventProfiler
+{
+public:
+  /** Constructor. */
+  EventProfiler ();
+  /** Destructor. */
+  ~EventProfiler ();
+
+  /**
+   * Write the cumulative profile of the targets to a CSV file every
+   * interval of simulation time, with the columns
+   * \verbatim
+   simulationTime,wallTime,target,events,seconds \endverbatim
+   *
+   * \param [in] fileName The CSV file.
+   * \param [in] interval The simulation time between the rows of a target.
+   */
+  void SetCsv (std::string fileName, Time interval);
+  /**
+   * Restart the wall clock, when the simulator starts to run the events:
+   * the time since the last event is not attributed.
+   */
+  void Start (void);
+  /**
+   * Invoke an event and attribute its time.
+   *
+   * \param [in] event The event.
+   * \param [in] context The context of the event.
+   * \param [in] now The simulation time of the event.
+   */
+  void Invoke (EventImpl *event, uint32_t context, Time now);
+  /**
+   * Write the report: the targets and the contexts sorted by wall
+   * clock time.
+   *
+   * \param [in,out] os The output stream.
+   */
+  void Report (std::ostream &os);
+
+private:
+  /** Clock of the profiler. */
+  typedef std::chrono::steady_clock Clock;
+
+  /** The events of a target or context. */
+  struct Entry
+  {
+    Entry ();
+    uint64_t m_events;              /**< Number of events. */
+    Clock::duration m_time;         /**< Wall clock time. */
+    const void *m_function;         /**< The code run by the events, if known. */
+    const std::type_info *m_type;   /**< The type of the first event. */
+  };
+  /** The totals of a named target. */
+  typedef std::map<std::string, std::pair<uint64_t, Clock::duration> > Totals;
+
+  /**
+   * Name a target, from the symbol of its code or from its event type.
+   *
+   * \param [in] entry The target.
+   * \returns The name.
+   */
+  static std::string GetName (const Entry &entry);
+  /**
+   * Sum the targets by name, as several keys may name the same target.
+   *
+   * \param [out] totals The totals.
+   */
+  void GetTotals (Totals &totals);
+  /**
+   * Write the rows of the CSV file.
+   *
+   * \param [in] now The simulation time.
+   */
+  void WriteCsv (Time now);
+
+  /**
+   * The targets, by address of their code or, when it is unknown, by
+   * type of their events.
+   */
+  std::map<const void *, Entry> m_targets;
+  /** The contexts. */
+  std::map<uint32_t, Entry> m_contexts;
+  /** The time between the events. */
+  Entry m_queue;
+  /** The names of the keys of m_targets resolved so far. */
+  std::map<const void *, std::string> m_names;
+  /** End of the last event. */
+  Clock::time_point m_last;
+  /** Start of the profile. */
+  Clock::time_point m_start;
+  /** The CSV file. */
+  std::ofstream m_csv;
+  /** Simulation time between the rows of the CSV file. */
+  Time m_csvInterval;
+  /** Simulation time of the next rows of the CSV file. */
+  Time m_nextCsv;
+};
+
+} // namespace ns3
+
+#endif /* EVENT_PROFILER_H */
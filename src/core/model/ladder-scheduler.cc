@@ -0,0 +1,347 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler class implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+/**
+ * \ingroup scheduler
+ * Order of the events in Bottom, from the latest to the earliest.
+ *
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns \c true if \p a is later than \p b.
+ */
+static bool
+IsLater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return b.key < a.key;
+}
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_topMin (0),
+    m_topMax (0),
+    m_nRungs (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::GetCurrentStart (const Rung &rung)
+{
+  return rung.m_start + rung.m_current * rung.m_width;
+}
+
+LadderScheduler::Rung &
+LadderScheduler::AddRung (uint64_t start, uint64_t width, uint32_t nBuckets)
+{
+  NS_LOG_FUNCTION (this << start << width << nBuckets);
+  NS_ASSERT (m_nRungs < MAX_RUNGS);
+  if (m_nRungs == m_rungs.size ())
+    {
+      m_rungs.push_back (Rung ());
+    }
+  Rung &rung = m_rungs[m_nRungs];
+  m_nRungs++;
+  rung.m_start = start;
+  rung.m_width = width;
+  rung.m_nBuckets = nBuckets;
+  rung.m_current = 0;
+  rung.m_count = 0;
+  if (rung.m_buckets.size () < nBuckets)
+    {
+      rung.m_buckets.resize (nBuckets);
+    }
+  return rung;
+}
+
+void
+LadderScheduler::InsertInRung (Rung &rung, const Scheduler::Event &ev)
+{
+  uint64_t bucket = (ev.key.m_ts - rung.m_start) / rung.m_width;
+  NS_ASSERT (bucket >= rung.m_current && bucket < rung.m_nBuckets);
+  rung.m_buckets[bucket].push_back (ev);
+  rung.m_count++;
+}
+
+void
+LadderScheduler::InsertInBottom (const Scheduler::Event &ev)
+{
+  std::vector<Scheduler::Event>::iterator it = std::upper_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater);
+  m_bottom.insert (it, ev);
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  if (m_bottom.empty ())
+    {
+      // the queue is empty: the rungs left are empty too
+      NS_ASSERT (m_top.empty ());
+      m_nRungs = 0;
+      m_bottom.push_back (ev);
+      m_topStart = ev.key.m_ts + 1;
+      return;
+    }
+  if (ev.key.m_ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = ev.key.m_ts;
+          m_topMax = ev.key.m_ts;
+        }
+      else
+        {
+          m_topMin = std::min (m_topMin, ev.key.m_ts);
+          m_topMax = std::max (m_topMax, ev.key.m_ts);
+        }
+      m_top.push_back (ev);
+      return;
+    }
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      if (ev.key.m_ts >= GetCurrentStart (m_rungs[i]))
+        {
+          InsertInRung (m_rungs[i], ev);
+          return;
+        }
+    }
+  InsertInBottom (ev);
+  if (m_bottom.size () > BUCKET_THRESHOLD && m_nRungs < MAX_RUNGS
+      && m_bottom.front ().key.m_ts > m_bottom.back ().key.m_ts)
+    {
+      TransferBottom ();
+    }
+}
+
+void
+LadderScheduler::TransferTop (void)
+{
+  NS_LOG_FUNCTION (this << m_top.size () << m_topMin << m_topMax);
+  NS_ASSERT (m_nRungs == 0 && !m_top.empty ());
+  uint64_t width = (m_topMax - m_topMin) / m_top.size () + 1;
+  uint32_t nBuckets = (m_topMax - m_topMin) / width + 1;
+  Rung &rung = AddRung (m_topMin, width, nBuckets);
+  for (Bucket::const_iterator it = m_top.begin (); it != m_top.end (); it++)
+    {
+      InsertInRung (rung, *it);
+    }
+  m_top.clear ();
+  m_topStart = m_topMin + width * nBuckets;
+}
+
+void
+LadderScheduler::TransferBottom (void)
+{
+  NS_LOG_FUNCTION (this << m_bottom.size ());
+  // the rung covers the range up to the first bucket of the previous rung,
+  // or up to Top, where the events later than Bottom are inserted
+  uint64_t start = m_bottom.back ().key.m_ts;
+  uint64_t end = m_nRungs > 0 ? GetCurrentStart (m_rungs[m_nRungs - 1]) : m_topStart;
+  NS_ASSERT (end > m_bottom.front ().key.m_ts);
+  uint64_t width = (end - start - 1) / m_bottom.size () + 1;
+  uint32_t nBuckets = (end - start - 1) / width + 1;
+  Rung &rung = AddRung (start, width, nBuckets);
+  for (std::vector<Scheduler::Event>::const_iterator it = m_bottom.begin (); it != m_bottom.end (); it++)
+    {
+      InsertInRung (rung, *it);
+    }
+  m_bottom.clear ();
+  FillBottom ();
+}
+
+void
+LadderScheduler::FillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_bottom.empty ());
+  while (true)
+    {
+      if (m_nRungs == 0)
+        {
+          if (m_top.empty ())
+            {
+              return;
+            }
+          TransferTop ();
+        }
+      uint32_t last = m_nRungs - 1;
+      Rung &rung = m_rungs[last];
+      while (rung.m_current < rung.m_nBuckets && rung.m_buckets[rung.m_current].empty ())
+        {
+          rung.m_current++;
+        }
+      if (rung.m_current == rung.m_nBuckets)
+        {
+          NS_ASSERT (rung.m_count == 0);
+          m_nRungs--;
+          continue;
+        }
+      uint32_t size = rung.m_buckets[rung.m_current].size ();
+      if (size > BUCKET_THRESHOLD && rung.m_width > 1 && m_nRungs < MAX_RUNGS)
+        {
+          // spread the bucket over a finer rung
+          uint64_t start = GetCurrentStart (rung);
+          uint64_t width = (rung.m_width + size - 1) / size;
+          uint32_t nBuckets = (rung.m_width + width - 1) / width;
+          rung.m_count -= size;
+          rung.m_current++;
+          Rung &child = AddRung (start, width, nBuckets);
+          // AddRung may have moved the rungs
+          Bucket &bucket = m_rungs[last].m_buckets[m_rungs[last].m_current - 1];
+          for (Bucket::const_iterator it = bucket.begin (); it != bucket.end (); it++)
+            {
+              InsertInRung (child, *it);
+            }
+          bucket.clear ();
+          continue;
+        }
+      Bucket &bucket = rung.m_buckets[rung.m_current];
+      m_bottom.assign (bucket.begin (), bucket.end ());
+      std::sort (m_bottom.begin (), m_bottom.end (), IsLater);
+      bucket.clear ();
+      rung.m_count -= size;
+      rung.m_current++;
+      break;
+    }
+  // drop the rungs that have been dequeued, the events inserted in their
+  // range go to Bottom
+  while (m_nRungs > 0 && m_rungs[m_nRungs - 1].m_count == 0)
+    {
+      m_nRungs--;
+    }
+  if (m_nRungs == 0)
+    {
+      // Top starts right after Bottom until the next transfer
+      m_topStart = std::min (m_topStart, m_bottom.front ().key.m_ts + 1);
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  return m_bottom.empty ();
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!m_bottom.empty ());
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!m_bottom.empty ());
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  if (m_bottom.empty ())
+    {
+      FillBottom ();
+    }
+  return ev;
+}
+
+bool
+LadderScheduler::RemoveFromBucket (Bucket &bucket, const Scheduler::Event &ev)
+{
+  for (Bucket::iterator it = bucket.begin (); it != bucket.end (); it++)
+    {
+      if (it->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == it->impl);
+          *it = bucket.back ();
+          bucket.pop_back ();
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  if (ev.key.m_ts >= m_topStart)
+    {
+      bool found = RemoveFromBucket (m_top, ev);
+      NS_ASSERT_MSG (found, "the event is not in the scheduler");
+      return;
+    }
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      if (ev.key.m_ts >= GetCurrentStart (rung))
+        {
+          bool found = RemoveFromBucket (rung.m_buckets[(ev.key.m_ts - rung.m_start) / rung.m_width], ev);
+          NS_ASSERT_MSG (found, "the event is not in the scheduler");
+          rung.m_count--;
+          return;
+        }
+    }
+  for (std::vector<Scheduler::Event>::iterator it = m_bottom.begin (); it != m_bottom.end (); it++)
+    {
+      if (it->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == it->impl);
+          m_bottom.erase (it);
+          if (m_bottom.empty ())
+            {
+              FillBottom ();
+            }
+          return;
+        }
+    }
+  NS_ASSERT_MSG (false, "the event is not in the scheduler");
+}
+
+} // namespace ns3
@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler declaration.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue of
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh and
+ * Ian Li-Jin Thng (2005). The events are kept in three tiers:
+ *
+ *  - Top: an unsorted list of the events beyond the range of the ladder,
+ *    which is where most of the events are inserted in O(1).
+ *  - Ladder: rungs of buckets. When the ladder is empty, the events of
+ *    Top are spread over the buckets of a new rung, whose width is set by
+ *    the range and number of these events. A bucket with more than
+ *    BUCKET_THRESHOLD events is spread over a new, finer rung before it
+ *    is dequeued.
+ *  - Bottom: the sorted events of the first bucket of the last rung,
+ *    from which the events are dequeued in O(1). When more than
+ *    BUCKET_THRESHOLD events are inserted in Bottom, they are spread over
+ *    a new rung too.
+ *
+ * Only the small buckets that reach Bottom are sorted, so the amortized
+ * cost of Insert and RemoveNext does not depend on the number of events.
+ * This suits the workloads where most events are scheduled a slot ahead
+ * on a periodic grid, plus small offsets, as the mmWave stack does: the
+ * events of a slot are spread over the buckets of a rung instead of
+ * being inserted in a tree or a heap of all the pending events.
+ *
+ * The rungs and buckets keep their memory when they are emptied, so
+ * the steady state does not allocate.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** A bucket of a rung, or Top: unsorted events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    uint64_t m_start;               /**< Time of the start of the first bucket. */
+    uint64_t m_width;               /**< Duration of a bucket. */
+    uint32_t m_nBuckets;            /**< Number of buckets in use. */
+    uint32_t m_current;             /**< First bucket that has not been dequeued. */
+    uint32_t m_count;               /**< Number of events in the rung. */
+    std::vector<Bucket> m_buckets;  /**< Buckets, at least m_nBuckets. */
+  };
+
+  /** Events in a bucket above which it is spread over a new rung. */
+  static const uint32_t BUCKET_THRESHOLD = 50;
+  /** Maximum number of rungs. */
+  static const uint32_t MAX_RUNGS = 8;
+
+  /**
+   * Time of the start of the first bucket of a rung that has not been
+   * dequeued: the events before it are in the next rungs or in Bottom.
+   *
+   * \param [in] rung The rung.
+   * \returns The time.
+   */
+  static uint64_t GetCurrentStart (const Rung &rung);
+  /**
+   * Prepare a new rung at the end of the ladder, reusing its memory.
+   *
+   * \param [in] start The time of the start of the first bucket.
+   * \param [in] width The duration of a bucket.
+   * \param [in] nBuckets The number of buckets.
+   * \returns The rung.
+   */
+  Rung & AddRung (uint64_t start, uint64_t width, uint32_t nBuckets);
+  /**
+   * Insert an event in the bucket of a rung.
+   *
+   * \param [in] rung The rung.
+   * \param [in] ev The event.
+   */
+  static void InsertInRung (Rung &rung, const Scheduler::Event &ev);
+  /**
+   * Insert an event in Bottom, in order.
+   *
+   * \param [in] ev The event.
+   */
+  void InsertInBottom (const Scheduler::Event &ev);
+  /** Spread the events of Top over a new rung. */
+  void TransferTop (void);
+  /**
+   * Spread the events of Bottom over a new rung, up to the range of the
+   * previous rung, when too many events have been inserted in Bottom.
+   */
+  void TransferBottom (void);
+  /**
+   * Move the next bucket of the ladder to Bottom, spawning finer rungs
+   * from the buckets with too many events. Called when Bottom is empty
+   * and the queue is not.
+   */
+  void FillBottom (void);
+  /**
+   * Remove an event from an unsorted bucket.
+   *
+   * \param [in] bucket The bucket.
+   * \param [in] ev The event.
+   * \returns \c true if the event was found.
+   */
+  static bool RemoveFromBucket (Bucket &bucket, const Scheduler::Event &ev);
+
+  /** Top: the events from m_topStart on. */
+  Bucket m_top;
+  /** Start of the range of Top. */
+  uint64_t m_topStart;
+  /** Earliest event in Top. */
+  uint64_t m_topMin;
+  /** Latest event in Top. */
+  uint64_t m_topMax;
+  /** The rungs, only the first m_nRungs are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** Bottom: the earliest events, sorted from the latest to the earliest. */
+  std::vector<Scheduler::Event> m_bottom;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
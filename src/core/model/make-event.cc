@@ -20,6 +20,9 @@
 #include "make-event.h"
 #include "log.h"
 
+#include <stdint.h>
+#include <cstring>
+
 /**
  * \file
  * \ingroup events
@@ -52,10 +55,53 @@ protected:
     {
       (*m_function)();
     }
+    virtual const void * GetFunction (void) const
+    {
+      return reinterpret_cast<const void *> (m_function);
+    }
 private:
     F m_function;
   } *ev = new EventFunctionImpl0 (f);
   return ev;
 }
 
+const void *
+EventMethodAddress (const void *mem_ptr, std::size_t size, const void *obj)
+{
+  // the representation of the pointers to member functions of the
+  // Itanium C++ ABI, used by gcc and clang: a function address, or one
+  // plus the offset of the method in the vtable, followed by the
+  // adjustment of the this pointer. On ARM the virtual flag is the low
+  // bit of the adjustment instead.
+#if defined (__GNUC__)
+  struct
+  {
+    uintptr_t ptr;
+    ptrdiff_t adj;
+  } rep;
+  if (size != sizeof (rep))
+    {
+      return 0;
+    }
+  std::memcpy (&rep, mem_ptr, sizeof (rep));
+#if defined (__arm__) || defined (__aarch64__)
+  bool isVirtual = (rep.adj & 1) != 0;
+  ptrdiff_t adj = rep.adj >> 1;
+  uintptr_t offset = rep.ptr;
+#else
+  bool isVirtual = (rep.ptr & 1) != 0;
+  ptrdiff_t adj = rep.adj;
+  uintptr_t offset = rep.ptr - 1;
+#endif
+  if (!isVirtual)
+    {
+      return reinterpret_cast<const void *> (rep.ptr);
+    }
+  const char *vtable = *reinterpret_cast<const char * const *> (static_cast<const char *> (obj) + adj);
+  return *reinterpret_cast<const void * const *> (vtable + offset);
+#else
+  return 0;
+#endif
+}
+
 } // namespace ns3
@@ -316,6 +316,7 @@ EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4,U5,U6), T1 a1, T2 a2, T3 a3, T4 a4,
 
 #include "event-impl.h"
 #include "type-traits.h"
+#include <cstddef>
 
 namespace ns3 {
 
@@ -355,6 +356,76 @@ struct EventMemberImplObjTraits<T *>
   }
 };
 
+/**
+ * \ingroup makeeventmemptr
+ * Get the code a class method pointer calls on an object.
+ *
+ * \param [in] mem_ptr The representation of the class method pointer.
+ * \param [in] size The size of the class method pointer.
+ * \param [in] obj The object, converted to the class of the method.
+ * \returns The address of the code, or 0 if it is not known.
+ */
+const void * EventMethodAddress (const void *mem_ptr, std::size_t size, const void *obj);
+
+/**
+ * \ingroup makeeventmemptr
+ * Get the code run by the MakeEvent functions which take a class member.
+ *
+ * This is the generic version, for the members which are not methods,
+ * such as Callback members: the code is not known.
+ *
+ * \tparam MEM \deduced The class member type.
+ * \tparam T \deduced The class type of the object.
+ * \param [in] mem_ptr The class member.
+ * \param [in] obj The object.
+ * \returns 0.
+ */
+template <typename MEM, typename T>
+const void * EventMemberFunctionAddress (MEM mem_ptr, T &obj)
+{
+  return 0;
+}
+
+/**
+ * \ingroup makeeventmemptr
+ * Get the code run by the MakeEvent functions which take a class method.
+ *
+ * This is the version for non-const methods.
+ *
+ * \tparam R \deduced The return type.
+ * \tparam C \deduced The class type of the method.
+ * \tparam A \deduced The argument types.
+ * \tparam T \deduced The class type of the object.
+ * \param [in] mem_ptr The class method.
+ * \param [in] obj The object.
+ * \returns The address of the code, or 0 if it is not known.
+ */
+template <typename R, typename C, typename... A, typename T>
+const void * EventMemberFunctionAddress (R (C::*mem_ptr)(A...), T &obj)
+{
+  return EventMethodAddress (&mem_ptr, sizeof (mem_ptr), static_cast<const C *> (&obj));
+}
+
+/**
+ * \ingroup makeeventmemptr
+ * Get the code run by the MakeEvent functions which take a class method.
+ *
+ * This is the version for const methods.
+ *
+ * \tparam R \deduced The return type.
+ * \tparam C \deduced The class type of the method.
+ * \tparam A \deduced The argument types.
+ * \tparam T \deduced The class type of the object.
+ * \param [in] mem_ptr The class method.
+ * \param [in] obj The object.
+ * \returns The address of the code, or 0 if it is not known.
+ */
+template <typename R, typename C, typename... A, typename T>
+const void * EventMemberFunctionAddress (R (C::*mem_ptr)(A...) const, T &obj)
+{
+  return EventMethodAddress (&mem_ptr, sizeof (mem_ptr), static_cast<const C *> (&obj));
+}
+
 template <typename MEM, typename OBJ>
 EventImpl * MakeEvent (MEM mem_ptr, OBJ obj)
 {
@@ -375,6 +446,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)();
     }
+    virtual const void * GetFunction (void) const
+    {
+      return EventMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
   } *ev = new EventMemberImpl0 (obj, mem_ptr);
@@ -405,6 +480,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return EventMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -436,6 +515,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return EventMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -469,6 +552,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return EventMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -504,6 +591,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3, m_a4);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return EventMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -542,6 +633,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return EventMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -582,6 +677,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5, m_a6);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return EventMemberFunctionAddress (m_function, EventMemberImplObjTraits<OBJ>::GetReference (m_obj));
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -617,6 +716,10 @@ private:
     {
       (*m_function)(m_a1);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return reinterpret_cast<const void *> (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
   } *ev = new EventFunctionImpl1 (f, a1);
@@ -647,6 +750,10 @@ private:
     {
       (*m_function)(m_a1, m_a2);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return reinterpret_cast<const void *> (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -680,6 +787,10 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return reinterpret_cast<const void *> (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -715,6 +826,10 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3, m_a4);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return reinterpret_cast<const void *> (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -752,6 +867,10 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return reinterpret_cast<const void *> (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -791,6 +910,10 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5, m_a6);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return reinterpret_cast<const void *> (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
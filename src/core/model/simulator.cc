@@ -206,6 +206,7 @@ Simulator::Destroy (void)
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
+  EventImpl::ReleasePool ();
 }
 
 void
@@ -18,11 +18,24 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "ns3/test.h"
+#include "ns3/core-config.h"
 #include "ns3/simulator.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/object-factory.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/string.h"
+#include "ns3/nstime.h"
+#include <fstream>
+#include <sstream>
+#include <vector>
 
 using namespace ns3;
 
@@ -459,6 +472,246 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SimulatorEventPoolTestCase : public TestCase
+{
+public:
+  SimulatorEventPoolTestCase ();
+  virtual void DoRun (void);
+  void Chain (uint32_t remaining);
+  uint32_t m_invoked;
+};
+
+SimulatorEventPoolTestCase::SimulatorEventPoolTestCase ()
+  : TestCase ("Check that the events reuse the memory of the deleted ones")
+{
+}
+
+void
+SimulatorEventPoolTestCase::Chain (uint32_t remaining)
+{
+  m_invoked++;
+  if (remaining > 0)
+    {
+      Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::Chain, this, remaining - 1);
+    }
+}
+
+void
+SimulatorEventPoolTestCase::DoRun (void)
+{
+  // every event is scheduled by the previous one, so it is allocated
+  // while the previous one is still alive and the third event is the
+  // first one to reuse a block
+  m_invoked = 0;
+  EventImpl::ReleasePool ();
+  EventImpl::PoolStats before = EventImpl::GetPoolStats ();
+  Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::Chain, this, 999);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  EventImpl::PoolStats after = EventImpl::GetPoolStats ();
+  NS_TEST_ASSERT_MSG_EQ (m_invoked, 1000, "Events were not invoked");
+  NS_TEST_ASSERT_MSG_EQ (after.m_allocations - before.m_allocations, 1000, "Unexpected number of events");
+  NS_TEST_ASSERT_MSG_EQ (after.m_hits - before.m_hits, 998, "Events did not reuse the deleted ones");
+  NS_TEST_ASSERT_MSG_EQ (after.m_cached, 0, "Simulator::Destroy did not release the free lists");
+
+  m_invoked = 0;
+  GlobalValue::Bind ("EventImplPoolEnabled", BooleanValue (false));
+  before = EventImpl::GetPoolStats ();
+  Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::Chain, this, 999);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  after = EventImpl::GetPoolStats ();
+  GlobalValue::Bind ("EventImplPoolEnabled", BooleanValue (true));
+  NS_TEST_ASSERT_MSG_EQ (m_invoked, 1000, "Events were not invoked");
+  NS_TEST_ASSERT_MSG_EQ (after.m_hits - before.m_hits, 0, "Events reused memory with the free lists disabled");
+}
+
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the order of slot-periodic and random events against MapScheduler " + schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  // the events are scheduled from the dequeued ones on a 125 us grid,
+  // with symbol offsets, ties and a few far events, and some of them are
+  // removed before they expire
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  Ptr<Scheduler> reference = CreateObject<MapScheduler> ();
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+  std::vector<Scheduler::Event> pending;
+  uint32_t uid = 0;
+  uint64_t now = 0;
+  for (uint32_t i = 0; i < 20000; i++)
+    {
+      uint32_t inserts = (scheduler->IsEmpty () ? 5 : random->GetInteger (0, 2));
+      for (uint32_t j = 0; j < inserts; j++)
+        {
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          uint32_t kind = random->GetInteger (0, 9);
+          if (kind < 5)
+            {
+              ev.key.m_ts = (now / 125000 + random->GetInteger (1, 8)) * 125000 + random->GetInteger (0, 13) * 8928;
+            }
+          else if (kind < 8)
+            {
+              ev.key.m_ts = now + random->GetInteger (0, 3);
+            }
+          else if (kind < 9)
+            {
+              ev.key.m_ts = now + random->GetInteger (0, 5000000);
+            }
+          else
+            {
+              ev.key.m_ts = now + 1000000000;
+            }
+          scheduler->Insert (ev);
+          reference->Insert (ev);
+          pending.push_back (ev);
+        }
+      if (random->GetInteger (0, 9) == 0 && !pending.empty ())
+        {
+          uint32_t index = random->GetInteger (0, pending.size () - 1);
+          Scheduler::Event ev = pending[index];
+          pending[index] = pending.back ();
+          pending.pop_back ();
+          if (ev.key.m_ts >= now)
+            {
+              scheduler->Remove (ev);
+              reference->Remove (ev);
+            }
+        }
+      if (!reference->IsEmpty ())
+        {
+          NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), false, "The scheduler lost events");
+          Scheduler::Event next = scheduler->RemoveNext ();
+          Scheduler::Event expected = reference->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, expected.key.m_uid, "Events out of order");
+          now = next.key.m_ts;
+          for (uint32_t k = 0; k < pending.size (); k++)
+            {
+              if (pending[k].key.m_uid == next.key.m_uid)
+                {
+                  pending[k] = pending.back ();
+                  pending.pop_back ();
+                  break;
+                }
+            }
+        }
+    }
+  while (!reference->IsEmpty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (scheduler->RemoveNext ().key.m_uid, reference->RemoveNext ().key.m_uid, "Events out of order");
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "The scheduler has more events");
+}
+
+class SimulatorEventProfilerTestCase : public TestCase
+{
+public:
+  SimulatorEventProfilerTestCase ();
+  virtual void DoRun (void);
+  void EventA (void);
+  virtual void EventB (int b);
+  static uint64_t GetEvents (std::string fileName, std::string target);
+};
+
+SimulatorEventProfilerTestCase::SimulatorEventProfilerTestCase ()
+  : TestCase ("Check the event profiler of the default simulator")
+{
+}
+
+void
+SimulatorEventProfilerTestCase::EventA (void)
+{
+}
+
+void
+SimulatorEventProfilerTestCase::EventB (int b)
+{
+}
+
+uint64_t
+SimulatorEventProfilerTestCase::GetEvents (std::string fileName, std::string target)
+{
+  std::ifstream report (fileName.c_str ());
+  std::string line;
+  while (std::getline (report, line))
+    {
+      if (line.find (target) != std::string::npos)
+        {
+          std::istringstream row (line);
+          double seconds, percentage;
+          uint64_t events = 0;
+          row >> seconds >> percentage >> events;
+          return events;
+        }
+    }
+  return 0;
+}
+
+void
+SimulatorEventProfilerTestCase::DoRun (void)
+{
+  std::string reportFile = CreateTempDirFilename ("event-profile.txt");
+  std::string csvFile = CreateTempDirFilename ("event-profile.csv");
+  ObjectFactory factory ("ns3::DefaultSimulatorImpl");
+  factory.Set ("EnableEventProfiler", BooleanValue (true));
+  factory.Set ("EventProfilerReport", StringValue (reportFile));
+  factory.Set ("EventProfilerCsv", StringValue (csvFile));
+  factory.Set ("EventProfilerCsvInterval", TimeValue (MicroSeconds (5)));
+  Simulator::SetImplementation (factory.Create<SimulatorImpl> ());
+
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      EventId id = Simulator::Schedule (MicroSeconds (i + 1), &SimulatorEventProfilerTestCase::EventA, this);
+      if (i == 5)
+        {
+          Simulator::Cancel (id);
+        }
+    }
+  // EventB is virtual: the profiler finds it in the vtable
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      Simulator::ScheduleWithContext (3, MicroSeconds (i + 1), &SimulatorEventProfilerTestCase::EventB, this, i);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (GetEvents (reportFile, "context 3"), 5, "Context 3 was not profiled");
+  NS_TEST_ASSERT_MSG_EQ (GetEvents (reportFile, "[event queue]"), 15, "Events were not counted");
+
+  // without the symbols, the targets are named after raw addresses
+#if defined (HAVE_DLADDR) && defined (HAVE_CXXABI_H)
+  NS_TEST_ASSERT_MSG_EQ (GetEvents (reportFile, "SimulatorEventProfilerTestCase::EventA"), 9, "EventA was not profiled");
+  NS_TEST_ASSERT_MSG_EQ (GetEvents (reportFile, "SimulatorEventProfilerTestCase::EventB"), 5, "EventB was not profiled");
+
+  std::ifstream csv (csvFile.c_str ());
+  std::string line;
+  uint32_t rows = 0;
+  while (std::getline (csv, line))
+    {
+      rows += (line.find ("SimulatorEventProfilerTestCase::EventA") != std::string::npos);
+    }
+  // the rows are written at the events of 5 and 10 us
+  NS_TEST_ASSERT_MSG_EQ (rows, 2, "Unexpected rows of the CSV file");
+#endif
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +728,10 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorEventPoolTestCase (), TestCase::QUICK);
+    AddTestCase (new SimulatorEventProfilerTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -654,7 +654,7 @@ LteRlcAm::DoNotifyTxOpportunity (uint32_t bytes, uint8_t layer, uint8_t harqId)
   Ptr<Packet> firstSegment = (*(m_txonBuffer.begin ()))->Copy ();
   m_txonBufferSize -= (*(m_txonBuffer.begin()))->GetSize ();
   NS_LOG_LOGIC ("txBufferSize      = " << m_txonBufferSize );
-  m_txonBuffer.erase (m_txonBuffer.begin ());
+  m_txonBuffer.pop_front ();
 
   while ( firstSegment && (firstSegment->GetSize () > 0) && (nextSegmentSize > 0) )
     {
@@ -702,14 +702,7 @@ LteRlcAm::DoNotifyTxOpportunity (uint32_t bytes, uint8_t layer, uint8_t harqId)
             {
               firstSegment->AddPacketTag (oldTag);
 
-              if(m_txonBuffer.empty())
-              {
-            	  m_txonBuffer.push_back(firstSegment);
-              }
-              else
-              {
-                  m_txonBuffer.insert (m_txonBuffer.begin (), firstSegment);
-              }
+              m_txonBuffer.push_front (firstSegment);
               m_txonBufferSize += (*(m_txonBuffer.begin()))->GetSize ();
 
               NS_LOG_LOGIC ("    Txon buffer: Give back the remaining segment");
@@ -827,7 +820,7 @@ LteRlcAm::DoNotifyTxOpportunity (uint32_t bytes, uint8_t layer, uint8_t harqId)
 
           firstSegment = (*(m_txonBuffer.begin ()))->Copy ();
           m_txonBufferSize -= (*(m_txonBuffer.begin()))->GetSize ();
-          m_txonBuffer.erase (m_txonBuffer.begin ());
+          m_txonBuffer.pop_front ();
           NS_LOG_LOGIC ("        txBufferSize = " << m_txonBufferSize );
         }
 
@@ -27,6 +27,7 @@
 #include "ns3/codel-queue-disc.h"
 
 #include <vector>
+#include <deque>
 #include <map>
 
 namespace ns3 {
@@ -82,7 +83,7 @@ private:
   void DoReportBufferStatus ();
 
 private:
-    std::vector < Ptr<Packet> > m_txonBuffer;       // Transmission buffer
+    std::deque < Ptr<Packet> > m_txonBuffer;       // Transmission buffer
     Ptr<CoDelQueueDisc> m_txonQueue; //the packets comming from PDCP first stored in this queue and move to m_txonBuffer during transmission.
 
     struct RetxPdu
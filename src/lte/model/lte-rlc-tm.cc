@@ -136,7 +136,7 @@ LteRlcTm::DoNotifyTxOpportunity (uint32_t bytes, uint8_t layer, uint8_t harqId)
     }
 
   m_txBufferSize -= (*(m_txBuffer.begin()))->GetSize ();
-  m_txBuffer.erase (m_txBuffer.begin ());
+  m_txBuffer.pop_front ();
  
   // Sender timestamp
   RlcTag rlcTag (Simulator::Now ());
@@ -202,7 +202,7 @@ LteRlcUmLowLat::DoNotifyTxOpportunity (uint32_t bytes, uint8_t layer, uint8_t ha
   Ptr<Packet> firstSegment = (*(m_txBuffer.begin ()))->Copy ();
   m_txBufferSize -= (*(m_txBuffer.begin()))->GetSize ();
   NS_LOG_LOGIC ("txBufferSize      = " << m_txBufferSize );
-  m_txBuffer.erase (m_txBuffer.begin ());
+  m_txBuffer.pop_front ();
 
   while ( firstSegment && (firstSegment->GetSize () > 0) && (nextSegmentSize > 0) )
     {
@@ -250,7 +250,7 @@ LteRlcUmLowLat::DoNotifyTxOpportunity (uint32_t bytes, uint8_t layer, uint8_t ha
             {
               firstSegment->AddPacketTag (oldTag);
 
-              m_txBuffer.insert (m_txBuffer.begin (), firstSegment);
+              m_txBuffer.push_front (firstSegment);
               m_txBufferSize += (*(m_txBuffer.begin()))->GetSize ();
 
               NS_LOG_LOGIC ("    TX buffer: Give back the remaining segment");
@@ -355,7 +355,7 @@ LteRlcUmLowLat::DoNotifyTxOpportunity (uint32_t bytes, uint8_t layer, uint8_t ha
           // (more segments)
           firstSegment = (*(m_txBuffer.begin ()))->Copy ();
           m_txBufferSize -= (*(m_txBuffer.begin()))->GetSize ();
-          m_txBuffer.erase (m_txBuffer.begin ());
+          m_txBuffer.pop_front ();
           NS_LOG_LOGIC ("        txBufferSize = " << m_txBufferSize );
         }
 
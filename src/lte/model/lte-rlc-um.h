@@ -26,6 +26,7 @@
 
 #include <ns3/event-id.h>
 #include <map>
+#include <deque>
 
 namespace ns3 {
 
@@ -68,7 +69,7 @@ private:
 private:
   uint32_t m_maxTxBufferSize;
   uint32_t m_txBufferSize;
-  std::vector < Ptr<Packet> > m_txBuffer;       // Transmission buffer
+  std::deque < Ptr<Packet> > m_txBuffer;       // Transmission buffer
   std::map <uint16_t, Ptr<Packet> > m_rxBuffer; // Reception buffer
   std::vector < Ptr<Packet> > m_reasBuffer;     // Reassembling buffer
 
@@ -0,0 +1,112 @@
+/*
+ * mmwave-buildings-los-benchmark.cc
+ *
+ *  Compares the LOS queries of the building-aware propagation loss models through
+ *  MmWaveBuildingsIndex with the test against every building of BuildingList, on a
+ *  synthetic Manhattan grid of buildings.
+ *
+ *  ./waf --run "mmwave-buildings-los-benchmark --blocks=50 --links=100000"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/buildings-module.h"
+#include "ns3/mmwave-buildings-index.h"
+#include <ns3/system-wall-clock-ms.h>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+	uint32_t blocks = 50;
+	double blockSize = 80.0;
+	double streetWidth = 20.0;
+	uint32_t links = 100000;
+	uint32_t seed = 1;
+
+	CommandLine cmd;
+	cmd.AddValue ("blocks", "Number of blocks along each side of the grid, one building per block", blocks);
+	cmd.AddValue ("blockSize", "Side of a building in m", blockSize);
+	cmd.AddValue ("streetWidth", "Width of the streets in m", streetWidth);
+	cmd.AddValue ("links", "Number of links queried", links);
+	cmd.AddValue ("seed", "Seed of the positions of the links", seed);
+	cmd.Parse (argc, argv);
+	RngSeedManager::SetSeed (seed);
+
+	Ptr<UniformRandomVariable> height = CreateObject<UniformRandomVariable> ();
+	height->SetAttribute ("Min", DoubleValue (10.0));
+	height->SetAttribute ("Max", DoubleValue (60.0));
+	double pitch = blockSize + streetWidth;
+	for (uint32_t i = 0; i < blocks; i++)
+	{
+		for (uint32_t j = 0; j < blocks; j++)
+		{
+			Ptr<Building> building = CreateObject<Building> ();
+			building->SetBoundaries (Box (streetWidth + i*pitch, (i + 1)*pitch, streetWidth + j*pitch, (j + 1)*pitch,
+					0.0, height->GetValue ()));
+		}
+	}
+
+	// gNBs at 25 m and UEs at 1.5 m, both in the streets, up to 500 m apart
+	Ptr<UniformRandomVariable> position = CreateObject<UniformRandomVariable> ();
+	position->SetAttribute ("Min", DoubleValue (0.0));
+	position->SetAttribute ("Max", DoubleValue (blocks*pitch));
+	Ptr<UniformRandomVariable> offset = CreateObject<UniformRandomVariable> ();
+	offset->SetAttribute ("Min", DoubleValue (-500.0));
+	offset->SetAttribute ("Max", DoubleValue (500.0));
+	Ptr<UniformRandomVariable> street = CreateObject<UniformRandomVariable> ();
+	street->SetAttribute ("Min", DoubleValue (0.0));
+	street->SetAttribute ("Max", DoubleValue (streetWidth));
+	std::vector<Vector> enbs (links);
+	std::vector<Vector> ues (links);
+	for (uint32_t l = 0; l < links; l++)
+	{
+		double x = std::floor (position->GetValue () / pitch) * pitch + street->GetValue ();
+		double y = position->GetValue ();
+		enbs[l] = Vector (x, y, 25.0);
+		ues[l] = Vector (x + offset->GetValue (), std::floor ((y + offset->GetValue ()) / pitch) * pitch + street->GetValue (), 1.5);
+	}
+
+	SystemWallClockMs clock;
+	clock.Start ();
+	Ptr<MmWaveBuildingsIndex> index = MmWaveBuildingsIndex::Get ();
+	int64_t buildMs = clock.End ();
+
+	const char *names[2] = {"3D (MmWave3gppBuildingsPropagationLossModel)", "2D (BuildingsObstaclePropagationLossModel with FootprintLos)"};
+	for (int ignoreHeight = 0; ignoreHeight < 2; ignoreHeight++)
+	{
+		std::vector<bool> linear (links);
+		clock.Start ();
+		for (uint32_t l = 0; l < links; l++)
+		{
+			linear[l] = MmWaveBuildingsIndex::IsLineIntersectBuildingsLinear (enbs[l], ues[l], ignoreHeight);
+		}
+		int64_t linearMs = clock.End ();
+
+		uint32_t nlos = 0;
+		uint32_t mismatches = 0;
+		clock.Start ();
+		for (uint32_t l = 0; l < links; l++)
+		{
+			bool intersect = index->IsLineIntersectBuildings (enbs[l], ues[l], ignoreHeight);
+			nlos += intersect;
+			mismatches += intersect != linear[l];
+		}
+		int64_t indexMs = clock.End ();
+
+		std::cout << names[ignoreHeight] << ": " << links << " links, " << nlos << " NLOS, " << mismatches << " mismatches" << std::endl;
+		std::cout << "  every building: " << linearMs << " ms, index: " << indexMs << " ms";
+		if (indexMs > 0)
+		{
+			std::cout << " (" << (double) linearMs / indexMs << "x)";
+		}
+		std::cout << std::endl;
+		NS_ABORT_MSG_IF (mismatches > 0, "The index and the test against every building disagree");
+	}
+	std::cout << BuildingList::GetNBuildings () << " buildings indexed in " << buildMs << " ms" << std::endl;
+
+	Simulator::Destroy ();
+	return 0;
+}
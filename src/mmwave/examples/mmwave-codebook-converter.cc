@@ -0,0 +1,49 @@
+/*
+ * mmwave-codebook-converter.cc
+ *
+ *  Converts a text codebook (e.g. BeamFormingMatrix/KronCodebook16h4v.txt) to the binary
+ *  format of MmWaveCodebookLoader, which is read in place instead of parsed at start-up.
+ *
+ *  ./waf --run "mmwave-codebook-converter --input=src/mmwave/model/BeamFormingMatrix/KronCodebook16h4v.txt
+ *  --output=KronCodebook16h4v.bin"
+ *
+ *  The output file can then be given to the beam management as the gNB or UE codebook path.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-codebook-loader.h"
+#include <iostream>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+	std::string input = "src/mmwave/model/BeamFormingMatrix/KronCodebook16h4v.txt";
+	std::string output = "";
+
+	CommandLine cmd;
+	cmd.AddValue ("input", "Text codebook to convert", input);
+	cmd.AddValue ("output", "Binary codebook to write (input path with .bin extension if empty)", output);
+	cmd.Parse (argc, argv);
+
+	if (output == "")
+	{
+		output = input.substr (0, input.find_last_of (".")) + ".bin";
+	}
+	if (MmWaveCodebookLoader::IsBinaryFile (input))
+	{
+		NS_FATAL_ERROR (input << " is already a binary codebook");
+	}
+
+	complex2DVector_t codebook = MmWaveCodebookLoader::ParseTextFile (input);
+	MmWaveCodebookLoader::WriteBinaryFile (codebook, output);
+
+	// read it back to check that the conversion is lossless
+	complex2DVector_t check = MmWaveCodebookLoader::ReadBinaryFile (output);
+	NS_ABORT_MSG_IF (check != codebook, "The binary codebook " << output << " does not match " << input);
+
+	std::cout << "Converted " << codebook.size () << " codewords of "
+			<< (codebook.empty () ? 0 : codebook[0].size ()) << " elements from " << input << " to " << output << std::endl;
+	return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * mmwave-mi-error-model-benchmark.cc
+ *
+ *  Compares the time to evaluate the 29 MCSs of random TBs the way MmWaveAmc does, with
+ *  the per-chunk lookup that MmWaveMiErrorModel::Mib replaces, with one mmib per MCS or
+ *  with one mmib per modulation. The results are checked by the mmwave-mi-error-model
+ *  test suite.
+ *
+ *  ./waf --run "mmwave-mi-error-model-benchmark --chunks=72 --tbs=20000"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-mi-error-model.h"
+#include <ns3/system-wall-clock-ms.h>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/*
+ * @brief mmib of a TB with the per-chunk lookup of each modulation, as computed before MibAllModulations
+ */
+static double
+ReferenceMib (const SpectrumValue& sinr, const std::vector<int>& map, uint8_t mcs)
+{
+	double MI;
+	double MIsum = 0.0;
+	Values::const_iterator sinrBegin = sinr.ConstValuesBegin ();
+	for (uint32_t i = 0; i < map.size (); i++)
+	{
+		double sinrLin = *(sinrBegin + map.at (i));
+		if (mcs <= MI_QPSK_MAX_ID)
+		{
+			if (sinrLin > MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1])
+			{
+				MI = 1;
+			}
+			else
+			{
+				static const double scalingCoeffQpsk =
+						(MI_MAP_QPSK_SIZE - 1) / (MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1] - MI_map_qpsk_axis[0]);
+				double sinrIndexDouble = (sinrLin -  MI_map_qpsk_axis[0]) * scalingCoeffQpsk + 1;
+				uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
+				MI = MI_map_qpsk[sinrIndex];
+			}
+		}
+		else if (mcs <= MI_16QAM_MAX_ID)
+		{
+			if (sinrLin > MI_map_16qam_axis[MI_MAP_16QAM_SIZE-1])
+			{
+				MI = 1;
+			}
+			else
+			{
+				static const double scalingCoeff16qam =
+						(MI_MAP_16QAM_SIZE - 1) / (MI_map_16qam_axis[MI_MAP_16QAM_SIZE-1] - MI_map_16qam_axis[0]);
+				double sinrIndexDouble = (sinrLin -  MI_map_16qam_axis[0]) * scalingCoeff16qam + 1;
+				uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
+				MI = MI_map_16qam[sinrIndex];
+			}
+		}
+		else
+		{
+			if (sinrLin > MI_map_64qam_axis[MI_MAP_64QAM_SIZE-1])
+			{
+				MI = 1;
+			}
+			else
+			{
+				static const double scalingCoeff64qam =
+						(MI_MAP_64QAM_SIZE - 1) / (MI_map_64qam_axis[MI_MAP_64QAM_SIZE-1] - MI_map_64qam_axis[0]);
+				double sinrIndexDouble = (sinrLin -  MI_map_64qam_axis[0]) * scalingCoeff64qam + 1;
+				uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
+				MI = MI_map_64qam[sinrIndex];
+			}
+		}
+		MIsum += MI;
+	}
+	return MIsum / map.size ();
+}
+
+int
+main (int argc, char *argv[])
+{
+	uint32_t chunks = 72;
+	uint32_t tbs = 20000;
+	double minSinrDb = -10.0;
+	double maxSinrDb = 40.0;
+	uint32_t seed = 1;
+
+	CommandLine cmd;
+	cmd.AddValue ("chunks", "Number of chunks of the band", chunks);
+	cmd.AddValue ("tbs", "Number of TBs evaluated", tbs);
+	cmd.AddValue ("minSinrDb", "Minimum SINR of a chunk in dB", minSinrDb);
+	cmd.AddValue ("maxSinrDb", "Maximum SINR of a chunk in dB", maxSinrDb);
+	cmd.AddValue ("seed", "Seed of the SINRs and of the chunks of the TBs", seed);
+	cmd.Parse (argc, argv);
+	RngSeedManager::SetSeed (seed);
+
+	Ptr<SpectrumModel> model = Create<SpectrumModel> (std::vector<double> (chunks, 1.0));
+	Ptr<UniformRandomVariable> sinrDb = CreateObject<UniformRandomVariable> ();
+	sinrDb->SetAttribute ("Min", DoubleValue (minSinrDb));
+	sinrDb->SetAttribute ("Max", DoubleValue (maxSinrDb));
+	Ptr<UniformRandomVariable> chunk = CreateObject<UniformRandomVariable> ();
+
+	// a TB is sent over a random set of consecutive chunks of a random PSD
+	std::vector<SpectrumValue> sinrs;
+	std::vector<std::vector<int> > maps (tbs);
+	for (uint32_t t = 0; t < tbs; t++)
+	{
+		SpectrumValue sinr (model);
+		for (uint32_t c = 0; c < chunks; c++)
+		{
+			sinr[c] = std::pow (10.0, sinrDb->GetValue () / 10.0);
+		}
+		sinrs.push_back (sinr);
+		uint32_t first = chunk->GetInteger (0, chunks - 1);
+		uint32_t last = chunk->GetInteger (first, chunks - 1);
+		for (uint32_t c = first; c <= last; c++)
+		{
+			maps[t].push_back (c);
+		}
+	}
+
+	MmWaveHarqProcessInfoList_t harqInfoList;
+	uint32_t tbSize = 1000;
+	SystemWallClockMs clock;
+
+	// every MCS with its own mmib, as GetTbDecodificationStats computes it; the TBLERs are kept
+	// so that the evaluations are not optimized away
+	std::vector<double> referenceTbler (tbs * 29);
+	clock.Start ();
+	for (uint32_t t = 0; t < tbs; t++)
+	{
+		for (uint8_t mcs = 0; mcs <= 28; mcs++)
+		{
+			double mib = ReferenceMib (sinrs[t], maps[t], mcs);
+			referenceTbler[t*29 + mcs] = MmWaveMiErrorModel::GetTbDecodificationStatsFromMib (mib, tbSize, mcs, harqInfoList).tbler;
+		}
+	}
+	int64_t referenceMs = clock.End ();
+
+	std::vector<double> perMcsTbler (tbs * 29);
+	clock.Start ();
+	for (uint32_t t = 0; t < tbs; t++)
+	{
+		for (uint8_t mcs = 0; mcs <= 28; mcs++)
+		{
+			perMcsTbler[t*29 + mcs] = MmWaveMiErrorModel::GetTbDecodificationStats (sinrs[t], maps[t], tbSize, mcs, harqInfoList).tbler;
+		}
+	}
+	int64_t perMcsMs = clock.End ();
+
+	// one mmib per modulation for all the MCSs
+	std::vector<double> batchedTbler (tbs * 29);
+	clock.Start ();
+	for (uint32_t t = 0; t < tbs; t++)
+	{
+		double mib[MI_NUM_MODULATIONS];
+		MmWaveMiErrorModel::MibAllModulations (sinrs[t], maps[t], mib);
+		for (uint8_t mcs = 0; mcs <= 28; mcs++)
+		{
+			batchedTbler[t*29 + mcs] = MmWaveMiErrorModel::GetTbDecodificationStatsFromMib (mib[MmWaveMiErrorModel::GetModulationIndex (mcs)],
+					tbSize, mcs, harqInfoList).tbler;
+		}
+	}
+	int64_t batchedMs = clock.End ();
+
+	std::cout << tbs << " TBs over up to " << chunks << " chunks, 29 MCSs each" << std::endl;
+	std::cout << "  per-chunk lookup per MCS: " << referenceMs << " ms" << std::endl;
+	std::cout << "  Mib per MCS: " << perMcsMs << " ms" << std::endl;
+	std::cout << "  MibAllModulations per TB: " << batchedMs << " ms";
+	if (batchedMs > 0)
+	{
+		std::cout << " (" << (double) referenceMs / batchedMs << "x)";
+	}
+	std::cout << std::endl;
+
+	Simulator::Destroy ();
+	return 0;
+}
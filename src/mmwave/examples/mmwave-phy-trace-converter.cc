@@ -0,0 +1,37 @@
+/*
+ * mmwave-phy-trace-converter.cc
+ *
+ *  Converts a binary PHY trace, written by MmWavePhyRxTrace with the BinaryFormat attribute
+ *  (e.g. RxPacketTraceUe.bin or UE_1_SINR_dB.bin), to the text format of the same trace.
+ *
+ *  ./waf --run "mmwave-phy-trace-converter --input=RxPacketTraceUe.bin"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-phy-rx-trace.h"
+#include <iostream>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+	std::string input = "RxPacketTraceUe.bin";
+	std::string output = "";
+
+	CommandLine cmd;
+	cmd.AddValue ("input", "Binary PHY trace to convert", input);
+	cmd.AddValue ("output", "Text trace to write (input path with .txt extension if empty)", output);
+	cmd.Parse (argc, argv);
+
+	if (output == "")
+	{
+		output = input.substr (0, input.find_last_of (".")) + ".txt";
+	}
+	NS_ABORT_MSG_IF (output == input, "The text trace cannot overwrite its source " << input);
+
+	uint64_t numRecords = MmWavePhyRxTrace::ConvertBinaryFile (input, output);
+
+	std::cout << "Converted " << numRecords << " records from " << input << " to " << output << std::endl;
+	return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * mmwave-raytracing-trace-converter.cc
+ *
+ *  Converts a text ray-tracing trace (8 lines per record, e.g. Raytracing/NS3_linear1.txt) to the
+ *  indexed binary format of MmWaveRaytracingTrace, whose index is read from the header instead of
+ *  scanning the whole file at start-up.
+ *
+ *  ./waf --run "mmwave-raytracing-trace-converter --input=src/mmwave/model/Raytracing/NS3_linear1.txt
+ *  --output=NS3_linear1.bin"
+ *
+ *  The output file can then be given to the MmWaveHelper as the ray-tracing file path.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-raytracing-trace.h"
+#include <iostream>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+	std::string input = "src/mmwave/model/Raytracing/NS3_linear1.txt";
+	std::string output = "";
+
+	CommandLine cmd;
+	cmd.AddValue ("input", "Text ray-tracing trace to convert", input);
+	cmd.AddValue ("output", "Binary trace to write (input path with .bin extension if empty)", output);
+	cmd.Parse (argc, argv);
+
+	if (output == "")
+	{
+		output = input.substr (0, input.find_last_of (".")) + ".bin";
+	}
+	if (MmWaveRaytracingTrace::IsBinaryFile (input))
+	{
+		NS_FATAL_ERROR (input << " is already a binary trace");
+	}
+
+	Ptr<MmWaveRaytracingTrace> text = Create<MmWaveRaytracingTrace> (input);
+	text->WriteBinaryFile (output);
+
+	// read it back to check that the conversion is lossless
+	Ptr<MmWaveRaytracingTrace> binary = Create<MmWaveRaytracingTrace> (output);
+	NS_ABORT_MSG_IF (binary->GetNumRecords () != text->GetNumRecords (), "The binary trace " << output << " does not match " << input);
+	for (uint32_t i = 0; i < text->GetNumRecords (); i++)
+	{
+		Ptr<const RaytracingTraceRecord> a = text->ReadRecord (i);
+		Ptr<const RaytracingTraceRecord> b = binary->ReadRecord (i);
+		NS_ABORT_MSG_IF (a->m_numPaths != b->m_numPaths || a->m_delay != b->m_delay || a->m_pathloss != b->m_pathloss
+				|| a->m_phase != b->m_phase || a->m_aodElevation != b->m_aodElevation || a->m_aodAzimuth != b->m_aodAzimuth
+				|| a->m_aoaElevation != b->m_aoaElevation || a->m_aoaAzimuth != b->m_aoaAzimuth,
+				"Record " << i << " of the binary trace " << output << " does not match " << input);
+	}
+
+	std::cout << "Converted " << text->GetNumRecords () << " records from " << input << " to " << output << std::endl;
+	return 0;
+}
@@ -0,0 +1,205 @@
+/*
+ * mmwave-rlc-benchmark.cc
+ *
+ *  Drives an RLC AM or UM transmitter and its receiver, connected back to back by a loopback
+ *  MAC, at the rates of a mmWave link: every slot the PDCP source offers its SDUs and the MAC
+ *  gives the transmitter a transmission opportunity of the link capacity. With an offered load
+ *  above the capacity, the transmission buffer of the RLC stays full, with thousands of SDUs,
+ *  and the benchmark measures the wall clock time per transmission opportunity, e.g.
+ *
+ *  ./waf --run "mmwave-rlc-benchmark --mode=am --offeredRate=10e9 --capacity=8e9"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include <ns3/lte-rlc-am.h>
+#include <ns3/lte-rlc-um.h>
+#include <ns3/lte-rlc-sap.h>
+#include <ns3/lte-mac-sap.h>
+#include <ns3/system-wall-clock-ms.h>
+#include <iostream>
+
+using namespace ns3;
+
+/**
+ * The MAC of an RLC entity: it forwards the PDUs to the peer RLC entity after a delay
+ * and keeps the last buffer status report
+ */
+class LoopbackMac : public LteMacSapProvider
+{
+public:
+	LoopbackMac ()
+		: m_peer (0),
+		  m_txPdus (0),
+		  m_txBytes (0)
+	{
+		m_report.txQueueSize = 0;
+		m_report.retxQueueSize = 0;
+		m_report.statusPduSize = 0;
+	}
+
+	virtual void TransmitPdu (TransmitPduParameters params)
+	{
+		m_txPdus++;
+		m_txBytes += params.pdu->GetSize ();
+		Simulator::Schedule (m_delay, &LteMacSapUser::ReceivePdu, m_peer, params.pdu);
+	}
+
+	virtual void ReportBufferStatus (ReportBufferStatusParameters params)
+	{
+		m_report = params;
+	}
+
+	LteMacSapUser *m_peer;
+	Time m_delay;
+	ReportBufferStatusParameters m_report;
+	uint64_t m_txPdus;
+	uint64_t m_txBytes;
+};
+
+/**
+ * The PDCP of the receiver: it counts the SDUs delivered by the RLC
+ */
+class CountingPdcp : public LteRlcSapUser
+{
+public:
+	CountingPdcp ()
+		: m_rxSdus (0),
+		  m_rxBytes (0)
+	{
+	}
+
+	virtual void ReceivePdcpPdu (Ptr<Packet> p)
+	{
+		m_rxSdus++;
+		m_rxBytes += p->GetSize ();
+	}
+
+	uint64_t m_rxSdus;
+	uint64_t m_rxBytes;
+};
+
+static Ptr<LteRlc> g_tx;
+static Ptr<LteRlc> g_rx;
+static LoopbackMac g_txMac;
+static LoopbackMac g_rxMac;
+static uint32_t g_sduSize;
+static double g_sdusPerSlot;
+static double g_sduCredit = 0;
+static uint32_t g_opportunity;
+static Time g_slot;
+static uint64_t g_opportunities = 0;
+static uint64_t g_queuedSdus = 0;
+
+/*
+ * @brief A slot: the source offers its SDUs, the transmitter gets a transmission opportunity
+ * of the link capacity and the receiver one for its STATUS PDUs
+ */
+static void
+Slot ()
+{
+	g_sduCredit += g_sdusPerSlot;
+	LteRlcSapProvider::TransmitPdcpPduParameters params;
+	params.rnti = 1;
+	params.lcid = 3;
+	while (g_sduCredit >= 1)
+	{
+		params.pdcpPdu = Create<Packet> (g_sduSize);
+		g_tx->GetLteRlcSapProvider ()->TransmitPdcpPdu (params);
+		g_sduCredit -= 1;
+	}
+	if (g_txMac.m_report.txQueueSize + g_txMac.m_report.retxQueueSize + g_txMac.m_report.statusPduSize > 0)
+	{
+		g_tx->GetLteMacSapUser ()->NotifyTxOpportunity (g_opportunity, 0, 0);
+		g_opportunities++;
+		g_queuedSdus += g_txMac.m_report.txQueueSize / g_sduSize;
+	}
+	if (g_rxMac.m_report.statusPduSize > 0)
+	{
+		g_rx->GetLteMacSapUser ()->NotifyTxOpportunity (g_rxMac.m_report.statusPduSize, 0, 0);
+	}
+	Simulator::Schedule (g_slot, &Slot);
+}
+
+int
+main (int argc, char *argv[])
+{
+	std::string mode = "am";
+	double offeredRate = 10e9;
+	double capacity = 8e9;
+	uint32_t sduSize = 1400;
+	uint32_t bufferSize = 10 * 1024 * 1024;
+	double slotPeriod = 125e-6;
+	double simTime = 0.5;
+
+	CommandLine cmd;
+	cmd.AddValue ("mode", "RLC mode, am or um", mode);
+	cmd.AddValue ("offeredRate", "Rate offered by the PDCP source (bit/s)", offeredRate);
+	cmd.AddValue ("capacity", "Bytes of the transmission opportunities per second, times 8 (bit/s)", capacity);
+	cmd.AddValue ("sduSize", "Size of the SDUs (bytes)", sduSize);
+	cmd.AddValue ("bufferSize", "Maximum size of the transmission buffer of the RLC (bytes)", bufferSize);
+	cmd.AddValue ("slotPeriod", "Time between the transmission opportunities (s)", slotPeriod);
+	cmd.AddValue ("simTime", "Simulation time (s)", simTime);
+	cmd.Parse (argc, argv);
+
+	NS_ABORT_MSG_IF (mode != "am" && mode != "um", "Unknown RLC mode " << mode);
+	Config::SetDefault ("ns3::LteRlcAm::MaxTxBufferSize", UintegerValue (bufferSize));
+	Config::SetDefault ("ns3::LteRlcUm::MaxTxBufferSize", UintegerValue (bufferSize));
+
+	g_sduSize = sduSize;
+	g_slot = Seconds (slotPeriod);
+	g_sdusPerSlot = offeredRate * slotPeriod / 8 / sduSize;
+	g_opportunity = capacity * slotPeriod / 8;
+
+	CountingPdcp txPdcp;
+	CountingPdcp rxPdcp;
+	if (mode == "am")
+	{
+		g_tx = CreateObject<LteRlcAm> ();
+		g_rx = CreateObject<LteRlcAm> ();
+	}
+	else
+	{
+		g_tx = CreateObject<LteRlcUm> ();
+		g_rx = CreateObject<LteRlcUm> ();
+	}
+	Ptr<LteRlc> rlcs[2] = {g_tx, g_rx};
+	LoopbackMac *macs[2] = {&g_txMac, &g_rxMac};
+	CountingPdcp *pdcps[2] = {&txPdcp, &rxPdcp};
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		rlcs[i]->SetRnti (1);
+		rlcs[i]->SetLcId (3);
+		rlcs[i]->SetLteRlcSapUser (pdcps[i]);
+		rlcs[i]->SetLteMacSapProvider (macs[i]);
+		rlcs[i]->Initialize ();
+		macs[i]->m_delay = g_slot;
+	}
+	g_txMac.m_peer = g_rx->GetLteMacSapUser ();
+	g_rxMac.m_peer = g_tx->GetLteMacSapUser ();
+
+	Simulator::Schedule (g_slot, &Slot);
+	Simulator::Stop (Seconds (simTime));
+	SystemWallClockMs clock;
+	clock.Start ();
+	Simulator::Run ();
+	int64_t ms = clock.End ();
+
+	std::cout << "RLC " << mode << ", offered " << offeredRate / 1e9 << " Gbps, capacity " << capacity / 1e9
+			<< " Gbps, " << sduSize << " byte SDUs" << std::endl;
+	std::cout << "  " << g_opportunities << " transmission opportunities, "
+			<< (g_opportunities > 0 ? g_queuedSdus / g_opportunities : 0) << " SDUs queued on average" << std::endl;
+	std::cout << "  transmitted " << g_txMac.m_txPdus << " PDUs, " << g_txMac.m_txBytes * 8 / simTime / 1e9
+			<< " Gbps, delivered " << rxPdcp.m_rxSdus << " SDUs, " << rxPdcp.m_rxBytes * 8 / simTime / 1e9 << " Gbps" << std::endl;
+	std::cout << "  " << ms << " ms";
+	if (g_opportunities > 0)
+	{
+		std::cout << ", " << 1e3 * ms / g_opportunities << " us per transmission opportunity";
+	}
+	std::cout << std::endl;
+
+	Simulator::Destroy ();
+	g_tx = 0;
+	g_rx = 0;
+	return 0;
+}
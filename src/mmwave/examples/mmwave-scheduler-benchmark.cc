@@ -0,0 +1,214 @@
+/*
+ * mmwave-scheduler-benchmark.cc
+ *
+ *  Replays event traces through every event scheduler of the simulator, checks that they
+ *  dequeue the events in the same order and compares their time. The traces are the DES
+ *  Metrics event traces (see DesMetrics) of the mmWave examples, captured with a build
+ *  configured with --enable-des-metrics, e.g.
+ *
+ *  ./waf --run "mmwave-tcp-multi-ue --simTime=3"
+ *  ./waf --run "mmwave-epc-tdma --simTime=5 --symPerSf=112 --sfPeriod=1000"
+ *  ./waf --run "mmwave-scheduler-benchmark --traces=mmwave-tcp-multi-ue.json,mmwave-epc-tdma.json"
+ *
+ *  Without traces, a synthetic trace of slot-periodic devices is generated.
+ */
+
+#include "ns3/core-module.h"
+#include <ns3/system-wall-clock-ms.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * An event of a trace: the time it is scheduled at and the time it expires, in time steps
+ */
+struct TraceEvent
+{
+	uint64_t m_send;
+	uint64_t m_exec;
+};
+
+/*
+ * @brief Read the events of a DES Metrics trace, ["sendCtx","sendTime","recvCtx","recvTime"] records
+ */
+static void
+ReadTrace (std::string fileName, std::vector<TraceEvent> &trace)
+{
+	std::ifstream file (fileName.c_str ());
+	NS_ABORT_MSG_IF (!file.is_open (), "Could not open the trace " << fileName);
+	std::string line;
+	while (std::getline (file, line))
+	{
+		if (line.find ('[') == std::string::npos || line.find (':') != std::string::npos)
+		{
+			continue;
+		}
+		std::replace (line.begin (), line.end (), '[', ' ');
+		std::replace (line.begin (), line.end (), ']', ' ');
+		std::replace (line.begin (), line.end (), '"', ' ');
+		std::replace (line.begin (), line.end (), ',', ' ');
+		std::istringstream fields (line);
+		int64_t sendContext, recvContext;
+		TraceEvent ev;
+		if (fields >> sendContext >> ev.m_send >> recvContext >> ev.m_exec)
+		{
+			trace.push_back (ev);
+		}
+	}
+}
+
+/*
+ * @brief Events of devices that start a slot every slotPeriod. Each slot schedules the next
+ * one, the symbols of the slot and, at random, an event a few slots later (HARQ, packets)
+ * and an event for the current time step
+ */
+static void
+GenerateSlotTrace (uint32_t devices, uint32_t slots, std::vector<TraceEvent> &trace)
+{
+	const uint64_t slotPeriod = 125000;
+	const uint32_t symbols = 14;
+	Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+	for (uint32_t slot = 0; slot < slots; slot++)
+	{
+		uint64_t now = slot * slotPeriod;
+		for (uint32_t d = 0; d < devices; d++)
+		{
+			TraceEvent ev;
+			ev.m_send = now;
+			ev.m_exec = now + slotPeriod;
+			trace.push_back (ev);
+			for (uint32_t s = 1; s < symbols; s++)
+			{
+				ev.m_exec = now + s * slotPeriod / symbols;
+				trace.push_back (ev);
+			}
+			if (random->GetValue () < 0.5)
+			{
+				ev.m_exec = now + random->GetInteger (1, 8) * slotPeriod + random->GetInteger (0, symbols - 1) * slotPeriod / symbols;
+				trace.push_back (ev);
+			}
+			if (random->GetValue () < 0.2)
+			{
+				ev.m_exec = now;
+				trace.push_back (ev);
+			}
+		}
+	}
+}
+
+/*
+ * @brief Replay a trace: the events expiring before the time an event is scheduled at are
+ * dequeued first. Returns a hash of the order of the dequeued events
+ */
+static uint64_t
+Replay (Ptr<Scheduler> scheduler, const std::vector<TraceEvent> &trace)
+{
+	uint64_t hash = 0;
+	Scheduler::Event ev;
+	ev.impl = 0;
+	ev.key.m_context = 0;
+	for (uint32_t i = 0; i < trace.size (); i++)
+	{
+		while (!scheduler->IsEmpty () && scheduler->PeekNext ().key.m_ts < trace[i].m_send)
+		{
+			hash = hash * 1000003 + scheduler->RemoveNext ().key.m_uid;
+		}
+		ev.key.m_ts = trace[i].m_exec;
+		ev.key.m_uid = i;
+		scheduler->Insert (ev);
+	}
+	while (!scheduler->IsEmpty ())
+	{
+		hash = hash * 1000003 + scheduler->RemoveNext ().key.m_uid;
+	}
+	return hash;
+}
+
+int
+main (int argc, char *argv[])
+{
+	std::string traces = "";
+	std::string schedulers = "ns3::MapScheduler,ns3::HeapScheduler,ns3::ListScheduler,ns3::CalendarScheduler,ns3::LadderScheduler";
+	uint32_t devices = 16;
+	uint32_t slots = 20000;
+	uint32_t runs = 3;
+
+	CommandLine cmd;
+	cmd.AddValue ("traces", "Comma-separated DES Metrics event traces, a synthetic trace if empty", traces);
+	cmd.AddValue ("schedulers", "Comma-separated schedulers, the first one is the reference", schedulers);
+	cmd.AddValue ("devices", "Devices of the synthetic trace", devices);
+	cmd.AddValue ("slots", "Slots of the synthetic trace", slots);
+	cmd.AddValue ("runs", "Replays of each trace per scheduler", runs);
+	cmd.Parse (argc, argv);
+
+	std::vector<std::string> traceNames;
+	std::vector<std::string> schedulerNames;
+	std::string name;
+	std::istringstream traceList (traces);
+	while (std::getline (traceList, name, ','))
+	{
+		traceNames.push_back (name);
+	}
+	if (traceNames.empty ())
+	{
+		traceNames.push_back ("");
+	}
+	std::istringstream schedulerList (schedulers);
+	while (std::getline (schedulerList, name, ','))
+	{
+		schedulerNames.push_back (name);
+	}
+
+	uint32_t mismatches = 0;
+	for (uint32_t t = 0; t < traceNames.size (); t++)
+	{
+		std::vector<TraceEvent> trace;
+		if (traceNames[t].empty ())
+		{
+			GenerateSlotTrace (devices, slots, trace);
+			std::cout << "synthetic trace, " << devices << " devices, " << slots << " slots: ";
+		}
+		else
+		{
+			ReadTrace (traceNames[t], trace);
+			std::cout << traceNames[t] << ": ";
+		}
+		std::cout << trace.size () << " events" << std::endl;
+
+		uint64_t referenceHash = 0;
+		int64_t referenceMs = 0;
+		for (uint32_t s = 0; s < schedulerNames.size (); s++)
+		{
+			ObjectFactory factory (schedulerNames[s]);
+			uint64_t hash = 0;
+			SystemWallClockMs clock;
+			clock.Start ();
+			for (uint32_t r = 0; r < runs; r++)
+			{
+				hash = Replay (factory.Create<Scheduler> (), trace);
+			}
+			int64_t ms = clock.End ();
+			if (s == 0)
+			{
+				referenceHash = hash;
+				referenceMs = ms;
+			}
+			mismatches += (hash != referenceHash);
+			std::cout << "  " << schedulerNames[s] << ": " << ms << " ms";
+			if (ms > 0)
+			{
+				std::cout << ", " << (double) trace.size () * runs / ms / 1000 << " Mevents/s, "
+						<< (double) referenceMs / ms << "x";
+			}
+			std::cout << (hash != referenceHash ? ", DIFFERENT ORDER" : "") << std::endl;
+		}
+	}
+	NS_ABORT_MSG_IF (mismatches > 0, "The schedulers dequeued the events in a different order");
+
+	Simulator::Destroy ();
+	return 0;
+}
@@ -63,7 +63,12 @@ MmWaveHelper::MmWaveHelper(void)
 	 m_noRxAntenna (16),
 	 m_harqEnabled (false),
 	 m_rlcAmEnabled (false),
-	 m_snrTest (false)
+	 m_snrTest (false),
+	 m_trackingListStrategy (2),
+	 m_numMaxBeamPairsToMonitor (20),
+	 m_memory (true),
+	 m_alpha (2),
+	 m_beta (4)
 {
 	NS_LOG_FUNCTION(this);
 	m_channelFactory.SetTypeId (MultiModelSpectrumChannel::GetTypeId ());
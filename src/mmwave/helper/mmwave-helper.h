@@ -226,7 +226,8 @@ private:
   	MmWavePhyMacCommon::CsiReportingPeriod m_csiResourcePeriodicity;
   	MmWavePhyMacCommon::CsiReportingPeriod m_beamReportingPeriodicity;
 
-  	// Parameters to configure the list of candidate beams to be used for beam tracking.
+  	// Parameters to configure the list of candidate beams to be used for beam tracking,
+  	// by default those of MmWaveBeamManagement.
   	uint8_t m_trackingListStrategy;
   	uint16_t m_numMaxBeamPairsToMonitor;	// Max number of beam pairs to monitor
   	bool m_memory;	// If all SSB beam measurement combinations must be stored
@@ -30,7 +30,11 @@
 #include <ns3/log.h>
 #include "mmwave-phy-rx-trace.h"
 #include <ns3/simulator.h>
+#include <ns3/boolean.h>
+#include <ns3/uinteger.h>
+#include <ns3/abort.h>
 #include <stdio.h>
+#include <cstring>
 
 namespace ns3 {
 
@@ -38,19 +42,50 @@ NS_LOG_COMPONENT_DEFINE ("MmWavePhyRxTrace");
 
 NS_OBJECT_ENSURE_REGISTERED (MmWavePhyRxTrace);
 
-std::ofstream MmWavePhyRxTrace::m_rxPacketTraceFile;
-std::string MmWavePhyRxTrace::m_rxPacketTraceFilename;
+/*
+ * @brief Names of the files of the TraceFile enum, without extension
+ */
+static const char *TRACE_FILE_NAMES[] = {"UE_%llu_SINR_dB", "UE_%llu_UL_SINR_dB", "UE_%llu_ReceivedPower_dB",
+		"UE_%llu_Packet_Trace", "BS_%llu_Packet_Trace", "UE_%llu_Tb_Size"};
+
+/*
+ * @brief Append a field of a binary record
+ */
+template <class T>
+static void
+WriteField (Ptr<MmWaveTraceSink> sink, T value)
+{
+	sink->Write (&value, sizeof (T));
+}
+
+/*
+ * @brief Read a field of a binary record, false at the end of the file
+ */
+template <class T>
+static bool
+ReadField (std::istream &is, T &value)
+{
+	is.read ((char *) &value, sizeof (T));
+	return is.good ();
+}
 
 MmWavePhyRxTrace::MmWavePhyRxTrace()
+	: m_binary (false),
+	  m_bufferSize (1 << 20)
 {
 }
 
 MmWavePhyRxTrace::~MmWavePhyRxTrace()
 {
-	if (m_rxPacketTraceFile.is_open ())
-	{
-		m_rxPacketTraceFile.close ();
-	}
+}
+
+void
+MmWavePhyRxTrace::DoDispose (void)
+{
+	// the sinks are flushed and closed by Simulator::Destroy
+	m_rxPacketTraceSink = 0;
+	m_sinks.clear ();
+	Object::DoDispose ();
 }
 
 TypeId
@@ -59,10 +94,42 @@ MmWavePhyRxTrace::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::MmWavePhyRxTrace")
     .SetParent<Object> ()
     .AddConstructor<MmWavePhyRxTrace> ()
+    .AddAttribute ("BinaryFormat",
+                   "Write the traces as binary records to .bin files, see ConvertBinaryFile",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MmWavePhyRxTrace::m_binary),
+                   MakeBooleanChecker ())
+    .AddAttribute ("BufferSize",
+                   "Size in bytes of the write buffer of each trace file",
+                   UintegerValue (1 << 20),
+                   MakeUintegerAccessor (&MmWavePhyRxTrace::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlushInterval",
+                   "Simulation time after which the buffer of a trace file is written, 0 to write it only when it is full",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&MmWavePhyRxTrace::m_flushInterval),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
 
+Ptr<MmWaveTraceSink>
+MmWavePhyRxTrace::GetSink (TraceFile file, uint64_t id)
+{
+	std::pair<TraceFile, uint64_t> key (file, id);
+	std::map<std::pair<TraceFile, uint64_t>, Ptr<MmWaveTraceSink> >::iterator it = m_sinks.find (key);
+	if (it != m_sinks.end ())
+	{
+		return it->second;
+	}
+	char fname[255];
+	sprintf (fname, TRACE_FILE_NAMES[file], (long long unsigned) id);
+	strcat (fname, m_binary ? ".bin" : ".txt");
+	Ptr<MmWaveTraceSink> sink = MmWaveTraceSink::Open (fname, true, m_binary, m_bufferSize, m_flushInterval);
+	m_sinks[key] = sink;
+	return sink;
+}
+
 void
 MmWavePhyRxTrace::ReportCurrentCellRsrpSinrCallback (Ptr<MmWavePhyRxTrace> phyStats, std::string path,
 																uint64_t imsi, SpectrumValue& sinr, SpectrumValue& power)
@@ -77,66 +144,60 @@ MmWavePhyRxTrace::UlSinrTraceCallback (Ptr<MmWavePhyRxTrace> phyStats, std::stri
 																uint64_t imsi, SpectrumValue& sinr, SpectrumValue& power)
 {
 	NS_LOG_INFO ("UE"<<imsi<<"->Generate UlSinrTrace");
-	uint64_t slot_count = Now().GetMicroSeconds ()/125;
-	uint32_t rb_count = 1;
-	FILE* log_file;
-	char fname[255];
-	sprintf(fname, "UE_%llu_UL_SINR_dB.txt", (long long unsigned ) imsi);
-	log_file = fopen(fname, "a");
-	Values::iterator it = sinr.ValuesBegin();
-	while(it!=sinr.ValuesEnd())
-	{
-		//fprintf(log_file, "%d\t%d\t%f\t \n", slot_count/2, rb_count, 10*log10(*it));
-		fprintf(log_file, "%llu\t%llu\t%d\t%f\t \n",(long long unsigned )slot_count/8+1, (long long unsigned )slot_count%8+1, rb_count, 10*log10(*it));
-		rb_count++;
-		it++;
-	}
-	fflush(log_file);
-	fclose(log_file);
+	phyStats->ReportUlSinrTrace (imsi, sinr);
 	//phyStats->ReportInterferenceTrace (imsi, sinr);
 	//phyStats->ReportPowerTrace (imsi, power);
 }
 
+void
+MmWavePhyRxTrace::ReportUlSinrTrace (uint64_t imsi, SpectrumValue& sinr)
+{
+	WriteSpectrum (GetSink (UE_UL_SINR, imsi), Now().GetMicroSeconds ()/125, sinr);
+}
+
 void
 MmWavePhyRxTrace::ReportInterferenceTrace (uint64_t imsi, SpectrumValue& sinr)
 {
-	uint64_t slot_count = Now().GetMicroSeconds ()/125;
-	uint32_t rb_count = 1;
-	FILE* log_file;
-	char fname[255];
-	sprintf(fname, "UE_%llu_SINR_dB.txt", (long long unsigned ) imsi);
-	log_file = fopen(fname, "a");
-	Values::iterator it = sinr.ValuesBegin();
-	while(it!=sinr.ValuesEnd())
-	{
-		//fprintf(log_file, "%d\t%d\t%f\t \n", slot_count/2, rb_count, 10*log10(*it));
-		fprintf(log_file, "%llu\t%llu\t%d\t%f\t \n",(long long unsigned) slot_count/8+1, (long long unsigned) slot_count%8+1, rb_count, 10*log10(*it));
-		rb_count++;
-		it++;
-	}
-	fflush(log_file);
-	fclose(log_file);
+	WriteSpectrum (GetSink (UE_SINR, imsi), Now().GetMicroSeconds ()/125, sinr);
 }
 
 void
 MmWavePhyRxTrace::ReportPowerTrace (uint64_t imsi, SpectrumValue& power)
 {
+	WriteSpectrum (GetSink (UE_POWER, imsi), Now().GetMicroSeconds ()/125, power);
+}
 
-	uint32_t slot_count = Now().GetMicroSeconds ()/125;
-	uint32_t rb_count = 1;
-	FILE* log_file;
-	char fname[255];
-	printf (fname, "UE_%llu_ReceivedPower_dB.txt", (long long unsigned) imsi);
-	log_file = fopen(fname, "a");
-	Values::iterator it = power.ValuesBegin();
-	while(it!=power.ValuesEnd())
+void
+MmWavePhyRxTrace::WriteSpectrum (Ptr<MmWaveTraceSink> sink, uint64_t slotCount, const SpectrumValue& values)
+{
+	if (m_binary)
 	{
-		fprintf(log_file, "%llu\t%llu\t%d\t%f\t \n",(long long unsigned) slot_count/8+1,(long long unsigned) slot_count%8+1, rb_count, 10*log10(*it));
-		rb_count++;
-		it++;
+		WriteField<uint8_t> (sink, SPECTRUM);
+		WriteField<uint64_t> (sink, slotCount);
+		WriteField<uint32_t> (sink, values.GetSpectrumModel ()->GetNumBands ());
+		for (Values::const_iterator it = values.ConstValuesBegin (); it != values.ConstValuesEnd (); it++)
+		{
+			WriteField<double> (sink, *it);
+		}
 	}
-	fflush(log_file);
-	fclose(log_file);
+	else
+	{
+		uint32_t rb_count = 1;
+		for (Values::const_iterator it = values.ConstValuesBegin (); it != values.ConstValuesEnd (); it++)
+		{
+			WriteSpectrumText (sink->GetStream (), slotCount, rb_count++, *it);
+		}
+	}
+	sink->EndRecord ();
+}
+
+void
+MmWavePhyRxTrace::WriteSpectrumText (std::ostream &os, uint64_t slotCount, uint32_t rb, double value)
+{
+	char line[128];
+	int length = snprintf (line, sizeof (line), "%llu\t%llu\t%d\t%f\t \n",(long long unsigned) slotCount/8+1,
+			(long long unsigned) slotCount%8+1, rb, 10*log10(value));
+	os.write (line, length);
 }
 
 void
@@ -164,75 +225,73 @@ MmWavePhyRxTrace::ReportDownLinkTBSize (Ptr<MmWavePhyRxTrace> phyStats, std::str
 void
 MmWavePhyRxTrace::ReportPacketCountUe (UePhyPacketCountParameter param)
 {
-	FILE* log_file;
-	char fname[255];
-	sprintf (fname,"UE_%llu_Packet_Trace.txt", (long long unsigned) param.m_imsi);
-	log_file = fopen (fname, "a");
-	if (param.m_isTx)
+	WritePacketCount (GetSink (UE_PACKET_COUNT, param.m_imsi), param.m_subframeno,
+			param.m_isTx ? param.m_noBytes : 0, param.m_isTx ? 0 : param.m_noBytes);
+}
+
+void
+MmWavePhyRxTrace::ReportPacketCountEnb (EnbPhyPacketCountParameter param)
+{
+	WritePacketCount (GetSink (BS_PACKET_COUNT, param.m_cellId), param.m_subframeno,
+			param.m_isTx ? param.m_noBytes : 0, param.m_isTx ? 0 : param.m_noBytes);
+}
+
+void
+MmWavePhyRxTrace::WritePacketCount (Ptr<MmWaveTraceSink> sink, uint32_t subframe, uint32_t txBytes, uint32_t rxBytes)
+{
+	if (m_binary)
 	{
-		fprintf (log_file, "%d\t%d\t%d\n", param.m_subframeno, param.m_noBytes, 0);
+		WriteField<uint8_t> (sink, PACKET_COUNT);
+		WriteField<uint32_t> (sink, subframe);
+		WriteField<uint32_t> (sink, txBytes);
+		WriteField<uint32_t> (sink, rxBytes);
 	}
 	else
 	{
-		fprintf (log_file, "%d\t%d\t%d\n", param.m_subframeno, 0, param.m_noBytes);
+		WritePacketCountText (sink->GetStream (), subframe, txBytes, rxBytes);
 	}
+	sink->EndRecord ();
+}
 
-	fflush(log_file);
-	fclose(log_file);
-
+void
+MmWavePhyRxTrace::WritePacketCountText (std::ostream &os, uint32_t subframe, uint32_t txBytes, uint32_t rxBytes)
+{
+	char line[64];
+	int length = snprintf (line, sizeof (line), "%d\t%d\t%d\n", subframe, txBytes, rxBytes);
+	os.write (line, length);
 }
 
 void
-MmWavePhyRxTrace::ReportPacketCountEnb (EnbPhyPacketCountParameter param)
+MmWavePhyRxTrace::ReportDLTbSize (uint64_t imsi, uint64_t tbSize)
 {
-	FILE* log_file;
-	char fname[255];
-	sprintf (fname,"BS_%llu_Packet_Trace.txt",(long long unsigned) param.m_cellId);
-	log_file = fopen (fname, "a");
-	if (param.m_isTx)
+	Ptr<MmWaveTraceSink> sink = GetSink (UE_TB_SIZE, imsi);
+	if (m_binary)
 	{
-		fprintf (log_file, "%d\t%d\t%d\n", param.m_subframeno, param.m_noBytes, 0);
+		WriteField<uint8_t> (sink, TB_SIZE);
+		WriteField<int64_t> (sink, Now().GetMicroSeconds ());
+		WriteField<uint64_t> (sink, tbSize);
 	}
 	else
 	{
-		fprintf (log_file, "%d\t%d\t%d\n", param.m_subframeno, 0, param.m_noBytes);
+		WriteTbSizeText (sink->GetStream (), Now().GetMicroSeconds (), tbSize);
 	}
-
-	fflush(log_file);
-	fclose(log_file);
+	sink->EndRecord ();
 }
 
 void
-MmWavePhyRxTrace::ReportDLTbSize (uint64_t imsi, uint64_t tbSize)
+MmWavePhyRxTrace::WriteTbSizeText (std::ostream &os, int64_t timeUs, uint64_t tbSize)
 {
-	FILE* log_file;
-	char fname[255];
-	sprintf (fname,"UE_%llu_Tb_Size.txt", (long long unsigned) imsi);
-	log_file = fopen (fname, "a");
-
-	fprintf (log_file, "%llu \t %llu\n", (long long unsigned )Now().GetMicroSeconds (), (long long unsigned )tbSize);
-	fprintf (log_file, "%lld \t %llu \n",(long long int) Now().GetMicroSeconds (), (long long unsigned) tbSize);
-	fflush(log_file);
-	fclose(log_file);
+	char line[128];
+	int length = snprintf (line, sizeof (line), "%llu \t %llu\n", (long long unsigned) timeUs, (long long unsigned) tbSize);
+	os.write (line, length);
+	length = snprintf (line, sizeof (line), "%lld \t %llu \n", (long long int) timeUs, (long long unsigned) tbSize);
+	os.write (line, length);
 }
 
 void
 MmWavePhyRxTrace::RxPacketTraceUeCallback (Ptr<MmWavePhyRxTrace> phyStats, std::string path, RxPacketTraceParams params)
 {
-	if (!m_rxPacketTraceFile.is_open())
-	{
-		m_rxPacketTraceFilename = "RxPacketTraceUe.txt";
-		m_rxPacketTraceFile.open(m_rxPacketTraceFilename.c_str ());
-		m_rxPacketTraceFile << "\tframe\tsubF\t1stSym\tsymbol#\tcellId\trnti\ttbSize\tmcs\trv\tSINR(dB)\tcorrupt\tTBler" << std::endl;
-		if (!m_rxPacketTraceFile.is_open())
-		{
-			NS_FATAL_ERROR ("Could not open tracefile");
-		}
-	}
-	m_rxPacketTraceFile << "DL\t" << params.m_frameNum << "\t" << (unsigned)params.m_sfNum << "\t" << (unsigned)params.m_symStart
-			<< "\t" << (unsigned)params.m_numSym << "\t" << params.m_cellId
-			<< "\t" << params.m_rnti << "\t" << params.m_tbSize << "\t" << (unsigned)params.m_mcs << "\t" << (unsigned)params.m_rv << "\t"
-			<< 10*log10(params.m_sinr) << "\t\t" << params.m_corrupt <<"\t" << params.m_tbler << std::endl;
+	phyStats->ReportRxPacketTrace ("RxPacketTraceUe", true, params);
 
 	if (params.m_corrupt)
 	{
@@ -245,21 +304,7 @@ MmWavePhyRxTrace::RxPacketTraceUeCallback (Ptr<MmWavePhyRxTrace> phyStats, std::
 void
 MmWavePhyRxTrace::RxPacketTraceEnbCallback (Ptr<MmWavePhyRxTrace> phyStats, std::string path, RxPacketTraceParams params)
 {
-	if (!m_rxPacketTraceFile.is_open())
-	{
-		m_rxPacketTraceFilename = "RxPacketTraceEnb.txt";
-		m_rxPacketTraceFile.open(m_rxPacketTraceFilename.c_str ());
-		m_rxPacketTraceFile << "\tframe\tsubF\t1stSym\tsymbol#\tcellId\trnti\ttbSize\tmcs\trv\tSINR(dB)\tcorrupt\tTBler" << std::endl;
-
-		if (!m_rxPacketTraceFile.is_open())
-		{
-			NS_FATAL_ERROR ("Could not open tracefile");
-		}
-	}
-	m_rxPacketTraceFile << "UL\t" << params.m_frameNum << "\t" << (unsigned)params.m_sfNum << "\t" << (unsigned)params.m_symStart
-				<< "\t" << (unsigned)params.m_numSym << "\t" << params.m_cellId
-				<< "\t" << params.m_rnti << "\t" << params.m_tbSize << "\t" << (unsigned)params.m_mcs << "\t" << (unsigned)params.m_rv << "\t"
-				<< 10*log10(params.m_sinr) << "\t\t" << params.m_corrupt <<" \t" << params.m_tbler << std::endl;
+	phyStats->ReportRxPacketTrace ("RxPacketTraceEnb", false, params);
 
 		if (params.m_corrupt)
 		{
@@ -270,4 +315,143 @@ MmWavePhyRxTrace::RxPacketTraceEnbCallback (Ptr<MmWavePhyRxTrace> phyStats, std:
 		}
 }
 
+void
+MmWavePhyRxTrace::ReportRxPacketTrace (std::string filename, bool downlink, const RxPacketTraceParams &params)
+{
+	// the DL and UL TBs go to the file of the first trace received
+	if (m_rxPacketTraceSink == 0)
+	{
+		m_rxPacketTraceSink = MmWaveTraceSink::Open (filename + (m_binary ? ".bin" : ".txt"), false, m_binary, m_bufferSize, m_flushInterval);
+		if (m_binary)
+		{
+			WriteField<uint8_t> (m_rxPacketTraceSink, RX_PACKET_HEADER);
+		}
+		else
+		{
+			WriteRxPacketTraceHeader (m_rxPacketTraceSink->GetStream ());
+		}
+	}
+	if (m_binary)
+	{
+		WriteField<uint8_t> (m_rxPacketTraceSink, downlink ? RX_PACKET_DL : RX_PACKET_UL);
+		WriteField<uint64_t> (m_rxPacketTraceSink, params.m_cellId);
+		WriteField<uint16_t> (m_rxPacketTraceSink, params.m_rnti);
+		WriteField<uint32_t> (m_rxPacketTraceSink, params.m_frameNum);
+		WriteField<uint8_t> (m_rxPacketTraceSink, params.m_sfNum);
+		WriteField<uint8_t> (m_rxPacketTraceSink, params.m_symStart);
+		WriteField<uint8_t> (m_rxPacketTraceSink, params.m_numSym);
+		WriteField<uint32_t> (m_rxPacketTraceSink, params.m_tbSize);
+		WriteField<uint8_t> (m_rxPacketTraceSink, params.m_mcs);
+		WriteField<uint8_t> (m_rxPacketTraceSink, params.m_rv);
+		WriteField<double> (m_rxPacketTraceSink, params.m_sinr);
+		WriteField<double> (m_rxPacketTraceSink, params.m_tbler);
+		WriteField<uint8_t> (m_rxPacketTraceSink, params.m_corrupt);
+	}
+	else
+	{
+		WriteRxPacketTraceText (m_rxPacketTraceSink->GetStream (), downlink, params);
+	}
+	m_rxPacketTraceSink->EndRecord ();
+}
+
+void
+MmWavePhyRxTrace::WriteRxPacketTraceHeader (std::ostream &os)
+{
+	os << "\tframe\tsubF\t1stSym\tsymbol#\tcellId\trnti\ttbSize\tmcs\trv\tSINR(dB)\tcorrupt\tTBler\n";
+}
+
+void
+MmWavePhyRxTrace::WriteRxPacketTraceText (std::ostream &os, bool downlink, const RxPacketTraceParams &params)
+{
+	os << (downlink ? "DL\t" : "UL\t") << params.m_frameNum << "\t" << (unsigned)params.m_sfNum << "\t" << (unsigned)params.m_symStart
+			<< "\t" << (unsigned)params.m_numSym << "\t" << params.m_cellId
+			<< "\t" << params.m_rnti << "\t" << params.m_tbSize << "\t" << (unsigned)params.m_mcs << "\t" << (unsigned)params.m_rv << "\t"
+			<< 10*log10(params.m_sinr) << "\t\t" << params.m_corrupt << (downlink ? "\t" : " \t") << params.m_tbler << "\n";
+}
+
+uint64_t
+MmWavePhyRxTrace::ConvertBinaryFile (std::string input, std::string output)
+{
+	std::ifstream in (input.c_str (), std::ifstream::binary);
+	NS_ABORT_MSG_IF (!in.good (), "Unable to open " << input);
+	char magic[sizeof (MmWaveTraceSink::MAGIC)];
+	in.read (magic, sizeof (magic));
+	NS_ABORT_MSG_IF (!in.good () || memcmp (magic, MmWaveTraceSink::MAGIC, sizeof (magic)) != 0,
+			input << " is not a binary PHY trace");
+	std::ofstream out (output.c_str (), std::ofstream::trunc);
+	NS_ABORT_MSG_IF (!out.good (), "Unable to open " << output);
+
+	uint64_t numRecords = 0;
+	uint8_t type;
+	while (ReadField (in, type))
+	{
+		bool complete = true;
+		switch (type)
+		{
+		case RX_PACKET_HEADER:
+			WriteRxPacketTraceHeader (out);
+			break;
+		case RX_PACKET_DL:
+		case RX_PACKET_UL:
+		{
+			RxPacketTraceParams params;
+			uint8_t corrupt = 0;
+			complete = ReadField (in, params.m_cellId) && ReadField (in, params.m_rnti) && ReadField (in, params.m_frameNum)
+					&& ReadField (in, params.m_sfNum) && ReadField (in, params.m_symStart) && ReadField (in, params.m_numSym)
+					&& ReadField (in, params.m_tbSize) && ReadField (in, params.m_mcs) && ReadField (in, params.m_rv)
+					&& ReadField (in, params.m_sinr) && ReadField (in, params.m_tbler) && ReadField (in, corrupt);
+			params.m_corrupt = corrupt;
+			if (complete)
+			{
+				WriteRxPacketTraceText (out, type == RX_PACKET_DL, params);
+			}
+			break;
+		}
+		case SPECTRUM:
+		{
+			uint64_t slotCount = 0;
+			uint32_t numRb = 0;
+			complete = ReadField (in, slotCount) && ReadField (in, numRb);
+			for (uint32_t rb = 1; complete && rb <= numRb; rb++)
+			{
+				double value;
+				complete = ReadField (in, value);
+				if (complete)
+				{
+					WriteSpectrumText (out, slotCount, rb, value);
+				}
+			}
+			break;
+		}
+		case PACKET_COUNT:
+		{
+			uint32_t subframe = 0, txBytes = 0, rxBytes = 0;
+			complete = ReadField (in, subframe) && ReadField (in, txBytes) && ReadField (in, rxBytes);
+			if (complete)
+			{
+				WritePacketCountText (out, subframe, txBytes, rxBytes);
+			}
+			break;
+		}
+		case TB_SIZE:
+		{
+			int64_t timeUs = 0;
+			uint64_t tbSize = 0;
+			complete = ReadField (in, timeUs) && ReadField (in, tbSize);
+			if (complete)
+			{
+				WriteTbSizeText (out, timeUs, tbSize);
+			}
+			break;
+		}
+		default:
+			NS_FATAL_ERROR ("Unknown record type " << (unsigned) type << " in " << input);
+		}
+		NS_ABORT_MSG_IF (!complete, "Truncated record " << numRecords << " in " << input);
+		numRecords++;
+	}
+	NS_ABORT_MSG_IF (!out.good (), "Unable to write " << output);
+	return numRecords;
+}
+
 } /* namespace ns3 */
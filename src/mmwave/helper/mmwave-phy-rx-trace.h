@@ -29,13 +29,25 @@
 #ifndef SRC_MMWAVE_HELPER_MMWAVE_PHY_RX_TRACE_H_
 #define SRC_MMWAVE_HELPER_MMWAVE_PHY_RX_TRACE_H_
 #include <ns3/object.h>
+#include <ns3/nstime.h>
 #include <ns3/spectrum-value.h>
 #include <ns3/mmwave-phy-mac-common.h>
+#include "mmwave-trace-sink.h"
 #include <fstream>
 #include <iostream>
+#include <map>
 
 namespace ns3 {
 
+/**
+ * \brief Writes the PHY traces. Every output file is a MmWaveTraceSink that stays open and
+ * buffered for the whole run, instead of being opened for every event.
+ *
+ * With the BinaryFormat attribute the traces are written as binary records to files with the
+ * .bin extension instead of .txt: the MmWaveTraceSink::MAGIC string followed by records made of
+ * a RecordType byte and the fields of the trace, in host byte order. ConvertBinaryFile (or the
+ * mmwave-phy-trace-converter program) writes them in the text format.
+ */
 class MmWavePhyRxTrace : public Object
 {
 public:
@@ -55,15 +67,65 @@ public:
 	static void RxPacketTraceUeCallback (Ptr<MmWavePhyRxTrace> phyStats, std::string path, RxPacketTraceParams param);
 	static void RxPacketTraceEnbCallback (Ptr<MmWavePhyRxTrace> phyStats, std::string path, RxPacketTraceParams param);
 
+	/**
+	 * Convert a binary trace to the text format
+	 * @params the path of the binary trace
+	 * @params the path of the text trace
+	 * @returns the number of records converted
+	 */
+	static uint64_t ConvertBinaryFile (std::string input, std::string output);
+
+	enum RecordType
+	{
+		RX_PACKET_HEADER = 1,	// header line of the RxPacketTrace file
+		RX_PACKET_DL,			// RxPacketTraceParams of a DL TB
+		RX_PACKET_UL,			// RxPacketTraceParams of an UL TB
+		SPECTRUM,				// slot count and the linear values of the RBs (SINR or power traces)
+		PACKET_COUNT,			// subframe, tx bytes and rx bytes
+		TB_SIZE					// time in microseconds and TB size
+	};
+
+protected:
+	virtual void DoDispose (void);
+
 private:
+	enum TraceFile
+	{
+		UE_SINR,
+		UE_UL_SINR,
+		UE_POWER,
+		UE_PACKET_COUNT,
+		BS_PACKET_COUNT,
+		UE_TB_SIZE
+	};
+
 	void ReportInterferenceTrace (uint64_t imsi, SpectrumValue& sinr);
+	void ReportUlSinrTrace (uint64_t imsi, SpectrumValue& sinr);
 	void ReportPowerTrace (uint64_t imsi, SpectrumValue& power);
 	void ReportPacketCountUe (UePhyPacketCountParameter param);
 	void ReportPacketCountEnb (EnbPhyPacketCountParameter param);
 	void ReportDLTbSize (uint64_t imsi, uint64_t tbSize);
+	void ReportRxPacketTrace (std::string filename, bool downlink, const RxPacketTraceParams &params);
+
+	/**
+	 * @returns the sink of the file of a trace of a UE or BS, opened in append mode
+	 */
+	Ptr<MmWaveTraceSink> GetSink (TraceFile file, uint64_t id);
+
+	void WriteSpectrum (Ptr<MmWaveTraceSink> sink, uint64_t slotCount, const SpectrumValue& values);
+	void WritePacketCount (Ptr<MmWaveTraceSink> sink, uint32_t subframe, uint32_t txBytes, uint32_t rxBytes);
+
+	static void WriteRxPacketTraceHeader (std::ostream &os);
+	static void WriteRxPacketTraceText (std::ostream &os, bool downlink, const RxPacketTraceParams &params);
+	static void WriteSpectrumText (std::ostream &os, uint64_t slotCount, uint32_t rb, double value);
+	static void WritePacketCountText (std::ostream &os, uint32_t subframe, uint32_t txBytes, uint32_t rxBytes);
+	static void WriteTbSizeText (std::ostream &os, int64_t timeUs, uint64_t tbSize);
 
-	static std::ofstream m_rxPacketTraceFile;
-	static std::string m_rxPacketTraceFilename;
+	bool m_binary;
+	uint32_t m_bufferSize;
+	Time m_flushInterval;
+	Ptr<MmWaveTraceSink> m_rxPacketTraceSink;	// shared by the DL and UL RxPacketTrace
+	std::map<std::pair<TraceFile, uint64_t>, Ptr<MmWaveTraceSink> > m_sinks;
 };
 
 } /* namespace ns3 */
@@ -0,0 +1,164 @@
+/*
+ * mmwave-trace-sink.cc
+ *
+ *  Buffered output file of the PHY traces, kept open for the whole run and
+ *  shared by all the writers of the same path.
+ */
+
+#include "mmwave-trace-sink.h"
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <ns3/fatal-error.h>
+#include <ns3/simulator.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveTraceSink");
+
+const char MmWaveTraceSink::MAGIC[8] = {'M','M','W','P','H','Y','0','1'};
+
+/*
+ * @brief Sinks opened so far, indexed by path
+ */
+static std::map<std::string, Ptr<MmWaveTraceSink> > &
+GetSinks ()
+{
+	static std::map<std::string, Ptr<MmWaveTraceSink> > sinks;
+	return sinks;
+}
+
+Ptr<MmWaveTraceSink>
+MmWaveTraceSink::Open (std::string path, bool append, bool binary, uint32_t bufferSize, Time flushInterval)
+{
+	std::map<std::string, Ptr<MmWaveTraceSink> > &sinks = GetSinks ();
+	std::map<std::string, Ptr<MmWaveTraceSink> >::iterator it = sinks.find (path);
+	if (it != sinks.end ())
+	{
+		NS_ASSERT_MSG (it->second->IsBinary () == binary, "Trace " << path << " is already open with another format");
+		return it->second;
+	}
+	if (sinks.empty ())
+	{
+		Simulator::ScheduleDestroy (&MmWaveTraceSink::CloseAll);
+	}
+	Ptr<MmWaveTraceSink> sink = Create<MmWaveTraceSink> (path, append, binary, bufferSize, flushInterval);
+	sinks[path] = sink;
+	return sink;
+}
+
+void
+MmWaveTraceSink::CloseAll ()
+{
+	std::map<std::string, Ptr<MmWaveTraceSink> > &sinks = GetSinks ();
+	for (std::map<std::string, Ptr<MmWaveTraceSink> >::iterator it = sinks.begin (); it != sinks.end (); ++it)
+	{
+		it->second->Close ();
+	}
+	sinks.clear ();
+}
+
+MmWaveTraceSink::MmWaveTraceSink (std::string path, bool append, bool binary, uint32_t bufferSize, Time flushInterval)
+	: m_path (path),
+	  m_binary (binary),
+	  m_buffer (bufferSize),
+	  m_flushInterval (flushInterval)
+{
+	NS_LOG_FUNCTION (this << path << append << binary << bufferSize);
+	DoOpen (append);
+}
+
+MmWaveTraceSink::~MmWaveTraceSink ()
+{
+	Close ();
+}
+
+void
+MmWaveTraceSink::DoOpen (bool append)
+{
+	// the buffer has to be set before opening the file
+	if (!m_buffer.empty ())
+	{
+		m_file.rdbuf ()->pubsetbuf (&m_buffer[0], m_buffer.size ());
+	}
+	std::ios_base::openmode mode = std::ofstream::out | (append ? std::ofstream::app : std::ofstream::trunc);
+	if (m_binary)
+	{
+		mode |= std::ofstream::binary;
+	}
+	m_file.open (m_path.c_str (), mode);
+	if (!m_file.is_open ())
+	{
+		NS_FATAL_ERROR ("Could not open tracefile " << m_path);
+	}
+	if (m_binary && IsEmpty ())
+	{
+		m_file.write (MAGIC, sizeof (MAGIC));
+	}
+	m_lastFlush = Simulator::Now ();
+}
+
+std::ostream&
+MmWaveTraceSink::GetStream ()
+{
+	if (!m_file.is_open ())
+	{
+		DoOpen (true);
+	}
+	return m_file;
+}
+
+void
+MmWaveTraceSink::Write (const void *data, uint32_t size)
+{
+	GetStream ().write ((const char *) data, size);
+}
+
+void
+MmWaveTraceSink::EndRecord ()
+{
+	// a full buffer is written by the stream itself
+	if (!m_flushInterval.IsZero () && Simulator::Now () - m_lastFlush >= m_flushInterval)
+	{
+		Flush ();
+	}
+}
+
+void
+MmWaveTraceSink::Flush ()
+{
+	if (m_file.is_open ())
+	{
+		m_file.flush ();
+	}
+	m_lastFlush = Simulator::Now ();
+}
+
+void
+MmWaveTraceSink::Close ()
+{
+	if (m_file.is_open ())
+	{
+		NS_LOG_LOGIC ("Closing " << m_path);
+		m_file.close ();
+	}
+}
+
+bool
+MmWaveTraceSink::IsEmpty ()
+{
+	return GetStream ().tellp () == std::streampos (0);
+}
+
+std::string
+MmWaveTraceSink::GetPath () const
+{
+	return m_path;
+}
+
+bool
+MmWaveTraceSink::IsBinary () const
+{
+	return m_binary;
+}
+
+} // namespace ns3
@@ -0,0 +1,99 @@
+/*
+ * mmwave-trace-sink.h
+ *
+ *  Buffered output file of the PHY traces, kept open for the whole run and
+ *  shared by all the writers of the same path.
+ */
+
+#ifndef MMWAVE_TRACE_SINK_H_
+#define MMWAVE_TRACE_SINK_H_
+
+#include <ns3/simple-ref-count.h>
+#include <ns3/ptr.h>
+#include <ns3/nstime.h>
+#include <stdint.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Output file of a trace with a large write buffer. Records are appended to the buffer,
+ * which is written to the file when it is full, when the flush interval of simulation time has
+ * elapsed since the last flush, and when the simulation is destroyed.
+ *
+ * The sinks are indexed by path, so all the writers of a path share the same open file.
+ * Simulator::Destroy flushes and closes all of them; a closed sink that is written again is
+ * reopened in append mode.
+ */
+class MmWaveTraceSink : public SimpleRefCount<MmWaveTraceSink>
+{
+public:
+	/**
+	 * Returns the sink of a path, opening the file the first time the path is requested
+	 * @params the path of the output file
+	 * @params whether an existing file is appended to or truncated
+	 * @params whether records are binary, a new binary file starts with the MAGIC string
+	 * @params size of the write buffer in bytes
+	 * @params simulation time after which the buffer is flushed, 0 to flush only when it is full
+	 * @returns the shared sink, whose buffer size and flush interval are those of its first request
+	 */
+	static Ptr<MmWaveTraceSink> Open (std::string path, bool append, bool binary, uint32_t bufferSize, Time flushInterval);
+
+	/**
+	 * Flush and close all the sinks opened so far, scheduled at Simulator::Destroy
+	 */
+	static void CloseAll ();
+
+	MmWaveTraceSink (std::string path, bool append, bool binary, uint32_t bufferSize, Time flushInterval);
+	~MmWaveTraceSink ();
+
+	/**
+	 * Stream where a record is written. EndRecord must be called after every record
+	 * @returns the buffered stream of the file
+	 */
+	std::ostream& GetStream ();
+
+	/**
+	 * Append raw bytes to the buffer
+	 * @params the data
+	 * @params the number of bytes
+	 */
+	void Write (const void *data, uint32_t size);
+
+	/**
+	 * Flush the buffer if the flush interval has elapsed since the last flush
+	 */
+	void EndRecord ();
+
+	void Flush ();
+
+	void Close ();
+
+	/**
+	 * @returns true if nothing has been written to the file yet, e.g. to write a header line
+	 */
+	bool IsEmpty ();
+
+	std::string GetPath () const;
+
+	bool IsBinary () const;
+
+	static const char MAGIC[8]; // first bytes of a binary trace file.
+
+private:
+	void DoOpen (bool append);
+
+	std::string m_path;
+	bool m_binary;
+	std::ofstream m_file;
+	std::vector<char> m_buffer; // buffer of m_file.
+	Time m_lastFlush;
+	Time m_flushInterval;
+};
+
+} // namespace ns3
+
+#endif /* MMWAVE_TRACE_SINK_H_ */
@@ -30,6 +30,12 @@
 #include <ns3/simulator.h>
 #include <ns3/mobility-model.h>
 #include "ns3/double.h"
+#ifdef HAVE_PTHREAD_H
+#include <ns3/system-mutex.h>
+#endif
+#include "mmwave-codebook-loader.h"
+#include <cmath>
+#include <map>
 
 
 NS_LOG_COMPONENT_DEFINE ("AntennaArrayModel");
@@ -82,8 +88,62 @@ static const double All90DegreeBFVectorImag[2][4] = {
 };
 
 
+MmWaveSteeringTable::MmWaveSteeringTable ()
+	: m_numSectors (0),
+	  m_elevationStep (0)
+{
+}
+
+uint32_t
+MmWaveSteeringTable::GetNumBeams () const
+{
+	return m_steering.size ();
+}
+
+uint32_t
+MmWaveSteeringTable::FindBeam (uint8_t sector, double elevation) const
+{
+	if (sector >= m_numSectors || m_elevation.empty ())
+	{
+		return GetNumBeams ();
+	}
+	// index of the elevation in the grid, the elevations of the callers may be accumulated steps
+	double position = (elevation - m_elevation[0])/m_elevationStep;
+	double index = std::floor (position + 0.5);
+	if (index < 0 || index >= m_elevation.size () || std::fabs (position - index) > 1e-6)
+	{
+		return GetNumBeams ();
+	}
+	return (uint32_t)index*m_numSectors + sector;
+}
+
+/*
+ * @brief Steering tables computed so far, indexed by the geometry of the array and the elevation grid
+ */
+static std::map<std::vector<double>, Ptr<const MmWaveSteeringTable> > &
+GetSteeringTableCache ()
+{
+	static std::map<std::vector<double>, Ptr<const MmWaveSteeringTable> > cache;
+	return cache;
+}
+
+#ifdef HAVE_PTHREAD_H
+/*
+ * @brief Serializes the accesses to the steering table cache, the channel generation threads
+ * of MmWave3gppChannel may request tables concurrently
+ */
+static SystemMutex &
+GetSteeringTableMutex ()
+{
+	static SystemMutex mutex;
+	return mutex;
+}
+#endif
+
 AntennaArrayModel::AntennaArrayModel()
-	:m_minAngle (0),m_maxAngle(2*M_PI)
+	:m_minAngle (0),m_maxAngle(2*M_PI),
+	 m_minElevation (60), m_maxElevation (120), m_elevationStep (10),
+	 m_steeringBeam (0)
 {
 	m_omniTx = false;
 }
@@ -109,6 +169,21 @@ AntennaArrayModel::GetTypeId ()
 			DoubleValue (0.5),
 			MakeDoubleAccessor (&AntennaArrayModel::m_disV),
 		    MakeDoubleChecker<double> ())
+	.AddAttribute ("SteeringMinElevation",
+			"Lowest elevation of the grid of steering vectors of the beam search, in degrees",
+			DoubleValue (60),
+			MakeDoubleAccessor (&AntennaArrayModel::m_minElevation),
+		    MakeDoubleChecker<double> (0, 180))
+	.AddAttribute ("SteeringMaxElevation",
+			"Highest elevation of the grid of steering vectors of the beam search, in degrees",
+			DoubleValue (120),
+			MakeDoubleAccessor (&AntennaArrayModel::m_maxElevation),
+		    MakeDoubleChecker<double> (0, 180))
+	.AddAttribute ("SteeringElevationStep",
+			"Elevation step of the grid of steering vectors of the beam search, in degrees",
+			DoubleValue (10),
+			MakeDoubleAccessor (&AntennaArrayModel::m_elevationStep),
+		    MakeDoubleChecker<double> (0.1))
 	;
 	return tid;
 }
@@ -172,6 +247,7 @@ AntennaArrayModel::SetBeamformingVector (complexVector_t antennaWeights, Ptr<Net
 		}
 	}
 	m_beamformingVector = antennaWeights;
+	m_steeringTable = 0;
 }
 
 void
@@ -181,6 +257,7 @@ AntennaArrayModel::ChangeBeamformingVector (Ptr<NetDevice> device)
 	std::map< Ptr<NetDevice>, complexVector_t >::iterator it = m_beamformingVectorMap.find (device);
 	NS_ASSERT_MSG (it != m_beamformingVectorMap.end (), "could not find");
 	m_beamformingVector = it->second;
+	m_steeringTable = 0;
 }
 
 complexVector_t
@@ -190,6 +267,16 @@ AntennaArrayModel::GetBeamformingVector ()
 //	{
 //		NS_FATAL_ERROR ("omi transmission do not need beamforming vector");
 //	}
+	return GetCurrentBeamformingVector ();
+}
+
+const complexVector_t&
+AntennaArrayModel::GetCurrentBeamformingVector () const
+{
+	if (m_steeringTable != 0)
+	{
+		return m_steeringTable->m_steering[m_steeringBeam];
+	}
 	return m_beamformingVector;
 }
 
@@ -217,7 +304,7 @@ AntennaArrayModel::GetBeamformingVector (Ptr<NetDevice> device)
 	}
 	else
 	{
-		weights = m_beamformingVector;
+		weights = GetCurrentBeamformingVector ();
 	}
 	return weights;
 }
@@ -361,6 +448,7 @@ AntennaArrayModel::SetToSector (uint32_t sector, uint32_t antennaNum)
 		cmplxVector. at(i) = cmplxVector. at(i)/sqrt(weightSum);
 	}
 	m_beamformingVector = cmplxVector;
+	m_steeringTable = 0;
 }
 
 double
@@ -399,20 +487,99 @@ AntennaArrayModel::GetAntennaLocation(uint8_t index, uint8_t* antennaNum)
 void
 AntennaArrayModel::SetSector (uint8_t sector, uint8_t *antennaNum, double elevation)
 {
+	Ptr<const MmWaveSteeringTable> table = GetSteeringTable (antennaNum);
+	uint32_t beam = table->FindBeam (sector, elevation);
+	if (beam < table->GetNumBeams ())
+	{
+		SetSteeringBeam (table, beam);
+		return;
+	}
+
+	// the beam is not in the grid of the table
 	complexVector_t tempVector;
 	double hAngle_radian = M_PI*(double)sector/(double)antennaNum[1]-0.5*M_PI;
 	double vAngle_radian = elevation*M_PI/180;
 	uint16_t size = antennaNum[0]*antennaNum[1];
 	double power = 1/sqrt(size);
+	tempVector.reserve (size);
 	for(int ind=0; ind<size; ind++)
 	{
-		Vector loc = GetAntennaLocation(ind, antennaNum);
+		const Vector &loc = table->m_location[ind];
 		double phase = -2*M_PI*(sin(vAngle_radian)*cos(hAngle_radian)*loc.x
 							+ sin(vAngle_radian)*sin(hAngle_radian)*loc.y
 							+ cos(vAngle_radian)*loc.z);
 		tempVector.push_back(exp(std::complex<double>(0, phase))*power);
 	}
 	m_beamformingVector = tempVector;
+	m_steeringTable = 0;
+}
+
+void
+AntennaArrayModel::SetSteeringBeam (Ptr<const MmWaveSteeringTable> table, uint32_t beam)
+{
+	NS_ASSERT_MSG (beam < table->GetNumBeams (), "the beam is not in the steering table");
+	m_steeringTable = table;
+	m_steeringBeam = beam;
+}
+
+Ptr<const MmWaveSteeringTable>
+AntennaArrayModel::GetSteeringTable (uint8_t *antennaNum)
+{
+	std::vector<double> key;
+	key.push_back (antennaNum[0]);
+	key.push_back (antennaNum[1]);
+	key.push_back (m_disH);
+	key.push_back (m_disV);
+	key.push_back (m_minElevation);
+	key.push_back (m_maxElevation);
+	key.push_back (m_elevationStep);
+#ifdef HAVE_PTHREAD_H
+	CriticalSection lock (GetSteeringTableMutex ());
+#endif
+	std::map<std::vector<double>, Ptr<const MmWaveSteeringTable> > &cache = GetSteeringTableCache ();
+	std::map<std::vector<double>, Ptr<const MmWaveSteeringTable> >::iterator it = cache.find (key);
+	if (it != cache.end ())
+	{
+		return it->second;
+	}
+
+	NS_LOG_INFO ("Computing the steering table of a " << (uint16_t)antennaNum[0] << "x" << (uint16_t)antennaNum[1] << " array");
+	Ptr<MmWaveSteeringTable> table = Create<MmWaveSteeringTable> ();
+	uint16_t size = antennaNum[0]*antennaNum[1];
+	for (uint16_t ind = 0; ind < size; ind++)
+	{
+		table->m_location.push_back (GetAntennaLocation (ind, antennaNum));
+	}
+	table->m_numSectors = antennaNum[1] + 1;
+	table->m_elevationStep = m_elevationStep;
+	double power = 1/sqrt(size);
+	// the elevations are min + i*step, accumulating the steps would drift from the grid
+	uint32_t numElevations = m_maxElevation < m_minElevation ? 0
+			: (uint32_t)std::floor ((m_maxElevation - m_minElevation)/m_elevationStep + 1e-6) + 1;
+	for (uint32_t elevationIndex = 0; elevationIndex < numElevations; elevationIndex++)
+	{
+		double elevation = m_minElevation + elevationIndex*m_elevationStep;
+		table->m_elevation.push_back (elevation);
+		double vAngle_radian = elevation*M_PI/180;
+		for (uint16_t sector = 0; sector < table->m_numSectors; sector++)
+		{
+			// same steering vector as SetSector
+			double hAngle_radian = M_PI*(double)sector/(double)antennaNum[1]-0.5*M_PI;
+			complexVector_t steering;
+			steering.reserve (size);
+			for (uint16_t ind = 0; ind < size; ind++)
+			{
+				const Vector &loc = table->m_location[ind];
+				double phase = -2*M_PI*(sin(vAngle_radian)*cos(hAngle_radian)*loc.x
+									+ sin(vAngle_radian)*sin(hAngle_radian)*loc.y
+									+ cos(vAngle_radian)*loc.z);
+				steering.push_back (exp(std::complex<double>(0, phase))*power);
+			}
+			table->m_steering.push_back (steering);
+		}
+	}
+	cache[key] = table;
+	return table;
 }
 
 
@@ -420,45 +587,7 @@ AntennaArrayModel::SetSector (uint8_t sector, uint8_t *antennaNum, double elevat
 std::complex<double>
 AntennaArrayModel::ParseComplex (std::string strCmplx)
 {
-    double re = 0.00;
-    double im = 0.00;
-    size_t findj = 0;
-    std::complex<double> out_complex;
-
-    findj = strCmplx.find("i");
-    if( findj == std::string::npos )
-    {
-        im = -1.00;
-    }
-    else
-    {
-        strCmplx[findj] = '\0';
-    }
-    if( ( strCmplx.find("+",1) == std::string::npos && strCmplx.find("-",1) == std::string::npos ) && im != -1 )
-    {
-        /* No real value */
-        re = -1.00;
-    }
-    std::stringstream stream( strCmplx );
-    if( re != -1.00 )
-    {
-        stream>>re;
-    }
-    else
-    {
-        re = 0;
-    }
-    if( im != -1 )
-    {
-        stream>>im;
-    }
-    else
-    {
-        im = 0.00;
-    }
-    //  std::cout<<" ---  "<<re<<"  "<<im<<std::endl;
-    out_complex = std::complex<double>(re,im);
-    return out_complex;
+	return MmWaveCodebookLoader::ParseComplex (strCmplx);
 }
 
 } /* namespace ns3 */
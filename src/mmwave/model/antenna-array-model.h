@@ -29,12 +29,44 @@
 #include <ns3/net-device.h>
 #include <ns3/net-device-container.h>
 #include <ns3/spectrum-value.h>
+#include <ns3/simple-ref-count.h>
+#include <ns3/vector.h>
 #include <map>
+#include <vector>
 
 namespace ns3 {
 
 typedef std::vector< std::complex<double> > complexVector_t;
 
+/**
+ * Element locations of an antenna array and steering vectors of every sector of its beam
+ * search grid, the same ones AntennaArrayModel::SetSector computes. The tables are shared
+ * by all the arrays with the same geometry and grid (AntennaArrayModel::GetSteeringTable)
+ */
+struct MmWaveSteeringTable : public SimpleRefCount<MmWaveSteeringTable>
+{
+	uint16_t m_numSectors;			// horizontal sectors per elevation, antennaNum[1]+1
+	std::vector<double> m_elevation;	// degree, min + i*m_elevationStep
+	double m_elevationStep;			// degree
+	std::vector<Vector> m_location;	// location of every antenna element, in wavelengths
+	std::vector<complexVector_t> m_steering;	// [elevation index*m_numSectors + sector][antenna element]
+
+	MmWaveSteeringTable ();
+
+	/**
+	 * @returns the number of beams of the grid
+	 */
+	uint32_t GetNumBeams () const;
+
+	/**
+	 * @params the sector
+	 * @params the elevation in degree
+	 * @returns the beam of the grid, GetNumBeams () if the sector or the elevation are not in the grid.
+	 * The elevation is matched on its index in the grid, so rounding errors of the caller are ignored
+	 */
+	uint32_t FindBeam (uint8_t sector, double elevation) const;
+};
+
 class AntennaArrayModel: public AntennaModel {
 public:
 	AntennaArrayModel();
@@ -54,6 +86,21 @@ public:
 	Vector GetAntennaLocation (uint8_t index, uint8_t* antennaNum) ;
 	void SetSector (uint8_t sector, uint8_t *antennaNum, double elevation = 90);
 
+	/**
+	 * Returns the steering table of the array, computed the first time a geometry and
+	 * elevation grid is requested by any array
+	 * @params the number of antennas in each direction, as passed to SetSector
+	 * @returns the table shared by the arrays with the same geometry
+	 */
+	Ptr<const MmWaveSteeringTable> GetSteeringTable (uint8_t *antennaNum);
+
+	/**
+	 * Use a steering vector of a table as beamforming vector, without copying it
+	 * @params the steering table
+	 * @params the beam of the table
+	 */
+	void SetSteeringBeam (Ptr<const MmWaveSteeringTable> table, uint32_t beam);
+
 	// Carlos modification
 
 	/* \brief Get complex number from a string
@@ -65,6 +112,11 @@ public:
 
 
 private:
+	/**
+	 * @returns the beamforming vector, the steering vector of m_steeringTable if it is set
+	 */
+	const complexVector_t& GetCurrentBeamformingVector () const;
+
 	bool m_omniTx;
 	double m_minAngle;
 	double m_maxAngle;
@@ -74,6 +126,12 @@ private:
 	double m_disV; //antenna spacing in the vertical direction in terms of wave length.
 	double m_disH; //antenna spacing in the horizontal direction in terms of wave length.
 
+	double m_minElevation; //lowest elevation of the steering grid, degree.
+	double m_maxElevation; //highest elevation of the steering grid, degree.
+	double m_elevationStep; //elevation step of the steering grid, degree.
+	Ptr<const MmWaveSteeringTable> m_steeringTable; //table of the beamforming vector set by SetSector, 0 if it is m_beamformingVector.
+	uint32_t m_steeringBeam; //beam of m_steeringTable.
+
 };
 
 } /* namespace ns3 */
@@ -27,9 +27,11 @@
 #include "ns3/log.h"
 #include "ns3/mobility-model.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include <ns3/mobility-building-info.h>
 #include <ns3/building-list.h>
 #include <ns3/angles.h>
+#include "mmwave-buildings-index.h"
 #include "ns3/config-store.h"
 
 
@@ -44,6 +46,7 @@ NS_OBJECT_ENSURE_REGISTERED (BuildingsObstaclePropagationLossModel);
 
 
 BuildingsObstaclePropagationLossModel::BuildingsObstaclePropagationLossModel ()
+	: m_footprintLos (false)
 {
 }
 
@@ -62,6 +65,12 @@ BuildingsObstaclePropagationLossModel::GetTypeId (void)
 					   DoubleValue (28e9),
 					   MakeDoubleAccessor (&BuildingsObstaclePropagationLossModel::SetFrequency),
 					   MakeDoubleChecker<double> ())
+		.AddAttribute ("FootprintLos",
+					   "Determine the LOS condition with the buildings index: the link is NLOS if its projection on the ground "
+					   "crosses the footprint of a building. If false, the angles of the buildings seen from one end of the link are used",
+					   BooleanValue (false),
+					   MakeBooleanAccessor (&BuildingsObstaclePropagationLossModel::m_footprintLos),
+					   MakeBooleanChecker ())
 	;
 	return tid;
 }
@@ -97,49 +106,8 @@ BuildingsObstaclePropagationLossModel::GetLoss (Ptr<MobilityModel> a, Ptr<Mobili
 	if (a1->IsOutdoor () && b1->IsOutdoor ())
 	{
 		/*Determine LOS or NLOS*/
-		bool los = true;
-		for (BuildingList::Iterator bit = BuildingList::Begin (); bit != BuildingList::End (); ++bit)
-		{
-			Box boundaries = (*bit)->GetBoundaries ();
-			Vector locationA = a->GetPosition ();
-			Vector locationB = b->GetPosition ();
-			Angles pathAngles (locationB, locationA);
-			double angle = pathAngles.phi;
-			if (angle >= M_PI/2 || angle < -M_PI/2)
-			{
-				locationA = b->GetPosition ();
-				locationB = a->GetPosition ();
-				Angles pathAngles (locationB, locationA);
-				angle = pathAngles.phi;
-			}
-
-			if (angle >=0 && angle < M_PI/2 )
-			{
-				Vector loc1(boundaries.xMax,boundaries.yMin,boundaries.zMin);
-				Vector loc2(boundaries.xMin,boundaries.yMax,boundaries.zMin);
-				Angles angles1 (loc1,locationA);
-				Angles angles2 (loc2,locationA);
-				if (angle >= angles1.phi && angle <= angles2.phi && locationB.x >= boundaries.xMin && locationB.y >= boundaries.yMin)
-				{
-					los = false;
-					break;
-				}
-			}
-			else if (angle >= -M_PI/2 && angle < 0)
-			{
-				Vector loc1(boundaries.xMin,boundaries.yMin,boundaries.zMin);
-				Vector loc2(boundaries.xMax,boundaries.yMax,boundaries.zMin);
-				Angles angles1 (loc1,locationA);
-				Angles angles2 (loc2,locationA);
-				if (angle > angles1.phi && angle < angles2.phi && locationB.x > boundaries.xMin && locationB.y < boundaries.yMax)
-				{
-					los = false;
-					break;
-				}
-			}
-		}
-
-
+		bool los = m_footprintLos ? !MmWaveBuildingsIndex::Get ()->IsLineIntersectBuildings (a->GetPosition (), b->GetPosition (), true)
+				: IsLosByAngles (a->GetPosition (), b->GetPosition ());
 
 		if(los)
 		{
@@ -172,6 +140,53 @@ BuildingsObstaclePropagationLossModel::GetLoss (Ptr<MobilityModel> a, Ptr<Mobili
 	return loss;
 }
 
+bool
+BuildingsObstaclePropagationLossModel::IsLosByAngles (Vector a, Vector b) const
+{
+	bool los = true;
+	for (BuildingList::Iterator bit = BuildingList::Begin (); bit != BuildingList::End (); ++bit)
+	{
+		Box boundaries = (*bit)->GetBoundaries ();
+		Vector locationA = a;
+		Vector locationB = b;
+		Angles pathAngles (locationB, locationA);
+		double angle = pathAngles.phi;
+		if (angle >= M_PI/2 || angle < -M_PI/2)
+		{
+			locationA = b;
+			locationB = a;
+			Angles pathAngles (locationB, locationA);
+			angle = pathAngles.phi;
+		}
+
+		if (angle >=0 && angle < M_PI/2 )
+		{
+			Vector loc1(boundaries.xMax,boundaries.yMin,boundaries.zMin);
+			Vector loc2(boundaries.xMin,boundaries.yMax,boundaries.zMin);
+			Angles angles1 (loc1,locationA);
+			Angles angles2 (loc2,locationA);
+			if (angle >= angles1.phi && angle <= angles2.phi && locationB.x >= boundaries.xMin && locationB.y >= boundaries.yMin)
+			{
+				los = false;
+				break;
+			}
+		}
+		else if (angle >= -M_PI/2 && angle < 0)
+		{
+			Vector loc1(boundaries.xMin,boundaries.yMin,boundaries.zMin);
+			Vector loc2(boundaries.xMax,boundaries.yMax,boundaries.zMin);
+			Angles angles1 (loc1,locationA);
+			Angles angles2 (loc2,locationA);
+			if (angle > angles1.phi && angle < angles2.phi && locationB.x > boundaries.xMin && locationB.y < boundaries.yMax)
+			{
+				los = false;
+				break;
+			}
+		}
+	}
+	return los;
+}
+
 double
 BuildingsObstaclePropagationLossModel::mmWaveLosLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
 {
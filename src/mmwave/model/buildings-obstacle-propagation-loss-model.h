@@ -47,10 +47,18 @@ public:
 	void SetFrequency (double freq);
 
 private:
+	/**
+	 * LOS test against every building, through the angles of its corners seen from one end of the link
+	 * @params the position of the first end
+	 * @params the position of the second end
+	 * @returns true if no building blocks the link
+	 */
+	bool IsLosByAngles (Vector a, Vector b) const;
 	double mmWaveLosLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
 	double mmWaveNlosLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
 	double m_frequency;
 	double m_lambda;
+	bool m_footprintLos; // LOS test of the buildings index instead of IsLosByAngles.
 
 };
 
@@ -29,6 +29,7 @@
 #include "ns3/double.h"
 #include <ns3/mobility-building-info.h>
 #include <ns3/building-list.h>
+#include "mmwave-buildings-index.h"
 #include <ns3/angles.h>
 #include "ns3/config-store.h"
 #include <ns3/mmwave-ue-net-device.h>
@@ -330,42 +331,8 @@ MmWave3gppBuildingsPropagationLossModel::mmWaveNlosLoss (Ptr<MobilityModel> a, P
 bool
 MmWave3gppBuildingsPropagationLossModel::IsLineIntersectBuildings(Vector L1, Vector L2 ) const
 {
-	for (BuildingList::Iterator bit = BuildingList::Begin (); bit != BuildingList::End (); ++bit)
-	{
-		Box boundaries = (*bit)->GetBoundaries ();
-
-		Vector boxSize (0.5*(boundaries.xMax - boundaries.xMin),
-				0.5*(boundaries.yMax - boundaries.yMin),
-				0.5*(boundaries.zMax - boundaries.zMin));
-		Vector boxCenter (boundaries.xMin + boxSize.x,
-				boundaries.yMin + boxSize.y,
-				boundaries.zMin + boxSize.z);
-
-		// Put line in box space
-		Vector LB1 (L1.x-boxCenter.x, L1.y-boxCenter.y, L1.z-boxCenter.z);
-		Vector LB2 (L2.x-boxCenter.x, L2.y-boxCenter.y, L2.z-boxCenter.z);
-
-		// Get line midpoint and extent
-		Vector LMid (0.5*(LB1.x+LB2.x), 0.5*(LB1.y+LB2.y), 0.5*(LB1.z+LB2.z));
-		Vector L (LB1.x - LMid.x, LB1.y - LMid.y, LB1.z - LMid.z);
-		Vector LExt ( std::abs(L.x), std::abs(L.y), std::abs(L.z) );
-
-		// Use Separating Axis Test
-		// Separation vector from box center to line center is LMid, since the line is in box space
-		// If the line did not intersect this building, jump to the next building.
-		if ( std::abs( LMid.x ) > boxSize.x + LExt.x ) continue;
-		if ( std::abs( LMid.y ) > boxSize.y + LExt.y ) continue;
-		if ( std::abs( LMid.z ) > boxSize.z + LExt.z ) continue;
-		// Crossproducts of line and each axis
-		if ( std::abs( LMid.y * L.z - LMid.z * L.y)  >  (boxSize.y * LExt.z + boxSize.z * LExt.y) ) continue;
-		if ( std::abs( LMid.x * L.z - LMid.z * L.x)  >  (boxSize.x * LExt.z + boxSize.z * LExt.x) ) continue;
-		if ( std::abs( LMid.x * L.y - LMid.y * L.x)  >  (boxSize.x * LExt.y + boxSize.y * LExt.x) ) continue;
-
-		// No separating axis, the line intersects
-		// If the line intersect this building, return true.
-		return true;
-	}
-	return false;
+	// only the buildings whose bounding volumes the line crosses are tested
+	return MmWaveBuildingsIndex::Get ()->IsLineIntersectBuildings (L1, L2, false);
 }
 
 void
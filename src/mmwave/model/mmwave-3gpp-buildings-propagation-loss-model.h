@@ -52,6 +52,7 @@ private:
 	//The IsLineIntersectBuildings method is based on
 	//ISLineInBox method implemented in Bounding Box Types.
 	//Link: http://www.3dkingdoms.com/weekly/weekly.php?a=21.
+	//The buildings are searched through MmWaveBuildingsIndex.
 	bool IsLineIntersectBuildings (Vector L1, Vector L2 ) const;
 	void LocationTrace (Vector enbLoc, Vector ueLoc, bool los) const;
 	double mmWaveLosLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
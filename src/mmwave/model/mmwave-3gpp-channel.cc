@@ -25,6 +25,7 @@
 
 #include "mmwave-3gpp-channel.h"
 #include <ns3/log.h>
+#include <ns3/abort.h>
 #include <ns3/math.h>
 #include <ns3/simulator.h>
 #include <ns3/mmwave-phy.h>
@@ -39,7 +40,14 @@
 #include <random>       // std::default_random_engine
 #include <ns3/boolean.h>
 #include <ns3/integer.h>
+#include <ns3/uinteger.h>
+#include <ns3/core-config.h>
+#include <ns3/rng-seed-manager.h>
+#ifdef HAVE_PTHREAD_H
+#include <ns3/system-thread.h>
+#endif
 #include "mmwave-spectrum-value-helper.h"
+#include "mmwave-subband-gain.h"
 
 
 namespace ns3{
@@ -159,7 +167,166 @@ static const double sqrtC_office_NLOS[6][6] = {
 
 
 
+BeamPairSinrBatch::BeamPairSinrBatch ()
+	: m_numBands (0)
+{
+}
+
+SpectrumValue
+BeamPairSinrBatch::GetSinrPsd (uint32_t index) const
+{
+	NS_ASSERT_MSG (index < m_beamPairs.size (), "beam pair index out of the batch");
+	SpectrumValue sinr (m_spectrumModel);
+	doubleVector_t::const_iterator first = m_sinr.begin () + index*m_numBands;
+	std::copy (first, first + m_numBands, sinr.ValuesBegin ());
+	return sinr;
+}
+
+/*
+ * @brief Stores the ray angles [n][m] of a realization, given as the rows of the arrays of
+ * GetNewChannel and UpdateChannel
+ */
+static void
+SetRayAngles (ChannelRays &rays, uint8_t numCluster, uint8_t raysPerCluster, const double *rayAoa,
+		const double *rayZoa, const double *rayAod, const double *rayZod)
+{
+	rays.m_rayAoa.resize (numCluster);
+	rays.m_rayZoa.resize (numCluster);
+	rays.m_rayAod.resize (numCluster);
+	rays.m_rayZod.resize (numCluster);
+	for (uint8_t nIndex = 0; nIndex < numCluster; nIndex++)
+	{
+		uint32_t first = nIndex*raysPerCluster;
+		rays.m_rayAoa.at (nIndex).assign (rayAoa + first, rayAoa + first + raysPerCluster);
+		rays.m_rayZoa.at (nIndex).assign (rayZoa + first, rayZoa + first + raysPerCluster);
+		rays.m_rayAod.at (nIndex).assign (rayAod + first, rayAod + first + raysPerCluster);
+		rays.m_rayZod.at (nIndex).assign (rayZod + first, rayZod + first + raysPerCluster);
+	}
+}
+
+/*
+ * @brief True if DeleteChannel removed the channel matrix of a link, so the next GetLinkChannel
+ * updates it. A compact link does not store its matrix either, but it is valid
+ */
+static bool
+IsChannelDeleted (const Params3gpp &params)
+{
+	return params.m_channel.size () == 0 && !params.m_compact;
+}
+
+/*
+ * @brief Bytes allocated by the elements of a vector
+ */
+template <typename T>
+static uint64_t
+GetAllocatedBytes (const std::vector<T> &v)
+{
+	return v.capacity ()*sizeof (T);
+}
+
+/*
+ * @brief Bytes allocated by a vector of vectors, including the ones of the inner vectors
+ */
+template <typename T>
+static uint64_t
+GetAllocatedBytes (const std::vector<std::vector<T> > &v)
+{
+	uint64_t bytes = v.capacity ()*sizeof (std::vector<T>);
+	for (typename std::vector<std::vector<T> >::const_iterator it = v.begin (); it != v.end (); it++)
+	{
+		bytes += GetAllocatedBytes (*it);
+	}
+	return bytes;
+}
+
+/*
+ * @brief Bytes of a channel realization, including its channel matrix and its codebook cache
+ */
+static uint64_t
+GetParamsBytes (const Params3gpp &params)
+{
+	const ChannelRays &rays = params.m_rays;
+	return sizeof (Params3gpp) + GetAllocatedBytes (params.m_channel) + GetAllocatedBytes (params.m_codebookLongTerm)
+			+ GetAllocatedBytes (params.m_txW) + GetAllocatedBytes (params.m_rxW)
+			+ GetAllocatedBytes (params.m_delay) + GetAllocatedBytes (params.m_angle)
+			+ GetAllocatedBytes (params.m_longTerm) + GetAllocatedBytes (params.m_nonSelfBlocking)
+			+ GetAllocatedBytes (params.m_norRvAngles) + GetAllocatedBytes (params.m_clusterPhase)
+			+ GetAllocatedBytes (rays.m_rayAoa) + GetAllocatedBytes (rays.m_rayZoa)
+			+ GetAllocatedBytes (rays.m_rayAod) + GetAllocatedBytes (rays.m_rayZod)
+			+ GetAllocatedBytes (rays.m_clusterPower);
+}
+
+LinkRandomStream::LinkRandomStream (uint64_t stream, uint64_t substream)
+	: m_rng (RngSeedManager::GetSeed (), stream, substream),
+	  m_next (0),
+	  m_nextValid (false)
+{
+}
+
+double
+LinkRandomStream::GetUniform (double min, double max)
+{
+	return min + m_rng.RandU01 () * (max - min);
+}
+
+double
+LinkRandomStream::GetNormal ()
+{
+	if (m_nextValid)
+	{
+		m_nextValid = false;
+		return m_next;
+	}
+	while (true)
+	{
+		double v1 = 2 * m_rng.RandU01 () - 1;
+		double v2 = 2 * m_rng.RandU01 () - 1;
+		double w = v1 * v1 + v2 * v2;
+		if (w <= 1.0)
+		{
+			double y = std::sqrt ((-2 * std::log (w)) / w);
+			m_next = v2 * y;
+			m_nextValid = true;
+			return v1 * y;
+		}
+	}
+}
+
+double
+ChannelRandomStreams::GetUniform (double min, double max) const
+{
+	return m_link ? m_link->GetUniform (min, max) : m_uniform->GetValue (min, max);
+}
+
+double
+ChannelRandomStreams::GetNormal () const
+{
+	return m_link ? m_link->GetNormal () : m_normal->GetValue ();
+}
+
+double
+ChannelRandomStreams::GetUniformBlockage (double min, double max) const
+{
+	return m_linkBlockage ? m_linkBlockage->GetUniform (min, max) : m_uniformBlockage->GetValue (min, max);
+}
+
+double
+ChannelRandomStreams::GetNormalBlockage () const
+{
+	return m_linkBlockage ? m_linkBlockage->GetNormal () : m_normalBlockage->GetValue ();
+}
+
 MmWave3gppChannel::MmWave3gppChannel ()
+	: m_numLinkStreams (0),
+	  m_initialChannelThreads (0),
+	  m_deferNewChannels (false),
+	  m_gainCache (true),
+	  m_gainCacheDopplerTolerance (0),
+	  m_gainCacheHits (0),
+	  m_gainCacheMisses (0),
+	  m_compactChannels (false),
+	  m_channelMatrixCacheSize (8),
+	  m_channelMatrixSyntheses (0)
 {
 	m_uniformRv = CreateObject<UniformRandomVariable> ();
 	m_uniformRvBlockage = CreateObject<UniformRandomVariable> ();
@@ -170,6 +337,9 @@ MmWave3gppChannel::MmWave3gppChannel ()
 	m_normalRvBlockage = CreateObject<NormalRandomVariable> ();
 	m_normalRvBlockage->SetAttribute ("Mean", DoubleValue (0));
 	m_normalRvBlockage->SetAttribute ("Variance", DoubleValue (1));
+	// the substreams of the links are those of a stream of the model, as the stream of a
+	// RandomVariableStream, so that creating the links does not shift the streams of other objects
+	m_linkStream = RngSeedManager::GetNextStreamIndex ();
 }
 
 TypeId
@@ -183,10 +353,72 @@ MmWave3gppChannel::GetTypeId (void)
 				MakeTimeAccessor (&MmWave3gppChannel::m_updatePeriod),
 				MakeTimeChecker ())
 	.AddAttribute ("CellScan",
-				"Use beam search method to determine beamforming vector, the default is long-term covariance matrix method",
+				"Use beam search method to determine the initial beamforming vectors of the connected pairs, the default is a single antenna element",
 				BooleanValue (false),
 				MakeBooleanAccessor (&MmWave3gppChannel::m_cellScan),
 				MakeBooleanChecker ())
+	.AddAttribute ("HierarchicalSectorSearch",
+				"Beam search method evaluates a coarse grid of sectors and then the neighbours of its best pairs, instead of every pair",
+				BooleanValue (false),
+				MakeBooleanAccessor (&MmWave3gppChannel::m_hierarchicalSectorSearch),
+				MakeBooleanChecker ())
+	.AddAttribute ("SectorSearchCandidates",
+				"Number of pairs of the coarse grid refined by the hierarchical sector search",
+				UintegerValue (4),
+				MakeUintegerAccessor (&MmWave3gppChannel::m_sectorSearchCandidates),
+				MakeUintegerChecker<uint32_t> (1))
+	.AddAttribute ("InitialChannelThreads",
+				"Number of threads generating the initial channel realizations of Initial and Initial_mod, each link with its own substreams "
+				"so that the realizations do not depend on the number of threads. 0 generates them on the simulator thread",
+				UintegerValue (0),
+				MakeUintegerAccessor (&MmWave3gppChannel::m_initialChannelThreads),
+				MakeUintegerChecker<uint32_t> ())
+	.AddAttribute ("GainCache",
+				"Reuse the beamforming gain of a link while its channel realization, beamforming vectors and relative speed are unchanged",
+				BooleanValue (true),
+				MakeBooleanAccessor (&MmWave3gppChannel::m_gainCache),
+				MakeBooleanChecker ())
+	.AddAttribute ("GainCacheDopplerTolerance",
+				"Largest drift of the Doppler phase of a cluster, in rad, for which a cached beamforming gain is reused. "
+				"0 reuses it only at the time it was computed, or at any time if the link is static",
+				DoubleValue (0),
+				MakeDoubleAccessor (&MmWave3gppChannel::m_gainCacheDopplerTolerance),
+				MakeDoubleChecker<double> (0))
+	.AddAttribute ("GainCacheHits",
+				"Number of beamforming gains taken from the cache",
+				TypeId::ATTR_GET,
+				UintegerValue (0),
+				MakeUintegerAccessor (&MmWave3gppChannel::m_gainCacheHits),
+				MakeUintegerChecker<uint64_t> ())
+	.AddAttribute ("GainCacheMisses",
+				"Number of beamforming gains computed because the cache had no valid entry",
+				TypeId::ATTR_GET,
+				UintegerValue (0),
+				MakeUintegerAccessor (&MmWave3gppChannel::m_gainCacheMisses),
+				MakeUintegerChecker<uint64_t> ())
+	.AddAttribute ("CompactChannels",
+				"Store the channel matrix of the serving links only. The other links keep the rays of their "
+				"realization and their matrix is computed again when the beam sweeping or the beamforming needs it",
+				BooleanValue (false),
+				MakeBooleanAccessor (&MmWave3gppChannel::m_compactChannels),
+				MakeBooleanChecker ())
+	.AddAttribute ("ChannelMatrixCacheSize",
+				"Number of channel matrices of links without a stored matrix kept for reuse, with CompactChannels",
+				UintegerValue (8),
+				MakeUintegerAccessor (&MmWave3gppChannel::m_channelMatrixCacheSize),
+				MakeUintegerChecker<uint32_t> (1))
+	.AddAttribute ("ChannelMatrixSyntheses",
+				"Number of channel matrices of links without a stored matrix computed again from their rays",
+				TypeId::ATTR_GET,
+				UintegerValue (0),
+				MakeUintegerAccessor (&MmWave3gppChannel::m_channelMatrixSyntheses),
+				MakeUintegerChecker<uint64_t> ())
+	.AddAttribute ("ChannelMemory",
+				"Memory allocated by the channel realizations and their caches, in bytes",
+				TypeId::ATTR_GET,
+				UintegerValue (0),
+				MakeUintegerAccessor (&MmWave3gppChannel::GetChannelMemory),
+				MakeUintegerChecker<uint64_t> ())
 	.AddAttribute ("Blockage",
 				"Enable blockage model A (sec 7.6.4.1)",
 				BooleanValue (false),
@@ -220,6 +452,23 @@ void
 MmWave3gppChannel::DoDispose ()
 {
 	NS_LOG_FUNCTION (this);
+	m_gainCacheMap.clear ();
+	m_channelMatrixCache.clear ();
+	m_channelMatrixCacheIndex.clear ();
+}
+
+int64_t
+MmWave3gppChannel::AssignStreams (int64_t stream)
+{
+	NS_LOG_FUNCTION (this << stream);
+	m_uniformRv->SetStream (stream);
+	m_uniformRvBlockage->SetStream (stream + 1);
+	m_expRv->SetStream (stream + 2);
+	m_normalRv->SetStream (stream + 3);
+	m_normalRvBlockage->SetStream (stream + 4);
+	// the stream index of RandomVariableStream::SetStream
+	m_linkStream = (static_cast<uint64_t> (1) << 63) + stream + 5;
+	return 6;
 }
 
 void
@@ -272,6 +521,7 @@ MmWave3gppChannel::Initial(NetDeviceContainer ueDevices, NetDeviceContainer enbD
 {
 
 	NS_LOG_INFO (&ueDevices<<&enbDevices);
+	m_deferNewChannels = true;
 
 	for (NetDeviceContainer::Iterator i = ueDevices.Begin(); i != ueDevices.End(); i++)
 	{
@@ -316,6 +566,7 @@ MmWave3gppChannel::Initial(NetDeviceContainer ueDevices, NetDeviceContainer enbD
 			DoCalcRxPowerSpectralDensity(fakePsd, a, b);
 		}
 	}
+	GenerateDeferredChannels ();
 
 }
 
@@ -325,6 +576,7 @@ MmWave3gppChannel::Initial_mod(NetDeviceContainer ueDevices, NetDeviceContainer
 {
 
 	NS_LOG_INFO (&ueDevices<<&enbDevices);
+	m_deferNewChannels = true;
 
 	for (NetDeviceContainer::Iterator i = enbDevices.Begin(); i != enbDevices.End(); i++)
 	{
@@ -372,18 +624,122 @@ MmWave3gppChannel::Initial_mod(NetDeviceContainer ueDevices, NetDeviceContainer
 			DoCalcRxPowerSpectralDensity(fakePsd, a, b);
 		}
 	}
+	GenerateDeferredChannels ();
 
 }
 
 
+ChannelRandomStreams
+MmWave3gppChannel::GetChannelRandomStreams () const
+{
+	ChannelRandomStreams streams;
+	streams.m_uniform = m_uniformRv;
+	streams.m_normal = m_normalRv;
+	streams.m_uniformBlockage = m_uniformRvBlockage;
+	streams.m_normalBlockage = m_normalRvBlockage;
+	return streams;
+}
 
-Ptr<SpectrumValue>
-MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
-                                                   Ptr<const MobilityModel> a,
-                                                   Ptr<const MobilityModel> b) const
+/*
+ * @brief Generates a subset of the deferred channels, run by a SystemThread
+ */
+class DeferredChannelWorker
+{
+public:
+	const MmWave3gppChannel *m_channel;
+	uint32_t m_first;
+	uint32_t m_step;
+
+	void Run ()
+	{
+		m_channel->GenerateDeferredChannelRange (m_first, m_step);
+	}
+};
+
+void
+MmWave3gppChannel::GenerateDeferredChannels ()
+{
+	NS_LOG_FUNCTION (this << m_deferredChannels.size () << m_initialChannelThreads);
+	m_deferNewChannels = false;
+
+	// the substreams are given in link order, so each link draws from its own substreams
+	// regardless of the number of threads and of the thread that generates it. Different runs
+	// take disjoint substreams, as the runs of a RandomVariableStream
+	uint64_t runSubstreams = RngSeedManager::GetRun () << 32;
+	for (std::vector<DeferredChannel>::iterator it = m_deferredChannels.begin (); it != m_deferredChannels.end (); it++)
+	{
+		NS_ABORT_MSG_IF (m_numLinkStreams >= (static_cast<uint64_t> (1) << 31), "too many links for the substreams of a run");
+		it->m_streams.m_link = Create<LinkRandomStream> (m_linkStream, runSubstreams + 2 * m_numLinkStreams);
+		it->m_streams.m_linkBlockage = Create<LinkRandomStream> (m_linkStream, runSubstreams + 2 * m_numLinkStreams + 1);
+		m_numLinkStreams++;
+	}
+
+	uint32_t numThreads = std::min<uint32_t> (m_initialChannelThreads, m_deferredChannels.size ());
+	std::vector<DeferredChannelWorker> workers (numThreads);
+	for (uint32_t i = 0; i < numThreads; i++)
+	{
+		workers[i].m_channel = this;
+		workers[i].m_first = i;
+		workers[i].m_step = numThreads;
+	}
+#ifdef HAVE_PTHREAD_H
+	// Now () is called by GetNewChannel, make sure the simulator exists before starting the threads
+	Simulator::Now ();
+	std::vector<Ptr<SystemThread> > threads;
+	for (uint32_t i = 0; i < numThreads; i++)
+	{
+		threads.push_back (Create<SystemThread> (MakeCallback (&DeferredChannelWorker::Run, &workers[i])));
+		threads.back ()->Start ();
+	}
+	for (uint32_t i = 0; i < numThreads; i++)
+	{
+		threads[i]->Join ();
+	}
+#else
+	for (uint32_t i = 0; i < numThreads; i++)
+	{
+		workers[i].Run ();
+	}
+#endif
+	if (numThreads == 0)
+	{
+		GenerateDeferredChannelRange (0, 1);
+	}
+
+	for (std::vector<DeferredChannel>::iterator it = m_deferredChannels.begin (); it != m_deferredChannels.end (); it++)
+	{
+		m_generatedChannels[it->m_key] = it->m_params;
+	}
+	m_deferredChannels.clear ();
+
+	// repeat the deferred calls to store the channels and initialize their beamforming vectors
+	std::vector<DeferredRxPsdCall> calls;
+	calls.swap (m_deferredCalls);
+	for (std::vector<DeferredRxPsdCall>::iterator it = calls.begin (); it != calls.end (); it++)
+	{
+		DoCalcRxPowerSpectralDensity (it->m_txPsd, it->m_a, it->m_b);
+	}
+	NS_ASSERT_MSG (m_generatedChannels.empty (), "a generated channel has not been stored");
+}
+
+void
+MmWave3gppChannel::GenerateDeferredChannelRange (uint32_t first, uint32_t step) const
+{
+	for (uint32_t i = first; i < m_deferredChannels.size (); i += step)
+	{
+		DeferredChannel &channel = m_deferredChannels[i];
+		channel.m_params = GetNewChannel (channel.m_table3gpp, channel.m_locUT, channel.m_los, channel.m_o2i,
+				channel.m_txAntenna, channel.m_rxAntenna, channel.m_txAntennaNum, channel.m_rxAntennaNum,
+				channel.m_rxAngle, channel.m_txAngle, channel.m_speed, channel.m_dis2D, channel.m_dis3D, channel.m_streams);
+	}
+}
+
+
+Ptr<Params3gpp>
+MmWave3gppChannel::GetLinkChannel (Ptr<const SpectrumValue> txPsd, Ptr<const MobilityModel> a,
+		Ptr<const MobilityModel> b, key_t &key, Vector &relativeSpeed, bool &reverseLink) const
 {
 	NS_LOG_FUNCTION (this);
-	Ptr<SpectrumValue> rxPsd = Copy (txPsd);
 	Ptr<NetDevice> txDevice = a->GetObject<Node> ()->GetDevice (0);
 	Ptr<NetDevice> rxDevice = b->GetObject<Node> ()->GetDevice (0);
 	Ptr<MmWaveEnbNetDevice> txEnb =
@@ -438,13 +794,13 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 	else
 	{
 		NS_LOG_INFO ("enb to enb or ue to ue transmission, skip beamforming a tx " << a->GetPosition() << " b rx " << b->GetPosition());
-		return rxPsd;
+		return 0;
 	}
 
 	if(txAntennaArray->IsOmniTx() || rxAntennaArray->IsOmniTx() )
 	{
 		//omi transmission, do nothing.
-		return rxPsd;
+		return 0;
 	}
 
 	/*txAntennaNum[0] = 1;
@@ -456,9 +812,9 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 
 	Vector rxSpeed = b->GetVelocity();
 	Vector txSpeed = a->GetVelocity();
-	Vector relativeSpeed (rxSpeed.x-txSpeed.x,rxSpeed.y-txSpeed.y,rxSpeed.z-txSpeed.z);
+	relativeSpeed = Vector (rxSpeed.x-txSpeed.x,rxSpeed.y-txSpeed.y,rxSpeed.z-txSpeed.z);
 
-	key_t key = std::make_pair(txDevice,rxDevice);
+	key = std::make_pair(txDevice,rxDevice);
 	key_t keyReverse = std::make_pair(rxDevice,txDevice);
 
 	std::map< key_t, Ptr<Params3gpp> >::iterator it = m_channelMap.find (key);
@@ -466,20 +822,18 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 
 	Ptr<Params3gpp> channelParams;
 
-	bool reverseLink = false;
+	reverseLink = false;
 
 	//Step 2: Assign propagation condition (LOS/NLOS).
 
 	char condition;
-	if (DynamicCast<MmWave3gppPropagationLossModel> (m_3gppPathloss)!=0)
+	if (m_3gppLossModel != 0)
 	{
-		condition = m_3gppPathloss->GetObject<MmWave3gppPropagationLossModel> ()
-				->GetChannelCondition(a->GetObject<MobilityModel>(),b->GetObject<MobilityModel>());
+		condition = m_3gppLossModel->GetChannelCondition(a->GetObject<MobilityModel>(),b->GetObject<MobilityModel>());
 	}
-	else if (DynamicCast<MmWave3gppBuildingsPropagationLossModel> (m_3gppPathloss)!=0)
+	else if (m_3gppBuildingsLossModel != 0)
 	{
-		condition = m_3gppPathloss->GetObject<MmWave3gppBuildingsPropagationLossModel> ()
-				->GetChannelCondition(a->GetObject<MobilityModel>(),b->GetObject<MobilityModel>());
+		condition = m_3gppBuildingsLossModel->GetChannelCondition(a->GetObject<MobilityModel>(),b->GetObject<MobilityModel>());
 	}
 	else
 	{
@@ -508,13 +862,13 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 
 	//I only update the fowrad channel.
 	if ((it == m_channelMap.end () && itReverse == m_channelMap.end ()) ||
-			(it != m_channelMap.end () && it->second->m_channel.size() == 0)||
+			(it != m_channelMap.end () && IsChannelDeleted (*it->second))||
 			(it != m_channelMap.end () && it->second->m_los != los))
 	{
 		NS_LOG_INFO("Update or create the forward channel");
 		NS_LOG_LOGIC("it == m_channelMap.end () " << (it == m_channelMap.end ()));
 		NS_LOG_LOGIC("itReverse == m_channelMap.end () " << (itReverse == m_channelMap.end ()));
-		NS_LOG_LOGIC("it->second->m_channel.size() == 0 " << (it->second->m_channel.size() == 0));
+		NS_LOG_LOGIC("IsChannelDeleted (*it->second) " << IsChannelDeleted (*it->second));
 		NS_LOG_LOGIC("it->second->m_los != los" << (it->second->m_los != los));
 		
 		//Step 1: The parameters are configured in the example code.
@@ -546,8 +900,43 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 		Ptr<ParamsTable> table3gpp = Get3gppTable(los, o2i, hBS, hUT, distance2D);
 
 		// Step 4-11 are performed in function GetNewChannel()
+		if (m_deferNewChannels && !(it != m_channelMap.end () && IsChannelDeleted (*it->second)))
+		{
+			// the channel is generated by GenerateDeferredChannels, which repeats this call afterwards
+			DeferredRxPsdCall call;
+			call.m_txPsd = txPsd;
+			call.m_a = a;
+			call.m_b = b;
+			m_deferredCalls.push_back (call);
+			bool deferred = false;
+			for (std::vector<DeferredChannel>::iterator itDeferred = m_deferredChannels.begin (); itDeferred != m_deferredChannels.end (); itDeferred++)
+			{
+				deferred = deferred || itDeferred->m_key == key || itDeferred->m_key == keyReverse;
+			}
+			if (!deferred)
+			{
+				DeferredChannel channel;
+				channel.m_key = key;
+				channel.m_table3gpp = table3gpp;
+				channel.m_locUT = locUT;
+				channel.m_los = los;
+				channel.m_o2i = o2i;
+				channel.m_txAntenna = txAntennaArray;
+				channel.m_rxAntenna = rxAntennaArray;
+				std::copy (txAntennaNum, txAntennaNum + 2, channel.m_txAntennaNum);
+				std::copy (rxAntennaNum, rxAntennaNum + 2, channel.m_rxAntennaNum);
+				channel.m_rxAngle = rxAngle;
+				channel.m_txAngle = txAngle;
+				channel.m_speed = relativeSpeed;
+				channel.m_dis2D = distance2D;
+				channel.m_dis3D = a->GetDistanceFrom(b);
+				m_deferredChannels.push_back (channel);
+			}
+			return 0;
+		}
+
 		if((it == m_channelMap.end () && itReverse == m_channelMap.end ()) ||
-				(it != m_channelMap.end () && it->second->m_channel.size() == 0))
+				(it != m_channelMap.end () && IsChannelDeleted (*it->second)))
 		{
 			//delete the channel parameter to cause the channel to be updated again.
 			//The m_updatePeriod can be configured to be relatively large in order to disable updates.
@@ -561,7 +950,7 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 
 		double distance3D = a->GetDistanceFrom(b);
 
-		if(it != m_channelMap.end () && it->second->m_channel.size() == 0)
+		if(it != m_channelMap.end () && IsChannelDeleted (*it->second))
 		{
 			//if the channel map is not empty, we only update the channel.
 			NS_LOG_DEBUG ("Update forward channel consistently");
@@ -581,8 +970,18 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 		{
 			//if the channel map is empty, we create a new channel.
 			NS_LOG_INFO("Create new channel");
-			channelParams = GetNewChannel(table3gpp, locUT, los, o2i, txAntennaArray, rxAntennaArray,
-					txAntennaNum, rxAntennaNum, rxAngle, txAngle, relativeSpeed, distance2D, distance3D);
+			std::map<key_t, Ptr<Params3gpp> >::iterator itGenerated = m_generatedChannels.find (key);
+			if (itGenerated != m_generatedChannels.end ())
+			{
+				channelParams = itGenerated->second;
+				m_generatedChannels.erase (itGenerated);
+			}
+			else
+			{
+				channelParams = GetNewChannel(table3gpp, locUT, los, o2i, txAntennaArray, rxAntennaArray,
+						txAntennaNum, rxAntennaNum, rxAngle, txAngle, relativeSpeed, distance2D, distance3D,
+						GetChannelRandomStreams ());
+			}
 		}
 		// Beam management will update the beamforming vectors, but give initial values
 		if(Simulator::Now() == NanoSeconds(0.0))
@@ -590,25 +989,24 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 			std::map< key_t, int >::iterator it1 = m_connectedPair.find (key);
 					if(it1 != m_connectedPair.end ())
 					{
-						/*if(m_cellScan)
+						if(m_cellScan)
 						{
-							BeamSearchBeamforming (rxPsd, channelParams,txAntennaArray,rxAntennaArray, txAntennaNum, rxAntennaNum);
+							// initial beams from the search of the sector grid
+							BeamSearchBeamforming (txPsd, channelParams,txAntennaArray,rxAntennaArray, txAntennaNum, rxAntennaNum);
 						}
 						else
 						{
-							LongTermCovMatrixBeamforming (channelParams);
-						}*/
-
 							channelParams->m_txW.push_back(1);
 							channelParams->m_rxW.push_back(1);
 
-						for (uint8_t eIndex = 1; eIndex < txAntennaNum[0]*txAntennaNum[1]; eIndex++)
-						{
-							channelParams->m_txW.push_back(0);
-						}
-						for (uint8_t eIndex = 1; eIndex < rxAntennaNum[0]*rxAntennaNum[1]; eIndex++)
-						{
-							channelParams->m_rxW.push_back(0);
+							for (uint8_t eIndex = 1; eIndex < txAntennaNum[0]*txAntennaNum[1]; eIndex++)
+							{
+								channelParams->m_txW.push_back(0);
+							}
+							for (uint8_t eIndex = 1; eIndex < rxAntennaNum[0]*rxAntennaNum[1]; eIndex++)
+							{
+								channelParams->m_rxW.push_back(0);
+							}
 						}
 
 						if(Simulator::Now() == NanoSeconds(0)) //Give initial bfs
@@ -626,9 +1024,8 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 						{
 							NS_LOG_INFO("channelParams->m_txW.size() == 0 " << (channelParams->m_txW.size() == 0));
 							NS_LOG_INFO("channelParams->m_rxW.size() == 0 " << (channelParams->m_rxW.size() == 0));
-							m_channelMap[key] = channelParams;
-							m_channelScanningMatrixMap[key] = Copy(channelParams);
-							return rxPsd;
+							StoreLinkChannel (key, channelParams, txAntennaArray, rxAntennaArray);
+							return 0;
 						}
 					}
 		}
@@ -640,8 +1037,7 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 
 
 		CalLongTerm (channelParams);
-		m_channelMap[key] = channelParams;
-		m_channelScanningMatrixMap[key] = Copy(channelParams);
+		StoreLinkChannel (key, channelParams, txAntennaArray, rxAntennaArray);
 
 	}
 	else if (itReverse == m_channelMap.end ()) //Find channel matrix in the forward link
@@ -654,27 +1050,178 @@ MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
 		channelParams = (*itReverse).second;
 	}
 
-	Ptr<SpectrumValue> bfPsd = CalBeamformingGain(rxPsd, channelParams, relativeSpeed);
+	return channelParams;
+}
+
+Ptr<SpectrumValue>
+MmWave3gppChannel::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue> txPsd,
+                                                   Ptr<const MobilityModel> a,
+                                                   Ptr<const MobilityModel> b) const
+{
+	NS_LOG_FUNCTION (this);
+	Ptr<SpectrumValue> rxPsd = Copy (txPsd);
+	key_t key;
+	Vector relativeSpeed;
+	bool reverseLink;
+	Ptr<Params3gpp> channelParams = GetLinkChannel (txPsd, a, b, key, relativeSpeed, reverseLink);
+	if (channelParams == 0)
+	{
+		return rxPsd;
+	}
+
+	Ptr<SpectrumValue> bfPsd;
+	if (m_gainCache)
+	{
+		// the copy of txPsd is scaled in place
+		bfPsd = rxPsd;
+		MmWaveSubbandGain::Scale (&GetBeamformingGain (key, channelParams, relativeSpeed, txPsd->GetSpectrumModel ())[0], *bfPsd);
+	}
+	else
+	{
+		bfPsd = CalBeamformingGain(rxPsd, channelParams, relativeSpeed);
+	}
 
-	SpectrumValue bfGain = (*bfPsd)/(*rxPsd);
-	uint8_t nbands = bfGain.GetSpectrumModel ()->GetNumBands ();
+	uint8_t nbands = txPsd->GetSpectrumModel ()->GetNumBands ();
 	if (reverseLink == false)
 	{
-		NS_LOG_DEBUG ("****** DL BF gain == " << Sum (bfGain)/nbands << " RX PSD " << Sum(*rxPsd)/nbands); // print avg bf gain
+		NS_LOG_DEBUG ("****** DL BF gain == " << Sum ((*bfPsd)/(*txPsd))/nbands << " RX PSD " << Sum(*txPsd)/nbands); // print avg bf gain
 	}
 	else
 	{
-		NS_LOG_DEBUG ("****** UL BF gain == " << Sum (bfGain)/nbands << " RX PSD " << Sum(*rxPsd)/nbands);
+		NS_LOG_DEBUG ("****** UL BF gain == " << Sum ((*bfPsd)/(*txPsd))/nbands << " RX PSD " << Sum(*txPsd)/nbands);
 	}
 	return bfPsd;
 }
 
+bool
+MmWave3gppChannel::DoPrepareRxPowerSpectralDensity (Ptr<SpectrumValue> rxPsd, Ptr<const MobilityModel> a,
+		Ptr<const MobilityModel> b, Completion *&completion) const
+{
+	NS_LOG_FUNCTION (this);
+	completion = 0;
+	if (!m_gainCache)
+	{
+		return false;
+	}
+	key_t key;
+	Vector relativeSpeed;
+	bool reverseLink;
+	Ptr<Params3gpp> channelParams = GetLinkChannel (rxPsd, a, b, key, relativeSpeed, reverseLink);
+	if (channelParams == 0)
+	{
+		return true;
+	}
+
+	BfGainCacheEntry *entry;
+	if (FindBeamformingGain (key, channelParams, relativeSpeed, rxPsd->GetSpectrumModel (), entry))
+	{
+		MmWaveSubbandGain::Scale (&entry->m_gain[0], *rxPsd);
+	}
+	else if (entry->m_pending)
+	{
+		// the link appears twice among the receivers and its entry is still to be completed
+		*rxPsd = *CalBeamformingGain (rxPsd, channelParams, relativeSpeed);
+	}
+	else
+	{
+		entry->m_pending = true;
+		completion = entry;
+	}
+	return true;
+}
+
+const doubleVector_t&
+MmWave3gppChannel::GetBeamformingGain (const key_t &key, Ptr<Params3gpp> params, Vector speed,
+		Ptr<const SpectrumModel> spectrumModel) const
+{
+	BfGainCacheEntry *entry;
+	if (!FindBeamformingGain (key, params, speed, spectrumModel, entry))
+	{
+		NS_ASSERT_MSG (!entry->m_pending, "the gain of the link is being completed");
+		EvaluateBeamformingGain (*entry);
+	}
+	return entry->m_gain;
+}
+
+bool
+MmWave3gppChannel::FindBeamformingGain (const key_t &key, Ptr<Params3gpp> params, Vector speed,
+		Ptr<const SpectrumModel> spectrumModel, BfGainCacheEntry *&entry) const
+{
+	std::map<key_t, BfGainCacheEntry>::iterator it = m_gainCacheMap.find (key);
+	if (it == m_gainCacheMap.end ())
+	{
+		it = m_gainCacheMap.insert (std::make_pair (key, BfGainCacheEntry (this))).first;
+	}
+	entry = &it->second;
+	if (entry->m_pending)
+	{
+		m_gainCacheMisses++;
+		return false;
+	}
+	double now = Simulator::Now ().GetSeconds ();
+	// m_longTerm folds the channel matrix and the beamforming vectors, so its version covers both
+	if (entry->m_params == params && entry->m_longTermVersion == params->m_longTermVersion
+			&& entry->m_speed.x == speed.x && entry->m_speed.y == speed.y && entry->m_speed.z == speed.z
+			&& entry->m_spectrumModel == spectrumModel
+			&& (entry->m_maxDopplerRate == 0 || entry->m_maxDopplerRate*std::abs (now - entry->m_time.GetSeconds ()) <= m_gainCacheDopplerTolerance))
+	{
+		m_gainCacheHits++;
+		return true;
+	}
+	m_gainCacheMisses++;
+
+	entry->m_params = params;
+	entry->m_longTermVersion = params->m_longTermVersion;
+	entry->m_speed = speed;
+	entry->m_spectrumModel = spectrumModel;
+	entry->m_time = Simulator::Now ();
+	entry->m_gain.resize (spectrumModel->GetNumBands ());
+	return false;
+}
+
+void
+MmWave3gppChannel::EvaluateBeamformingGain (BfGainCacheEntry &entry) const
+{
+	// only the entry is accessed, so that the entries of different links can be evaluated concurrently
+	MmWaveSubbandGain &kernel = MmWaveSubbandGain::GetThreadKernel ();
+	const Params3gpp &params = *entry.m_params;
+	double time = entry.m_time.GetSeconds ();
+	entry.m_maxDopplerRate = 0;
+	kernel.Clear ();
+	kernel.Reserve (params.m_delay.size ());
+	for (uint8_t cIndex = 0; cIndex < params.m_delay.size (); cIndex++)
+	{
+		std::complex<double> doppler = exp(std::complex<double> (0, CalDopplerPhase (params, entry.m_speed, cIndex, time)));
+		kernel.AddCluster (params.m_longTerm.at(cIndex)*doppler, params.m_delay.at (cIndex));
+		entry.m_maxDopplerRate = std::max (entry.m_maxDopplerRate, std::abs (CalDopplerPhase (params, entry.m_speed, cIndex, 1.0)));
+	}
+	double firstFrequency = m_phyMacConfig->GetCentreFrequency () - GetSystemBandwidth ()/2;
+	kernel.Evaluate (firstFrequency, m_phyMacConfig->GetChunkWidth (), entry.m_gain.size (), &entry.m_gain[0]);
+	entry.m_pending = false;
+}
+
+BfGainCacheEntry::BfGainCacheEntry (const MmWave3gppChannel *channel)
+	: m_channel (channel),
+	  m_longTermVersion (0),
+	  m_maxDopplerRate (0),
+	  m_pending (false)
+{
+}
+
+void
+BfGainCacheEntry::Complete (SpectrumValue &rxPsd)
+{
+	m_channel->EvaluateBeamformingGain (*this);
+	MmWaveSubbandGain::Scale (&m_gain[0], rxPsd);
+}
+
 void
 MmWave3gppChannel::LongTermCovMatrixBeamforming(Ptr<Params3gpp> params) const
 {
+	const complex3DVector_t &channel = GetChannelMatrix (params);
 	//generate transmitter side spatial correlation matrix
-	uint8_t txSize = params->m_channel.at(0).size();
-	uint8_t rxSize = params->m_channel.size();
+	uint8_t txSize = channel.at(0).size();
+	uint8_t rxSize = channel.size();
 	complex2DVector_t txQ;
 	txQ.resize(txSize);
 
@@ -691,10 +1238,10 @@ MmWave3gppChannel::LongTermCovMatrixBeamforming(Ptr<Params3gpp> params) const
 			for(uint8_t rxIndex = 0; rxIndex < rxSize; rxIndex++)
 			{
 				std::complex<double> cSum (0,0);
-				for (uint8_t cIndex = 0; cIndex < params->m_channel.at(rxIndex).at(t1Index).size(); cIndex++)
+				for (uint8_t cIndex = 0; cIndex < channel.at(rxIndex).at(t1Index).size(); cIndex++)
 				{
-					cSum = cSum + std::conj(params->m_channel.at(rxIndex).at(t1Index).at(cIndex))*
-							(params->m_channel.at(rxIndex).at(t2Index).at(cIndex));
+					cSum = cSum + std::conj(channel.at(rxIndex).at(t1Index).at(cIndex))*
+							(channel.at(rxIndex).at(t2Index).at(cIndex));
 				}
 				txQ[t1Index][t2Index] += cSum;
 			}
@@ -764,10 +1311,10 @@ MmWave3gppChannel::LongTermCovMatrixBeamforming(Ptr<Params3gpp> params) const
 			for(uint8_t txIndex = 0; txIndex < txSize; txIndex++)
             {
 				std::complex<double> cSum (0,0);
-				for (uint8_t cIndex = 0; cIndex < params->m_channel.at(r1Index).at(txIndex).size(); cIndex++)
+				for (uint8_t cIndex = 0; cIndex < channel.at(r1Index).at(txIndex).size(); cIndex++)
 				{
-					cSum = cSum + params->m_channel.at(r1Index).at(txIndex).at(cIndex)*
-							std::conj(params->m_channel.at(r2Index).at(txIndex).at(cIndex));
+					cSum = cSum + channel.at(r1Index).at(txIndex).at(cIndex)*
+							std::conj(channel.at(r2Index).at(txIndex).at(cIndex));
 				}
 				rxQ[r1Index][r2Index] += cSum;
             }
@@ -840,38 +1387,40 @@ MmWave3gppChannel::CalBeamformingGain (Ptr<const SpectrumValue> txPsd, Ptr<Param
 	//uint8_t txAntenna = params->m_txW.size();
 	//uint8_t rxAntenna = params->m_rxW.size();
 	//the update of Doppler is simplified by only taking the center angle of each cluster in to consideration.
-	Values::iterator vit = tempPsd->ValuesBegin ();
-	uint16_t iSubband = 0;
-	double slotTime = Simulator::Now ().GetSeconds ();
-	complexVector_t doppler;
+	complexVector_t doppler = CalDoppler (params, speed);
+
+	MmWaveSubbandGain &kernel = MmWaveSubbandGain::GetThreadKernel ();
+	kernel.Clear ();
+	kernel.Reserve (numCluster);
 	for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
 	{
-		//cluster angle angle[direction][n],where, direction = 0(aoa), 1(zoa).
-		double temp_doppler = 2*M_PI*(sin(params->m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*cos(params->m_angle.at(AOA_INDEX).at(cIndex)*M_PI/180)*speed.x
-				+ sin(params->m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*sin(params->m_angle.at(AOA_INDEX).at(cIndex)*M_PI/180)*speed.y
-				+ cos(params->m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*speed.z)*slotTime*m_phyMacConfig->GetCentreFrequency ()/3e8;
-		doppler.push_back(exp(std::complex<double> (0, temp_doppler)));
-
+		kernel.AddCluster (params->m_longTerm.at(cIndex)*doppler.at(cIndex), params->m_delay.at (cIndex));
 	}
+	double firstFrequency = m_phyMacConfig->GetCentreFrequency () - GetSystemBandwidth ()/2;
+	kernel.Apply (firstFrequency, m_phyMacConfig->GetChunkWidth (), *tempPsd);
+	return tempPsd;
+}
 
-	while (vit != tempPsd->ValuesEnd ())
+complexVector_t
+MmWave3gppChannel::CalDoppler (Ptr<Params3gpp> params, Vector speed) const
+{
+	uint8_t numCluster = params->m_delay.size();
+	double slotTime = Simulator::Now ().GetSeconds ();
+	complexVector_t doppler;
+	for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
 	{
-		std::complex<double> subsbandGain (0.0,0.0);
-		if ((*vit) != 0.00)
-		{
-			double fsb = m_phyMacConfig->GetCentreFrequency () - GetSystemBandwidth ()/2 + m_phyMacConfig->GetChunkWidth ()*iSubband ;
-			for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
-			{
-				double delay = -2*M_PI*fsb*(params->m_delay.at (cIndex));
-				std::complex<double> txSum(0,0);
-				subsbandGain = subsbandGain + params->m_longTerm.at(cIndex)*doppler.at(cIndex)*exp(std::complex<double>(0, delay));
-			}
-			*vit = (*vit)*(norm (subsbandGain));
-		}
-		vit++;
-		iSubband++;
+		doppler.push_back(exp(std::complex<double> (0, CalDopplerPhase (*params, speed, cIndex, slotTime))));
 	}
-	return tempPsd;
+	return doppler;
+}
+
+double
+MmWave3gppChannel::CalDopplerPhase (const Params3gpp &params, Vector speed, uint8_t cIndex, double time) const
+{
+	//cluster angle angle[direction][n],where, direction = 0(aoa), 1(zoa).
+	return 2*M_PI*(sin(params.m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*cos(params.m_angle.at(AOA_INDEX).at(cIndex)*M_PI/180)*speed.x
+			+ sin(params.m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*sin(params.m_angle.at(AOA_INDEX).at(cIndex)*M_PI/180)*speed.y
+			+ cos(params.m_angle.at(ZOA_INDEX).at(cIndex)*M_PI/180)*speed.z)*time*m_phyMacConfig->GetCentreFrequency ()/3e8;
 }
 
 double
@@ -886,6 +1435,8 @@ void
 MmWave3gppChannel::SetPathlossModel (Ptr<PropagationLossModel> pathloss)
 {
 	m_3gppPathloss = pathloss;
+	m_3gppLossModel = DynamicCast<MmWave3gppPropagationLossModel> (m_3gppPathloss);
+	m_3gppBuildingsLossModel = DynamicCast<MmWave3gppBuildingsPropagationLossModel> (m_3gppPathloss);
 	if (DynamicCast<MmWave3gppPropagationLossModel> (m_3gppPathloss)!=0)
 	{
 		m_scenario = m_3gppPathloss->GetObject<MmWave3gppPropagationLossModel> ()->GetScenario();
@@ -906,6 +1457,7 @@ MmWave3gppChannel::CalLongTerm (Ptr<Params3gpp> params) const
 {
 	uint8_t txAntenna = params->m_txW.size();
 	uint8_t rxAntenna = params->m_rxW.size();
+	const complex3DVector_t &channel = GetChannelMatrix (params);
 
 	//store the long term part to reduce computation load
 	//only the small scale fading is need to be updated if the large scale parameters and antenna weights remain unchanged.
@@ -920,14 +1472,73 @@ MmWave3gppChannel::CalLongTerm (Ptr<Params3gpp> params) const
 			std::complex<double> rxSum(0,0);
 			for (uint8_t rxIndex = 0; rxIndex < rxAntenna; rxIndex++)
 			{
-				rxSum = rxSum + std::conj(params->m_rxW.at(rxIndex))*params->m_channel.at(rxIndex).at(txIndex).at(cIndex);
+				rxSum = rxSum + std::conj(params->m_rxW.at(rxIndex))*channel.at(rxIndex).at(txIndex).at(cIndex);
 			}
 			txSum = txSum + params->m_txW.at(txIndex)*rxSum;
 		}
 		longTerm.push_back(txSum);
 	}
 	params->m_longTerm = longTerm;
+	params->m_longTermVersion++;
+
+}
 
+const complexVector_t&
+MmWave3gppChannel::GetCodebookLongTerm (Ptr<Params3gpp> params, Ptr<const MmWaveCodebook> txCodebookObject,
+		Ptr<const MmWaveCodebook> rxCodebookObject, uint16_t txBeamId, uint16_t rxBeamId) const
+{
+	NS_ASSERT_MSG (!IsChannelDeleted (*params), "the channel matrix has been deleted");
+
+	const complex2DVector_t &txCodebook = txCodebookObject->m_codewords;
+	const complex2DVector_t &rxCodebook = rxCodebookObject->m_codewords;
+	if (params->m_txCodebook != txCodebookObject || params->m_rxCodebook != rxCodebookObject
+			|| params->m_codebookLongTerm.size () != txCodebook.size ())
+	{
+		params->m_txCodebook = txCodebookObject;
+		params->m_rxCodebook = rxCodebookObject;
+		params->m_codebookLongTerm.clear ();
+		params->m_codebookLongTerm.resize (txCodebook.size ());
+	}
+
+	complex2DVector_t &txRow = params->m_codebookLongTerm.at (txBeamId);
+	if (txRow.empty ())
+	{
+		const complex3DVector_t &channel = GetChannelMatrix (params);
+		uint16_t rxAntenna = channel.size ();
+		uint8_t numCluster = params->m_delay.size ();
+		const complexVector_t &txW = txCodebook.at (txBeamId);
+
+		// project the channel onto the tx codeword first, projection[u*numCluster+n] = sum_s H[u][s][n]*txW[s],
+		// then onto every rx codeword
+		complexVector_t projection (rxAntenna*numCluster, std::complex<double> (0,0));
+		for (uint16_t rxIndex = 0; rxIndex < rxAntenna; rxIndex++)
+		{
+			for (uint16_t txIndex = 0; txIndex < txW.size (); txIndex++)
+			{
+				const complexVector_t &h = channel[rxIndex].at (txIndex);
+				for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
+				{
+					projection[rxIndex*numCluster+cIndex] += txW[txIndex]*h[cIndex];
+				}
+			}
+		}
+
+		txRow.assign (rxCodebook.size (), complexVector_t (numCluster, std::complex<double> (0,0)));
+		for (uint16_t rxBeam = 0; rxBeam < rxCodebook.size (); rxBeam++)
+		{
+			const complexVector_t &rxW = rxCodebook[rxBeam];
+			complexVector_t &longTerm = txRow[rxBeam];
+			for (uint16_t rxIndex = 0; rxIndex < rxW.size (); rxIndex++)
+			{
+				std::complex<double> rxConj = std::conj (rxW[rxIndex]);
+				for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
+				{
+					longTerm[cIndex] += rxConj*projection[rxIndex*numCluster+cIndex];
+				}
+			}
+		}
+	}
+	return txRow.at (rxBeamId);
 }
 
 Ptr<ParamsTable>
@@ -1129,6 +1740,19 @@ MmWave3gppChannel::DeleteChannel(Ptr<const MobilityModel> a, Ptr<const MobilityM
 	NS_LOG_INFO("params m_channel size" << params->m_channel.size());
 	NS_ASSERT_MSG(m_channelMap.find(std::make_pair(dev1,dev2)) != m_channelMap.end(), "Channel not found");
 	params->m_channel.clear();
+	params->m_codebookLongTerm.clear();
+	if (params->m_compact)
+	{
+		std::map<Ptr<Params3gpp>, ChannelMatrixCache::iterator>::iterator it = m_channelMatrixCacheIndex.find (params);
+		if (it != m_channelMatrixCacheIndex.end ())
+		{
+			m_channelMatrixCache.erase (it->second);
+			m_channelMatrixCacheIndex.erase (it);
+		}
+		params->m_compact = false;
+		params->m_rays.m_txAntenna = 0;
+		params->m_rays.m_rxAntenna = 0;
+	}
 	m_channelMap[std::make_pair(dev1,dev2)] = params;
 
 	/*
@@ -1149,9 +1773,9 @@ MmWave3gppChannel::DeleteChannel(Ptr<const MobilityModel> a, Ptr<const MobilityM
 
 Ptr<Params3gpp>
 MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool los, bool o2i,
-		Ptr<AntennaArrayModel> txAntenna, Ptr<AntennaArrayModel> rxAntenna,
+		const Ptr<AntennaArrayModel> &txAntenna, const Ptr<AntennaArrayModel> &rxAntenna,
 		uint8_t *txAntennaNum, uint8_t *rxAntennaNum,  Angles &rxAngle, Angles &txAngle,
-		Vector speed, double dis2D, double dis3D) const
+		Vector speed, double dis2D, double dis3D, const ChannelRandomStreams &streams) const
 {
 	uint8_t numOfCluster = table3gpp->m_numOfCluster;
 	uint8_t raysPerCluster = table3gpp->m_raysPerCluster;
@@ -1179,7 +1803,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 	//Generate paramNum independent LSPs.
 	for (uint8_t iter = 0; iter < paramNum; iter++)
 	{
-		LSPsIndep.push_back(m_normalRv->GetValue());
+		LSPsIndep.push_back(streams.GetNormal ());
 	}
 	for (uint8_t row = 0; row < paramNum; row++)
 	{
@@ -1241,7 +1865,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 	double minTau = 100.0;
 	for (uint8_t cIndex = 0; cIndex < numOfCluster; cIndex++)
 	{
-		double tau = -1*table3gpp->m_rTau*DS*log(m_uniformRv->GetValue(0,1)); //(7.5-1)
+		double tau = -1*table3gpp->m_rTau*DS*log(streams.GetUniform (0,1)); //(7.5-1)
 		if(minTau > tau)
 		{
 			minTau = tau;
@@ -1264,7 +1888,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 	for (uint8_t cIndex = 0; cIndex < numOfCluster; cIndex++)
 	{
 		double power = exp(-1*clusterDelay.at(cIndex)*(table3gpp->m_rTau-1)/table3gpp->m_rTau/DS)*
-				pow(10,-1*m_normalRv->GetValue()*table3gpp->m_shadowingStd/10); //(7.5-5)
+				pow(10,-1*streams.GetNormal ()*table3gpp->m_shadowingStd/10); //(7.5-5)
 		powerSum +=power;
 		clusterPower.push_back(power);
 	}
@@ -1438,21 +2062,21 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 	for (uint8_t cIndex = 0; cIndex < numReducedCluster; cIndex++)
 	{
 		int Xn = 1;
-		if (m_uniformRv->GetValue(0,1) < 0.5)
+		if (streams.GetUniform (0,1) < 0.5)
 		{
 			Xn = -1;
 		}
-		clusterAoa.at(cIndex) = clusterAoa.at(cIndex)*Xn+(m_normalRv->GetValue()*ASA/7)+rxAngle.phi*180/M_PI; //(7.5-11)
-		clusterAod.at(cIndex) = clusterAod.at(cIndex)*Xn+(m_normalRv->GetValue()*ASD/7)+txAngle.phi*180/M_PI;
+		clusterAoa.at(cIndex) = clusterAoa.at(cIndex)*Xn+(streams.GetNormal ()*ASA/7)+rxAngle.phi*180/M_PI; //(7.5-11)
+		clusterAod.at(cIndex) = clusterAod.at(cIndex)*Xn+(streams.GetNormal ()*ASD/7)+txAngle.phi*180/M_PI;
 		if (o2i)
 		{
-			clusterZoa.at(cIndex) = clusterZoa.at(cIndex)*Xn+(m_normalRv->GetValue()*ZSA/7)+90; //(7.5-16)
+			clusterZoa.at(cIndex) = clusterZoa.at(cIndex)*Xn+(streams.GetNormal ()*ZSA/7)+90; //(7.5-16)
 		}
 		else
 		{
-			clusterZoa.at(cIndex) = clusterZoa.at(cIndex)*Xn+(m_normalRv->GetValue()*ZSA/7)+rxAngle.theta*180/M_PI; //(7.5-16)
+			clusterZoa.at(cIndex) = clusterZoa.at(cIndex)*Xn+(streams.GetNormal ()*ZSA/7)+rxAngle.theta*180/M_PI; //(7.5-16)
 		}
-		clusterZod.at(cIndex) = clusterZod.at(cIndex)*Xn+(m_normalRv->GetValue()*ZSD/7)+txAngle.theta*180/M_PI+table3gpp->m_offsetZOD; //(7.5-19)
+		clusterZod.at(cIndex) = clusterZod.at(cIndex)*Xn+(streams.GetNormal ()*ZSD/7)+txAngle.theta*180/M_PI+table3gpp->m_offsetZOD; //(7.5-19)
 
 	}
 
@@ -1606,7 +2230,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 	doubleVector_t attenuation_dB;
 	if(m_blockage)
 	{
-		 attenuation_dB = CalAttenuationOfBlockage (channelParams, clusterAoa, clusterZoa);
+		 attenuation_dB = CalAttenuationOfBlockage (channelParams, clusterAoa, clusterZoa, streams);
 		 for (uint8_t cInd = 0; cInd < numReducedCluster; cInd++)
 		 {
 			 clusterPower.at (cInd) = clusterPower.at (cInd)/pow(10,attenuation_dB.at (cInd)/10);
@@ -1678,21 +2302,16 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 		doubleVector_t temp;
 		for(uint8_t mInd = 0; mInd < raysPerCluster; mInd++)
 		{
-			temp.push_back(m_uniformRv->GetValue(-1*M_PI, M_PI));
+			temp.push_back(streams.GetUniform (-1*M_PI, M_PI));
 		}
 		clusterPhase.push_back(temp);
 	}
-	double losPhase = m_uniformRv->GetValue(-1*M_PI, M_PI);
+	double losPhase = streams.GetUniform (-1*M_PI, M_PI);
 	channelParams->m_clusterPhase = clusterPhase;
 	channelParams->m_losPhase = losPhase;
 
 	//Step 11: Generate channel coefficients for each cluster n and each receiver and transmitter element pair u,s.
 
-	complex3DVector_t H_NLOS; // channel coefficients H_NLOS [u][s][n],
-							  // where u and s are receive and transmit antenna element, n is cluster index.
-	uint16_t uSize = rxAntennaNum[0]*rxAntennaNum[1];
-	uint16_t sSize = txAntennaNum[0]*txAntennaNum[1];
-
 	uint8_t cluster1st = 0, cluster2nd = 0; // first and second strongest cluster;
 	double maxPower = 0;
 	for (uint8_t cIndex = 0; cIndex < numReducedCluster; cIndex++)
@@ -1715,167 +2334,21 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 
 	NS_LOG_INFO ("1st strongest cluster:"<<(int)cluster1st<<", 2nd strongest cluster:"<<(int)cluster2nd);
 
-	complex3DVector_t H_usn; //channel coffecient H_usn[u][s][n];
-	//Since each of the strongest 2 clusters are divided into 3 sub-clusters, the total cluster will be numReducedCLuster + 4.
+	// the ray parameters are kept to compute the matrix again for the links whose matrix is not stored
+	ChannelRays &rayParams = channelParams->m_rays;
+	SetRayAngles (rayParams, numReducedCluster, raysPerCluster, &rayAoa_radian[0][0], &rayZoa_radian[0][0],
+			&rayAod_radian[0][0], &rayZod_radian[0][0]);
+	rayParams.m_clusterPower = clusterPower;
+	rayParams.m_cluster1st = cluster1st;
+	rayParams.m_cluster2nd = cluster2nd;
+	rayParams.m_losAttenuationDb = attenuation_dB.at (0);
+	rayParams.m_rxAngle = rxAngle;
+	rayParams.m_txAngle = txAngle;
+	std::copy (txAntennaNum, txAntennaNum + 2, rayParams.m_txAntennaNum);
+	std::copy (rxAntennaNum, rxAntennaNum + 2, rayParams.m_rxAntennaNum);
+	CalChannelMatrix (*channelParams, txAntenna, rxAntenna, channelParams->m_channel);
 
-	H_usn.resize(uSize);
-	for (uint16_t uIndex = 0; uIndex < uSize; uIndex++)
-	{
-		H_usn.at(uIndex).resize(sSize);
-		for (uint16_t sIndex = 0; sIndex < sSize; sIndex++)
-		{
-			H_usn.at(uIndex).at(sIndex).resize(numReducedCluster);
-		}
-	}
-	//double slotTime = Simulator::Now ().GetSeconds ();
-	// The following for loops computes the channel coefficients
-	for (uint16_t uIndex = 0; uIndex < uSize; uIndex++)
-	{
-		Vector uLoc = rxAntenna->GetAntennaLocation(uIndex,rxAntennaNum);
-
-		for (uint16_t sIndex = 0; sIndex < sSize; sIndex++)
-		{
-
-			Vector sLoc = txAntenna->GetAntennaLocation(sIndex,txAntennaNum);
-
-			for (uint8_t nIndex = 0; nIndex < numReducedCluster; nIndex++)
-			{
-				//Compute the N-2 weakest cluster, only vertical polarization. (7.5-22)
-				if(nIndex != cluster1st && nIndex != cluster2nd)
-				{
-					std::complex<double> rays(0,0);
-					for(uint8_t mIndex = 0; mIndex < raysPerCluster; mIndex++)
-					{
-						double initialPhase = clusterPhase.at(nIndex).at(mIndex);
-						//lambda_0 is accounted in the antenna spacing uLoc and sLoc.
-						double rxPhaseDiff = 2*M_PI*(sin(rayZoa_radian[nIndex][mIndex])*cos(rayAoa_radian[nIndex][mIndex])*uLoc.x
-								+ sin(rayZoa_radian[nIndex][mIndex])*sin(rayAoa_radian[nIndex][mIndex])*uLoc.y
-								+ cos(rayZoa_radian[nIndex][mIndex])*uLoc.z);
-
-						double txPhaseDiff = 2*M_PI*(sin(rayZod_radian[nIndex][mIndex])*cos(rayAod_radian[nIndex][mIndex])*sLoc.x
-								+ sin(rayZod_radian[nIndex][mIndex])*sin(rayAod_radian[nIndex][mIndex])*sLoc.y
-								+ cos(rayZod_radian[nIndex][mIndex])*sLoc.z);
-						//Doppler is computed in the CalBeamformingGain function and is simplified to only account for the center anngle of each cluster.
-						//double doppler = 2*M_PI*(sin(rayZoa_radian[nIndex][mIndex])*cos(rayAoa_radian[nIndex][mIndex])*relativeSpeed.x
-						//		+ sin(rayZoa_radian[nIndex][mIndex])*sin(rayAoa_radian[nIndex][mIndex])*relativeSpeed.y
-						//		+ cos(rayZoa_radian[nIndex][mIndex])*relativeSpeed.z)*slotTime*m_phyMacConfig->GetCentreFrequency ()/3e8;
-						rays += exp(std::complex<double>(0, initialPhase))
-								*(rxAntenna->GetRadiationPattern(rayZoa_radian[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayZod_radian[nIndex][mIndex]))
-								*exp(std::complex<double>(0, rxPhaseDiff))
-								*exp(std::complex<double>(0, txPhaseDiff));
-								//*exp(std::complex<double>(0, doppler));
-						//rays += 1;
-					}
-					//rays *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
-					rays *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = rays;
-				}
-				else //(7.5-28)
-				{
-					std::complex<double> raysSub1(0,0);
-					std::complex<double> raysSub2(0,0);
-					std::complex<double> raysSub3(0,0);
-
-					for(uint8_t mIndex = 0; mIndex < raysPerCluster; mIndex++)
-					{
-
-						//ZML:Just remind me that the angle offsets for the 3 subclusters were not generated correctly.
-
-						double initialPhase = clusterPhase.at(nIndex).at(mIndex);
-						double rxPhaseDiff = 2*M_PI*(sin(rayZoa_radian[nIndex][mIndex])*cos(rayAoa_radian[nIndex][mIndex])*uLoc.x
-								+ sin(rayZoa_radian[nIndex][mIndex])*sin(rayAoa_radian[nIndex][mIndex])*uLoc.y
-								+ cos(rayZoa_radian[nIndex][mIndex])*uLoc.z);
-						double txPhaseDiff = 2*M_PI*(sin(rayZod_radian[nIndex][mIndex])*cos(rayAod_radian[nIndex][mIndex])*sLoc.x
-								+ sin(rayZod_radian[nIndex][mIndex])*sin(rayAod_radian[nIndex][mIndex])*sLoc.y
-								+ cos(rayZod_radian[nIndex][mIndex])*sLoc.z);
-						//double doppler = 2*M_PI*(sin(rayZoa_radian[nIndex][mIndex])*cos(rayAoa_radian[nIndex][mIndex])*relativeSpeed.x
-						//		+ sin(rayZoa_radian[nIndex][mIndex])*sin(rayAoa_radian[nIndex][mIndex])*relativeSpeed.y
-						//		+ cos(rayZoa_radian[nIndex][mIndex])*relativeSpeed.z)*slotTime*m_phyMacConfig->GetCentreFrequency ()/3e8;
-						//double delaySpread;
-						switch(mIndex)
-						{
-						case 9:
-						case 10:
-						case 11:
-						case 12:
-						case 17:
-						case 18:
-							//delaySpread= -2*M_PI*(clusterDelay.at(nIndex)+1.28*c_DS)*m_phyMacConfig->GetCentreFrequency ();
-							raysSub2 += exp(std::complex<double>(0, initialPhase))
-								*(rxAntenna->GetRadiationPattern(rayZoa_radian[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayZod_radian[nIndex][mIndex]))
-								*exp(std::complex<double>(0, rxPhaseDiff))
-								*exp(std::complex<double>(0, txPhaseDiff));
-								//*exp(std::complex<double>(0, doppler));
-							//raysSub2 +=1;
-							break;
-						case 13:
-						case 14:
-						case 15:
-						case 16:
-							//delaySpread = -2*M_PI*(clusterDelay.at(nIndex)+2.56*c_DS)*m_phyMacConfig->GetCentreFrequency ();
-							raysSub3 += exp(std::complex<double>(0, initialPhase))
-								*(rxAntenna->GetRadiationPattern(rayZoa_radian[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayZod_radian[nIndex][mIndex]))
-								*exp(std::complex<double>(0, rxPhaseDiff))
-								*exp(std::complex<double>(0, txPhaseDiff));
-								//*exp(std::complex<double>(0, doppler));
-							//raysSub3 +=1;
-							break;
-						default://case 1,2,3,4,5,6,7,8,19,20
-							//delaySpread = -2*M_PI*clusterDelay.at(nIndex)*m_phyMacConfig->GetCentreFrequency ();
-							raysSub1 += exp(std::complex<double>(0, initialPhase))
-								*(rxAntenna->GetRadiationPattern(rayZoa_radian[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayZod_radian[nIndex][mIndex]))
-								*exp(std::complex<double>(0, rxPhaseDiff))
-								*exp(std::complex<double>(0, txPhaseDiff));
-								//*exp(std::complex<double>(0, doppler));
-							//raysSub1 +=1;
-							break;
-						}
-					}
-					//raysSub1 *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
-					//raysSub2 *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
-					//raysSub3 *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
-					raysSub1 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					raysSub2 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					raysSub3 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = raysSub1;
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub2);
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub3);
-
-				}
-			}
-			if(los) //(7.5-29) && (7.5-30)
-			{
-				std::complex<double> ray(0,0);
-				double rxPhaseDiff = 2*M_PI*(sin(rxAngle.theta)*cos(rxAngle.phi)*uLoc.x
-						+ sin(rxAngle.theta)*sin(rxAngle.phi)*uLoc.y
-						+ cos(rxAngle.theta)*uLoc.z);
-				double txPhaseDiff = 2*M_PI*(sin(txAngle.theta)*cos(txAngle.phi)*sLoc.x
-						+ sin(txAngle.theta)*sin(txAngle.phi)*sLoc.y
-						+ cos(txAngle.theta)*sLoc.z);
-				//double doppler = 2*M_PI*(sin(rxAngle.theta)*cos(rxAngle.phi)*relativeSpeed.x
-				//		+ sin(rxAngle.theta)*sin(rxAngle.phi)*relativeSpeed.y
-				//		+ cos(rxAngle.theta)*relativeSpeed.z)*slotTime*m_phyMacConfig->GetCentreFrequency ()/3e8;
-
-				ray = exp(std::complex<double>(0, losPhase))
-						*(rxAntenna->GetRadiationPattern(rxAngle.theta)*txAntenna->GetRadiationPattern(txAngle.theta))
-						*exp(std::complex<double>(0, rxPhaseDiff))
-						*exp(std::complex<double>(0, txPhaseDiff));
-						//*exp(std::complex<double>(0, doppler));
-
-				double K_linear = pow(10,K_factor/10);
-				// the LOS path should be attenuated if blockage is enabled.
-				H_usn.at(uIndex).at(sIndex).at(0) = sqrt(1/(K_linear+1))*H_usn.at(uIndex).at(sIndex).at(0)+sqrt(K_linear/(1+K_linear))*ray/pow(10,attenuation_dB.at (0)/10);  //(7.5-30) for tau = tau1
-				double tempSize = H_usn.at(uIndex).at(sIndex).size();
-				for(uint8_t nIndex = 1; nIndex < tempSize; nIndex++)
-				{
-					H_usn.at(uIndex).at(sIndex).at(nIndex) *= sqrt(1/(K_linear+1)); //(7.5-30) for tau = tau2...taunN
-				}
-
-			}
-		}
-	}
-
-	if (cluster1st == cluster2nd)
+	if (cluster1st == cluster2nd)
 	{
 		clusterDelay.push_back(clusterDelay.at(cluster1st)+1.28*table3gpp->m_cDS);
 		clusterDelay.push_back(clusterDelay.at(cluster1st)+2.56*table3gpp->m_cDS);
@@ -1933,7 +2406,7 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 
 	}
 
-	NS_LOG_INFO ("size of coefficient matrix =["<<H_usn.size() << "][" << H_usn.at(0).size() << "][" << H_usn.at (0).at(0).size()<<"]");
+	NS_LOG_INFO ("size of coefficient matrix =["<<channelParams->m_channel.size() << "][" << channelParams->m_channel.at(0).size() << "][" << channelParams->m_channel.at (0).at(0).size()<<"]");
 
 
 	/*std::cout << "Delay:";
@@ -1943,7 +2416,6 @@ MmWave3gppChannel::GetNewChannel(Ptr<ParamsTable>  table3gpp, Vector locUT, bool
 	}
 	std::cout << "\n";*/
 
-	channelParams->m_channel = H_usn;
 	channelParams->m_delay = clusterDelay;
 
 	channelParams->m_angle.clear();
@@ -2254,7 +2726,7 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 	doubleVector_t attenuation_dB;
 	if(m_blockage)
 	{
-		 attenuation_dB = CalAttenuationOfBlockage (params, clusterAoa, clusterZoa);
+		 attenuation_dB = CalAttenuationOfBlockage (params, clusterAoa, clusterZoa, GetChannelRandomStreams ());
 		 for (uint8_t cInd = 0; cInd < params->m_numCluster; cInd++)
 		 {
 			 clusterPower.at (cInd) = clusterPower.at (cInd)/pow(10,attenuation_dB.at (cInd)/10);
@@ -2326,17 +2798,10 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 	//This step is skipped, only vertical polarization is considered in this version
 
 	//Step 10: Draw initial phases
-	double2DVector_t clusterPhase = params->m_clusterPhase; //rayAoa_radian[n][m], where n is cluster index, m is ray index
-	double losPhase = params->m_losPhase;
-	// these two should also be generated from previous channel.
+	// the initial phases of the previous channel, params->m_clusterPhase and params->m_losPhase, are kept.
 
 	//Step 11: Generate channel coefficients for each cluster n and each receiver and transmitter element pair u,s.
 
-	complex3DVector_t H_NLOS; // channel coefficients H_NLOS [u][s][n],
-							  // where u and s are receive and transmit antenna element, n is cluster index.
-	uint16_t uSize = rxAntennaNum[0]*rxAntennaNum[1];
-	uint16_t sSize = txAntennaNum[0]*txAntennaNum[1];
-
 	uint8_t cluster1st = 0, cluster2nd = 0; // first and second strongest cluster;
 	double maxPower = 0;
 	for (uint8_t cIndex = 0; cIndex < params->m_numCluster; cIndex++)
@@ -2359,16 +2824,105 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 
 	NS_LOG_INFO ("1st strongest cluster:"<<(int)cluster1st<<", 2nd strongest cluster:"<<(int)cluster2nd);
 
-	complex3DVector_t H_usn; //channel coffecient H_usn[u][s][n];
-	//Since each of the strongest 2 clusters are divided into 3 sub-clusters, the total cluster will be numReducedCLuster + 4.
+	// the ray parameters are kept to compute the matrix again for the links whose matrix is not stored
+	ChannelRays &rayParams = params->m_rays;
+	SetRayAngles (rayParams, params->m_numCluster, raysPerCluster, &rayAoa_radian[0][0], &rayZoa_radian[0][0],
+			&rayAod_radian[0][0], &rayZod_radian[0][0]);
+	rayParams.m_clusterPower = clusterPower;
+	rayParams.m_cluster1st = cluster1st;
+	rayParams.m_cluster2nd = cluster2nd;
+	rayParams.m_losAttenuationDb = attenuation_dB.at (0);
+	rayParams.m_rxAngle = rxAngle;
+	rayParams.m_txAngle = txAngle;
+	std::copy (txAntennaNum, txAntennaNum + 2, rayParams.m_txAntennaNum);
+	std::copy (rxAntennaNum, rxAntennaNum + 2, rayParams.m_rxAntennaNum);
+	CalChannelMatrix (*params, txAntenna, rxAntenna, params->m_channel);
+
+	if (cluster1st == cluster2nd)
+	{
+		clusterDelay.push_back(clusterDelay.at(cluster2nd)+1.28*table3gpp->m_cDS);
+		clusterDelay.push_back(clusterDelay.at(cluster2nd)+2.56*table3gpp->m_cDS);
+
+		clusterAoa.push_back(clusterAoa.at(cluster2nd));
+		clusterAoa.push_back(clusterAoa.at(cluster2nd));
+		clusterZoa.push_back(clusterZoa.at(cluster2nd));
+		clusterZoa.push_back(clusterZoa.at(cluster2nd));
+	}
+	else
+	{
+		double min, max;
+		if(cluster1st < cluster2nd)
+		{
+			min = cluster1st;
+			max = cluster2nd;
+		}
+		else
+		{
+			min = cluster2nd;
+			max = cluster1st;
+		}
+		clusterDelay.push_back(clusterDelay.at(min)+1.28*table3gpp->m_cDS);
+		clusterDelay.push_back(clusterDelay.at(min)+2.56*table3gpp->m_cDS);
+		clusterDelay.push_back(clusterDelay.at(max)+1.28*table3gpp->m_cDS);
+		clusterDelay.push_back(clusterDelay.at(max)+2.56*table3gpp->m_cDS);
+
+		clusterAoa.push_back(clusterAoa.at(min));
+		clusterAoa.push_back(clusterAoa.at(min));
+		clusterAoa.push_back(clusterAoa.at(max));
+		clusterAoa.push_back(clusterAoa.at(max));
+
+		clusterZoa.push_back(clusterZoa.at(min));
+		clusterZoa.push_back(clusterZoa.at(min));
+		clusterZoa.push_back(clusterZoa.at(max));
+		clusterZoa.push_back(clusterZoa.at(max));
+
 
-	H_usn.resize(uSize);
+	}
+
+	NS_LOG_INFO ("size of coefficient matrix =["<<params->m_channel.size() << "][" << params->m_channel.at(0).size() << "][" << params->m_channel.at (0).at(0).size()<<"]");
+
+
+	/*std::cout << "Delay:";
+	for (uint8_t i = 0; i < clusterDelay.size(); i++)
+	{
+		std::cout <<clusterDelay.at(i)<<"s\t";
+	}
+	std::cout << "\n";*/
+
+	params->m_delay = clusterDelay;
+	params->m_codebookLongTerm.clear();
+	params->m_angle.clear();
+	params->m_angle.push_back(clusterAoa);
+	params->m_angle.push_back(clusterZoa);
+	params->m_angle.push_back(clusterAod);
+	params->m_angle.push_back(clusterZod);
+	//update the previous location.
+
+	return params;
+
+}
+
+void
+MmWave3gppChannel::CalChannelMatrix (const Params3gpp &params, const Ptr<AntennaArrayModel> &txAntenna,
+		const Ptr<AntennaArrayModel> &rxAntenna, complex3DVector_t &channel) const
+{
+	const ChannelRays &rayParams = params.m_rays;
+	uint8_t raysPerCluster = rayParams.m_rayAoa.at (0).size ();
+	uint8_t txAntennaNum[2] = {rayParams.m_txAntennaNum[0], rayParams.m_txAntennaNum[1]};
+	uint8_t rxAntennaNum[2] = {rayParams.m_rxAntennaNum[0], rayParams.m_rxAntennaNum[1]};
+	uint16_t uSize = rxAntennaNum[0]*rxAntennaNum[1];
+	uint16_t sSize = txAntennaNum[0]*txAntennaNum[1];
+
+		//Since each of the strongest 2 clusters are divided into 3 sub-clusters, the total cluster will be numReducedCLuster + 4.
+
+	channel.clear ();
+	channel.resize(uSize);
 	for (uint16_t uIndex = 0; uIndex < uSize; uIndex++)
 	{
-		H_usn.at(uIndex).resize(sSize);
+		channel.at(uIndex).resize(sSize);
 		for (uint16_t sIndex = 0; sIndex < sSize; sIndex++)
 		{
-			H_usn.at(uIndex).at(sIndex).resize(params->m_numCluster);
+			channel.at(uIndex).at(sIndex).resize(params.m_numCluster);
 		}
 	}
 	//double slotTime = Simulator::Now ().GetSeconds ();
@@ -2382,37 +2936,37 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 
 			Vector sLoc = txAntenna->GetAntennaLocation(sIndex,txAntennaNum);
 
-			for (uint8_t nIndex = 0; nIndex < params->m_numCluster; nIndex++)
+			for (uint8_t nIndex = 0; nIndex < params.m_numCluster; nIndex++)
 			{
 				//Compute the N-2 weakest cluster, only vertical polarization. (7.5-22)
-				if(nIndex != cluster1st && nIndex != cluster2nd)
+				if(nIndex != rayParams.m_cluster1st && nIndex != rayParams.m_cluster2nd)
 				{
 					std::complex<double> rays(0,0);
 					for(uint8_t mIndex = 0; mIndex < raysPerCluster; mIndex++)
 					{
-						double initialPhase = clusterPhase.at(nIndex).at(mIndex);
+						double initialPhase = params.m_clusterPhase.at(nIndex).at(mIndex);
 						//lambda_0 is accounted in the antenna spacing uLoc and sLoc.
-						double rxPhaseDiff = 2*M_PI*(sin(rayZoa_radian[nIndex][mIndex])*cos(rayAoa_radian[nIndex][mIndex])*uLoc.x
-								+ sin(rayZoa_radian[nIndex][mIndex])*sin(rayAoa_radian[nIndex][mIndex])*uLoc.y
-								+ cos(rayZoa_radian[nIndex][mIndex])*uLoc.z);
+						double rxPhaseDiff = 2*M_PI*(sin(rayParams.m_rayZoa[nIndex][mIndex])*cos(rayParams.m_rayAoa[nIndex][mIndex])*uLoc.x
+								+ sin(rayParams.m_rayZoa[nIndex][mIndex])*sin(rayParams.m_rayAoa[nIndex][mIndex])*uLoc.y
+								+ cos(rayParams.m_rayZoa[nIndex][mIndex])*uLoc.z);
 
-						double txPhaseDiff = 2*M_PI*(sin(rayZod_radian[nIndex][mIndex])*cos(rayAod_radian[nIndex][mIndex])*sLoc.x
-								+ sin(rayZod_radian[nIndex][mIndex])*sin(rayAod_radian[nIndex][mIndex])*sLoc.y
-								+ cos(rayZod_radian[nIndex][mIndex])*sLoc.z);
+						double txPhaseDiff = 2*M_PI*(sin(rayParams.m_rayZod[nIndex][mIndex])*cos(rayParams.m_rayAod[nIndex][mIndex])*sLoc.x
+								+ sin(rayParams.m_rayZod[nIndex][mIndex])*sin(rayParams.m_rayAod[nIndex][mIndex])*sLoc.y
+								+ cos(rayParams.m_rayZod[nIndex][mIndex])*sLoc.z);
 						//Doppler is computed in the CalBeamformingGain function and is simplified to only account for the center anngle of each cluster.
-						//double doppler = 2*M_PI*(sin(rayZoa_radian[nIndex][mIndex])*cos(rayAoa_radian[nIndex][mIndex])*relativeSpeed.x
-						//		+ sin(rayZoa_radian[nIndex][mIndex])*sin(rayAoa_radian[nIndex][mIndex])*relativeSpeed.y
-						//		+ cos(rayZoa_radian[nIndex][mIndex])*relativeSpeed.z)*slotTime*m_phyMacConfig->GetCentreFrequency ()/3e8;
+						//double doppler = 2*M_PI*(sin(rayParams.m_rayZoa[nIndex][mIndex])*cos(rayParams.m_rayAoa[nIndex][mIndex])*relativeSpeed.x
+						//		+ sin(rayParams.m_rayZoa[nIndex][mIndex])*sin(rayParams.m_rayAoa[nIndex][mIndex])*relativeSpeed.y
+						//		+ cos(rayParams.m_rayZoa[nIndex][mIndex])*relativeSpeed.z)*slotTime*m_phyMacConfig->GetCentreFrequency ()/3e8;
 						rays += exp(std::complex<double>(0, initialPhase))
-								*(rxAntenna->GetRadiationPattern(rayZoa_radian[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayZod_radian[nIndex][mIndex]))
+								*(rxAntenna->GetRadiationPattern(rayParams.m_rayZoa[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayParams.m_rayZod[nIndex][mIndex]))
 								*exp(std::complex<double>(0, rxPhaseDiff))
 								*exp(std::complex<double>(0, txPhaseDiff));
 								//*exp(std::complex<double>(0, doppler));
 						//rays += 1;
 					}
-					//rays *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
-					rays *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = rays;
+					//rays *= sqrt(rayParams.m_clusterPower.at(nIndex))/raysPerCluster;
+					rays *= sqrt(rayParams.m_clusterPower.at(nIndex)/raysPerCluster);
+					channel.at(uIndex).at(sIndex).at(nIndex) = rays;
 				}
 				else //(7.5-28)
 				{
@@ -2422,16 +2976,19 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 
 					for(uint8_t mIndex = 0; mIndex < raysPerCluster; mIndex++)
 					{
-						double initialPhase = clusterPhase.at(nIndex).at(mIndex);
-						double rxPhaseDiff = 2*M_PI*(sin(rayZoa_radian[nIndex][mIndex])*cos(rayAoa_radian[nIndex][mIndex])*uLoc.x
-								+ sin(rayZoa_radian[nIndex][mIndex])*sin(rayAoa_radian[nIndex][mIndex])*uLoc.y
-								+ cos(rayZoa_radian[nIndex][mIndex])*uLoc.z);
-						double txPhaseDiff = 2*M_PI*(sin(rayZod_radian[nIndex][mIndex])*cos(rayAod_radian[nIndex][mIndex])*sLoc.x
-								+ sin(rayZod_radian[nIndex][mIndex])*sin(rayAod_radian[nIndex][mIndex])*sLoc.y
-								+ cos(rayZod_radian[nIndex][mIndex])*sLoc.z);
-						//double doppler = 2*M_PI*(sin(rayZoa_radian[nIndex][mIndex])*cos(rayAoa_radian[nIndex][mIndex])*relativeSpeed.x
-						//		+ sin(rayZoa_radian[nIndex][mIndex])*sin(rayAoa_radian[nIndex][mIndex])*relativeSpeed.y
-						//		+ cos(rayZoa_radian[nIndex][mIndex])*relativeSpeed.z)*slotTime*m_phyMacConfig->GetCentreFrequency ()/3e8;
+
+						//ZML:Just remind me that the angle offsets for the 3 subclusters were not generated correctly.
+
+						double initialPhase = params.m_clusterPhase.at(nIndex).at(mIndex);
+						double rxPhaseDiff = 2*M_PI*(sin(rayParams.m_rayZoa[nIndex][mIndex])*cos(rayParams.m_rayAoa[nIndex][mIndex])*uLoc.x
+								+ sin(rayParams.m_rayZoa[nIndex][mIndex])*sin(rayParams.m_rayAoa[nIndex][mIndex])*uLoc.y
+								+ cos(rayParams.m_rayZoa[nIndex][mIndex])*uLoc.z);
+						double txPhaseDiff = 2*M_PI*(sin(rayParams.m_rayZod[nIndex][mIndex])*cos(rayParams.m_rayAod[nIndex][mIndex])*sLoc.x
+								+ sin(rayParams.m_rayZod[nIndex][mIndex])*sin(rayParams.m_rayAod[nIndex][mIndex])*sLoc.y
+								+ cos(rayParams.m_rayZod[nIndex][mIndex])*sLoc.z);
+						//double doppler = 2*M_PI*(sin(rayParams.m_rayZoa[nIndex][mIndex])*cos(rayParams.m_rayAoa[nIndex][mIndex])*relativeSpeed.x
+						//		+ sin(rayParams.m_rayZoa[nIndex][mIndex])*sin(rayParams.m_rayAoa[nIndex][mIndex])*relativeSpeed.y
+						//		+ cos(rayParams.m_rayZoa[nIndex][mIndex])*relativeSpeed.z)*slotTime*m_phyMacConfig->GetCentreFrequency ()/3e8;
 						//double delaySpread;
 						switch(mIndex)
 						{
@@ -2443,7 +3000,7 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 						case 18:
 							//delaySpread= -2*M_PI*(clusterDelay.at(nIndex)+1.28*c_DS)*m_phyMacConfig->GetCentreFrequency ();
 							raysSub2 += exp(std::complex<double>(0, initialPhase))
-								*(rxAntenna->GetRadiationPattern(rayZoa_radian[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayZod_radian[nIndex][mIndex]))
+								*(rxAntenna->GetRadiationPattern(rayParams.m_rayZoa[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayParams.m_rayZod[nIndex][mIndex]))
 								*exp(std::complex<double>(0, rxPhaseDiff))
 								*exp(std::complex<double>(0, txPhaseDiff));
 								//*exp(std::complex<double>(0, doppler));
@@ -2455,7 +3012,7 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 						case 16:
 							//delaySpread = -2*M_PI*(clusterDelay.at(nIndex)+2.56*c_DS)*m_phyMacConfig->GetCentreFrequency ();
 							raysSub3 += exp(std::complex<double>(0, initialPhase))
-								*(rxAntenna->GetRadiationPattern(rayZoa_radian[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayZod_radian[nIndex][mIndex]))
+								*(rxAntenna->GetRadiationPattern(rayParams.m_rayZoa[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayParams.m_rayZod[nIndex][mIndex]))
 								*exp(std::complex<double>(0, rxPhaseDiff))
 								*exp(std::complex<double>(0, txPhaseDiff));
 								//*exp(std::complex<double>(0, doppler));
@@ -2464,7 +3021,7 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 						default://case 1,2,3,4,5,6,7,8,19,20
 							//delaySpread = -2*M_PI*clusterDelay.at(nIndex)*m_phyMacConfig->GetCentreFrequency ();
 							raysSub1 += exp(std::complex<double>(0, initialPhase))
-								*(rxAntenna->GetRadiationPattern(rayZoa_radian[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayZod_radian[nIndex][mIndex]))
+								*(rxAntenna->GetRadiationPattern(rayParams.m_rayZoa[nIndex][mIndex])*txAntenna->GetRadiationPattern(rayParams.m_rayZod[nIndex][mIndex]))
 								*exp(std::complex<double>(0, rxPhaseDiff))
 								*exp(std::complex<double>(0, txPhaseDiff));
 								//*exp(std::complex<double>(0, doppler));
@@ -2472,167 +3029,219 @@ MmWave3gppChannel::UpdateChannel(Ptr<Params3gpp> params3gpp, Ptr<ParamsTable>  t
 							break;
 						}
 					}
-					//raysSub1 *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
-					//raysSub2 *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
-					//raysSub3 *= sqrt(clusterPower.at(nIndex))/raysPerCluster;
-					raysSub1 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					raysSub2 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					raysSub3 *= sqrt(clusterPower.at(nIndex)/raysPerCluster);
-					H_usn.at(uIndex).at(sIndex).at(nIndex) = raysSub1;
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub2);
-					H_usn.at(uIndex).at(sIndex).push_back(raysSub3);
+					//raysSub1 *= sqrt(rayParams.m_clusterPower.at(nIndex))/raysPerCluster;
+					//raysSub2 *= sqrt(rayParams.m_clusterPower.at(nIndex))/raysPerCluster;
+					//raysSub3 *= sqrt(rayParams.m_clusterPower.at(nIndex))/raysPerCluster;
+					raysSub1 *= sqrt(rayParams.m_clusterPower.at(nIndex)/raysPerCluster);
+					raysSub2 *= sqrt(rayParams.m_clusterPower.at(nIndex)/raysPerCluster);
+					raysSub3 *= sqrt(rayParams.m_clusterPower.at(nIndex)/raysPerCluster);
+					channel.at(uIndex).at(sIndex).at(nIndex) = raysSub1;
+					channel.at(uIndex).at(sIndex).push_back(raysSub2);
+					channel.at(uIndex).at(sIndex).push_back(raysSub3);
 
 				}
 			}
-			if(params->m_los) //(7.5-29) && (7.5-30)
+			if(params.m_los) //(7.5-29) && (7.5-30)
 			{
 				std::complex<double> ray(0,0);
-				double rxPhaseDiff = 2*M_PI*(sin(rxAngle.theta)*cos(rxAngle.phi)*uLoc.x
-						+ sin(rxAngle.theta)*sin(rxAngle.phi)*uLoc.y
-						+ cos(rxAngle.theta)*uLoc.z);
-				double txPhaseDiff = 2*M_PI*(sin(txAngle.theta)*cos(txAngle.phi)*sLoc.x
-						+ sin(txAngle.theta)*sin(txAngle.phi)*sLoc.y
-						+ cos(txAngle.theta)*sLoc.z);
-				//double doppler = 2*M_PI*(sin(rxAngle.theta)*cos(rxAngle.phi)*relativeSpeed.x
-				//		+ sin(rxAngle.theta)*sin(rxAngle.phi)*relativeSpeed.y
-				//		+ cos(rxAngle.theta)*relativeSpeed.z)*slotTime*m_phyMacConfig->GetCentreFrequency ()/3e8;
-
-				ray = exp(std::complex<double>(0, losPhase))
-						*(rxAntenna->GetRadiationPattern(rxAngle.theta)*txAntenna->GetRadiationPattern(txAngle.theta))
+				double rxPhaseDiff = 2*M_PI*(sin(rayParams.m_rxAngle.theta)*cos(rayParams.m_rxAngle.phi)*uLoc.x
+						+ sin(rayParams.m_rxAngle.theta)*sin(rayParams.m_rxAngle.phi)*uLoc.y
+						+ cos(rayParams.m_rxAngle.theta)*uLoc.z);
+				double txPhaseDiff = 2*M_PI*(sin(rayParams.m_txAngle.theta)*cos(rayParams.m_txAngle.phi)*sLoc.x
+						+ sin(rayParams.m_txAngle.theta)*sin(rayParams.m_txAngle.phi)*sLoc.y
+						+ cos(rayParams.m_txAngle.theta)*sLoc.z);
+				//double doppler = 2*M_PI*(sin(rayParams.m_rxAngle.theta)*cos(rayParams.m_rxAngle.phi)*relativeSpeed.x
+				//		+ sin(rayParams.m_rxAngle.theta)*sin(rayParams.m_rxAngle.phi)*relativeSpeed.y
+				//		+ cos(rayParams.m_rxAngle.theta)*relativeSpeed.z)*slotTime*m_phyMacConfig->GetCentreFrequency ()/3e8;
+
+				ray = exp(std::complex<double>(0, params.m_losPhase))
+						*(rxAntenna->GetRadiationPattern(rayParams.m_rxAngle.theta)*txAntenna->GetRadiationPattern(rayParams.m_txAngle.theta))
 						*exp(std::complex<double>(0, rxPhaseDiff))
 						*exp(std::complex<double>(0, txPhaseDiff));
 						//*exp(std::complex<double>(0, doppler));
 
-				double K_linear = pow(10,K_factor/10);
-
-				H_usn.at(uIndex).at(sIndex).at(0) = sqrt(1/(K_linear+1))*H_usn.at(uIndex).at(sIndex).at(0)+sqrt(K_linear/(1+K_linear))*ray/pow(10,attenuation_dB.at (0)/10);  //(7.5-30) for tau = tau1
-				double tempSize = H_usn.at(uIndex).at(sIndex).size();
+				double K_linear = pow(10,params.m_K/10);
+				// the LOS path should be attenuated if blockage is enabled.
+				channel.at(uIndex).at(sIndex).at(0) = sqrt(1/(K_linear+1))*channel.at(uIndex).at(sIndex).at(0)+sqrt(K_linear/(1+K_linear))*ray/pow(10,rayParams.m_losAttenuationDb/10);  //(7.5-30) for tau = tau1
+				double tempSize = channel.at(uIndex).at(sIndex).size();
 				for(uint8_t nIndex = 1; nIndex < tempSize; nIndex++)
 				{
-					H_usn.at(uIndex).at(sIndex).at(nIndex) *= sqrt(1/(K_linear+1)); //(7.5-30) for tau = tau2...taunN
+					channel.at(uIndex).at(sIndex).at(nIndex) *= sqrt(1/(K_linear+1)); //(7.5-30) for tau = tau2...taunN
 				}
 
 			}
 		}
 	}
+}
 
-	if (cluster1st == cluster2nd)
+const complex3DVector_t&
+MmWave3gppChannel::GetChannelMatrix (Ptr<Params3gpp> params) const
+{
+	if (!params->m_compact)
 	{
-		clusterDelay.push_back(clusterDelay.at(cluster2nd)+1.28*table3gpp->m_cDS);
-		clusterDelay.push_back(clusterDelay.at(cluster2nd)+2.56*table3gpp->m_cDS);
+		return params->m_channel;
+	}
+	std::map<Ptr<Params3gpp>, ChannelMatrixCache::iterator>::iterator it = m_channelMatrixCacheIndex.find (params);
+	if (it != m_channelMatrixCacheIndex.end ())
+	{
+		// the list iterators stay valid when the entry is moved to the front
+		m_channelMatrixCache.splice (m_channelMatrixCache.begin (), m_channelMatrixCache, it->second);
+		return m_channelMatrixCache.front ().second;
+	}
+	NS_LOG_LOGIC ("Compute the channel matrix of a compact link");
+	complex3DVector_t &channel = InsertChannelMatrix (params);
+	CalChannelMatrix (*params, params->m_rays.m_txAntenna, params->m_rays.m_rxAntenna, channel);
+	m_channelMatrixSyntheses++;
+	return channel;
+}
 
-		clusterAoa.push_back(clusterAoa.at(cluster2nd));
-		clusterAoa.push_back(clusterAoa.at(cluster2nd));
-		clusterZoa.push_back(clusterZoa.at(cluster2nd));
-		clusterZoa.push_back(clusterZoa.at(cluster2nd));
+complex3DVector_t&
+MmWave3gppChannel::InsertChannelMatrix (Ptr<Params3gpp> params) const
+{
+	m_channelMatrixCache.push_front (std::make_pair (params, complex3DVector_t ()));
+	m_channelMatrixCacheIndex[params] = m_channelMatrixCache.begin ();
+	while (m_channelMatrixCache.size () > m_channelMatrixCacheSize)
+	{
+		m_channelMatrixCacheIndex.erase (m_channelMatrixCache.back ().first);
+		m_channelMatrixCache.pop_back ();
 	}
-	else
+	return m_channelMatrixCache.front ().second;
+}
+
+void
+MmWave3gppChannel::StoreLinkChannel (const key_t &key, Ptr<Params3gpp> params,
+		const Ptr<AntennaArrayModel> &txAntenna, const Ptr<AntennaArrayModel> &rxAntenna) const
+{
+	if (m_compactChannels && !params->m_compact && !IsServingLink (key))
 	{
-		double min, max;
-		if(cluster1st < cluster2nd)
+		// the matrix just computed becomes the most recently used one of the cache
+		NS_LOG_LOGIC ("Store the rays only of a link that is not a serving one");
+		params->m_rays.m_txAntenna = txAntenna;
+		params->m_rays.m_rxAntenna = rxAntenna;
+		params->m_compact = true;
+		InsertChannelMatrix (params).swap (params->m_channel);
+	}
+	m_channelMap[key] = params;
+	m_channelScanningMatrixMap[key] = params;
+}
+
+bool
+MmWave3gppChannel::IsServingLink (const key_t &key) const
+{
+	if (m_connectedPair.find (key) != m_connectedPair.end ()
+			|| m_connectedPair.find (std::make_pair (key.second, key.first)) != m_connectedPair.end ())
+	{
+		return true;
+	}
+	Ptr<MmWaveUeNetDevice> ueDevice = DynamicCast<MmWaveUeNetDevice> (key.first);
+	Ptr<NetDevice> enbDevice = key.second;
+	if (ueDevice == 0)
+	{
+		ueDevice = DynamicCast<MmWaveUeNetDevice> (key.second);
+		enbDevice = key.first;
+	}
+	return ueDevice != 0 && ueDevice->GetTargetEnb () == enbDevice;
+}
+
+ChannelMemoryUsage
+MmWave3gppChannel::GetChannelMemoryUsage () const
+{
+	ChannelMemoryUsage usage;
+	for (std::map<key_t, Ptr<Params3gpp> >::const_iterator it = m_channelMap.begin (); it != m_channelMap.end (); it++)
+	{
+		// m_channelScanningMatrixMap holds the same realization, it is counted once
+		ChannelLinkMemory &link = usage.m_links[it->first];
+		link.m_compact = it->second->m_compact;
+		link.m_realizationBytes = GetParamsBytes (*it->second);
+		link.m_channelBytes = GetAllocatedBytes (it->second->m_channel);
+		link.m_codebookBytes = GetAllocatedBytes (it->second->m_codebookLongTerm);
+	}
+	for (ChannelMatrixCache::const_iterator it = m_channelMatrixCache.begin (); it != m_channelMatrixCache.end (); it++)
+	{
+		std::map<key_t, Ptr<Params3gpp> >::const_iterator itLink = m_channelMap.begin ();
+		while (itLink != m_channelMap.end () && itLink->second != it->first)
 		{
-			min = cluster1st;
-			max = cluster2nd;
+			itLink++;
+		}
+		if (itLink != m_channelMap.end ())
+		{
+			usage.m_links[itLink->first].m_matrixCacheBytes += GetAllocatedBytes (it->second);
 		}
 		else
 		{
-			min = cluster2nd;
-			max = cluster1st;
+			usage.m_staleMatrixCacheBytes += GetAllocatedBytes (it->second);
 		}
-		clusterDelay.push_back(clusterDelay.at(min)+1.28*table3gpp->m_cDS);
-		clusterDelay.push_back(clusterDelay.at(min)+2.56*table3gpp->m_cDS);
-		clusterDelay.push_back(clusterDelay.at(max)+1.28*table3gpp->m_cDS);
-		clusterDelay.push_back(clusterDelay.at(max)+2.56*table3gpp->m_cDS);
-
-		clusterAoa.push_back(clusterAoa.at(min));
-		clusterAoa.push_back(clusterAoa.at(min));
-		clusterAoa.push_back(clusterAoa.at(max));
-		clusterAoa.push_back(clusterAoa.at(max));
-
-		clusterZoa.push_back(clusterZoa.at(min));
-		clusterZoa.push_back(clusterZoa.at(min));
-		clusterZoa.push_back(clusterZoa.at(max));
-		clusterZoa.push_back(clusterZoa.at(max));
-
-
 	}
-
-	NS_LOG_INFO ("size of coefficient matrix =["<<H_usn.size() << "][" << H_usn.at(0).size() << "][" << H_usn.at (0).at(0).size()<<"]");
-
-
-	/*std::cout << "Delay:";
-	for (uint8_t i = 0; i < clusterDelay.size(); i++)
+	for (std::map<key_t, BfGainCacheEntry>::const_iterator it = m_gainCacheMap.begin (); it != m_gainCacheMap.end (); it++)
 	{
-		std::cout <<clusterDelay.at(i)<<"s\t";
+		usage.m_links[it->first].m_gainCacheBytes += sizeof (BfGainCacheEntry) + GetAllocatedBytes (it->second.m_gain);
 	}
-	std::cout << "\n";*/
-
-	params->m_delay = clusterDelay;
-	params->m_channel = H_usn;
-	params->m_angle.clear();
-	params->m_angle.push_back(clusterAoa);
-	params->m_angle.push_back(clusterZoa);
-	params->m_angle.push_back(clusterAod);
-	params->m_angle.push_back(clusterZod);
-	//update the previous location.
+	return usage;
+}
 
-	return params;
+uint64_t
+MmWave3gppChannel::GetChannelMemory () const
+{
+	ChannelMemoryUsage usage = GetChannelMemoryUsage ();
+	uint64_t bytes = usage.m_staleMatrixCacheBytes;
+	for (std::map<key_t, ChannelLinkMemory>::const_iterator it = usage.m_links.begin (); it != usage.m_links.end (); it++)
+	{
+		bytes += it->second.m_realizationBytes + it->second.m_matrixCacheBytes + it->second.m_gainCacheBytes;
+	}
+	return bytes;
+}
 
+void
+MmWave3gppChannel::PrintChannelMemory (std::ostream &os) const
+{
+	ChannelMemoryUsage usage = GetChannelMemoryUsage ();
+	for (std::map<key_t, ChannelLinkMemory>::const_iterator it = usage.m_links.begin (); it != usage.m_links.end (); it++)
+	{
+		const ChannelLinkMemory &link = it->second;
+		os << "link " << it->first.first->GetNode ()->GetId () << " -> " << it->first.second->GetNode ()->GetId ()
+				<< (link.m_compact ? ", rays only: " : ": ")
+				<< link.m_realizationBytes + link.m_matrixCacheBytes + link.m_gainCacheBytes << " bytes"
+				<< " (realization " << link.m_realizationBytes << ", channel matrix " << link.m_channelBytes
+				<< ", codebook long terms " << link.m_codebookBytes << ", matrix cache " << link.m_matrixCacheBytes
+				<< ", gain cache " << link.m_gainCacheBytes << ")" << std::endl;
+	}
+	os << "matrices of replaced realizations in the cache: " << usage.m_staleMatrixCacheBytes << " bytes" << std::endl;
+	os << "channel realizations of " << usage.m_links.size () << " links: " << GetChannelMemory () << " bytes" << std::endl;
 }
 
 void
 MmWave3gppChannel::BeamSearchBeamforming (Ptr<const SpectrumValue> txPsd, Ptr<Params3gpp> params, Ptr<AntennaArrayModel> txAntenna,
 		Ptr<AntennaArrayModel> rxAntenna, uint8_t *txAntennaNum, uint8_t *rxAntennaNum) const
 {
-	double max = 0, maxTx = 0, maxRx =0, maxTxTheta=0, maxRxTheta=0;
 	NS_LOG_LOGIC("BeamSearchBeamforming method at time " << Simulator::Now().GetSeconds());
-	for (uint16_t txTheta = 60; txTheta < 121; txTheta=txTheta+10)
+	Ptr<const MmWaveSteeringTable> txTable = txAntenna->GetSteeringTable (txAntennaNum);
+	Ptr<const MmWaveSteeringTable> rxTable = rxAntenna->GetSteeringTable (rxAntennaNum);
+	double firstFrequency = m_phyMacConfig->GetCentreFrequency () - GetSystemBandwidth ()/2;
+	m_sectorSearch.SetChannel (GetChannelMatrix (params), params->m_delay, *txPsd, firstFrequency, m_phyMacConfig->GetChunkWidth ());
+	MmWaveSectorSearchResult best;
+	if (m_hierarchicalSectorSearch)
 	{
-		for(uint16_t tx=0; tx<=txAntennaNum[1]; tx++)
-		{
-			for (uint16_t rxTheta = 60; rxTheta < 121; rxTheta=rxTheta+10)
-			{
-				for(uint16_t rx=0; rx<=rxAntennaNum[1]; rx++)
-				{
-					NS_LOG_LOGIC("txTheta " << txTheta << " rxTheta " << rxTheta << " tx sector " << 
-						(M_PI*(double)tx/(double)txAntennaNum[1]-0.5*M_PI)/(M_PI)*180 << " rx sector " << 
-						(M_PI*(double)rx/(double)rxAntennaNum[1]-0.5*M_PI)/(M_PI)*180);
-
-					txAntenna->SetSector(tx, txAntennaNum, txTheta);
-					rxAntenna->SetSector(rx, rxAntennaNum, rxTheta);
-					params->m_txW = txAntenna->GetBeamformingVector();
-					params->m_rxW = rxAntenna->GetBeamformingVector();
-					CalLongTerm(params);
-					Ptr<SpectrumValue> bfPsd = CalBeamformingGain(txPsd, params, Vector(0,0,0));
-
-					SpectrumValue bfGain = (*bfPsd)/(*txPsd);
-					uint8_t nbands = bfGain.GetSpectrumModel ()->GetNumBands ();
-					double power = Sum (bfGain)/nbands;
-
-					NS_LOG_LOGIC("gain " << power);
-					if (max < power)
-					{
-						max = power;
-						maxTx = tx;
-						maxRx = rx;
-						maxTxTheta = txTheta;
-						maxRxTheta = rxTheta;
-					}
-				}
-			}
-		}
+		best = m_sectorSearch.SearchHierarchical (*txTable, *rxTable, m_sectorSearchCandidates);
 	}
-	NS_LOG_LOGIC("maxTx " << maxTx << " txAntennaNum[1] " << (uint16_t)txAntennaNum[1]);
-	NS_LOG_LOGIC("max gain " << max << " maxTx " << (M_PI*(double)maxTx/(double)txAntennaNum[1]-0.5*M_PI)/(M_PI)*180 << " maxRx " << (M_PI*(double)maxRx/(double)rxAntennaNum[1]-0.5*M_PI)/(M_PI)*180 << " maxTxTheta " << maxTxTheta << " maxRxTheta " << maxRxTheta);
-	txAntenna->SetSector(maxTx, txAntennaNum, maxTxTheta);
-	rxAntenna->SetSector(maxRx, rxAntennaNum, maxRxTheta);
+	else
+	{
+		best = m_sectorSearch.Search (*txTable, *rxTable);
+	}
+	uint16_t maxTx = best.m_txBeam%txTable->m_numSectors;
+	uint16_t maxRx = best.m_rxBeam%rxTable->m_numSectors;
+	double maxTxTheta = txTable->m_elevation.at (best.m_txBeam/txTable->m_numSectors);
+	double maxRxTheta = rxTable->m_elevation.at (best.m_rxBeam/rxTable->m_numSectors);
+	NS_LOG_LOGIC("evaluated " << best.m_numPairs << " pairs of sectors");
+	NS_LOG_LOGIC("max gain " << best.m_gain << " maxTx " << (M_PI*(double)maxTx/(double)txAntennaNum[1]-0.5*M_PI)/(M_PI)*180 << " maxRx " << (M_PI*(double)maxRx/(double)rxAntennaNum[1]-0.5*M_PI)/(M_PI)*180 << " maxTxTheta " << maxTxTheta << " maxRxTheta " << maxRxTheta);
+	txAntenna->SetSteeringBeam (txTable, best.m_txBeam);
+	rxAntenna->SetSteeringBeam (rxTable, best.m_rxBeam);
 	params->m_txW = txAntenna->GetBeamformingVector();
 	params->m_rxW = rxAntenna->GetBeamformingVector();
 }
 
 doubleVector_t
 MmWave3gppChannel::CalAttenuationOfBlockage (Ptr<Params3gpp> params,
-		doubleVector_t clusterAOA, doubleVector_t clusterZOA) const
+		doubleVector_t clusterAOA, doubleVector_t clusterZOA, const ChannelRandomStreams &streams) const
 {
 	doubleVector_t powerAttenuation;
 	uint8_t clusterNum = clusterAOA.size ();
@@ -2668,17 +3277,17 @@ MmWave3gppChannel::CalAttenuationOfBlockage (Ptr<Params3gpp> params,
 		{
 			//draw value from table 7.6.4.1-2 Blocking region parameters
 			doubleVector_t table;
-			table.push_back (m_normalRvBlockage->GetValue()); //phi_k: store the normal RV that will be mapped to uniform (0,360) later.
+			table.push_back (streams.GetNormalBlockage ()); //phi_k: store the normal RV that will be mapped to uniform (0,360) later.
 			if(m_scenario == "InH-OfficeMixed" || m_scenario == "InH-OfficeOpen")
 			{
-				table.push_back (m_uniformRvBlockage->GetValue(15, 45)); //x_k
+				table.push_back (streams.GetUniformBlockage (15, 45)); //x_k
 				table.push_back (90); //Theta_k
-				table.push_back (m_uniformRvBlockage->GetValue(5, 15)); //y_k
+				table.push_back (streams.GetUniformBlockage (5, 15)); //y_k
 				table.push_back (2); //r
 			}
 			else
 			{
-				table.push_back (m_uniformRvBlockage->GetValue(5, 15)); //x_k
+				table.push_back (streams.GetUniformBlockage (5, 15)); //x_k
 				table.push_back (90); //Theta_k
 				table.push_back (5); //y_k
 				table.push_back (10); //r
@@ -2741,7 +3350,7 @@ MmWave3gppChannel::CalAttenuationOfBlockage (Ptr<Params3gpp> params,
 
 				//Generate a new correlated normal RV with the following formula
 				params->m_nonSelfBlocking.at(blockInd).at(PHI_INDEX) =
-						R*params->m_nonSelfBlocking.at(blockInd).at(PHI_INDEX) + sqrt(1-R*R)*m_normalRvBlockage->GetValue ();
+						R*params->m_nonSelfBlocking.at(blockInd).at(PHI_INDEX) + sqrt(1-R*R)*streams.GetNormalBlockage ();
 			}
 		}
 
@@ -2850,25 +3459,6 @@ MmWave3gppChannel::CalAttenuationOfBlockage (Ptr<Params3gpp> params,
 void
 MmWave3gppChannel::SetBeamSweepingVector (Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice)
 {
-	key_t key = std::make_pair(enbDevice,ueDevice);
-	key_t keyReverse = std::make_pair(ueDevice,enbDevice);
-
-//	std::map< key_t, Ptr<BeamformingParams> >::iterator it = m_channelScanningMatrixMap.find(key);
-	std::map< key_t, Ptr<Params3gpp> >::iterator it = m_channelScanningMatrixMap.find(key);
-	std::map< key_t, Ptr<Params3gpp> >::iterator itReverse = m_channelScanningMatrixMap.find(keyReverse);
-	Ptr<Params3gpp> Params;
-	if (it != m_channelScanningMatrixMap.end ())
-	{
-		Params = it->second;
-	}
-	else if (itReverse != m_channelScanningMatrixMap.end ())
-	{
-		Params = itReverse->second;
-	}
-	else
-	{
-		NS_ASSERT_MSG (it != m_channelScanningMatrixMap.end (), "could not find");
-	}
 	Ptr<MmWaveEnbNetDevice> EnbDev =
 			DynamicCast<MmWaveEnbNetDevice> (enbDevice);
 	Ptr<MmWaveUeNetDevice> UeDev =
@@ -2880,22 +3470,14 @@ MmWave3gppChannel::SetBeamSweepingVector (Ptr<NetDevice> ueDevice, Ptr<NetDevice
 	Ptr<MmWaveBeamManagement> enbBeamMng = enbPhy->GetBeamManagement();
 	Ptr<MmWaveBeamManagement> ueBeamMng = uePhy->GetBeamManagement();
 
-	// Update the bf params in the beam sweeping map:
-	Params->m_txW = enbBeamMng->GetBeamSweepVector();
-	Params->m_rxW = ueBeamMng->GetBeamSweepVector();
-
 	//TODO: Thinking considering multiplying the codebooks by the antenna sector (AoD/AoA)
 
-//	Ptr<MobilityModel> a = enbDevice->GetNode()->GetObject<MobilityModel> ();
-//	Ptr<MobilityModel> b = ueDevice->GetNode()->GetObject<MobilityModel> ();
-//	UpdateChannelMatrixAntennaSpatialSignatures(a,b,Params);
-//	Params->m_beam = GetLongTermFading(Params);
-	CalLongTerm(Params);
-
-	// Now lets use the UE Phy to get the experienced SINR for this channel with the new combination of beams
-	//Ptr<const SpectrumModel> pSModel = enbPhy->GetDlSpectrumPhy()->GetRxSpectrumModel();	// the UePhy does not have content in this pointer
-	Ptr<SpectrumValue> dummyPsd = uePhy->CreateTxPowerSpectralDensity();
-	SpectrumValue experiencedSinr = CalSnr(dummyPsd,enbDevice,ueDevice);
+	// The current beams are codewords of the beam sweeping codebooks, so their long term component
+	// is taken from the projection cached in the channel realization instead of being recomputed.
+	BeamPairSinrBatch batch;
+	batch.m_beamPairs.push_back (std::make_pair (enbBeamMng->GetCurrentBeamId(), ueBeamMng->GetCurrentBeamId()));
+	CalSinrForBeamPairBatch (ueDevice, enbDevice, batch);
+	SpectrumValue experiencedSinr = batch.GetSinrPsd (0);
 
 	// Now add the experienced SINR to the beam management node
 	ueBeamMng->AddEnbSinr(
@@ -2930,9 +3512,9 @@ MmWave3gppChannel::GetSinrForBeamPairs (
 		NS_ASSERT_MSG (it != m_channelScanningMatrixMap.end (), "could not find");
 	}
 
-	CalLongTerm(Params);
-	Params->m_txW = txBeamforming;
-	Params->m_rxW = rxBeamforming;
+	// the realization is the one of the link, so its beamforming vectors are restored afterwards
+	Params->m_txW.swap (txBeamforming);
+	Params->m_rxW.swap (rxBeamforming);
 
 	// Now lets use the UE Phy to get the experienced SINR for this channel with the new combination of beams
 	Ptr<MmWaveUeNetDevice> UeDev =
@@ -2940,6 +3522,8 @@ MmWave3gppChannel::GetSinrForBeamPairs (
 	Ptr<MmWaveUePhy> uePhy = UeDev->GetPhy();
 	Ptr<SpectrumValue> dummyPsd = uePhy->CreateTxPowerSpectralDensity();
 	SpectrumValue experiencedSinr = CalSnr(dummyPsd,enbDevice,ueDevice);
+	Params->m_txW.swap (txBeamforming);
+	Params->m_rxW.swap (rxBeamforming);
 
 //	// Now add the experienced SINR to the beam management node
 //	ueBeamMng->AddEnbSinr(
@@ -2951,6 +3535,146 @@ MmWave3gppChannel::GetSinrForBeamPairs (
 }
 
 
+BeamPairSinrBatch
+MmWave3gppChannel::GetSinrForBeamPairs (Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice,
+		const BeamTrackingParams &beamPairs)
+{
+	BeamPairSinrBatch batch;
+	for (std::vector<BeamPairInfoStruct>::const_iterator it = beamPairs.m_beamPairList.begin ();
+			it != beamPairs.m_beamPairList.end (); ++it)
+	{
+		batch.m_beamPairs.push_back (std::make_pair (it->m_txBeamId, it->m_rxBeamId));
+	}
+	CalSinrForBeamPairBatch (ueDevice, enbDevice, batch);
+	return batch;
+}
+
+BeamPairSinrBatch
+MmWave3gppChannel::GetSinrForCodebook (Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice)
+{
+	Ptr<MmWaveEnbNetDevice> enbDev = DynamicCast<MmWaveEnbNetDevice> (enbDevice);
+	Ptr<MmWaveUeNetDevice> ueDev = DynamicCast<MmWaveUeNetDevice> (ueDevice);
+	uint16_t numTxBeams = enbDev->GetPhy ()->GetBeamManagement ()->GetBeamSweepCodebook ().size ();
+	uint16_t numRxBeams = ueDev->GetPhy ()->GetBeamManagement ()->GetBeamSweepCodebook ().size ();
+
+	BeamPairSinrBatch batch;
+	batch.m_beamPairs.reserve (numTxBeams*numRxBeams);
+	for (uint16_t txBeamId = 0; txBeamId < numTxBeams; txBeamId++)
+	{
+		for (uint16_t rxBeamId = 0; rxBeamId < numRxBeams; rxBeamId++)
+		{
+			batch.m_beamPairs.push_back (std::make_pair (txBeamId, rxBeamId));
+		}
+	}
+	CalSinrForBeamPairBatch (ueDevice, enbDevice, batch);
+	return batch;
+}
+
+void
+MmWave3gppChannel::CalSinrForBeamPairBatch (Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice,
+		BeamPairSinrBatch &batch)
+{
+	NS_LOG_FUNCTION (this << batch.m_beamPairs.size ());
+
+	key_t key = std::make_pair(enbDevice,ueDevice);
+	key_t keyReverse = std::make_pair(ueDevice,enbDevice);
+	std::map< key_t, Ptr<Params3gpp> >::iterator it = m_channelScanningMatrixMap.find(key);
+	if (it == m_channelScanningMatrixMap.end ())
+	{
+		it = m_channelScanningMatrixMap.find(keyReverse);
+	}
+	NS_ASSERT_MSG (it != m_channelScanningMatrixMap.end (), "could not find");
+	Ptr<Params3gpp> params = it->second;
+
+	Ptr<MmWaveEnbNetDevice> enbDev = DynamicCast<MmWaveEnbNetDevice> (enbDevice);
+	Ptr<MmWaveUeNetDevice> ueDev = DynamicCast<MmWaveUeNetDevice> (ueDevice);
+	Ptr<const MmWaveCodebook> txCodebook = enbDev->GetPhy ()->GetBeamManagement ()->GetBeamSweepCodebookObject ();
+	Ptr<const MmWaveCodebook> rxCodebook = ueDev->GetPhy ()->GetBeamManagement ()->GetBeamSweepCodebookObject ();
+
+	Ptr<MobilityModel> a = enbDevice->GetNode()->GetObject<MobilityModel> ();
+	Ptr<MobilityModel> b = ueDevice->GetNode()->GetObject<MobilityModel> ();
+	Vector rxSpeed = b->GetVelocity();
+	Vector txSpeed = a->GetVelocity();
+	Vector relativeSpeed (rxSpeed.x-txSpeed.x,rxSpeed.y-txSpeed.y,rxSpeed.z-txSpeed.z);
+
+	// The PSDs, the pathloss and the frequency response of each cluster are the same for all the beam pairs.
+	Ptr<SpectrumValue> txPsd = ueDev->GetPhy ()->CreateTxPowerSpectralDensity ();
+	double noiseFigure = 5.0;
+	Ptr<SpectrumValue> noisePsd =
+				MmWaveSpectrumValueHelper::CreateNoisePowerSpectralDensity (m_phyMacConfig, noiseFigure);
+
+	double powerDbm = 0;
+	double pathLossDb = 0;
+	if (DynamicCast<MmWave3gppPropagationLossModel> (m_3gppPathloss)!=0)
+	{
+		pathLossDb = m_3gppPathloss->GetObject<MmWave3gppPropagationLossModel> ()
+				->CalcRxPower(powerDbm,a,b);
+	}
+	else if (DynamicCast<MmWave3gppBuildingsPropagationLossModel> (m_3gppPathloss)!=0)
+	{
+		pathLossDb = m_3gppPathloss->GetObject<MmWave3gppBuildingsPropagationLossModel> ()
+				->CalcRxPower(powerDbm,a,b);
+	}
+	else
+	{
+		NS_FATAL_ERROR("unknown pathloss model");
+	}
+	double pathLossGain = std::pow (10.0, (pathLossDb) / 10.0);
+
+	uint8_t numCluster = params->m_delay.size();
+	uint16_t numBands = txPsd->GetSpectrumModel ()->GetNumBands ();
+	complexVector_t doppler = CalDoppler (params, relativeSpeed);
+
+	// scale[b] = txPsd/noisePsd*pathloss, phasor[b][n] = doppler[n]*exp(-j*2*pi*fsb*delay[n])
+	doubleVector_t scale (numBands, 0.0);
+	complexVector_t phasor (numBands*numCluster);
+	for (uint16_t iSubband = 0; iSubband < numBands; iSubband++)
+	{
+		if ((*txPsd)[iSubband] == 0.00)
+		{
+			continue;
+		}
+		scale[iSubband] = (*txPsd)[iSubband]/(*noisePsd)[iSubband]*pathLossGain;
+		double fsb = m_phyMacConfig->GetCentreFrequency () - GetSystemBandwidth ()/2 + m_phyMacConfig->GetChunkWidth ()*iSubband;
+		for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
+		{
+			double delay = -2*M_PI*fsb*(params->m_delay.at (cIndex));
+			phasor[iSubband*numCluster+cIndex] = doppler.at(cIndex)*exp(std::complex<double>(0, delay));
+		}
+	}
+
+	uint32_t numPairs = batch.m_beamPairs.size ();
+	batch.m_numBands = numBands;
+	batch.m_spectrumModel = txPsd->GetSpectrumModel ();
+	batch.m_sinr.assign (numPairs*numBands, 0.0);
+	batch.m_avgSinr.assign (numPairs, 0.0);
+
+	for (uint32_t pIndex = 0; pIndex < numPairs; pIndex++)
+	{
+		const complexVector_t &longTerm = GetCodebookLongTerm (params, txCodebook, rxCodebook,
+				batch.m_beamPairs[pIndex].first, batch.m_beamPairs[pIndex].second);
+
+		double *sinr = &batch.m_sinr[pIndex*numBands];
+		double sinrSum = 0;
+		for (uint16_t iSubband = 0; iSubband < numBands; iSubband++)
+		{
+			if (scale[iSubband] == 0.00)
+			{
+				continue;
+			}
+			std::complex<double> subsbandGain (0.0,0.0);
+			const std::complex<double> *bandPhasor = &phasor[iSubband*numCluster];
+			for (uint8_t cIndex = 0; cIndex < numCluster; cIndex++)
+			{
+				subsbandGain += longTerm[cIndex]*bandPhasor[cIndex];
+			}
+			sinr[iSubband] = scale[iSubband]*norm (subsbandGain);
+			sinrSum += sinr[iSubband];
+		}
+		batch.m_avgSinr[pIndex] = sinrSum/numBands;
+	}
+}
+
 SpectrumValue
 MmWave3gppChannel::CalSnr (
 		Ptr<SpectrumValue>  txPsd,
@@ -3002,9 +3726,14 @@ MmWave3gppChannel::CalSnr (
 
 	Ptr<Params3gpp> channelParams = it->second;
 
+	// the long term component of the link is restored, so that its beamforming gain stays cached
+	complexVector_t longTerm = channelParams->m_longTerm;
+	uint32_t longTermVersion = channelParams->m_longTermVersion;
 	CalLongTerm(channelParams);
 
 	Ptr<SpectrumValue> bfPsd = CalBeamformingGain (txPsd, channelParams, relativeSpeed);
+	channelParams->m_longTerm.swap (longTerm);
+	channelParams->m_longTermVersion = longTermVersion;
 
 	SpectrumValue bfGain = (*bfPsd)/(*txPsd);
 
@@ -34,10 +34,13 @@
 #include <ns3/spectrum-propagation-loss-model.h>
 #include <ns3/net-device.h>
 #include <map>
+#include <list>
 #include <ns3/angles.h>
 #include <ns3/net-device-container.h>
 #include <ns3/random-variable-stream.h>
+#include <ns3/rng-stream.h>
 #include "mmwave-phy-mac-common.h"
+#include "mmwave-sector-search.h"
 #include "mmwave-3gpp-propagation-loss-model.h"
 #include "mmwave-3gpp-buildings-propagation-loss-model.h"
 #include <ns3/antenna-array-model.h>
@@ -66,6 +69,28 @@ typedef std::vector<complex2DVector_t> complex3DVector_t;
 
 typedef std::pair<Ptr<NetDevice>, Ptr<NetDevice> > key_t;
 
+/**
+ * Data structure that stores the ray parameters of a channel realization, from which
+ * its channel matrix is computed (Step 11 of TR 38.900 Sec 7.5)
+ */
+struct ChannelRays
+{
+	double2DVector_t		m_rayAoa; // ray azimuth angle of arrival [n][m], in rad.
+	double2DVector_t		m_rayZoa; // ray zenith angle of arrival [n][m], in rad.
+	double2DVector_t		m_rayAod; // ray azimuth angle of departure [n][m], in rad.
+	double2DVector_t		m_rayZod; // ray zenith angle of departure [n][m], in rad.
+	doubleVector_t			m_clusterPower; // cluster power, after the blockage attenuation.
+	uint8_t					m_cluster1st = 0; // strongest cluster.
+	uint8_t					m_cluster2nd = 0; // second strongest cluster.
+	double					m_losAttenuationDb = 0; // blockage attenuation of the LOS path.
+	Angles					m_rxAngle; // LOS angle at the receiver.
+	Angles					m_txAngle; // LOS angle at the transmitter.
+	uint8_t					m_txAntennaNum[2] = {0, 0}; // tx antennas per row and column.
+	uint8_t					m_rxAntennaNum[2] = {0, 0}; // rx antennas per row and column.
+	Ptr<AntennaArrayModel>	m_txAntenna; // tx antenna, only set for a compact realization.
+	Ptr<AntennaArrayModel>	m_rxAntenna; // rx antenna, only set for a compact realization.
+};
+
 /**
  * Data structure that stores a channel realization
  */
@@ -73,10 +98,13 @@ struct Params3gpp : public SimpleRefCount<Params3gpp>
 {
 	complexVector_t 		m_txW; // tx antenna weights.
 	complexVector_t 		m_rxW; // rx antenna weights.
-	complex3DVector_t  		m_channel; // channel matrix H[u][s][n].
+	complex3DVector_t  		m_channel; // channel matrix H[u][s][n], empty if the channel is deleted or compact.
+	ChannelRays				m_rays; // ray parameters of m_channel.
+	bool					m_compact = false; // m_channel is not stored, GetChannelMatrix computes it from m_rays.
 	doubleVector_t  		m_delay; // cluster delay.
 	double2DVector_t		m_angle; //cluster angle angle[direction][n], where direction = 0(aoa), 1(zoa), 2(aod), 3(zod) in degree.
 	complexVector_t 		m_longTerm; // long term conponet.
+	uint32_t				m_longTermVersion = 0; // incremented every time m_longTerm is computed.
 
 	double2DVector_t		m_nonSelfBlocking; // store the blockages
 
@@ -95,6 +123,54 @@ struct Params3gpp : public SimpleRefCount<Params3gpp>
 	Vector m_speed;
 	double m_dis2D;
 	double m_dis3D;
+
+	/*The following parameters cache the channel projected onto the beam sweeping codebooks, they are only valid for the current m_channel*/
+	Ptr<const MmWaveCodebook> m_txCodebook; // tx codebook the cache refers to, held so that its address cannot be reused.
+	Ptr<const MmWaveCodebook> m_rxCodebook; // rx codebook the cache refers to.
+	complex3DVector_t m_codebookLongTerm; // long term component of each codeword pair [txBeamId][rxBeamId][n], a tx row is empty until it is used.
+};
+
+/**
+ * Memory allocated for a link by MmWave3gppChannel, in bytes
+ */
+struct ChannelLinkMemory
+{
+	bool m_compact = false; // the link stores the rays of its realization only.
+	uint64_t m_realizationBytes = 0; // realization, including its channel matrix and its codebook cache.
+	uint64_t m_channelBytes = 0; // channel matrix stored in the realization.
+	uint64_t m_codebookBytes = 0; // long term components of the beam sweeping codebooks.
+	uint64_t m_matrixCacheBytes = 0; // channel matrix of a compact link in the cache of GetChannelMatrix.
+	uint64_t m_gainCacheBytes = 0; // beamforming gain of the link.
+};
+
+/**
+ * Memory allocated by the channel realizations of MmWave3gppChannel and by their caches, in bytes
+ */
+struct ChannelMemoryUsage
+{
+	std::map<key_t, ChannelLinkMemory> m_links; // memory of each link of m_channelMap.
+	uint64_t m_staleMatrixCacheBytes = 0; // channel matrices in the cache of realizations replaced since.
+};
+
+/**
+ * Data structure that stores the SINR spectra of a batch of beam pairs of a single UE-gNB link
+ * in one contiguous buffer: the SINR of pair i in band b is m_sinr[i*m_numBands+b]
+ */
+struct BeamPairSinrBatch
+{
+	std::vector<sinrKey>	m_beamPairs; // <txBeamId,rxBeamId> of each entry of the batch.
+	uint16_t				m_numBands; // number of bands of each SINR spectrum.
+	doubleVector_t			m_sinr; // SINR spectra of all the beam pairs.
+	doubleVector_t			m_avgSinr; // SINR averaged over the bands of each beam pair.
+	Ptr<const SpectrumModel> m_spectrumModel;
+
+	BeamPairSinrBatch ();
+
+	/**
+	 * Returns the SINR spectrum of a beam pair of the batch as a SpectrumValue
+	 * @params the index of the beam pair in m_beamPairs
+	 */
+	SpectrumValue GetSinrPsd (uint32_t index) const;
 };
 
 /**
@@ -158,12 +234,119 @@ struct ParamsTable: public Object
 
 };
 
+/**
+ * Uniform and normal variates drawn from a substream of an RNG stream, owned by a single link
+ */
+class LinkRandomStream : public SimpleRefCount<LinkRandomStream>
+{
+public:
+	/**
+	 * @params the RNG stream
+	 * @params the substream of the link
+	 */
+	LinkRandomStream (uint64_t stream, uint64_t substream);
+
+	double GetUniform (double min, double max);
+
+	/**
+	 * @returns a standard normal variate, drawn with the polar method of NormalRandomVariable
+	 */
+	double GetNormal ();
+
+private:
+	RngStream m_rng;
+	double m_next; // second variate of the last pair.
+	bool m_nextValid;
+};
+
+/**
+ * Random variables drawn to generate a channel realization: the random variables of the
+ * model, or the substreams of a link if m_link is set
+ */
+struct ChannelRandomStreams
+{
+	double GetUniform (double min, double max) const;
+	double GetNormal () const;
+	double GetUniformBlockage (double min, double max) const;
+	double GetNormalBlockage () const;
+
+	Ptr<UniformRandomVariable> m_uniform;
+	Ptr<NormalRandomVariable> m_normal;
+	Ptr<UniformRandomVariable> m_uniformBlockage;
+	Ptr<NormalRandomVariable> m_normalBlockage;
+	Ptr<LinkRandomStream> m_link;
+	Ptr<LinkRandomStream> m_linkBlockage;
+};
+
+/**
+ * Inputs and result of GetNewChannel for a link whose initial realization
+ * is generated by the pool of InitialChannelThreads
+ */
+struct DeferredChannel
+{
+	key_t m_key;
+	Ptr<ParamsTable> m_table3gpp;
+	Vector m_locUT;
+	bool m_los;
+	bool m_o2i;
+	Ptr<AntennaArrayModel> m_txAntenna;
+	Ptr<AntennaArrayModel> m_rxAntenna;
+	uint8_t m_txAntennaNum[2];
+	uint8_t m_rxAntennaNum[2];
+	Angles m_rxAngle;
+	Angles m_txAngle;
+	Vector m_speed;
+	double m_dis2D;
+	double m_dis3D;
+	ChannelRandomStreams m_streams; // substreams of this link only.
+	Ptr<Params3gpp> m_params; // generated realization.
+};
+
+/**
+ * PSD and mobility models of a DoCalcRxPowerSpectralDensity call to be
+ * repeated once the deferred channels are generated
+ */
+struct DeferredRxPsdCall
+{
+	Ptr<const SpectrumValue> m_txPsd;
+	Ptr<const MobilityModel> m_a;
+	Ptr<const MobilityModel> m_b;
+};
+
+class MmWave3gppChannel;
+
+/**
+ * Per-subband beamforming gain of a link computed by DoCalcRxPowerSpectralDensity.
+ * It is also the completion of a link prepared by DoPrepareRxPowerSpectralDensity,
+ * which evaluates the gain on the thread of the caller
+ */
+struct BfGainCacheEntry : public SpectrumPropagationLossModel::Completion
+{
+	BfGainCacheEntry (const MmWave3gppChannel *channel);
+	virtual void Complete (SpectrumValue &rxPsd);
+
+	const MmWave3gppChannel *m_channel;
+	Ptr<Params3gpp> m_params; // realization the gain was computed with.
+	uint32_t m_longTermVersion; // version of the long term component of m_params.
+	Vector m_speed; // relative speed of the link.
+	Ptr<const SpectrumModel> m_spectrumModel;
+	Time m_time; // time the gain was computed at.
+	double m_maxDopplerRate; // largest Doppler phase rate of the clusters, in rad/s.
+	doubleVector_t m_gain; // gain of each subband.
+	bool m_pending; // the gain is to be evaluated by Complete.
+};
+
 /**
  * \brief This class implements the fading computation of the 3GPP TR 38.900 channel model and performs the 
  * beamforming gain computation. It implements the SpectrumPropagationLossModel interface
  */
+class DeferredChannelWorker;
+
 class MmWave3gppChannel : public SpectrumPropagationLossModel
 {
+	friend class DeferredChannelWorker;
+	friend struct BfGainCacheEntry;
+
 public:
 
 	/** 
@@ -188,7 +371,8 @@ public:
 
 	/**
 	 * Register the connection between all the devices in the NetDeviceContainer given
-	 * as input
+	 * as input. The initial channel realizations are generated by InitialChannelThreads
+	 * threads, each one with its own substreams, so they do not depend on the number of threads
 	 * @param a NetDeviceContainer for the UEs
 	 * @param a NetDeviceContainer for the eNBs
 	 */
@@ -220,16 +404,62 @@ public:
 	 */
 	void SetPathlossModel (Ptr<PropagationLossModel> pathloss);
 
+	/**
+	 * Assign a fixed random variable stream number to the random variables of the model.
+	 * The initial channel realizations draw from substreams of the last stream, one pair
+	 * of substreams per link
+	 * @params the first stream index to use
+	 * @returns the number of stream indices assigned
+	 */
+	int64_t AssignStreams (int64_t stream);
+
 	void SetBeamSweepingVector (Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice);
 
 	SpectrumValue GetSinrForBeamPairs (
 			Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice,
 			complexVector_t txBeamforming, complexVector_t rxBeamforming);
 
+	/**
+	 * Compute in one pass the SINR of all the beam pairs in a list of beam pairs to track.
+	 * The channel is projected once per TX beam and shared by all the RX beams paired with it
+	 * @params the UE NetDevice
+	 * @params the gNB NetDevice
+	 * @params the list of beam pairs, the beam ids refer to the gNB (tx) and UE (rx) codebooks
+	 * @returns the SINR spectra of the beam pairs, in the same order of the list
+	 */
+	BeamPairSinrBatch GetSinrForBeamPairs (Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice,
+			const BeamTrackingParams &beamPairs);
+
+	/**
+	 * Compute in one pass the SINR of every TX x RX combination of the gNB and UE codebooks.
+	 * The beam pairs are ordered with the index txBeamId*numRxBeams+rxBeamId
+	 * @params the UE NetDevice
+	 * @params the gNB NetDevice
+	 * @returns the SINR spectra of all the beam pairs
+	 */
+	BeamPairSinrBatch GetSinrForCodebook (Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice);
+
 	SpectrumValue CalSnr (Ptr<SpectrumValue>  txPsd,	Ptr<NetDevice> enbNetDevice,Ptr<NetDevice> ueNetDevice);
 
 	void UpdateBfChannelMatrix(Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice, BeamPairInfoStruct bestBeams);
 
+	/**
+	 * @returns the memory allocated for each link by its channel realization, its matrix in
+	 * the channel matrix cache and its beamforming gain
+	 */
+	ChannelMemoryUsage GetChannelMemoryUsage () const;
+
+	/**
+	 * @returns the total memory of GetChannelMemoryUsage, in bytes
+	 */
+	uint64_t GetChannelMemory () const;
+
+	/**
+	 * Print the memory of each link and the total
+	 * @params the output stream
+	 */
+	void PrintChannelMemory (std::ostream &os) const;
+
 private:
 
 	/**
@@ -243,6 +473,32 @@ private:
 														Ptr<const MobilityModel> a,
 														Ptr<const MobilityModel> b) const;
 
+	/**
+	 * Inherited from SpectrumPropagationLossModel, it finds or creates the channel realization of the link
+	 * and scales the PSD if its beamforming gain is cached. Otherwise the gain is evaluated by the completion,
+	 * the cache entry of the link. Only supported with GainCache
+	 * @params the PSD to be scaled
+	 * @params the mobility model of the transmitter
+	 * @params the mobility model of the receiver
+	 * @params the completion, 0 if the PSD is already scaled
+	 * @returns true if GainCache is enabled
+	 */
+	bool DoPrepareRxPowerSpectralDensity (Ptr<SpectrumValue> rxPsd, Ptr<const MobilityModel> a,
+			Ptr<const MobilityModel> b, Completion *&completion) const;
+
+	/**
+	 * Finds, creates or updates the channel realization of a link, as the first part of DoCalcRxPowerSpectralDensity
+	 * @params the transmitted PSD
+	 * @params the mobility model of the transmitter
+	 * @params the mobility model of the receiver
+	 * @params the key of the link
+	 * @params the relative speed between tx and rx
+	 * @params true if the realization is the one of the reverse link
+	 * @returns the channel realization, 0 if no beamforming gain is applied to the link
+	 */
+	Ptr<Params3gpp> GetLinkChannel (Ptr<const SpectrumValue> txPsd, Ptr<const MobilityModel> a,
+			Ptr<const MobilityModel> b, key_t &key, Vector &relativeSpeed, bool &reverseLink) const;
+
 	/**
 	 * Get a new realization of the channel
 	 * @params the ParamsTable for the specific scenario
@@ -258,12 +514,32 @@ private:
 	 * @params the relative speed between tx and rx
 	 * @params the 2D distance between tx and rx
 	 * @params the 3D distance between tx and rx
+	 * @params the random variables to draw from
 	 * @returns the channel realization in a Params3gpp object
 	 */
 	Ptr<Params3gpp> GetNewChannel(Ptr<ParamsTable> table3gpp, Vector locUT, bool los, bool o2i,
-			Ptr<AntennaArrayModel> txAntenna, Ptr<AntennaArrayModel> rxAntenna,
+			const Ptr<AntennaArrayModel> &txAntenna, const Ptr<AntennaArrayModel> &rxAntenna,
 			uint8_t *txAntennaNum, uint8_t *rxAntennaNum, Angles &rxAngle, Angles &txAngle,
-			Vector speed, double dis2D, double dis3D) const;
+			Vector speed, double dis2D, double dis3D, const ChannelRandomStreams &streams) const;
+
+	/**
+	 * @returns the random variables shared by all the links
+	 */
+	ChannelRandomStreams GetChannelRandomStreams () const;
+
+	/**
+	 * Generate the channels deferred by DoCalcRxPowerSpectralDensity on InitialChannelThreads threads,
+	 * or on the simulator thread if 0, then repeat the deferred calls in their original order, which
+	 * store the channels in m_channelMap
+	 */
+	void GenerateDeferredChannels ();
+
+	/**
+	 * Generate the deferred channels first, first + step, first + 2*step, ...
+	 * @params the index of the first channel
+	 * @params the distance between two channels
+	 */
+	void GenerateDeferredChannelRange (uint32_t first, uint32_t step) const;
 
 	/**
 	 * Update the channel realization with procedure A of TR 38.900 Sec 7.6.3.2 
@@ -282,6 +558,51 @@ private:
 			Ptr<AntennaArrayModel> txAntenna, Ptr<AntennaArrayModel> rxAntenna,
 			uint8_t *txAntennaNum, uint8_t *rxAntennaNum, Angles &rxAngle, Angles &txAngle) const;
 
+	/**
+	 * Compute the channel matrix of a realization from its ray parameters, Step 11 of TR 38.900 Sec 7.5
+	 * @params the channel realization
+	 * @params the ArrayAntennaModel for the txAntenna
+	 * @params the ArrayAntennaModel for the rxAntenna
+	 * @params the channel matrix H[u][s][n]
+	 */
+	void CalChannelMatrix (const Params3gpp &params, const Ptr<AntennaArrayModel> &txAntenna,
+			const Ptr<AntennaArrayModel> &rxAntenna, complex3DVector_t &channel) const;
+
+	/**
+	 * Returns the channel matrix of a realization. The matrix of a compact realization is taken
+	 * from the ChannelMatrixCacheSize most recently used ones, or computed again from its rays.
+	 * The matrix is valid until the next call
+	 * @params the channel realization
+	 * @returns the channel matrix H[u][s][n]
+	 */
+	const complex3DVector_t& GetChannelMatrix (Ptr<Params3gpp> params) const;
+
+	/**
+	 * Insert an empty channel matrix of a compact realization as the most recently used one of
+	 * m_channelMatrixCache, removing the least recently used ones beyond ChannelMatrixCacheSize
+	 * @params the channel realization
+	 * @returns the matrix inserted
+	 */
+	complex3DVector_t& InsertChannelMatrix (Ptr<Params3gpp> params) const;
+
+	/**
+	 * Store the realization of a link in m_channelMap and in m_channelScanningMatrixMap, which
+	 * the beam sweeping reads. With CompactChannels, the channel matrix of a link that is
+	 * not a serving one is not stored, only its rays
+	 * @params the key of the link
+	 * @params the channel realization
+	 * @params the ArrayAntennaModel for the txAntenna
+	 * @params the ArrayAntennaModel for the rxAntenna
+	 */
+	void StoreLinkChannel (const key_t &key, Ptr<Params3gpp> params,
+			const Ptr<AntennaArrayModel> &txAntenna, const Ptr<AntennaArrayModel> &rxAntenna) const;
+
+	/**
+	 * @params the key of a link between a UE and a gNB
+	 * @returns true if the gNB serves the UE, either connected by Initial or the target of the UE
+	 */
+	bool IsServingLink (const key_t &key) const;
+
 	/**
 	 * Compute the optimal BF vector with the Power Method (Maximum Ratio Transmission method).
 	 * The vector is stored in the Params3gpp object passed as parameter
@@ -291,6 +612,7 @@ private:
 	
 	/**
 	 * Scan all sectors with predefined code book and select the one returns maximum gain.
+	 * The search is done by m_sectorSearch, exhaustive or hierarchical (HierarchicalSectorSearch attribute).
 	 * The BF vector is stored in the Params3gpp object passed as parameter
 	 * @params the channel realizationin as a Params3gpp object
 	 */
@@ -304,6 +626,20 @@ private:
 	 */
 	void CalLongTerm (Ptr<Params3gpp> params) const;
 
+	/**
+	 * Returns the long term component of a pair of codewords of the beam sweeping codebooks.
+	 * The components of a tx codeword with every rx codeword are computed the first time the
+	 * tx codeword is used and kept in the Params3gpp object until its channel matrix changes
+	 * @params the channel realizationin as a Params3gpp object
+	 * @params the tx codebook
+	 * @params the rx codebook
+	 * @params the tx beam id
+	 * @params the rx beam id
+	 * @returns the long term component of each cluster
+	 */
+	const complexVector_t& GetCodebookLongTerm (Ptr<Params3gpp> params, Ptr<const MmWaveCodebook> txCodebook,
+			Ptr<const MmWaveCodebook> rxCodebook, uint16_t txBeamId, uint16_t rxBeamId) const;
+
 	/**
 	 * Compute the BF gain, apply frequency selectivity by phase-shifting with the cluster delays
 	 * and scale the txPsd to get the rxPsd
@@ -315,6 +651,68 @@ private:
 	Ptr<SpectrumValue> CalBeamformingGain (Ptr<const SpectrumValue> txPsd,
 												Ptr<Params3gpp> params, Vector speed) const;
 	
+	/**
+	 * Compute the Doppler term of each cluster at the current time,
+	 * only the center angle of each cluster is taken into consideration
+	 * @params the channel realizationin as a Params3gpp object
+	 * @params the relative speed between UE and eNB
+	 * @returns the Doppler phasor of each cluster
+	 */
+	complexVector_t CalDoppler (Ptr<Params3gpp> params, Vector speed) const;
+
+	/**
+	 * Compute the Doppler phase of a cluster
+	 * @params the channel realizationin as a Params3gpp object
+	 * @params the relative speed between UE and eNB
+	 * @params the cluster
+	 * @params the time in s
+	 * @returns the phase in rad
+	 */
+	double CalDopplerPhase (const Params3gpp &params, Vector speed, uint8_t cIndex, double time) const;
+
+	/**
+	 * Returns the cached beamforming gain of a link, computing it if the realization, its
+	 * beamforming vectors or the relative speed changed since it was cached, or if the Doppler
+	 * phase of a cluster drifted more than GainCacheDopplerTolerance since then
+	 * @params the key of the link
+	 * @params the channel realizationin as a Params3gpp object
+	 * @params the relative speed between UE and eNB
+	 * @params the spectrum model of the PSD
+	 * @returns the gain of each subband
+	 */
+	const doubleVector_t& GetBeamformingGain (const key_t &key, Ptr<Params3gpp> params, Vector speed,
+			Ptr<const SpectrumModel> spectrumModel) const;
+
+	/**
+	 * Finds the cache entry of a link and resets it with the current realization, speed and time if it is not valid.
+	 * An entry waiting for its completion is left unchanged
+	 * @params the key of the link
+	 * @params the channel realizationin as a Params3gpp object
+	 * @params the relative speed between UE and eNB
+	 * @params the spectrum model of the PSD
+	 * @params the entry of the link
+	 * @returns true if the gain of the entry is valid
+	 */
+	bool FindBeamformingGain (const key_t &key, Ptr<Params3gpp> params, Vector speed,
+			Ptr<const SpectrumModel> spectrumModel, BfGainCacheEntry *&entry) const;
+
+	/**
+	 * Evaluates the gain of a cache entry with the kernel of the calling thread. Only the entry
+	 * is accessed, so the entries of different links can be evaluated concurrently
+	 * @params the entry, reset by FindBeamformingGain
+	 */
+	void EvaluateBeamformingGain (BfGainCacheEntry &entry) const;
+
+	/**
+	 * Fill the SINR spectra of the beam pairs stored in the batch, evaluating all of them
+	 * with a single lookup of the channel, pathloss and noise of the link
+	 * @params the UE NetDevice
+	 * @params the gNB NetDevice
+	 * @params the batch, whose m_beamPairs must be already filled
+	 */
+	void CalSinrForBeamPairBatch (Ptr<NetDevice> ueDevice, Ptr<NetDevice> enbDevice,
+			BeamPairSinrBatch &batch);
+
 	/**
 	 * Returns the bandwidth used in a scenario
 	 * @returns a double with the bandwidth
@@ -347,9 +745,10 @@ private:
 	 * @params the channel realizationin as a Params3gpp object
 	 * @params cluster azimuth angle of arrival
 	 * @params cluster zenith angle of arrival
+	 * @params the random variables to draw from
 	 */
 	doubleVector_t CalAttenuationOfBlockage(Ptr<Params3gpp> params,
-			doubleVector_t clusterAOA, doubleVector_t clusterZOA) const;
+			doubleVector_t clusterAOA, doubleVector_t clusterZOA, const ChannelRandomStreams &streams) const;
 
 	mutable std::map< key_t, int > m_connectedPair;
 	mutable std::map< key_t, Ptr<Params3gpp> > m_channelMap;
@@ -363,8 +762,12 @@ private:
 
 
 	Ptr<ExponentialRandomVariable> m_expRv;
+	uint64_t m_linkStream; // RNG stream of the substreams of the initial channels.
+	uint64_t m_numLinkStreams; // links that drew substreams of m_linkStream.
 	Ptr<MmWavePhyMacCommon> m_phyMacConfig;
 	Ptr<PropagationLossModel> m_3gppPathloss;
+	Ptr<MmWave3gppPropagationLossModel> m_3gppLossModel; // m_3gppPathloss if it is of this type.
+	Ptr<MmWave3gppBuildingsPropagationLossModel> m_3gppBuildingsLossModel; // m_3gppPathloss if it is of this type.
 	Ptr<ParamsTable> m_table3gpp;
 	Time m_updatePeriod;
 	bool m_cellScan;
@@ -373,6 +776,25 @@ private:
 	bool m_portraitMode; //true (portrait mode); false (landscape mode).
 	std::string m_scenario;
 	double m_blockerSpeed;
+	mutable MmWaveSectorSearch m_sectorSearch; // engine reused by BeamSearchBeamforming.
+	bool m_hierarchicalSectorSearch;
+	uint32_t m_sectorSearchCandidates; // coarse pairs refined by the hierarchical sector search.
+	uint32_t m_initialChannelThreads; // 0 generates the initial channels on the simulator thread.
+	bool m_deferNewChannels; // set while Initial collects the links.
+	mutable std::vector<DeferredChannel> m_deferredChannels;
+	mutable std::vector<DeferredRxPsdCall> m_deferredCalls;
+	mutable std::map<key_t, Ptr<Params3gpp> > m_generatedChannels; // deferred channels not stored in m_channelMap yet.
+	bool m_gainCache;
+	double m_gainCacheDopplerTolerance; // largest Doppler phase drift of a cached gain, in rad.
+	mutable std::map<key_t, BfGainCacheEntry> m_gainCacheMap;
+	mutable uint64_t m_gainCacheHits;
+	mutable uint64_t m_gainCacheMisses;
+	bool m_compactChannels; // only the serving links store their channel matrix.
+	uint32_t m_channelMatrixCacheSize; // channel matrices of compact links kept by GetChannelMatrix.
+	typedef std::list<std::pair<Ptr<Params3gpp>, complex3DVector_t> > ChannelMatrixCache;
+	mutable ChannelMatrixCache m_channelMatrixCache; // most recently used first.
+	mutable std::map<Ptr<Params3gpp>, ChannelMatrixCache::iterator> m_channelMatrixCacheIndex; // entry of each link in m_channelMatrixCache.
+	mutable uint64_t m_channelMatrixSyntheses; // channel matrices computed by GetChannelMatrix.
 };
 
 
@@ -32,7 +32,13 @@
 #include <ns3/double.h>
 #include <ns3/math.h>
 #include "ns3/enum.h"
+#include <ns3/boolean.h>
+#include <ns3/abort.h>
 #include "mmwave-mi-error-model.h"
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <cstring>
 
 NS_LOG_COMPONENT_DEFINE ("MmWaveAmc");
 
@@ -102,13 +108,81 @@ static const int ModulationSchemeForMcs[32] = {
   6,  // reserved
 };
 
+/*
+ * @brief SINR thresholds of GetCqiSinrThresholds, indexed by the TB sizes of the MCSs 0 to 28
+ */
+static std::map<std::vector<uint32_t>, std::vector<double> > &
+GetCqiSinrThresholdCache ()
+{
+	static std::map<std::vector<uint32_t>, std::vector<double> > cache;
+	return cache;
+}
+
+/*
+ * @brief true if a TB of the given size and MCS sent over a single chunk has a TBLER of at most 10%
+ */
+static bool
+IsChunkMcsValid (double sinr, uint32_t size, uint8_t mcs)
+{
+	static Ptr<SpectrumModel> chunkModel = Create<SpectrumModel> (std::vector<double> (1, 1.0));
+	SpectrumValue chunkSinr (chunkModel);
+	chunkSinr[0] = sinr;
+	std::vector<int> chunkMap (1, 0);
+	MmWaveHarqProcessInfoList_t harqInfoList;
+	TbStats_t tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (chunkSinr, chunkMap, size, mcs, harqInfoList);
+	return !(tbStats.tbler > 0.1);
+}
+
+/*
+ * @brief minimum chunk SINR for which IsChunkMcsValid holds.
+ * The MI maps are non-decreasing and the BLER curves decreasing, so the validity is monotone in the SINR
+ * and the exact threshold is found by bisection over the ordered bit patterns of the non-negative doubles.
+ */
+static double
+GetMinValidChunkSinr (uint32_t size, uint8_t mcs)
+{
+	const double maxSinr = 1e30; // above the axis of every MI map, where the MI is 1
+	if (IsChunkMcsValid (0.0, size, mcs))
+	{
+		return -std::numeric_limits<double>::infinity (); // negative SINRs have the MI of a null SINR
+	}
+	if (!IsChunkMcsValid (maxSinr, size, mcs))
+	{
+		return std::numeric_limits<double>::infinity ();
+	}
+	double value = 0.0;
+	uint64_t invalidBits;
+	uint64_t validBits;
+	memcpy (&invalidBits, &value, sizeof (double));
+	memcpy (&validBits, &maxSinr, sizeof (double));
+	while (validBits - invalidBits > 1)
+	{
+		uint64_t midBits = invalidBits + (validBits - invalidBits)/2;
+		memcpy (&value, &midBits, sizeof (double));
+		if (IsChunkMcsValid (value, size, mcs))
+		{
+			validBits = midBits;
+		}
+		else
+		{
+			invalidBits = midBits;
+		}
+	}
+	memcpy (&value, &validBits, sizeof (double));
+	return value;
+}
+
 MmWaveAmc::MmWaveAmc ()
+: m_cqiTableEnabled (true),
+  m_cqiTableValidation (false)
 {
 	NS_LOG_ERROR ("This construcor should not be invoked");
 }
 
 MmWaveAmc::MmWaveAmc (Ptr<MmWavePhyMacCommon> ConfigParams)
-: m_phyMacConfig (ConfigParams)
+: m_cqiTableEnabled (true),
+  m_cqiTableValidation (false),
+  m_phyMacConfig (ConfigParams)
 {
 	NS_LOG_INFO ("Initialze AMC module");
 }
@@ -135,6 +209,16 @@ MmWaveAmc::GetTypeId (void)
 				 MakeEnumAccessor (&MmWaveAmc::m_amcModel),
 				 MakeEnumChecker (MmWaveAmc::MiErrorModel, "Vienna",
 								  MmWaveAmc::PiroEW2010, "PiroEW2010"))
+	.AddAttribute ("CqiTableEnabled",
+				"Compute the per-chunk CQIs of the MI error model from precomputed SINR thresholds",
+				 BooleanValue (true),
+				 MakeBooleanAccessor (&MmWaveAmc::m_cqiTableEnabled),
+				 MakeBooleanChecker ())
+	.AddAttribute ("CqiTableValidation",
+				"Check every per-chunk CQI obtained from the SINR thresholds against the MI error model",
+				 BooleanValue (false),
+				 MakeBooleanAccessor (&MmWaveAmc::m_cqiTableValidation),
+				 MakeBooleanChecker ())
 	;
 	return tid;
 }
@@ -269,10 +353,13 @@ MmWaveAmc::CreateCqiFeedbacks (const SpectrumValue& sinr, uint8_t rbgSize)
 			{
 				uint8_t mcs = 0;
 				TbStats_t tbStats;
+				double mib[MI_NUM_MODULATIONS];
+				MmWaveMiErrorModel::MibAllModulations (sinr, rbgMap, mib);
+				MmWaveHarqProcessInfoList_t harqInfoList;
 				while (mcs <= 28)
 				{
-					MmWaveHarqProcessInfoList_t harqInfoList;
-					tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (sinr, rbgMap, GetTbSizeFromMcs (mcs, rbgSize/18) / 8, mcs, harqInfoList);
+					tbStats = MmWaveMiErrorModel::GetTbDecodificationStatsFromMib (mib[MmWaveMiErrorModel::GetModulationIndex (mcs)],
+							GetTbSizeFromMcs (mcs, rbgSize/18) / 8, mcs, harqInfoList);
 					if (tbStats.tbler > 0.1)
 					{
 						break;
@@ -361,47 +448,25 @@ MmWaveAmc::CreateCqiFeedbacksTdma (const SpectrumValue& sinr, uint8_t numSym)
 	else if (m_amcModel == MiErrorModel)
 	{
 		int chunkId = 0;
-		for (it = sinr.ConstValuesBegin (); it != sinr.ConstValuesEnd (); it++)
+		for (it = sinr.ConstValuesBegin (); it != sinr.ConstValuesEnd (); it++, chunkId++)
 		{
-			uint8_t mcs = 0;
-			TbStats_t tbStats;
-			std::vector <int> chunkMap;
-			chunkMap.push_back (chunkId++);
-			while (mcs <= 28)
+			uint8_t numValidMcs;
+			if (m_cqiTableEnabled)
 			{
-				MmWaveHarqProcessInfoList_t harqInfoList;
-				tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (sinr, chunkMap, GetTbSizeFromMcsSymbols (mcs, numSym) / 8, mcs, harqInfoList);
-				if (tbStats.tbler > 0.1)
+				numValidMcs = GetNumValidMcsFromTable (*it, numSym);
+				if (m_cqiTableValidation)
 				{
-					break;
+					uint8_t numValidMcsExact = GetNumValidMcsExact (sinr, chunkId, numSym);
+					NS_ABORT_MSG_IF (numValidMcs != numValidMcsExact, "Chunk " << chunkId << " SINR " << *it << " numSym " << (uint16_t)numSym
+							<< ": " << (uint16_t)numValidMcs << " valid MCSs from the table, " << (uint16_t)numValidMcsExact << " from the error model");
 				}
-				mcs++;
-
-			}
-			if (mcs > 0)
-			{
-				mcs--;
-			}
-			NS_LOG_DEBUG (this << "\t MCS " << (uint16_t)mcs << " TBLER " << tbStats.tbler);
-			int chunkCqi = 0;
-			if ((tbStats.tbler > 0.1)&&(mcs==0))
-			{
-				chunkCqi = 0;
-			}
-			else if (mcs == 28)
-			{
-				chunkCqi = 15; // all MCSs can guarantee the 10 % of BER
 			}
 			else
 			{
-				double s = SpectralEfficiencyForMcs[mcs];
-				chunkCqi = 0;
-				while ((chunkCqi < 15) && (SpectralEfficiencyForCqi[chunkCqi + 1] <= s))
-				{
-					++chunkCqi;
-				}
+				numValidMcs = GetNumValidMcsExact (sinr, chunkId, numSym);
 			}
-			NS_LOG_DEBUG (this << "\t MCS " << (uint16_t)mcs << "-> CQI " << chunkCqi);
+			int chunkCqi = GetCqiFromNumValidMcs (numValidMcs);
+			NS_LOG_DEBUG (this << "\t chunk " << chunkId << " valid MCSs " << (uint16_t)numValidMcs << "-> CQI " << chunkCqi);
 			cqi.push_back (chunkCqi);
 		}
 	}
@@ -465,7 +530,8 @@ MmWaveAmc::CreateCqiFeedbackWbTdma (const SpectrumValue& sinr, uint8_t numSym, u
 	}
 	else if (m_amcModel == MiErrorModel)
 	{
-		std::vector <int> chunkMap;
+		std::vector <int> &chunkMap = m_wbChunkMap;
+		chunkMap.clear ();
 		int chunkId = 0;
 		double sinrAvg = 0;
 		for (it = sinr.ConstValuesBegin (); it != sinr.ConstValuesEnd (); it++)
@@ -477,10 +543,13 @@ MmWaveAmc::CreateCqiFeedbackWbTdma (const SpectrumValue& sinr, uint8_t numSym, u
 
 		mcs = 0;
 		TbStats_t tbStats;
+		MmWaveHarqProcessInfoList_t harqInfoList;
+		// the mmib only depends on the modulation, so it is computed once for QPSK, 16-QAM and 64-QAM
+		double mib[MI_NUM_MODULATIONS];
+		MmWaveMiErrorModel::MibAllModulations (sinr, chunkMap, mib);
 		while (mcs <= 28)
 		{
-			MmWaveHarqProcessInfoList_t harqInfoList;
-			tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (sinr, chunkMap, tbSize, mcs, harqInfoList);
+			tbStats = MmWaveMiErrorModel::GetTbDecodificationStatsFromMib (mib[MmWaveMiErrorModel::GetModulationIndex (mcs)], tbSize, mcs, harqInfoList);
 			if (tbStats.tbler > 0.1)
 			{
 				break;
@@ -518,6 +587,93 @@ MmWaveAmc::CreateCqiFeedbackWbTdma (const SpectrumValue& sinr, uint8_t numSym, u
 	return cqi;
 }
 
+uint8_t
+MmWaveAmc::GetNumValidMcsExact (const SpectrumValue& sinr, int chunkId, uint8_t numSym)
+{
+	uint8_t mcs = 0;
+	std::vector <int> chunkMap (1, chunkId);
+	double mib[MI_NUM_MODULATIONS];
+	MmWaveMiErrorModel::MibAllModulations (sinr, chunkMap, mib);
+	MmWaveHarqProcessInfoList_t harqInfoList;
+	while (mcs <= 28)
+	{
+		TbStats_t tbStats = MmWaveMiErrorModel::GetTbDecodificationStatsFromMib (mib[MmWaveMiErrorModel::GetModulationIndex (mcs)],
+				GetTbSizeFromMcsSymbols (mcs, numSym) / 8, mcs, harqInfoList);
+		if (tbStats.tbler > 0.1)
+		{
+			break;
+		}
+		mcs++;
+	}
+	return mcs;
+}
+
+uint8_t
+MmWaveAmc::GetNumValidMcsFromTable (double sinr, uint8_t numSym)
+{
+	const std::vector<double>& thresholds = GetCqiSinrThresholds (numSym);
+	return std::upper_bound (thresholds.begin (), thresholds.end (), sinr) - thresholds.begin ();
+}
+
+const std::vector<double>&
+MmWaveAmc::GetCqiSinrThresholds (uint8_t numSym)
+{
+	if (numSym >= m_cqiSinrThresholds.size ())
+	{
+		m_cqiSinrThresholds.resize (numSym + 1, 0);
+	}
+	if (m_cqiSinrThresholds[numSym] == 0)
+	{
+		std::vector<uint32_t> tbSizes;
+		for (uint8_t mcs = 0; mcs <= 28; mcs++)
+		{
+			tbSizes.push_back (GetTbSizeFromMcsSymbols (mcs, numSym) / 8);
+		}
+		std::map<std::vector<uint32_t>, std::vector<double> > &cache = GetCqiSinrThresholdCache ();
+		std::map<std::vector<uint32_t>, std::vector<double> >::iterator it = cache.find (tbSizes);
+		if (it == cache.end ())
+		{
+			NS_LOG_INFO ("Computing the CQI SINR thresholds for " << (uint16_t)numSym << " symbols");
+			// an MCS is selected only if all the lower ones are valid, hence the running maximum
+			std::vector<double> thresholds;
+			double threshold = -std::numeric_limits<double>::infinity ();
+			for (uint8_t mcs = 0; mcs <= 28; mcs++)
+			{
+				threshold = std::max (threshold, GetMinValidChunkSinr (tbSizes[mcs], mcs));
+				thresholds.push_back (threshold);
+			}
+			it = cache.insert (std::make_pair (tbSizes, thresholds)).first;
+		}
+		m_cqiSinrThresholds[numSym] = &it->second;
+	}
+	return *m_cqiSinrThresholds[numSym];
+}
+
+int
+MmWaveAmc::GetCqiFromNumValidMcs (uint8_t numValidMcs)
+{
+	uint8_t mcs = numValidMcs > 0 ? numValidMcs - 1 : 0;
+	int cqi = 0;
+	if ((numValidMcs <= 28)&&(mcs==0))
+	{
+		cqi = 0; // the TBLER of the last MCS tried exceeds 10 %
+	}
+	else if (mcs == 28)
+	{
+		cqi = 15; // all MCSs can guarantee the 10 % of BER
+	}
+	else
+	{
+		double s = SpectralEfficiencyForMcs[mcs];
+		cqi = 0;
+		while ((cqi < 15) && (SpectralEfficiencyForCqi[cqi + 1] <= s))
+		{
+			++cqi;
+		}
+	}
+	return cqi;
+}
+
 int
 MmWaveAmc::GetCqiFromSpectralEfficiency (double s)
 {
@@ -32,6 +32,7 @@
 #include <ns3/object.h>
 #include <ns3/spectrum-value.h>
 #include <ns3/mmwave-phy-mac-common.h>
+#include <vector>
 
 namespace ns3 {
 
@@ -61,8 +62,45 @@ public:
 	static const unsigned int m_crcLen=24;
 
 private:
+	/**
+	 * Number of consecutive MCSs, starting from MCS 0, whose TBLER is at most 10% over a single chunk,
+	 * evaluated with the MI error model
+	 * @params the SINR of all the chunks
+	 * @params the chunk
+	 * @params the number of symbols of the TB
+	 * @returns the number of MCSs
+	 */
+	uint8_t GetNumValidMcsExact (const SpectrumValue& sinr, int chunkId, uint8_t numSym);
+
+	/**
+	 * Same as GetNumValidMcsExact, with a binary search over the SINR thresholds of GetCqiSinrThresholds
+	 * @params the SINR of the chunk
+	 * @params the number of symbols of the TB
+	 * @returns the number of MCSs
+	 */
+	uint8_t GetNumValidMcsFromTable (double sinr, uint8_t numSym);
+
+	/**
+	 * Returns, for each MCS, the minimum SINR of a chunk for which that MCS and all the lower ones have a TBLER of
+	 * at most 10%. The table depends only on the TB sizes, so it is computed once per number of symbols and shared
+	 * by all the AMC instances with the same configuration.
+	 * @params the number of symbols of the TB
+	 * @returns the non-decreasing SINR thresholds of the MCSs 0 to 28
+	 */
+	const std::vector<double>& GetCqiSinrThresholds (uint8_t numSym);
+
+	/**
+	 * @params the number of consecutive valid MCSs returned by GetNumValidMcsExact
+	 * @returns the CQI of the chunk
+	 */
+	int GetCqiFromNumValidMcs (uint8_t numValidMcs);
+
 	  double m_ber;
 	  AmcModel m_amcModel;
+	  bool m_cqiTableEnabled;			// use the SINR thresholds in CreateCqiFeedbacksTdma
+	  bool m_cqiTableValidation;		// compare the SINR thresholds with the MI error model for every chunk
+	  std::vector<const std::vector<double>*> m_cqiSinrThresholds;	// thresholds per number of symbols
+	  std::vector<int> m_wbChunkMap;	// chunks of CreateCqiFeedbackWbTdma, reused every call
 
 	  Ptr<MmWavePhyMacCommon> m_phyMacConfig;
 		Ptr<SpectrumModel> m_lteRbModel;
@@ -40,14 +40,205 @@ BeamPairInfoStruct::BeamPairInfoStruct()
 }
 
 
+/*
+ * Orders the indices of a BeamPairSinrStore by descending average SINR and ascending index.
+ */
+struct BeamPairSinrCompare
+{
+	BeamPairSinrCompare (const std::vector<double> &avgSinr)
+		: m_avgSinr (avgSinr)
+	{
+	}
+
+	bool operator() (uint32_t a, uint32_t b) const
+	{
+		if (m_avgSinr[a] != m_avgSinr[b])
+		{
+			return m_avgSinr[a] > m_avgSinr[b];
+		}
+		return a < b;
+	}
+
+	const std::vector<double> &m_avgSinr;
+};
+
+BeamPairSinrStore::BeamPairSinrStore ()
+	: m_numTxBeams (0),
+	  m_numRxBeams (0),
+	  m_numBands (0),
+	  m_numValid (0)
+{
+}
+
+void
+BeamPairSinrStore::Resize (uint16_t numTxBeams, uint16_t numRxBeams, Ptr<const SpectrumModel> model)
+{
+	m_numTxBeams = numTxBeams;
+	m_numRxBeams = numRxBeams;
+	m_spectrumModel = model;
+	m_numBands = model->GetNumBands ();
+	uint32_t numPairs = numTxBeams*numRxBeams;
+	m_sinr.assign (numPairs*m_numBands, 0);
+	m_avgSinr.assign (numPairs, 0);
+	m_valid.assign (numPairs, false);
+	m_numValid = 0;
+}
+
+void
+BeamPairSinrStore::Set (uint16_t txBeamId, uint16_t rxBeamId, const SpectrumValue &sinr)
+{
+	if (txBeamId >= m_numTxBeams || rxBeamId >= m_numRxBeams)
+	{
+		// Re-layout the stored entries with the new dimensions
+		BeamPairSinrStore old = *this;
+		Resize (std::max<uint16_t> (m_numTxBeams, txBeamId + 1),
+				std::max<uint16_t> (m_numRxBeams, rxBeamId + 1),
+				old.m_spectrumModel ? old.m_spectrumModel : sinr.GetSpectrumModel ());
+		for (uint32_t oldIndex = 0; oldIndex < old.GetNumBeamPairs (); oldIndex++)
+		{
+			if (old.m_valid[oldIndex])
+			{
+				sinrKey pair = old.GetBeamPair (oldIndex);
+				uint32_t index = GetIndex (pair.first, pair.second);
+				std::copy (old.m_sinr.begin () + oldIndex*m_numBands, old.m_sinr.begin () + (oldIndex + 1)*m_numBands,
+						m_sinr.begin () + index*m_numBands);
+				m_avgSinr[index] = old.m_avgSinr[oldIndex];
+				m_valid[index] = true;
+				m_numValid++;
+			}
+		}
+	}
+	NS_ASSERT_MSG (sinr.GetSpectrumModel ()->GetNumBands () == m_numBands, "SINR with a different number of chunks");
+
+	uint32_t index = GetIndex (txBeamId, rxBeamId);
+	double *entry = &m_sinr[index*m_numBands];
+	double sum = 0;
+	uint16_t b = 0;
+	for (Values::const_iterator it = sinr.ConstValuesBegin (); it != sinr.ConstValuesEnd (); ++it, ++b)
+	{
+		entry[b] = *it;
+		sum += *it;
+	}
+	m_avgSinr[index] = sum/m_numBands;
+	if (!m_valid[index])
+	{
+		m_valid[index] = true;
+		m_numValid++;
+	}
+}
+
+void
+BeamPairSinrStore::Clear ()
+{
+	std::fill (m_valid.begin (), m_valid.end (), false);
+	m_numValid = 0;
+}
+
+std::vector<uint32_t>
+BeamPairSinrStore::GetBestBeamPairs (uint32_t numBeamPairs) const
+{
+	std::vector<uint32_t> indices;
+	indices.reserve (m_numValid);
+	for (uint32_t index = 0; index < m_valid.size (); index++)
+	{
+		if (m_valid[index])
+		{
+			indices.push_back (index);
+		}
+	}
+
+	// Descending average SINR, the lowest index first in case of a tie
+	BeamPairSinrCompare compare (m_avgSinr);
+	if (numBeamPairs < indices.size ())
+	{
+		std::partial_sort (indices.begin (), indices.begin () + numBeamPairs, indices.end (), compare);
+		indices.resize (numBeamPairs);
+	}
+	else
+	{
+		std::sort (indices.begin (), indices.end (), compare);
+	}
+	return indices;
+}
+
+bool
+BeamPairSinrStore::GetBestBeamPair (uint32_t &index) const
+{
+	bool found = false;
+	for (uint32_t i = 0; i < m_valid.size (); i++)
+	{
+		// strictly greater, so that the lowest index is kept in case of a tie
+		if (m_valid[i] && (!found || m_avgSinr[i] > m_avgSinr[index]))
+		{
+			index = i;
+			found = true;
+		}
+	}
+	return found;
+}
+
+bool
+BeamPairSinrStore::IsValid (uint16_t txBeamId, uint16_t rxBeamId) const
+{
+	if (txBeamId >= m_numTxBeams || rxBeamId >= m_numRxBeams)
+	{
+		return false;
+	}
+	return m_valid[GetIndex (txBeamId, rxBeamId)];
+}
+
+bool
+BeamPairSinrStore::IsValid (uint32_t index) const
+{
+	return m_valid[index];
+}
+
+double
+BeamPairSinrStore::GetAvgSinr (uint16_t txBeamId, uint16_t rxBeamId) const
+{
+	return m_avgSinr.at (GetIndex (txBeamId, rxBeamId));
+}
+
+double
+BeamPairSinrStore::GetAvgSinr (uint32_t index) const
+{
+	return m_avgSinr[index];
+}
+
+SpectrumValue
+BeamPairSinrStore::GetSinrPsd (uint16_t txBeamId, uint16_t rxBeamId) const
+{
+	return GetSinrPsd (GetIndex (txBeamId, rxBeamId));
+}
+
+SpectrumValue
+BeamPairSinrStore::GetSinrPsd (uint32_t index) const
+{
+	NS_ASSERT (index < m_avgSinr.size ());
+	SpectrumValue sinr (m_spectrumModel);
+	const double *entry = &m_sinr[index*m_numBands];
+	uint16_t b = 0;
+	for (Values::iterator it = sinr.ValuesBegin (); it != sinr.ValuesEnd (); ++it, ++b)
+	{
+		*it = entry[b];
+	}
+	return sinr;
+}
+
+
 MmWaveBeamManagement::MmWaveBeamManagement()
 {
 	m_beamSweepParams.m_currentBeamId = 0;
+	m_beamSweepParams.m_numBeamsH = 0;
+	m_beamSweepParams.m_numBeamsV = 0;
+	m_beamSweepParams.m_codebook = Create<MmWaveCodebook> ();
 	m_ssBlocksLastBeamSweepUpdate = 0;
 	m_maxNumBeamPairCandidates = 20;
 	m_beamReportingEnabled = false;
 	m_txFilePath = "";
 	m_rxFilePath = "";
+	m_txBeamGridRows = 0;
+	m_rxBeamGridRows = 0;
 	m_memorySs = true;
 	m_beamCandidateListStrategy = 2;
 	m_alpha = 2;
@@ -57,16 +248,6 @@ MmWaveBeamManagement::MmWaveBeamManagement()
 
 MmWaveBeamManagement::~MmWaveBeamManagement()
 {
-	std::map< Ptr<NetDevice>, std::map <sinrKey,SpectrumValue>>::iterator it1;
-	for (it1 = m_enbSinrMap.begin(); it1 != m_enbSinrMap.end(); ++it1)
-	{
-//		std::map <sinrKey,SpectrumValue>::iterator it2;
-//		for (it2 = it1->second.begin(); it2 != it1->second.end(); ++it2)
-//		{
-//			it2->clear();
-//		}
-		it1->second.clear();
-	}
 	m_enbSinrMap.clear();
 }
 
@@ -76,6 +257,18 @@ MmWaveBeamManagement::GetTypeId (void)
 {
 	static TypeId tid = TypeId ("ns3::MmWaveBeamManagement")
 		.SetParent<Object> ()
+		.AddAttribute ("TxBeamGridRows",
+				"Number of rows (vertical beams) of the beam grid of the gNB codebook, whose beam id is row*columns + column. "
+				"0 reads the grid from the codebook file name, such as KronCodebook16h4v.txt for 16 columns and 4 rows",
+				UintegerValue (0),
+				MakeUintegerAccessor (&MmWaveBeamManagement::m_txBeamGridRows),
+				MakeUintegerChecker<uint16_t> ())
+		.AddAttribute ("RxBeamGridRows",
+				"Number of rows (vertical beams) of the beam grid of the UE codebook, whose beam id is row*columns + column. "
+				"0 reads the grid from the codebook file name, such as KronCodebook8h2v.txt for 8 columns and 2 rows",
+				UintegerValue (0),
+				MakeUintegerAccessor (&MmWaveBeamManagement::m_rxBeamGridRows),
+				MakeUintegerChecker<uint16_t> ())
 	;
   	return tid;
 }
@@ -141,7 +334,8 @@ MmWaveBeamManagement::InitializeBeamSweepingTx(Time beamChangeTime)
 	{
 		m_txFilePath = txFilePath;
 	}
-	m_beamSweepParams.m_codebook = LoadCodebookFile(m_txFilePath);
+	m_beamSweepParams.m_codebook = MmWaveCodebookLoader::Load(m_txFilePath);
+	SetBeamSweepGeometryFromPath(m_txFilePath,m_txBeamGridRows);
 
 	this->SetBeamChangeInterval(beamChangeTime);
 	m_lastBeamSweepUpdate = Simulator::Now();
@@ -163,7 +357,8 @@ MmWaveBeamManagement::InitializeBeamSweepingRx(Time beamChangeTime)
 	{
 		m_rxFilePath = rxFilePath;
 	}
-	m_beamSweepParams.m_codebook = LoadCodebookFile(m_rxFilePath);
+	m_beamSweepParams.m_codebook = MmWaveCodebookLoader::Load(m_rxFilePath);
+	SetBeamSweepGeometryFromPath(m_rxFilePath,m_rxBeamGridRows);
 
 	this->SetBeamChangeInterval(beamChangeTime);
 	NS_LOG_INFO ("InitializeBeamSweepingRx");
@@ -179,26 +374,109 @@ void MmWaveBeamManagement::SetBeamChangeInterval (Time period)
 
 void MmWaveBeamManagement::SetBeamSweepCodebook (complex2DVector_t codebook)
 {
-	m_beamSweepParams.m_codebook = codebook;
+	Ptr<MmWaveCodebook> sweepCodebook = Create<MmWaveCodebook> ();
+	sweepCodebook->m_codewords = codebook;
+	m_beamSweepParams.m_codebook = sweepCodebook;
+	if (m_beamSweepParams.m_numBeamsH*m_beamSweepParams.m_numBeamsV != codebook.size())
+	{
+		// the grid of the new codebook has to be set with SetBeamSweepGeometry
+		m_beamSweepParams.m_numBeamsH = 0;
+		m_beamSweepParams.m_numBeamsV = 0;
+	}
+}
+
+void MmWaveBeamManagement::SetBeamSweepGeometry (uint16_t numBeamsH, uint16_t numBeamsV)
+{
+	NS_ASSERT_MSG (numBeamsH*numBeamsV == m_beamSweepParams.m_codebook->m_codewords.size(),
+			"The beam grid " << numBeamsH << "x" << numBeamsV << " does not match the codebook size " << m_beamSweepParams.m_codebook->m_codewords.size());
+	m_beamSweepParams.m_numBeamsH = numBeamsH;
+	m_beamSweepParams.m_numBeamsV = numBeamsV;
+}
+
+void MmWaveBeamManagement::SetBeamSweepGeometryFromPath (std::string path, uint16_t numBeamsV)
+{
+	uint16_t numBeams = m_beamSweepParams.m_codebook->m_codewords.size();
+	if (numBeamsV > 0)
+	{
+		NS_ABORT_MSG_IF (numBeams % numBeamsV != 0, "The " << numBeams << " beams of " << path
+				<< " cannot be arranged in " << numBeamsV << " rows");
+		SetBeamSweepGeometry(numBeams/numBeamsV,numBeamsV);
+		return;
+	}
+
+	// Kronecker codebooks are named after their beam grid, e.g. KronCodebook16h4v.txt has 16 horizontal x 4 vertical beams
+	std::string name = path.substr(path.find_last_of("/") + 1);
+	for (size_t hPos = name.find('h'); hPos != std::string::npos; hPos = name.find('h', hPos + 1))
+	{
+		size_t start = hPos;
+		while (start > 0 && isdigit(name[start - 1]))
+		{
+			start--;
+		}
+		size_t end = hPos + 1;
+		while (end < name.size() && isdigit(name[end]))
+		{
+			end++;
+		}
+		if (start < hPos && end > hPos + 1 && end < name.size() && name[end] == 'v')
+		{
+			uint16_t numBeamsH = atoi(name.substr(start, hPos - start).c_str());
+			uint16_t numBeamsV = atoi(name.substr(hPos + 1, end - hPos - 1).c_str());
+			if (numBeamsH*numBeamsV == numBeams)
+			{
+				SetBeamSweepGeometry(numBeamsH,numBeamsV);
+				return;
+			}
+		}
+	}
+	NS_LOG_INFO ("Beam grid of " << path << " unknown");
+	m_beamSweepParams.m_numBeamsH = 0;
+	m_beamSweepParams.m_numBeamsV = 0;
+}
+
+uint16_t MmWaveBeamManagement::GetNumBeamsH () const
+{
+	NS_ABORT_MSG_IF (m_beamSweepParams.m_numBeamsH == 0, "The beam grid of the codebook is unknown: set the TxBeamGridRows or "
+			"RxBeamGridRows attribute of ns3::MmWaveBeamManagement, or name the codebook file after its grid, e.g. KronCodebook16h4v.txt");
+	return m_beamSweepParams.m_numBeamsH;
+}
+
+uint16_t MmWaveBeamManagement::GetNumBeamsV () const
+{
+	NS_ABORT_MSG_IF (m_beamSweepParams.m_numBeamsV == 0, "The beam grid of the codebook is unknown: set the TxBeamGridRows or "
+			"RxBeamGridRows attribute of ns3::MmWaveBeamManagement, or name the codebook file after its grid, e.g. KronCodebook16h4v.txt");
+	return m_beamSweepParams.m_numBeamsV;
 }
 
 complexVector_t MmWaveBeamManagement::GetBeamSweepVector ()
 {
-	return m_beamSweepParams.m_codebook.at(m_beamSweepParams.m_currentBeamId);
+	return m_beamSweepParams.m_codebook->m_codewords.at(m_beamSweepParams.m_currentBeamId);
 
 }
 
 complexVector_t MmWaveBeamManagement::GetBeamSweepVector (uint16_t index)
 {
-	return m_beamSweepParams.m_codebook.at(index);
+	return m_beamSweepParams.m_codebook->m_codewords.at(index);
+
+}
+
+const complex2DVector_t&
+MmWaveBeamManagement::GetBeamSweepCodebook () const
+{
+	return m_beamSweepParams.m_codebook->m_codewords;
+}
 
+Ptr<const MmWaveCodebook>
+MmWaveBeamManagement::GetBeamSweepCodebookObject () const
+{
+	return m_beamSweepParams.m_codebook;
 }
 
 void MmWaveBeamManagement::BeamSweepStep()
 {
 
 	Time currentTime = Simulator::Now();
-	uint16_t numCodes = m_beamSweepParams.m_codebook.size();
+	uint16_t numCodes = m_beamSweepParams.m_codebook->m_codewords.size();
 //	NS_LOG_INFO ("[" << currentTime << "] Beam id " << m_beamSweepParams.m_currentBeamId << " of " << numCodes - 1);
 	m_beamSweepParams.m_currentBeamId = (m_beamSweepParams.m_currentBeamId + 1) % numCodes;
 //	m_lastBeamSweepUpdate = currentTime;
@@ -232,7 +510,7 @@ void MmWaveBeamManagement::BeamSweepStepRx()
 void MmWaveBeamManagement::DisplayCurrentBeamId ()
 {
 	Time currentTime = Simulator::Now();
-	uint16_t numCodes = m_beamSweepParams.m_codebook.size();
+	uint16_t numCodes = m_beamSweepParams.m_codebook->m_codewords.size();
 	NS_LOG_INFO ("[" << currentTime << "] Beam id " << m_beamSweepParams.m_currentBeamId << " of " << numCodes - 1);
 }
 
@@ -265,27 +543,21 @@ void MmWaveBeamManagement::ResetNumBlocksSinceLastBeamSweepUpdate ()
 void
 MmWaveBeamManagement::AddEnbSinr (Ptr<NetDevice> enbNetDevice, uint16_t enbBeamId, uint16_t ueBeamId, SpectrumValue sinr)
 {
-	sinrKey key = std::make_pair(enbBeamId,ueBeamId);
-	std::map< Ptr<NetDevice>, std::map <sinrKey,SpectrumValue>>::iterator it1 = m_enbSinrMap.find(enbNetDevice);
-	if (it1 != m_enbSinrMap.end ())
+	std::map <Ptr<NetDevice>,BeamPairSinrStore>::iterator it1 = m_enbSinrMap.find(enbNetDevice);
+	if (it1 == m_enbSinrMap.end ())
 	{
-		std::map <sinrKey,SpectrumValue>::iterator it2 = it1->second.find(key);
-		if (it2 != it1->second.end())
-		{
-			it2->second = sinr;
-		}
-		else
+		// The store is sized with the codebooks of both ends so that it is not re-laid out while sweeping
+		uint16_t numTxBeams = enbBeamId + 1;
+		Ptr<MmWaveEnbNetDevice> enbDev = DynamicCast<MmWaveEnbNetDevice> (enbNetDevice);
+		if (enbDev && enbDev->GetPhy ()->GetBeamManagement ())
 		{
-			it1->second.insert(make_pair(key,sinr));
+			numTxBeams = std::max<uint16_t> (numTxBeams, enbDev->GetPhy ()->GetBeamManagement ()->GetBeamSweepCodebook ().size ());
 		}
-//		m_enbSinrMap.erase (it1);
-	}
-	else
-	{
-		std::map <sinrKey,SpectrumValue> m2;
-		m2.insert(make_pair(key,sinr));
-		m_enbSinrMap.insert(make_pair(enbNetDevice,m2));
+		uint16_t numRxBeams = std::max<uint16_t> (ueBeamId + 1, m_beamSweepParams.m_codebook->m_codewords.size ());
+		it1 = m_enbSinrMap.insert (std::make_pair (enbNetDevice, BeamPairSinrStore ())).first;
+		it1->second.Resize (numTxBeams, numRxBeams, sinr.GetSpectrumModel ());
 	}
+	it1->second.Set (enbBeamId, ueBeamId, sinr);
 //	std::cout << Simulator::Now().GetNanoSeconds() << " " << enbBeamId << " " << ueBeamId << " "
 //			<< Sum(sinr)/sinr.GetSpectrumModel()->GetNumBands() << std::endl;
 
@@ -302,62 +574,40 @@ MmWaveBeamManagement::AddEnbSinr (Ptr<NetDevice> enbNetDevice, uint16_t enbBeamI
 void
 MmWaveBeamManagement::Alt0BeamTrackingList()
 {
-	for (std::map< Ptr<NetDevice>, std::map <sinrKey,SpectrumValue>>::iterator it1 = m_enbSinrMap.begin();
+	for (std::map <Ptr<NetDevice>,BeamPairSinrStore>::iterator it1 = m_enbSinrMap.begin();
 				it1 != m_enbSinrMap.end();
 				++it1)
 	{
 		Ptr<NetDevice> pDevice = it1->first;
+		const BeamPairSinrStore &store = it1->second;
 		std::vector<BeamPairInfoStruct> candidateBeamPairs;
-		uint16_t numBeamPairs = 0;
-		uint16_t tx_id, rx_id;
-		for (rx_id = 0; rx_id < 16; rx_id++)
+		candidateBeamPairs.reserve(store.GetNumBeamPairs());
+
+		// All the beam pairs of the codebooks are tracked. The measured ones go first, in descending order of SINR,
+		// followed by the ones that are not in the sinr store.
+		std::vector<uint32_t> bestPairs = store.GetBestBeamPairs(store.GetNumBeamPairs());
+		for (std::vector<uint32_t>::iterator itIndex = bestPairs.begin(); itIndex != bestPairs.end(); ++itIndex)
 		{
-			for (tx_id = 0; tx_id < 64; tx_id++)
+			BeamPairInfoStruct beamPair;
+			beamPair.m_avgSinr = store.GetAvgSinr(*itIndex);
+			beamPair.m_targetNetDevice = pDevice;
+			beamPair.m_txBeamId = store.GetBeamPair(*itIndex).first;
+			beamPair.m_rxBeamId = store.GetBeamPair(*itIndex).second;
+			candidateBeamPairs.push_back(beamPair);
+		}
+		for (uint32_t index = 0; index < store.GetNumBeamPairs(); index++)
+		{
+			if (store.IsValid(index))
 			{
-				// Fill beam pair information
-				sinrKey beam_pair = std::make_pair(tx_id,rx_id);
-				BeamPairInfoStruct beamPair;
-				std::map<sinrKey,SpectrumValue>::iterator it2 = it1->second.find(beam_pair);
-				SpectrumValue sv;
-				if (it2 != it1->second.end())
-				{
-					sv = it2->second;
-					int nbands = it2->second.GetSpectrumModel ()->GetNumBands ();
-					beamPair.m_avgSinr = Sum(sv)/nbands;
-				}
-				else
-				{
-					beamPair.m_avgSinr = 0;
-					beamPair.m_sinrPsd = sv;
-				}
-				beamPair.m_targetNetDevice = it1->first;
-				beamPair.m_txBeamId = tx_id;
-				beamPair.m_rxBeamId = rx_id;
-
-				// The candidate beam pairs are stored in descending order of SINR.
-				// If the list of candidate beam pairs is empty or it is not in the sinr map, add the struct to the list directly.
-				if(candidateBeamPairs.empty() || beamPair.m_avgSinr == 0)
-				{
-					candidateBeamPairs.push_back(beamPair);
-				}
-				// In case the list of candidate beam pairs is not empty, add the new node in the right position of the list
-				else
-				{
-					bool iterate = true;
-					std::vector<BeamPairInfoStruct>::iterator itV = candidateBeamPairs.begin();
-					while (iterate==true && itV != candidateBeamPairs.end())
-					{
-						if (itV->m_avgSinr < beamPair.m_avgSinr)
-						{
-							// insertion happens in the position following itV
-							iterate = false;	// Stop iteration
-						}
-						++itV;	// Increase list iterator
-					}
-					candidateBeamPairs.insert(itV,beamPair);
-				}
-				numBeamPairs++;
+				continue;
 			}
+			BeamPairInfoStruct beamPair;
+			beamPair.m_avgSinr = 0;
+			beamPair.m_sinrPsd = SpectrumValue ();
+			beamPair.m_targetNetDevice = pDevice;
+			beamPair.m_txBeamId = store.GetBeamPair(index).first;
+			beamPair.m_rxBeamId = store.GetBeamPair(index).second;
+			candidateBeamPairs.push_back(beamPair);
 		}
 
 		//to map:
@@ -380,76 +630,20 @@ MmWaveBeamManagement::Alt0BeamTrackingList()
 void
 MmWaveBeamManagement::FindBeamPairCandidatesSinr ()
 {
-//	BeamPairInfoStruct bestPairInfo;
-//	double bestAvgSinr = -1.0;
-
-	for (std::map< Ptr<NetDevice>, std::map <sinrKey,SpectrumValue>>::iterator it1 = m_enbSinrMap.begin();
+	for (std::map <Ptr<NetDevice>,BeamPairSinrStore>::iterator it1 = m_enbSinrMap.begin();
 			it1 != m_enbSinrMap.end();
 			++it1)
 	{
 		Ptr<NetDevice> pDevice = it1->first;
+		const BeamPairSinrStore &store = it1->second;
 		std::vector<BeamPairInfoStruct> candidateBeamPairs;
 
-		// Internal SINR values to control the size of the candidate beam vector.
-		double minSinr=0;
-		uint16_t numBeamPairs = 0;
-		//double maxSinr=0;
-
-		for (std::map <sinrKey,SpectrumValue>::iterator it2 = it1->second.begin();
-				it2 != it1->second.end();
-				++it2)
+		// The candidate beam pairs are stored in descending order of SINR.
+		std::vector<uint32_t> bestPairs = store.GetBestBeamPairs(m_maxNumBeamPairCandidates);
+		for (std::vector<uint32_t>::iterator itIndex = bestPairs.begin(); itIndex != bestPairs.end(); ++itIndex)
 		{
-			int nbands = it2->second.GetSpectrumModel ()->GetNumBands ();
-			double avgSinr = Sum (it2->second)/nbands;
-
-			// Skip the current pair of beams if they provide lower SINR than the current candidate pairs
-			if(avgSinr < minSinr)
-				continue;
-
-			// The SINR of the current pair of beams is large enough to be included in the list of candidate beam pairs
-			// Populate the beam pair info structure
-			BeamPairInfoStruct beamPair;
-			beamPair.m_avgSinr = avgSinr;
-			beamPair.m_sinrPsd = it2->second;
-			beamPair.m_targetNetDevice = it1->first;
-			beamPair.m_txBeamId = it2->first.first;
-			beamPair.m_rxBeamId = it2->first.second;
-
-			// The candidate beam pairs are stored in descending order of SINR.
-			// If the list of candidate beam pairs is empty, add the struct to the list directly.
-			if(candidateBeamPairs.empty())
-			{
-				candidateBeamPairs.push_back(beamPair);
-				numBeamPairs = 1;
-			}
-			// In case the list of candidate beam pairs is not empty, add the new node in the right position of the list
-			else
-			{
-				bool iterate = true;
-				std::vector<BeamPairInfoStruct>::iterator itV = candidateBeamPairs.begin();
-				while (iterate && itV != candidateBeamPairs.end())
-				{
-					if (itV->m_avgSinr < avgSinr)
-					{
-						iterate = false;	// Stop iteration
-					}
-					++itV;	// Increase list iterator
-				}
-				// insertion happens in the position following itV
-				candidateBeamPairs.insert(itV,beamPair);
-				numBeamPairs++;
-
-				// Only get best m_numMaxCandidateBeams pair of beams
-				if(candidateBeamPairs.size() > m_maxNumBeamPairCandidates)
-				{
-					// It gets rid of the last element in the vector
-					candidateBeamPairs.resize(m_maxNumBeamPairCandidates);
-					numBeamPairs = m_maxNumBeamPairCandidates;
-				}
-			}
-
-			//Update internal sinr values
-			minSinr = candidateBeamPairs.at(numBeamPairs-1).m_avgSinr;
+			sinrKey pair = store.GetBeamPair(*itIndex);
+			candidateBeamPairs.push_back(GetScannedBeamPairInfo(pDevice,store,pair.first,pair.second));
 		}
 
 		//to map:
@@ -460,18 +654,6 @@ MmWaveBeamManagement::FindBeamPairCandidatesSinr ()
 		trackingParamStruct.m_csiResourceLastAllocation = Simulator::Now();
 
 		UpdateBeamTrackingInfo(pDevice,trackingParamStruct);
-//		std::map <Ptr<NetDevice>,BeamTrackingParams>::iterator itMap = m_candidateBeamsMap.find(pDevice);
-//		if(itMap == m_candidateBeamsMap.end())
-//		{
-//			m_candidateBeamsMap.insert(std::pair<Ptr<NetDevice>,BeamTrackingParams>(pDevice,trackingParamStruct));
-//		}
-//		else
-//		{
-//			m_candidateBeamsMap.erase(itMap);	//Erase the entry so it can be updated
-//			m_candidateBeamsMap.insert(std::pair<Ptr<NetDevice>,BeamTrackingParams>(pDevice,trackingParamStruct));
-//			//(*itMap).second = trackingParamStruct;
-//			//itMap->second = trackingParamStruct;
-//		}
 	}
 }
 
@@ -533,80 +715,72 @@ MmWaveBeamManagement::GetAlphaSpacedAzimuthBeamsFromOptimal(uint16_t opt_beam_id
 
 }
 
+void
+MmWaveBeamManagement::UpdateNeighborBeamTrackingList (Ptr<NetDevice> enb, const BeamPairSinrStore &store,
+		BeamPairInfoStruct bestPair, const std::vector<uint16_t> &txBeamIds, const std::vector<uint16_t> &rxBeamIds)
+{
+	std::vector<BeamPairInfoStruct> candidateBeamPairs;
+	candidateBeamPairs.reserve(txBeamIds.size()*rxBeamIds.size());
+	// The best beam pair is the first one in the tracking list.
+	candidateBeamPairs.push_back(bestPair);
+
+	for (uint16_t numTxBeams = 0; numTxBeams < txBeamIds.size(); numTxBeams++)
+	{
+		for(uint16_t numRxBeams = 0; numRxBeams < rxBeamIds.size(); numRxBeams++)
+		{
+			if (numTxBeams == 0 && numRxBeams == 0)
+			{
+				continue;	//This one is already added in the vector
+			}
+			candidateBeamPairs.push_back(GetScannedBeamPairInfo(enb,store,txBeamIds.at(numTxBeams),rxBeamIds.at(numRxBeams)));
+		}
+	}
+
+	//to map:
+	BeamTrackingParams beamTrackingStruct;
+	beamTrackingStruct.m_beamPairList = candidateBeamPairs;
+	beamTrackingStruct.m_numBeamPairs = candidateBeamPairs.size();
+	beamTrackingStruct.csiReportPeriod = static_cast<MmWavePhyMacCommon::CsiReportingPeriod>(m_beamReportingPeriod);
+	UpdateBeamTrackingInfo(enb,beamTrackingStruct);
+}
+
+void
+MmWaveBeamManagement::GetPeerBeamGrid (Ptr<NetDevice> peer, const BeamPairSinrStore &store,
+		uint16_t &numBeamsH, uint16_t &numBeamsV) const
+{
+	Ptr<MmWaveEnbNetDevice> enbDev = DynamicCast<MmWaveEnbNetDevice> (peer);
+	if (enbDev && enbDev->GetPhy()->GetBeamManagement())
+	{
+		numBeamsH = enbDev->GetPhy()->GetBeamManagement()->GetNumBeamsH();
+		numBeamsV = enbDev->GetPhy()->GetBeamManagement()->GetNumBeamsV();
+	}
+	else
+	{
+		numBeamsH = store.GetNumTxBeams();
+		numBeamsV = 1;
+	}
+}
+
 /*
  * Alt2.
  */
 void
 MmWaveBeamManagement::Alt2BeamTrackingList ()
 {
-	for (std::map< Ptr<NetDevice>, std::map <sinrKey,SpectrumValue>>::iterator it1 = m_enbSinrMap.begin();
+	for (std::map <Ptr<NetDevice>,BeamPairSinrStore>::iterator it1 = m_enbSinrMap.begin();
 				it1 != m_enbSinrMap.end();
 				++it1)
 	{
 		Ptr<NetDevice> pDevice = it1->first;
-		std::vector<BeamPairInfoStruct> candidateBeamPairs;
-
-		// Internal SINR value to control the size of the candidate beam vector.
-//		double minSinr=0;
-		int nbands = m_enbSinrMap.begin()->second.begin()->second.GetSpectrumModel()->GetNumBands();
-		BeamPairInfoStruct beamPair, beamPairExtra;
-		beamPair = GetBestScannedBeamPair();
-		// The best beam pair is the first one in the tracking list.
-		candidateBeamPairs.push_back(beamPair);
+		BeamPairInfoStruct beamPair = GetBestScannedBeamPair();
 
 		// Now construct the rest of the beam pairs in the immediate vicinity
-		// TODO: Hard-coded for tx 16x4 and rx 8x2 arrays. Make it compatible with any geometry
-
-		std::vector<uint16_t> tx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_txBeamId,16,4);
-		std::vector<uint16_t> rx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_rxBeamId,8,2);
-
-		for (uint16_t numTxBeams = 0; numTxBeams < tx_beam_ids.size(); numTxBeams++)
-		{
-			uint16_t tempTxBeamId = tx_beam_ids.at(numTxBeams);
-			for(uint16_t numRxBeams = 0; numRxBeams < rx_beam_ids.size(); numRxBeams++)
-			{
-				if (numTxBeams == 0 && numRxBeams == 0)
-				{
-					continue;	//This one is already added in the vector
-				}
-				uint16_t tempRxBeamId = rx_beam_ids.at(numRxBeams);
-				std::map <sinrKey,SpectrumValue>::iterator itExtra =
-								it1->second.find(std::make_pair(tempTxBeamId,tempRxBeamId));
-				beamPairExtra.m_targetNetDevice = pDevice;
-				beamPairExtra.m_txBeamId = tempTxBeamId;
-				beamPairExtra.m_rxBeamId = tempRxBeamId;
-				if(itExtra != it1->second.end())	// Check whether SINR info is already available in the map
-				{
-					beamPairExtra.m_avgSinr = Sum(itExtra->second)/nbands;
-					beamPairExtra.m_sinrPsd = itExtra->second;
-				}
-				else
-				{
-					//No SINR value in the map. Just populating beam ids
-					beamPairExtra.m_avgSinr = -1;
-					beamPairExtra.m_sinrPsd = 0;
-				}
-				candidateBeamPairs.push_back(beamPairExtra);
-			}
-
+		uint16_t txBeamsH, txBeamsV;
+		GetPeerBeamGrid(pDevice,it1->second,txBeamsH,txBeamsV);
+		std::vector<uint16_t> tx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_txBeamId,txBeamsH,txBeamsV);
+		std::vector<uint16_t> rx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_rxBeamId,GetNumBeamsH(),GetNumBeamsV());
 
-		}
-
-		//to map:
-		BeamTrackingParams beamTrackingStruct;
-		beamTrackingStruct.m_beamPairList = candidateBeamPairs;
-		beamTrackingStruct.m_numBeamPairs = candidateBeamPairs.size();
-		beamTrackingStruct.csiReportPeriod = static_cast<MmWavePhyMacCommon::CsiReportingPeriod>(m_beamReportingPeriod);
-//		std::map <Ptr<NetDevice>,BeamTrackingParams>::iterator itMap = m_candidateBeamsMap.find(pDevice);
-//		if(itMap == m_candidateBeamsMap.end())
-//		{
-//			m_candidateBeamsMap.insert(std::pair<Ptr<NetDevice>,BeamTrackingParams>(pDevice,beamTrackingStruct));
-//		}
-//		else
-//		{
-//			itMap->second = beamTrackingStruct;
-//		}
-		UpdateBeamTrackingInfo(pDevice,beamTrackingStruct);
+		UpdateNeighborBeamTrackingList(pDevice,it1->second,beamPair,tx_beam_ids,rx_beam_ids);
 	}
 }
 
@@ -614,79 +788,25 @@ MmWaveBeamManagement::Alt2BeamTrackingList ()
 void
 MmWaveBeamManagement::Alt3BeamTrackingList (uint16_t alpha)
 {
-	for (std::map< Ptr<NetDevice>, std::map <sinrKey,SpectrumValue>>::iterator it1 = m_enbSinrMap.begin();
+	for (std::map <Ptr<NetDevice>,BeamPairSinrStore>::iterator it1 = m_enbSinrMap.begin();
 				it1 != m_enbSinrMap.end();
 				++it1)
 	{
 		Ptr<NetDevice> pDevice = it1->first;
-		std::vector<BeamPairInfoStruct> candidateBeamPairs;
-
-		// Internal SINR value to control the size of the candidate beam vector.
-//		double minSinr=0;
-		int nbands = m_enbSinrMap.begin()->second.begin()->second.GetSpectrumModel()->GetNumBands();
-		BeamPairInfoStruct beamPair, beamPairExtra;
-		beamPair = GetBestScannedBeamPair();
-		// The best beam pair is the first one in the tracking list.
-		candidateBeamPairs.push_back(beamPair);
+		BeamPairInfoStruct beamPair = GetBestScannedBeamPair();
 
 		// Now construct the rest of the beam pairs in the immediate vicinity
-		// TODO: Hard-coded for tx 16x4 and rx 8x2 arrays. Make it compatible with any geometry
-
-		std::vector<uint16_t> tx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_txBeamId,16,4);
-		std::vector<uint16_t> rx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_rxBeamId,8,2);
+		uint16_t txBeamsH, txBeamsV;
+		GetPeerBeamGrid(pDevice,it1->second,txBeamsH,txBeamsV);
+		std::vector<uint16_t> tx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_txBeamId,txBeamsH,txBeamsV);
+		std::vector<uint16_t> rx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_rxBeamId,GetNumBeamsH(),GetNumBeamsV());
 
-		std::vector<uint16_t> add_rx_beam_ids = GetAlphaSpacedAzimuthBeamsFromOptimal(beamPair.m_rxBeamId,alpha,8);
+		std::vector<uint16_t> add_rx_beam_ids = GetAlphaSpacedAzimuthBeamsFromOptimal(beamPair.m_rxBeamId,alpha,GetNumBeamsH());
 
 		// Append additional vector at the end of the original rx beam id vector
 		rx_beam_ids.insert(rx_beam_ids.end(),add_rx_beam_ids.begin(),add_rx_beam_ids.end());
 
-		for (uint16_t numTxBeams = 0; numTxBeams < tx_beam_ids.size(); numTxBeams++)
-		{
-			uint16_t tempTxBeamId = tx_beam_ids.at(numTxBeams);
-			for(uint16_t numRxBeams = 0; numRxBeams < rx_beam_ids.size(); numRxBeams++)
-			{
-				if (numTxBeams == 0 && numRxBeams == 0)
-				{
-					continue;	//This one is already added in the vector
-				}
-				uint16_t tempRxBeamId = rx_beam_ids.at(numRxBeams);
-				std::map <sinrKey,SpectrumValue>::iterator itExtra =
-								it1->second.find(std::make_pair(tempTxBeamId,tempRxBeamId));
-				beamPairExtra.m_targetNetDevice = pDevice;
-				beamPairExtra.m_txBeamId = tempTxBeamId;
-				beamPairExtra.m_rxBeamId = tempRxBeamId;
-				if(itExtra != it1->second.end())	// Check whether SINR info is already available in the map
-				{
-					beamPairExtra.m_avgSinr = Sum(itExtra->second)/nbands;
-					beamPairExtra.m_sinrPsd = itExtra->second;
-				}
-				else
-				{
-					//No SINR value in the map. Just populating beam ids
-					beamPairExtra.m_avgSinr = -1;
-					beamPairExtra.m_sinrPsd = 0;
-				}
-				candidateBeamPairs.push_back(beamPairExtra);
-			}
-
-
-		}
-
-		//to map:
-		BeamTrackingParams beamTrackingStruct;
-		beamTrackingStruct.m_beamPairList = candidateBeamPairs;
-		beamTrackingStruct.m_numBeamPairs = candidateBeamPairs.size();
-		beamTrackingStruct.csiReportPeriod = static_cast<MmWavePhyMacCommon::CsiReportingPeriod>(m_beamReportingPeriod);
-//		std::map <Ptr<NetDevice>,BeamTrackingParams>::iterator itMap = m_candidateBeamsMap.find(pDevice);
-//		if(itMap == m_candidateBeamsMap.end())
-//		{
-//			m_candidateBeamsMap.insert(std::pair<Ptr<NetDevice>,BeamTrackingParams>(pDevice,beamTrackingStruct));
-//		}
-//		else
-//		{
-//			itMap->second = beamTrackingStruct;
-//		}
-		UpdateBeamTrackingInfo(pDevice,beamTrackingStruct);
+		UpdateNeighborBeamTrackingList(pDevice,it1->second,beamPair,tx_beam_ids,rx_beam_ids);
 	}
 }
 
@@ -697,80 +817,25 @@ MmWaveBeamManagement::Alt3BeamTrackingList (uint16_t alpha)
 void
 MmWaveBeamManagement::Alt4BeamTrackingList (uint16_t alpha)
 {
-	for (std::map< Ptr<NetDevice>, std::map <sinrKey,SpectrumValue>>::iterator it1 = m_enbSinrMap.begin();
+	for (std::map <Ptr<NetDevice>,BeamPairSinrStore>::iterator it1 = m_enbSinrMap.begin();
 				it1 != m_enbSinrMap.end();
 				++it1)
 	{
 		Ptr<NetDevice> pDevice = it1->first;
-		std::vector<BeamPairInfoStruct> candidateBeamPairs;
-
-		// Internal SINR value to control the size of the candidate beam vector.
-//		double minSinr=0;
-		int nbands = m_enbSinrMap.begin()->second.begin()->second.GetSpectrumModel()->GetNumBands();
-		BeamPairInfoStruct beamPair, beamPairExtra;
-		beamPair = GetBestScannedBeamPair();
-		// The best beam pair is the first one in the tracking list.
-		candidateBeamPairs.push_back(beamPair);
+		BeamPairInfoStruct beamPair = GetBestScannedBeamPair();
 
 		// Now construct the rest of the beam pairs in the immediate vicinity
-		// TODO: Hard-coded for tx 16x4 and rx 8x2 arrays. Make it compatible with any geometry
+		uint16_t txBeamsH, txBeamsV;
+		GetPeerBeamGrid(pDevice,it1->second,txBeamsH,txBeamsV);
+		std::vector<uint16_t> tx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_txBeamId,txBeamsH,txBeamsV);
+		std::vector<uint16_t> rx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_rxBeamId,GetNumBeamsH(),GetNumBeamsV());
 
-		std::vector<uint16_t> tx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_txBeamId,16,4);
-		std::vector<uint16_t> rx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_rxBeamId,8,2);
-
-		uint16_t alpha = 4;
-		std::vector<uint16_t> add_tx_beam_ids = GetAlphaSpacedAzimuthBeamsFromOptimal(beamPair.m_txBeamId,alpha,16);
+		std::vector<uint16_t> add_tx_beam_ids = GetAlphaSpacedAzimuthBeamsFromOptimal(beamPair.m_txBeamId,alpha,txBeamsH);
 
 		// Append additional vector at the end of the original tx beam id vector
 		tx_beam_ids.insert(tx_beam_ids.end(),add_tx_beam_ids.begin(),add_tx_beam_ids.end());
 
-		for (uint16_t numTxBeams = 0; numTxBeams < tx_beam_ids.size(); numTxBeams++)
-		{
-			uint16_t tempTxBeamId = tx_beam_ids.at(numTxBeams);
-			for(uint16_t numRxBeams = 0; numRxBeams < rx_beam_ids.size(); numRxBeams++)
-			{
-				if (numTxBeams == 0 && numRxBeams == 0)
-				{
-					continue;	//This one is already added in the vector
-				}
-				uint16_t tempRxBeamId = rx_beam_ids.at(numRxBeams);
-				std::map <sinrKey,SpectrumValue>::iterator itExtra =
-								it1->second.find(std::make_pair(tempTxBeamId,tempRxBeamId));
-				beamPairExtra.m_targetNetDevice = pDevice;
-				beamPairExtra.m_txBeamId = tempTxBeamId;
-				beamPairExtra.m_rxBeamId = tempRxBeamId;
-				if(itExtra != it1->second.end())	// Check whether SINR info is already available in the map
-				{
-					beamPairExtra.m_avgSinr = Sum(itExtra->second)/nbands;
-					beamPairExtra.m_sinrPsd = itExtra->second;
-				}
-				else
-				{
-					//No SINR value in the map. Just populating beam ids
-					beamPairExtra.m_avgSinr = -1;
-					beamPairExtra.m_sinrPsd = 0;
-				}
-				candidateBeamPairs.push_back(beamPairExtra);
-			}
-
-
-		}
-
-		//to map:
-		BeamTrackingParams beamTrackingStruct;
-		beamTrackingStruct.m_beamPairList = candidateBeamPairs;
-		beamTrackingStruct.m_numBeamPairs = candidateBeamPairs.size();
-		beamTrackingStruct.csiReportPeriod = static_cast<MmWavePhyMacCommon::CsiReportingPeriod>(m_beamReportingPeriod);
-//		std::map <Ptr<NetDevice>,BeamTrackingParams>::iterator itMap = m_candidateBeamsMap.find(pDevice);
-//		if(itMap == m_candidateBeamsMap.end())
-//		{
-//			m_candidateBeamsMap.insert(std::pair<Ptr<NetDevice>,BeamTrackingParams>(pDevice,beamTrackingStruct));
-//		}
-//		else
-//		{
-//			itMap->second = beamTrackingStruct;
-//		}
-		UpdateBeamTrackingInfo(pDevice,beamTrackingStruct);
+		UpdateNeighborBeamTrackingList(pDevice,it1->second,beamPair,tx_beam_ids,rx_beam_ids);
 	}
 }
 
@@ -781,82 +846,28 @@ MmWaveBeamManagement::Alt4BeamTrackingList (uint16_t alpha)
 void
 MmWaveBeamManagement::Alt5BeamTrackingList (uint16_t beta, uint16_t alpha)
 {
-	for (std::map< Ptr<NetDevice>, std::map <sinrKey,SpectrumValue>>::iterator it1 = m_enbSinrMap.begin();
+	for (std::map <Ptr<NetDevice>,BeamPairSinrStore>::iterator it1 = m_enbSinrMap.begin();
 				it1 != m_enbSinrMap.end();
 				++it1)
 	{
 		Ptr<NetDevice> pDevice = it1->first;
-		std::vector<BeamPairInfoStruct> candidateBeamPairs;
-
-		// Internal SINR value to control the size of the candidate beam vector.
-//		double minSinr=0;
-		int nbands = m_enbSinrMap.begin()->second.begin()->second.GetSpectrumModel()->GetNumBands();
-		BeamPairInfoStruct beamPair, beamPairExtra;
-		beamPair = GetBestScannedBeamPair();
-		// The best beam pair is the first one in the tracking list.
-		candidateBeamPairs.push_back(beamPair);
+		BeamPairInfoStruct beamPair = GetBestScannedBeamPair();
 
 		// Now construct the rest of the beam pairs in the immediate vicinity
-		// TODO: Hard-coded for tx 16x4 and rx 8x2 arrays. Make it compatible with any geometry
-
-		std::vector<uint16_t> tx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_txBeamId,16,4);
-		std::vector<uint16_t> rx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_rxBeamId,8,2);
+		uint16_t txBeamsH, txBeamsV;
+		GetPeerBeamGrid(pDevice,it1->second,txBeamsH,txBeamsV);
+		std::vector<uint16_t> tx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_txBeamId,txBeamsH,txBeamsV);
+		std::vector<uint16_t> rx_beam_ids = GetSideImmediateNeighborBeams(beamPair.m_rxBeamId,GetNumBeamsH(),GetNumBeamsV());
 
-		std::vector<uint16_t> add_tx_beam_ids = GetAlphaSpacedAzimuthBeamsFromOptimal(beamPair.m_txBeamId,beta,16);
-		std::vector<uint16_t> add_rx_beam_ids = GetAlphaSpacedAzimuthBeamsFromOptimal(beamPair.m_rxBeamId,alpha,8);
+		std::vector<uint16_t> add_tx_beam_ids = GetAlphaSpacedAzimuthBeamsFromOptimal(beamPair.m_txBeamId,beta,txBeamsH);
+		std::vector<uint16_t> add_rx_beam_ids = GetAlphaSpacedAzimuthBeamsFromOptimal(beamPair.m_rxBeamId,alpha,GetNumBeamsH());
 
 		// Append additional vector at the end of the original tx beam id vector
 		tx_beam_ids.insert(tx_beam_ids.end(),add_tx_beam_ids.begin(),add_tx_beam_ids.end());
 		// Append additional vector at the end of the original rx beam id vector
 		rx_beam_ids.insert(rx_beam_ids.end(),add_rx_beam_ids.begin(),add_rx_beam_ids.end());
 
-		for (uint16_t numTxBeams = 0; numTxBeams < tx_beam_ids.size(); numTxBeams++)
-		{
-			uint16_t tempTxBeamId = tx_beam_ids.at(numTxBeams);
-			for(uint16_t numRxBeams = 0; numRxBeams < rx_beam_ids.size(); numRxBeams++)
-			{
-				if (numTxBeams == 0 && numRxBeams == 0)
-				{
-					continue;	//This one is already added in the vector
-				}
-				uint16_t tempRxBeamId = rx_beam_ids.at(numRxBeams);
-				std::map <sinrKey,SpectrumValue>::iterator itExtra =
-								it1->second.find(std::make_pair(tempTxBeamId,tempRxBeamId));
-				beamPairExtra.m_targetNetDevice = pDevice;
-				beamPairExtra.m_txBeamId = tempTxBeamId;
-				beamPairExtra.m_rxBeamId = tempRxBeamId;
-				if(itExtra != it1->second.end())	// Check whether SINR info is already available in the map
-				{
-					beamPairExtra.m_avgSinr = Sum(itExtra->second)/nbands;
-					beamPairExtra.m_sinrPsd = itExtra->second;
-				}
-				else
-				{
-					//No SINR value in the map. Just populating beam ids
-					beamPairExtra.m_avgSinr = -1;
-					beamPairExtra.m_sinrPsd = 0;
-				}
-				candidateBeamPairs.push_back(beamPairExtra);
-			}
-
-
-		}
-
-		//to map:
-		BeamTrackingParams beamTrackingStruct;
-		beamTrackingStruct.m_beamPairList = candidateBeamPairs;
-		beamTrackingStruct.m_numBeamPairs = candidateBeamPairs.size();
-		beamTrackingStruct.csiReportPeriod = static_cast<MmWavePhyMacCommon::CsiReportingPeriod>(m_beamReportingPeriod);
-//		std::map <Ptr<NetDevice>,BeamTrackingParams>::iterator itMap = m_candidateBeamsMap.find(pDevice);
-//		if(itMap == m_candidateBeamsMap.end())
-//		{
-//			m_candidateBeamsMap.insert(std::pair<Ptr<NetDevice>,BeamTrackingParams>(pDevice,beamTrackingStruct));
-//		}
-//		else
-//		{
-//			itMap->second = beamTrackingStruct;
-//		}
-		UpdateBeamTrackingInfo(pDevice,beamTrackingStruct);
+		UpdateNeighborBeamTrackingList(pDevice,it1->second,beamPair,tx_beam_ids,rx_beam_ids);
 	}
 }
 
@@ -864,23 +875,21 @@ MmWaveBeamManagement::Alt5BeamTrackingList (uint16_t beta, uint16_t alpha)
 void
 MmWaveBeamManagement::FingerPrinting_1()
 {
-	for (std::map< Ptr<NetDevice>, std::map <sinrKey,SpectrumValue>>::iterator it1 = m_enbSinrMap.begin();
+	for (std::map <Ptr<NetDevice>,BeamPairSinrStore>::iterator it1 = m_enbSinrMap.begin();
 					it1 != m_enbSinrMap.end();
 					++it1)
 	{
 		Ptr<NetDevice> pDevice = it1->first;
-		int nbands = it1->second.begin()->second.GetSpectrumModel()->GetNumBands();
 		BeamTrackingParams beamPairList = m_fingerprinting->GetBeamTrackingPairsCurrentIndex();
 		for (uint16_t n = 0; n < beamPairList.m_numBeamPairs; n++)
 		{
 			beamPairList.m_beamPairList.at(n).m_targetNetDevice = pDevice;
 			uint16_t tx_beam = beamPairList.m_beamPairList.at(n).m_txBeamId;
 			uint16_t rx_beam = beamPairList.m_beamPairList.at(n).m_rxBeamId;
-			std::map <sinrKey,SpectrumValue>::iterator it2 = it1->second.find(std::make_pair(tx_beam,rx_beam));
-			if(it2 != it1->second.end())	// Check whether SINR info is already available in the map
+			if(it1->second.IsValid(tx_beam,rx_beam))	// Check whether SINR info is already available in the map
 			{
-				beamPairList.m_beamPairList.at(n).m_avgSinr = Sum(it2->second)/nbands;
-				beamPairList.m_beamPairList.at(n).m_sinrPsd = it2->second;
+				beamPairList.m_beamPairList.at(n).m_avgSinr = it1->second.GetAvgSinr(tx_beam,rx_beam);
+				beamPairList.m_beamPairList.at(n).m_sinrPsd = it1->second.GetSinrPsd(tx_beam,rx_beam);
 			}
 			else
 			{
@@ -985,28 +994,27 @@ MmWaveBeamManagement::ExhaustiveBestScannedBeamPairSearch ()
 	bestPairInfo.m_targetNetDevice = NULL;
 
 	// Now iterate along the map and find the best gNB providing the best beam pairs in terms of SINR
-	for (std::map <Ptr<NetDevice>,std::map <sinrKey,SpectrumValue>>::iterator itEnb = m_enbSinrMap.begin();
+	for (std::map <Ptr<NetDevice>,BeamPairSinrStore>::iterator itEnb = m_enbSinrMap.begin();
 			itEnb != m_enbSinrMap.end();
 			++itEnb)
 	{
 		Ptr<NetDevice> pDevice = itEnb->first;
-		for(std::map <sinrKey,SpectrumValue>::iterator itSinrMap = itEnb->second.begin();
-				itSinrMap != itEnb->second.end();
-				++itSinrMap)
+		const BeamPairSinrStore &store = itEnb->second;
+		uint32_t bestPair = 0;
+		if (store.GetBestBeamPair (bestPair) && store.GetAvgSinr (bestPair) > bestPairInfo.m_avgSinr)
 		{
-			int nbands = itSinrMap->second.GetSpectrumModel ()->GetNumBands ();
-			double avgSinr = Sum (itSinrMap->second)/nbands;
-			if (avgSinr > bestPairInfo.m_avgSinr)
-			{
-				bestPairInfo.m_targetNetDevice = pDevice;
-				bestPairInfo.m_txBeamId = itSinrMap->first.first;
-				bestPairInfo.m_rxBeamId = itSinrMap->first.second;
-				bestPairInfo.m_avgSinr = avgSinr;
-				bestPairInfo.m_sinrPsd = itSinrMap->second;
-			}
+			bestPairInfo.m_targetNetDevice = pDevice;
+			bestPairInfo.m_txBeamId = store.GetBeamPair (bestPair).first;
+			bestPairInfo.m_rxBeamId = store.GetBeamPair (bestPair).second;
+			bestPairInfo.m_avgSinr = store.GetAvgSinr (bestPair);
 		}
 
 	}
+	// The PSD is only built for the selected beam pair
+	if (bestPairInfo.m_targetNetDevice)
+	{
+		bestPairInfo.m_sinrPsd = m_enbSinrMap[bestPairInfo.m_targetNetDevice].GetSinrPsd (bestPairInfo.m_txBeamId, bestPairInfo.m_rxBeamId);
+	}
 
 	return bestPairInfo;
 }
@@ -1107,10 +1115,10 @@ MmWaveBeamManagement::ClearAllSinrMapEntries ()
 {
 	if (m_memorySs == false)
 	{
-		std::map <Ptr<NetDevice>,std::map <sinrKey,SpectrumValue>>::iterator it;
+		std::map <Ptr<NetDevice>,BeamPairSinrStore>::iterator it;
 		for (it = m_enbSinrMap.begin(); it != m_enbSinrMap.end(); ++it)
 		{
-			it->second.clear();
+			it->second.Clear();
 		}
 	}
 }
@@ -1124,78 +1132,26 @@ MmWaveBeamManagement::ScheduleSsSlotSetStart(MmWavePhyMacCommon::SsBurstPeriods
 }
 
 
-std::complex<double>
-MmWaveBeamManagement::ParseComplex (std::string strCmplx)
-{
-    double re = 0.00;
-    double im = 0.00;
-    size_t findj = 0;
-    std::complex<double> out_complex;
-
-    findj = strCmplx.find("i");
-    if( findj == std::string::npos )
-    {
-        im = -1.00;
-    }
-    else
-    {
-        strCmplx[findj] = '\0';
-    }
-    if( ( strCmplx.find("+",1) == std::string::npos && strCmplx.find("-",1) == std::string::npos ) && im != -1 )
-    {
-        /* No real value */
-        re = -1.00;
-    }
-    std::stringstream stream( strCmplx );
-    if( re != -1.00 )
-    {
-        stream>>re;
-    }
-    else
-    {
-        re = 0;
-    }
-    if( im != -1 )
-    {
-        stream>>im;
-    }
-    else
-    {
-        im = 0.00;
-    }
-    //  std::cout<<" ---  "<<re<<"  "<<im<<std::endl;
-    out_complex = std::complex<double>(re,im);
-    return out_complex;
-}
-
-
-complex2DVector_t
-MmWaveBeamManagement::LoadCodebookFile (std::string inputFilename)
-{
-	//std::string filename = "src/mmwave/model/BeamFormingMatrix/TxAntenna.txt";
-	complex2DVector_t output;
-	NS_LOG_FUNCTION (this << "Loading TxAntenna file " << inputFilename);
-	std::ifstream singlefile;
-	std::complex<double> complexVar;
-	singlefile.open (inputFilename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << inputFilename);
-	NS_ASSERT_MSG(singlefile.good (), inputFilename << " file not found");
-    std::string line;
-    std::string token;
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	complexVector_t txAntenna;
-        std::istringstream stream(line);
-        while( getline(stream,token,',') ) //Parse each comma separated string in a line
-        {
-        	complexVar = ParseComplex(token);
-		    txAntenna.push_back(complexVar);
-		}
-        output.push_back(txAntenna);
+BeamPairInfoStruct
+MmWaveBeamManagement::GetScannedBeamPairInfo (Ptr<NetDevice> enb, const BeamPairSinrStore &store,
+		uint16_t txBeamId, uint16_t rxBeamId) const
+{
+	BeamPairInfoStruct beamPair;
+	beamPair.m_targetNetDevice = enb;
+	beamPair.m_txBeamId = txBeamId;
+	beamPair.m_rxBeamId = rxBeamId;
+	if (store.IsValid (txBeamId, rxBeamId))	// Check whether SINR info is already available in the store
+	{
+		beamPair.m_avgSinr = store.GetAvgSinr (txBeamId, rxBeamId);
+		beamPair.m_sinrPsd = store.GetSinrPsd (txBeamId, rxBeamId);
+	}
+	else
+	{
+		//No SINR value in the store. Just populating beam ids
+		beamPair.m_avgSinr = -1;
+		beamPair.m_sinrPsd = 0;
 	}
-    return output;
-//    NS_LOG_INFO ("TxAntenna[instance:"<<g_enbAntennaInstance.size()<<"][antennaSize:"<<g_enbAntennaInstance[0].size()<<"]");
+	return beamPair;
 }
 
 void MmWaveBeamManagement::SetBestScannedEnb(BeamPairInfoStruct bestEnbBeamInfo)
@@ -1238,49 +1194,35 @@ Time MmWaveBeamManagement::GetNextSsBlockTransmissionTime (Ptr<MmWavePhyMacCommo
 	return nextScheduledSsBlock;
 }
 
-std::map <Ptr<NetDevice>,BeamTrackingParams>
-MmWaveBeamManagement::GetDevicesMapToExpireTimer (Time margin)
+void
+MmWaveBeamManagement::GetDevicesToExpireTimer (Time margin, std::vector<Ptr<NetDevice> > &devices)
 {
-	std::map <Ptr<NetDevice>,BeamTrackingParams> newMap;
-	newMap.clear();
+	devices.clear ();
 	Time currentTime = Simulator::Now();
 	for (std::map <Ptr<NetDevice>,BeamTrackingParams>::iterator it = m_candidateBeamsMap.begin();
 			it != m_candidateBeamsMap.end();
 			++it)
 	{
-		BeamTrackingParams beamsInfo = it->second;
+		const BeamTrackingParams &beamsInfo = it->second;
 		if (currentTime - beamsInfo.m_csiResourceLastAllocation + margin > MilliSeconds(beamsInfo.csiReportPeriod))
 		{
-			std::pair<std::map <Ptr<NetDevice>,BeamTrackingParams>::iterator,bool> ret;
-			std::pair<Ptr<NetDevice>,BeamTrackingParams> newPair(it->first,it->second);
-			ret = newMap.insert(newPair);	//Insert the current iterator position
-			if(!ret.second)
-			{
-				std::cout << "Unable to insert into newMap" << std::endl;
-			}
+			devices.push_back (it->first);
 		}
 	}
-	return newMap;
 }
 
 void
-MmWaveBeamManagement::IncreaseBeamReportingTimers (std::map <Ptr<NetDevice>,BeamTrackingParams> devicesToUpdate)
+MmWaveBeamManagement::IncreaseBeamReportingTimers (const std::vector<Ptr<NetDevice> > &devicesToUpdate)
 {
-	if (!devicesToUpdate.empty())
+	// Find them in the map stored in the manager
+	for (unsigned i = 0; i < devicesToUpdate.size (); i++)
 	{
-		// Find it in the map stored in the manager
-		for (std::map <Ptr<NetDevice>,BeamTrackingParams>::iterator it1 = devicesToUpdate.begin();
-				it1 != devicesToUpdate.end();
-				++it1)
+		std::map <Ptr<NetDevice>,BeamTrackingParams>::iterator it = m_candidateBeamsMap.find (devicesToUpdate[i]);
+		if (it != m_candidateBeamsMap.end())	// This check might be redundant. The devices were obtained from this map
 		{
-			std::map <Ptr<NetDevice>,BeamTrackingParams>::iterator it2 = m_candidateBeamsMap.find(it1->first);
-			if (it2 != m_candidateBeamsMap.end())	// This check might be redundant. The beams were obtained from this map
-			{
-				it2->second.m_csiResourceLastAllocation =
-						it2->second.m_csiResourceLastAllocation + MilliSeconds(it2->second.csiReportPeriod);//Simulator::Now();
-			}
+			it->second.m_csiResourceLastAllocation =
+					it->second.m_csiResourceLastAllocation + MilliSeconds(it->second.csiReportPeriod);//Simulator::Now();
 		}
-
 	}
 }
 
@@ -1534,7 +1476,6 @@ FingerprintingDatabase::LoadFingerPrinting (std::string inputFilename)
 	NS_ASSERT_MSG(singlefile.good (), inputFilename << " file not found");
 
 	std::string line;
-	std::string token;
 	uint16_t counter = 0;
 	coordinate_t meas_point;
 	BeamTrackingParams bestBeamPairsInfo;
@@ -1552,13 +1493,13 @@ FingerprintingDatabase::LoadFingerPrinting (std::string inputFilename)
 			counter = 0;
 		}
 		doubleVector_t path;
-		std::istringstream stream(line);
-		while( getline(stream,token,',') ) //Parse each comma separated string in a line
+		const char *value = line.c_str();
+		const char *lineEnd = value + line.size();
+		while (value < lineEnd) //Parse each comma separated value in a line
 		{
-			double sigma = 0.00;
-			std::stringstream stream( token );
-			stream>>sigma;
-			path.push_back(sigma);
+			path.push_back(strtod(value, 0));
+			const char *comma = strchr(value, ',');
+			value = comma ? comma + 1 : lineEnd;
 		}
 
 		switch (counter)
@@ -25,6 +25,7 @@
 #include <ns3/mmwave-phy-mac-common.h>
 #include <ns3/random-variable-stream.h>
 #include <ns3/mmwave-phy-mac-common.h>
+#include <ns3/mmwave-codebook-loader.h>
 
 
 namespace ns3
@@ -43,7 +44,9 @@ struct BeamSweepingParams
 {
 	uint16_t m_currentBeamId;		// The current (or last) beam id used for beam sweeping
 	Time m_steerBeamInterval;		// The time period the beam is changed to the next one
-	complex2DVector_t m_codebook;	// The codebook used for beam sweeping
+	Ptr<const MmWaveCodebook> m_codebook;	// The codebook used for beam sweeping, shared by the devices that load the same file
+	uint16_t m_numBeamsH;			// Number of beams of the codebook in the horizontal plane
+	uint16_t m_numBeamsV;			// Number of beams of the codebook in the vertical plane (beam id = row*m_numBeamsH + column)
 };
 
 struct BeamPairInfoStruct
@@ -66,6 +69,97 @@ typedef struct BeamTrackingParams
 } BeamTrackingParams;
 
 
+/*
+ * Dense store of the SINR measured over the beam pairs of one gNB.
+ * The beam pair (txBeamId,rxBeamId) is stored at index txBeamId*numRxBeams+rxBeamId: the SINR of all its chunks
+ * in one flat array, its average SINR and a validity flag. Clear() invalidates the entries without releasing memory.
+ */
+class BeamPairSinrStore
+{
+public:
+	BeamPairSinrStore ();
+
+	/*
+	 * @brief Sets the dimensions of the store and invalidates all the entries.
+	 */
+	void Resize (uint16_t numTxBeams, uint16_t numRxBeams, Ptr<const SpectrumModel> model);
+
+	/*
+	 * @brief Stores the SINR of a beam pair, growing the store if the beam ids exceed its dimensions.
+	 */
+	void Set (uint16_t txBeamId, uint16_t rxBeamId, const SpectrumValue &sinr);
+
+	void Clear ();
+
+	/*
+	 * @brief Returns the indices of the numBeamPairs measured beam pairs with the highest average SINR,
+	 * in descending order of SINR (lowest index first in case of a tie). It uses a partial sort, O(N log numBeamPairs).
+	 */
+	std::vector<uint32_t> GetBestBeamPairs (uint32_t numBeamPairs) const;
+
+	/*
+	 * @brief Finds the measured beam pair with the highest average SINR (lowest index in case of a tie),
+	 * with one linear scan and no allocation.
+	 * @returns false if no beam pair is measured, otherwise true and the index of the pair in index.
+	 */
+	bool GetBestBeamPair (uint32_t &index) const;
+
+	bool IsValid (uint16_t txBeamId, uint16_t rxBeamId) const;
+	bool IsValid (uint32_t index) const;
+
+	double GetAvgSinr (uint16_t txBeamId, uint16_t rxBeamId) const;
+	double GetAvgSinr (uint32_t index) const;
+
+	SpectrumValue GetSinrPsd (uint16_t txBeamId, uint16_t rxBeamId) const;
+	SpectrumValue GetSinrPsd (uint32_t index) const;
+
+	uint32_t GetIndex (uint16_t txBeamId, uint16_t rxBeamId) const
+	{
+		return txBeamId*m_numRxBeams + rxBeamId;
+	}
+
+	sinrKey GetBeamPair (uint32_t index) const
+	{
+		return std::make_pair (index/m_numRxBeams, index%m_numRxBeams);
+	}
+
+	uint16_t GetNumTxBeams () const
+	{
+		return m_numTxBeams;
+	}
+
+	uint16_t GetNumRxBeams () const
+	{
+		return m_numRxBeams;
+	}
+
+	uint32_t GetNumBeamPairs () const
+	{
+		return m_avgSinr.size ();
+	}
+
+	uint32_t GetNumValidBeamPairs () const
+	{
+		return m_numValid;
+	}
+
+	uint16_t GetNumBands () const
+	{
+		return m_numBands;
+	}
+
+private:
+	uint16_t m_numTxBeams;
+	uint16_t m_numRxBeams;
+	uint16_t m_numBands;
+	Ptr<const SpectrumModel> m_spectrumModel;
+	std::vector<double> m_sinr;			// SINR of beam pair i in chunk b at [i*m_numBands+b]
+	std::vector<double> m_avgSinr;		// Average SINR of each beam pair
+	std::vector<bool> m_valid;			// Beam pairs measured since the last Clear()
+	uint32_t m_numValid;
+};
+
+
 
 class FingerprintingDatabase : public Object
 {
@@ -129,9 +223,31 @@ public:
 	void SetBeamChangeInterval (Time beamChangePeriod);
 	void SetBeamSweepCodebook (complex2DVector_t codebook);
 
+	/*
+	 * @brief Sets the beam grid of the codebook, the beam id is row*numBeamsH + column.
+	 */
+	void SetBeamSweepGeometry (uint16_t numBeamsH, uint16_t numBeamsV);
+
+	/*
+	 * @brief Returns the beam grid of the codebook. Aborts if it is unknown, i.e. if the codebook file name
+	 * does not describe it and the TxBeamGridRows or RxBeamGridRows attribute is not set.
+	 */
+	uint16_t GetNumBeamsH () const;
+	uint16_t GetNumBeamsV () const;
+
 	complexVector_t GetBeamSweepVector ();
 	complexVector_t GetBeamSweepVector (uint16_t index);
 
+	/*
+	 * @brief Returns the whole codebook used for beam sweeping without copying it.
+	 */
+	const complex2DVector_t& GetBeamSweepCodebook () const;
+	/*
+	 * @brief Returns the shared codebook object used for beam sweeping, which identifies the codebook
+	 * for as long as the reference is held.
+	 */
+	Ptr<const MmWaveCodebook> GetBeamSweepCodebookObject () const;
+
 	void BeamSweepStepTx ();
 	void BeamSweepStepRx ();
 	void BeamSweepStep ();
@@ -263,9 +379,14 @@ public:
 		m_rxFilePath = path;
 	}
 
-	std::map <Ptr<NetDevice>,BeamTrackingParams> GetDevicesMapToExpireTimer (Time margin);
+	/**
+	 * Find the devices whose CSI resources have to be allocated within a margin
+	 * @params the margin
+	 * @params the devices found, the vector is cleared first so that the caller can reuse it
+	 */
+	void GetDevicesToExpireTimer (Time margin, std::vector<Ptr<NetDevice> > &devices);
 
-	void IncreaseBeamReportingTimers (std::map <Ptr<NetDevice>,BeamTrackingParams> devicesToUpdate);
+	void IncreaseBeamReportingTimers (const std::vector<Ptr<NetDevice> > &devicesToUpdate);
 
 	BeamTrackingParams GetBeamsToTrackForEnb (Ptr<NetDevice> enb);
 
@@ -292,17 +413,34 @@ public:
 
 private:
 
-	std::complex<double> ParseComplex (std::string strCmplx);
+	/**
+	* \brief Sets the beam grid of the codebook from its number of rows or, if it is 0, from a codebook file name
+	* such as KronCodebook16h4v.txt. The grid is left unknown if the name does not describe it.
+	*/
+	void SetBeamSweepGeometryFromPath (std::string path, uint16_t numBeamsV);
+
+	/**
+	* \brief Creates the tracking list of a gNB with the best beam pair followed by the combinations of the tx and rx beams.
+	* The first tx and rx beams must be the ones of the best beam pair.
+	*/
+	void UpdateNeighborBeamTrackingList (Ptr<NetDevice> enb, const BeamPairSinrStore &store, BeamPairInfoStruct bestPair,
+			const std::vector<uint16_t> &txBeamIds, const std::vector<uint16_t> &rxBeamIds);
+
+	/**
+	* \brief Returns the beam grid of the codebook of the peer device
+	*/
+	void GetPeerBeamGrid (Ptr<NetDevice> peer, const BeamPairSinrStore &store, uint16_t &numBeamsH, uint16_t &numBeamsV) const;
 
 	/**
-	* \brief Loads a generic beamforming matrix
-	* \param Path to the input file to read
-	* \return Array of complex values
+	* \brief Fills the information of a beam pair with the SINR of the store, or with avgSinr -1 if it was not measured
 	*/
-	complex2DVector_t LoadCodebookFile (std::string inputFilename);
+	BeamPairInfoStruct GetScannedBeamPairInfo (Ptr<NetDevice> enb, const BeamPairSinrStore &store,
+			uint16_t txBeamId, uint16_t rxBeamId) const;
 
 	std::string m_txFilePath;
 	std::string m_rxFilePath;
+	uint16_t m_txBeamGridRows;	// Rows of the beam grid of the gNB codebook, 0 to read the grid from the file name
+	uint16_t m_rxBeamGridRows;	// Rows of the beam grid of the UE codebook, 0 to read the grid from the file name
 
 	BeamSweepingParams m_beamSweepParams;
 
@@ -322,7 +460,7 @@ private:
 	bool m_beamReportingEnabled;	// Determines if beam reporting is enabled at this time
 	bool m_memorySs;	// Flag to determine if SS tracking decisions are to be made with the whole historical or only within the current SSB window
 
-	std::map <Ptr<NetDevice>,std::map <sinrKey,SpectrumValue>> m_enbSinrMap;	//Map to all the eNBs
+	std::map <Ptr<NetDevice>,BeamPairSinrStore> m_enbSinrMap;	//Map to all the eNBs
 //	std::map <Ptr<NetDevice>,std::map <sinrKey,float>> m_ueSinrMap;	//Map to all the UEs
 
 	Ptr<FingerprintingDatabase> m_fingerprinting;
@@ -38,6 +38,7 @@
 #include <ns3/double.h>
 #include <ns3/boolean.h>
 #include "mmwave-spectrum-value-helper.h"
+#include "mmwave-codebook-loader.h"
 
 
 namespace ns3{
@@ -138,45 +139,7 @@ MmWaveBeamforming::GetConfigurationParameters (void) const
 std::complex<double>
 MmWaveBeamforming::ParseComplex (std::string strCmplx)
 {
-    double re = 0.00;
-    double im = 0.00;
-    size_t findj = 0;
-    std::complex<double> out_complex;
-
-    findj = strCmplx.find("i");
-    if( findj == std::string::npos )
-    {
-        im = -1.00;
-    }
-    else
-    {
-        strCmplx[findj] = '\0';
-    }
-    if( ( strCmplx.find("+",1) == std::string::npos && strCmplx.find("-",1) == std::string::npos ) && im != -1 )
-    {
-        /* No real value */
-        re = -1.00;
-    }
-    std::stringstream stream( strCmplx );
-    if( re != -1.00 )
-    {
-        stream>>re;
-    }
-    else
-    {
-        re = 0;
-    }
-    if( im != -1 )
-    {
-        stream>>im;
-    }
-    else
-    {
-        im = 0.00;
-    }
-    //  std::cout<<" ---  "<<re<<"  "<<im<<std::endl;
-    out_complex = std::complex<double>(re,im);
-    return out_complex;
+	return MmWaveCodebookLoader::ParseComplex (strCmplx);
 }
 
 void
@@ -223,25 +186,8 @@ MmWaveBeamforming::LoadEnbAntenna ()
 {
 	std::string filename = "src/mmwave/model/BeamFormingMatrix/TxAntenna.txt";
 	NS_LOG_FUNCTION (this << "Loading TxAntenna file " << filename);
-	std::ifstream singlefile;
-	std::complex<double> complexVar;
-	singlefile.open (filename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << filename);
-	NS_ASSERT_MSG(singlefile.good (), " TxAntenna file not found");
-    std::string line;
-    std::string token;
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	complexVector_t txAntenna;
-        std::istringstream stream(line);
-        while( getline(stream,token,',') ) //Parse each comma separated string in a line
-        {
-        	complexVar = ParseComplex(token);
-		    txAntenna.push_back(complexVar);
-		}
-		g_enbAntennaInstance.push_back(txAntenna);
-	}
+	const complex2DVector_t &txAntenna = MmWaveCodebookLoader::Load (filename)->m_codewords;
+	g_enbAntennaInstance.insert (g_enbAntennaInstance.end (), txAntenna.begin (), txAntenna.end ());
     NS_LOG_INFO ("TxAntenna[instance:"<<g_enbAntennaInstance.size()<<"][antennaSize:"<<g_enbAntennaInstance[0].size()<<"]");
 }
 
@@ -251,26 +197,8 @@ MmWaveBeamforming::LoadUeAntenna ()
 {
 	std::string filename = "src/mmwave/model/BeamFormingMatrix/RxAntenna.txt";
 	NS_LOG_FUNCTION (this << "Loading RxAntenna file " << filename);
-	std::ifstream singlefile;
-	std::complex<double> complexVar;
-	singlefile.open (filename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << filename);
-	NS_ASSERT_MSG(singlefile.good (), " RxAntenna file not found");
-
-    std::string line;
-    std::string token;
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	complexVector_t rxAntenna;
-		std::istringstream stream(line);
-		while( getline(stream,token,',') ) //Parse each comma separated string in a line
-		{
-			complexVar = ParseComplex(token);
-		    rxAntenna.push_back(complexVar);
-		}
-		g_ueAntennaInstance.push_back(rxAntenna);
-	}
+	const complex2DVector_t &rxAntenna = MmWaveCodebookLoader::Load (filename)->m_codewords;
+	g_ueAntennaInstance.insert (g_ueAntennaInstance.end (), rxAntenna.begin (), rxAntenna.end ());
     NS_LOG_INFO ("RxAntenna[instance:"<<g_ueAntennaInstance.size()<<"][antennaSize:"<<g_ueAntennaInstance[0].size()<<"]");
 }
 
@@ -279,34 +207,19 @@ MmWaveBeamforming::LoadEnbSpatialSignature ()
 {
 	std::string filename = "src/mmwave/model/BeamFormingMatrix/TxSpatialSigniture.txt";
 	NS_LOG_FUNCTION (this << "Loading TxspatialSigniture file " << filename);
-	std::ifstream singlefile;
-	std::string line;
-	std::string token;
+	complex2DVector_t txSpatialElements = MmWaveCodebookLoader::ParseTextFile (filename);
 
-	uint16_t counter = 1;
-	std::complex<double> complexVar;
+	// every m_pathNum rows form one instance
 	complex2DVector_t txSpatialMatrix;
-	singlefile.open (filename.c_str (), std::ifstream::in);
-
-	NS_ASSERT_MSG (singlefile.good (), "TxSpatialSigniture file not found");
-
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	complexVector_t txSpatialElement;
-		std::istringstream stream(line);
-		while( getline(stream,token,',') ) //Parse each comma separated string in a line
-		{
-			complexVar = ParseComplex(token);
-			txSpatialElement.push_back(complexVar);
-		}
-		txSpatialMatrix.push_back(txSpatialElement);
+	for (uint32_t counter = 1; counter <= txSpatialElements.size (); counter++)
+	{
+		txSpatialMatrix.push_back (txSpatialElements[counter - 1]);
 		if(counter % m_pathNum ==0 )
 		{
 			g_enbSpatialInstance.push_back(txSpatialMatrix);
 			txSpatialMatrix.clear();
 		}
-	    counter++;
-    }
+	}
     NS_LOG_INFO ("TxspatialSigniture[instance:"<<g_enbSpatialInstance.size()<<"][path:"<<g_enbSpatialInstance[0].size()<<"][antennaSize:"<<g_enbSpatialInstance[0][0].size()<<"]");
 }
 
@@ -315,33 +228,18 @@ MmWaveBeamforming::LoadUeSpatialSignature ()
 {
 	std::string strFilename = "src/mmwave/model/BeamFormingMatrix/RxSpatialSigniture.txt";
 	NS_LOG_FUNCTION (this << "Loading RxspatialSigniture file " << strFilename);
-	std::ifstream singlefile;
-	std::complex<double> complexVar;
-	complex2DVector_t rxSpatialMatrix;
-	singlefile.open (strFilename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << strFilename);
-	NS_ASSERT_MSG (singlefile.good (), " RxSpatialSigniture file not found");
+	complex2DVector_t rxSpatialElements = MmWaveCodebookLoader::ParseTextFile (strFilename);
 
-	std::string line;
-	std::string token;
-	int counter = 1;
-	while (std::getline(singlefile, line) ) //Parse each line of the file
+	// every m_pathNum rows form one instance
+	complex2DVector_t rxSpatialMatrix;
+	for (uint32_t counter = 1; counter <= rxSpatialElements.size (); counter++)
 	{
-		 complexVector_t rxSpatialElement;
-	     std::istringstream stream(line);
-	     while (getline(stream,token,',') ) //Parse each comma separated string in a line
-	     {
-	    	 complexVar = ParseComplex (token);
-	    	 rxSpatialElement.push_back (complexVar);
-	     }
-	     rxSpatialMatrix.push_back (rxSpatialElement);
-	     if (counter % m_pathNum == 0)
-	     {
-		   	 g_ueSpatialInstance.push_back (rxSpatialMatrix);
-		   	 rxSpatialMatrix.clear ();
-		 }
-	     counter++;
+		rxSpatialMatrix.push_back (rxSpatialElements[counter - 1]);
+		if (counter % m_pathNum == 0)
+		{
+			g_ueSpatialInstance.push_back (rxSpatialMatrix);
+			rxSpatialMatrix.clear ();
+		}
 	}
 	NS_LOG_INFO ("RxspatialSigniture[instance:"<<g_ueSpatialInstance.size()<<"][path:"<<g_ueSpatialInstance[0].size()<<"][antennaSize:"<<g_ueSpatialInstance[0][0].size()<<"]");
 }
@@ -0,0 +1,264 @@
+/*
+ * mmwave-buildings-index.cc
+ *
+ *  Bounding volume hierarchy over the buildings of BuildingList, used by the
+ *  building-aware propagation loss models to find the buildings crossed by a link.
+ */
+
+#include "mmwave-buildings-index.h"
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <ns3/building-list.h>
+#include <ns3/building.h>
+#include <ns3/simulator.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveBuildingsIndex");
+
+static const uint32_t MAX_LEAF_SIZE = 4;
+static const uint32_t MAX_DEPTH = 64;
+
+/*
+ * @brief Index of BuildingList and whether it has to be rebuilt
+ */
+static Ptr<MmWaveBuildingsIndex> g_buildingsIndex;
+static bool g_buildingsIndexValid = false;
+static bool g_destroyScheduled = false;
+
+/*
+ * @brief Invalidates the index when the simulator is destroyed, scheduled once per simulation
+ */
+static void
+DestroyBuildingsIndex ()
+{
+	g_buildingsIndexValid = false;
+	g_destroyScheduled = false;
+}
+
+/*
+ * @brief Orders buildings by the center of their box along an axis
+ */
+struct CompareCenters
+{
+	CompareCenters (const std::vector<Vector> &centers, int axis)
+		: m_centers (centers),
+		  m_axis (axis)
+	{
+	}
+	bool operator() (uint32_t i, uint32_t j) const
+	{
+		const Vector &a = m_centers[i];
+		const Vector &b = m_centers[j];
+		return m_axis == 0 ? a.x < b.x : (m_axis == 1 ? a.y < b.y : a.z < b.z);
+	}
+	const std::vector<Vector> &m_centers;
+	int m_axis;
+};
+
+Ptr<MmWaveBuildingsIndex>
+MmWaveBuildingsIndex::Get ()
+{
+	if (g_buildingsIndex == 0 || !g_buildingsIndexValid
+			|| g_buildingsIndex->GetNBuildings () != BuildingList::GetNBuildings ())
+	{
+		std::vector<Box> boxes;
+		boxes.reserve (BuildingList::GetNBuildings ());
+		for (BuildingList::Iterator bit = BuildingList::Begin (); bit != BuildingList::End (); ++bit)
+		{
+			boxes.push_back ((*bit)->GetBoundaries ());
+		}
+		g_buildingsIndex = Create<MmWaveBuildingsIndex> ();
+		g_buildingsIndex->Build (boxes);
+		g_buildingsIndexValid = true;
+		// BuildingList is emptied by Simulator::Destroy, the next simulation may create other buildings
+		if (!g_destroyScheduled)
+		{
+			Simulator::ScheduleDestroy (&DestroyBuildingsIndex);
+			g_destroyScheduled = true;
+		}
+		NS_LOG_INFO ("Indexed " << boxes.size () << " buildings");
+	}
+	return g_buildingsIndex;
+}
+
+void
+MmWaveBuildingsIndex::Invalidate ()
+{
+	g_buildingsIndexValid = false;
+}
+
+MmWaveBuildingsIndex::MmWaveBuildingsIndex ()
+{
+}
+
+void
+MmWaveBuildingsIndex::Build (const std::vector<Box> &boxes)
+{
+	m_nodes.clear ();
+	m_boxes.clear ();
+	if (boxes.empty ())
+	{
+		return;
+	}
+	std::vector<uint32_t> order (boxes.size ());
+	std::vector<Vector> centers (boxes.size ());
+	for (uint32_t i = 0; i < boxes.size (); i++)
+	{
+		order[i] = i;
+		centers[i] = Vector (0.5*(boxes[i].xMin + boxes[i].xMax), 0.5*(boxes[i].yMin + boxes[i].yMax),
+				0.5*(boxes[i].zMin + boxes[i].zMax));
+	}
+	m_nodes.reserve (2*boxes.size ()/MAX_LEAF_SIZE + 1);
+	BuildNode (order, boxes, centers, 0, boxes.size ());
+	m_boxes.resize (boxes.size ());
+	for (uint32_t i = 0; i < order.size (); i++)
+	{
+		m_boxes[i] = boxes[order[i]];
+	}
+}
+
+uint32_t
+MmWaveBuildingsIndex::BuildNode (std::vector<uint32_t> &order, const std::vector<Box> &boxes,
+		const std::vector<Vector> &centers, uint32_t first, uint32_t last)
+{
+	uint32_t index = m_nodes.size ();
+	m_nodes.push_back (Node ());
+	Box box = boxes[order[first]];
+	Box centerBounds (centers[order[first]].x, centers[order[first]].x, centers[order[first]].y,
+			centers[order[first]].y, centers[order[first]].z, centers[order[first]].z);
+	for (uint32_t i = first + 1; i < last; i++)
+	{
+		const Box &b = boxes[order[i]];
+		box = Box (std::min (box.xMin, b.xMin), std::max (box.xMax, b.xMax), std::min (box.yMin, b.yMin),
+				std::max (box.yMax, b.yMax), std::min (box.zMin, b.zMin), std::max (box.zMax, b.zMax));
+		const Vector &c = centers[order[i]];
+		centerBounds = Box (std::min (centerBounds.xMin, c.x), std::max (centerBounds.xMax, c.x),
+				std::min (centerBounds.yMin, c.y), std::max (centerBounds.yMax, c.y),
+				std::min (centerBounds.zMin, c.z), std::max (centerBounds.zMax, c.z));
+	}
+	// pad the box, so that rounding errors do not prune a building touched by the line
+	double pad = 1e-9 * (1.0 + std::max (std::max (box.xMax - box.xMin, box.yMax - box.yMin), box.zMax - box.zMin)
+			+ std::max (std::max (std::abs (box.xMin), std::abs (box.xMax)), std::max (std::abs (box.yMin), std::abs (box.yMax))));
+	m_nodes[index].m_box = Box (box.xMin - pad, box.xMax + pad, box.yMin - pad, box.yMax + pad, box.zMin - pad, box.zMax + pad);
+
+	if (last - first <= MAX_LEAF_SIZE)
+	{
+		m_nodes[index].m_first = first;
+		m_nodes[index].m_count = last - first;
+		return index;
+	}
+
+	// split at the median of the longest axis of the centers
+	double extent[3] = {centerBounds.xMax - centerBounds.xMin, centerBounds.yMax - centerBounds.yMin,
+			centerBounds.zMax - centerBounds.zMin};
+	int axis = extent[1] > extent[0] ? 1 : 0;
+	axis = extent[2] > extent[axis] ? 2 : axis;
+	uint32_t middle = first + (last - first) / 2;
+	std::nth_element (order.begin () + first, order.begin () + middle, order.begin () + last, CompareCenters (centers, axis));
+
+	m_nodes[index].m_count = 0;
+	BuildNode (order, boxes, centers, first, middle);
+	uint32_t right = BuildNode (order, boxes, centers, middle, last);
+	m_nodes[index].m_first = right;
+	return index;
+}
+
+bool
+MmWaveBuildingsIndex::IsLineIntersectBuildings (Vector l1, Vector l2, bool ignoreHeight) const
+{
+	if (m_nodes.empty ())
+	{
+		return false;
+	}
+	uint32_t stack[MAX_DEPTH];
+	uint32_t size = 0;
+	stack[size++] = 0;
+	while (size > 0)
+	{
+		const Node &node = m_nodes[stack[--size]];
+		if (!IsLineIntersectBox (node.m_box, l1, l2, ignoreHeight))
+		{
+			continue;
+		}
+		if (node.m_count > 0)
+		{
+			for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+			{
+				if (IsLineIntersectBox (m_boxes[i], l1, l2, ignoreHeight))
+				{
+					return true;
+				}
+			}
+		}
+		else
+		{
+			NS_ASSERT_MSG (size + 2 <= MAX_DEPTH, "Buildings index too deep");
+			stack[size++] = node.m_first;
+			stack[size++] = &node - &m_nodes[0] + 1;
+		}
+	}
+	return false;
+}
+
+uint32_t
+MmWaveBuildingsIndex::GetNBuildings () const
+{
+	return m_boxes.size ();
+}
+
+bool
+MmWaveBuildingsIndex::IsLineIntersectBox (const Box &boundaries, Vector L1, Vector L2, bool ignoreHeight)
+{
+	Vector boxSize (0.5*(boundaries.xMax - boundaries.xMin),
+			0.5*(boundaries.yMax - boundaries.yMin),
+			0.5*(boundaries.zMax - boundaries.zMin));
+	Vector boxCenter (boundaries.xMin + boxSize.x,
+			boundaries.yMin + boxSize.y,
+			boundaries.zMin + boxSize.z);
+
+	// Put line in box space
+	Vector LB1 (L1.x-boxCenter.x, L1.y-boxCenter.y, L1.z-boxCenter.z);
+	Vector LB2 (L2.x-boxCenter.x, L2.y-boxCenter.y, L2.z-boxCenter.z);
+
+	// Get line midpoint and extent
+	Vector LMid (0.5*(LB1.x+LB2.x), 0.5*(LB1.y+LB2.y), 0.5*(LB1.z+LB2.z));
+	Vector L (LB1.x - LMid.x, LB1.y - LMid.y, LB1.z - LMid.z);
+	Vector LExt ( std::abs(L.x), std::abs(L.y), std::abs(L.z) );
+
+	// Use Separating Axis Test
+	// Separation vector from box center to line center is LMid, since the line is in box space
+	if ( std::abs( LMid.x ) > boxSize.x + LExt.x ) return false;
+	if ( std::abs( LMid.y ) > boxSize.y + LExt.y ) return false;
+	if ( std::abs( LMid.x * L.y - LMid.y * L.x)  >  (boxSize.x * LExt.y + boxSize.y * LExt.x) ) return false;
+	if (ignoreHeight)
+	{
+		// in the horizontal plane, the vertical axis is the only cross product
+		return true;
+	}
+	if ( std::abs( LMid.z ) > boxSize.z + LExt.z ) return false;
+	// Crossproducts of line and each axis
+	if ( std::abs( LMid.y * L.z - LMid.z * L.y)  >  (boxSize.y * LExt.z + boxSize.z * LExt.y) ) return false;
+	if ( std::abs( LMid.x * L.z - LMid.z * L.x)  >  (boxSize.x * LExt.z + boxSize.z * LExt.x) ) return false;
+
+	// No separating axis, the line intersects
+	return true;
+}
+
+bool
+MmWaveBuildingsIndex::IsLineIntersectBuildingsLinear (Vector l1, Vector l2, bool ignoreHeight)
+{
+	for (BuildingList::Iterator bit = BuildingList::Begin (); bit != BuildingList::End (); ++bit)
+	{
+		if (IsLineIntersectBox ((*bit)->GetBoundaries (), l1, l2, ignoreHeight))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace ns3
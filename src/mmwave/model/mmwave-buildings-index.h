@@ -0,0 +1,103 @@
+/*
+ * mmwave-buildings-index.h
+ *
+ *  Bounding volume hierarchy over the buildings of BuildingList, used by the
+ *  building-aware propagation loss models to find the buildings crossed by a link.
+ */
+
+#ifndef MMWAVE_BUILDINGS_INDEX_H_
+#define MMWAVE_BUILDINGS_INDEX_H_
+
+#include <ns3/simple-ref-count.h>
+#include <ns3/ptr.h>
+#include <ns3/box.h>
+#include <ns3/vector.h>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Static bounding volume hierarchy over the boxes of the buildings. A line is tested
+ * against the boxes of the nodes it crosses only, so a LOS query costs O(log(buildings))
+ * instead of a test against every building.
+ *
+ * The shared index of BuildingList (Get) is built by the first query after the buildings
+ * are created, and rebuilt when the number of buildings changes and after Simulator::Destroy.
+ * Buildings moved or resized after the first query require Invalidate.
+ */
+class MmWaveBuildingsIndex : public SimpleRefCount<MmWaveBuildingsIndex>
+{
+public:
+	/**
+	 * @returns the index of the buildings of BuildingList, built if the buildings changed
+	 */
+	static Ptr<MmWaveBuildingsIndex> Get ();
+
+	/**
+	 * Rebuild the shared index at the next query, e.g. after changing the boundaries of a building
+	 */
+	static void Invalidate ();
+
+	MmWaveBuildingsIndex ();
+
+	/**
+	 * Build the hierarchy
+	 * @params the boxes of the buildings
+	 */
+	void Build (const std::vector<Box> &boxes);
+
+	/**
+	 * @params first end of the line
+	 * @params second end of the line
+	 * @params true to test the footprints of the buildings only, as if they were infinitely high
+	 * @returns true if the line intersects at least one building
+	 */
+	bool IsLineIntersectBuildings (Vector l1, Vector l2, bool ignoreHeight) const;
+
+	/**
+	 * @returns the number of buildings indexed
+	 */
+	uint32_t GetNBuildings () const;
+
+	/**
+	 * Separating axis test of a line and a box
+	 * @params the box
+	 * @params first end of the line
+	 * @params second end of the line
+	 * @params true to test in the horizontal plane only
+	 * @returns true if the line intersects the box
+	 */
+	static bool IsLineIntersectBox (const Box &box, Vector l1, Vector l2, bool ignoreHeight);
+
+	/**
+	 * Test the line against every building of BuildingList, without the index
+	 * @params first end of the line
+	 * @params second end of the line
+	 * @params true to test the footprints of the buildings only
+	 * @returns true if the line intersects at least one building
+	 */
+	static bool IsLineIntersectBuildingsLinear (Vector l1, Vector l2, bool ignoreHeight);
+
+private:
+	struct Node
+	{
+		Box m_box;			// bounding box of the buildings of the node
+		uint32_t m_first;	// first building of a leaf in m_boxes, right child of an inner node
+		uint32_t m_count;	// number of buildings of a leaf, 0 for an inner node (left child is the next node)
+	};
+
+	/**
+	 * Build the node of the buildings m_order[first, last)
+	 * @returns the index of the node
+	 */
+	uint32_t BuildNode (std::vector<uint32_t> &order, const std::vector<Box> &boxes,
+			const std::vector<Vector> &centers, uint32_t first, uint32_t last);
+
+	std::vector<Node> m_nodes;	// depth first, the root is the first one
+	std::vector<Box> m_boxes;	// boxes of the buildings, in the order of the leaves
+};
+
+} // namespace ns3
+
+#endif /* MMWAVE_BUILDINGS_INDEX_H_ */
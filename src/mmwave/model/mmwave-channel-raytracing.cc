@@ -41,6 +41,7 @@
 #include <algorithm>
 #include <fstream>
 #include "mmwave-spectrum-value-helper.h"
+#include "mmwave-subband-gain.h"
 
 
 namespace ns3{
@@ -50,19 +51,11 @@ NS_LOG_COMPONENT_DEFINE ("MmWaveChannelRaytracing");
 NS_OBJECT_ENSURE_REGISTERED (MmWaveChannelRaytracing);
 
 
-doubleVector_t g_path; //number of multipath
-double2DVector_t g_delay; //delay spread in ns
-double2DVector_t g_pathloss;	//pathloss in DB
-double2DVector_t g_phase;	//???what is this
-double2DVector_t g_aodElevation;	//degree
-double2DVector_t g_aodAzimuth;	//degree
-double2DVector_t g_aoaElevation;	//degree
-double2DVector_t g_aoaAzimuth;	//degree
-uint16_t g_numPdps;	// number of PDPs in the trace file
 
 
 MmWaveChannelRaytracing::MmWaveChannelRaytracing ()
-	:m_antennaSeparation(0.5)
+	:m_antennaSeparation(0.5),
+	 m_traceIndex(0)
 {
 	m_uniformRv = CreateObject<UniformRandomVariable> ();
 	m_transitory_time_seconds = 3.0;
@@ -94,6 +87,12 @@ MmWaveChannelRaytracing::GetTypeId (void)
 				StringValue(""),
 				MakeStringAccessor(&MmWaveChannelRaytracing::SetTraceFilePath),
 				MakeStringChecker ())
+	.AddAttribute ("TracePrefetchWindow",
+			   "Number of trace records kept in memory by this channel before and after the current one, also read in advance",
+			   UintegerValue (100),
+			   MakeUintegerAccessor (&MmWaveChannelRaytracing::SetTracePrefetchWindow,
+			                         &MmWaveChannelRaytracing::GetTracePrefetchWindow),
+			   MakeUintegerChecker<uint32_t> ())
 	;
 	return tid;
 }
@@ -131,6 +130,26 @@ void
 MmWaveChannelRaytracing::SetTraceIndex (uint16_t index)
 {
 	m_traceIndex = index;
+	if (m_trace != 0 && m_traceIndex < m_trace->GetNumRecords ())
+	{
+		m_trace->Prefetch (m_traceIndex);
+	}
+}
+
+void
+MmWaveChannelRaytracing::SetTracePrefetchWindow (uint32_t window)
+{
+	m_tracePrefetchWindow = window;
+	if (m_trace != 0)
+	{
+		m_trace->SetPrefetchWindow (window);
+	}
+}
+
+uint32_t
+MmWaveChannelRaytracing::GetTracePrefetchWindow () const
+{
+	return m_tracePrefetchWindow;
 }
 
 void
@@ -140,74 +159,7 @@ MmWaveChannelRaytracing::LoadTraces()
 	std::string filename = "src/mmwave/model/Raytracing/traces.txt";
 //	std::string filename = "src/mmwave/model/Raytracing/tracesUnity2_delay.txt";
 	NS_LOG_FUNCTION (this << "Loading Raytracing file " << filename);
-	std::ifstream singlefile;
-	singlefile.open (filename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << filename);
-	NS_ASSERT_MSG(singlefile.good (), " Raytracing file not found");
-    std::string line;
-    std::string token;
-    uint16_t counter = 0;
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	if(counter == 8)
-    	{
-    		counter = 0;
-    	}
-    	doubleVector_t path;
-        std::istringstream stream(line);
-        while( getline(stream,token,',') ) //Parse each comma separated string in a line
-        {
-            double sigma = 0.00;
-            std::stringstream stream( token );
-            stream>>sigma;
-        	path.push_back(sigma);
-		}
-
-		switch (counter)
-		{
-		case 0:
-			g_path.push_back (path.at (0));
-			break;
-		case 1:
-			g_delay.push_back (path);
-			break;
-		case 2:
-			g_pathloss.push_back (path);
-			break;
-		case 3:
-			g_phase.push_back (path);
-			break;
-		case 4:
-			g_aodElevation.push_back (path);
-			break;
-		case 5:
-			g_aodAzimuth.push_back (path);
-			break;
-		case 6:
-			g_aoaElevation.push_back (path);
-			break;
-		case 7:
-			g_aoaAzimuth.push_back (path);
-			break;
-		default:
-			NS_FATAL_ERROR("Never call this");
-			break;
-		}
-		counter++;
-	}
-
-	/*NS_LOG_UNCOND(g_path.size());
-	NS_LOG_UNCOND(g_delay.size());
-	NS_LOG_UNCOND(g_pathloss.size());
-	NS_LOG_UNCOND(g_phase.size());
-	NS_LOG_UNCOND(g_aodElevation.size());
-	NS_LOG_UNCOND(g_aodAzimuth.size());
-	NS_LOG_UNCOND(g_aoaElevation.size());
-	NS_LOG_UNCOND(g_aoaAzimuth.size());*/
-
-    g_numPdps = g_path.size();
-
+	OpenTrace (filename);
 }
 
 
@@ -223,77 +175,18 @@ MmWaveChannelRaytracing::LoadTracesMod()
 		filename = "src/mmwave/model/Raytracing/NS3_corner1.txt";
 	}
 	NS_LOG_FUNCTION (this << "Loading Raytracing file " << filename);
-	std::ifstream singlefile;
-	singlefile.open (filename.c_str (), std::ifstream::in);
-
-	NS_LOG_INFO (this << " File: " << filename);
-	NS_ASSERT_MSG(singlefile.good (), " Raytracing file not found");
-    std::string line;
-    std::string token;
-    uint16_t counter = 0;
-    double2DVector_t delay_temp;
-    while( std::getline(singlefile, line) ) //Parse each line of the file
-    {
-    	if(counter == 8)
-    	{
-    		counter = 0;
-    	}
-    	doubleVector_t path;
-        std::istringstream stream(line);
-        while( getline(stream,token,',') ) //Parse each comma separated string in a line
-        {
-            double sigma = 0.00;
-            std::stringstream stream( token );
-            stream>>sigma;
-        	path.push_back(sigma);
-		}
+	OpenTrace (filename);
+}
 
-		switch (counter)
-		{
-		case 0:
-			g_path.push_back (path.at (0));
-			break;
-		case 1:
-			delay_temp.push_back (path);
-			// Sort vector from smallest to greatest delay and keep indices for following reordering.
-			g_delay.push_back (path);
-			break;
-		case 2:
-			g_pathloss.push_back (path);
-			break;
-		case 3:
-			g_phase.push_back (path);
-			break;
-		case 4:
-			g_aodElevation.push_back (path);
-			break;
-		case 5:
-			g_aodAzimuth.push_back (path);
-			break;
-		case 6:
-			g_aoaElevation.push_back (path);
-			break;
-		case 7:
-			g_aoaAzimuth.push_back (path);
-			break;
-		default:
-			NS_FATAL_ERROR("Never call this");
-			break;
-		}
-		counter++;
+void
+MmWaveChannelRaytracing::OpenTrace (std::string filename)
+{
+	// the records are read on demand, only the index of the file is built here
+	m_trace = Create<MmWaveRaytracingTraceReader> (MmWaveRaytracingTrace::Open (filename), m_tracePrefetchWindow);
+	if (m_traceIndex < m_trace->GetNumRecords ())
+	{
+		m_trace->Prefetch (m_traceIndex);
 	}
-
-	/*NS_LOG_UNCOND(g_path.size());
-	NS_LOG_UNCOND(g_delay.size());
-	NS_LOG_UNCOND(g_pathloss.size());
-	NS_LOG_UNCOND(g_phase.size());
-	NS_LOG_UNCOND(g_aodElevation.size());
-	NS_LOG_UNCOND(g_aodAzimuth.size());
-	NS_LOG_UNCOND(g_aoaElevation.size());
-	NS_LOG_UNCOND(g_aoaAzimuth.size());*/
-
-    g_numPdps = g_path.size();
-
 }
 
 
@@ -481,9 +374,9 @@ MmWaveChannelRaytracing::CalSnr (
 		m_fingerprinting->SetCurrentPathIndex(traceIndex);
 	}
 	static uint16_t currentIndex = m_startDistance;
-	if(traceIndex > g_numPdps)
+	if(traceIndex >= m_trace->GetNumRecords ())
 	{
-		NS_FATAL_ERROR ("The maximum trace index is " << g_numPdps);
+		NS_FATAL_ERROR ("The maximum trace index is " << m_trace->GetNumRecords () - 1);
 	}
 
 	if(time > m_transitory_time_seconds && traceIndex != currentIndex)
@@ -497,20 +390,21 @@ MmWaveChannelRaytracing::CalSnr (
 	if (it == m_channelMatrixMap.end ())
 	{
 
+		Ptr<const RaytracingTraceRecord> record = m_trace->GetRecord (traceIndex);
 		complex2DVector_t txSpatialMatrix;
 		complex2DVector_t rxSpatialMatrix;
 		if(dl)
 		{
-			txSpatialMatrix = GenSpatialMatrix (traceIndex,txAntennaNum, true);
-			rxSpatialMatrix = GenSpatialMatrix (traceIndex,rxAntennaNum, false);
+			txSpatialMatrix = GenSpatialMatrix (record,txAntennaNum, true);
+			rxSpatialMatrix = GenSpatialMatrix (record,rxAntennaNum, false);
 		}
 		else
 		{
-			txSpatialMatrix = GenSpatialMatrix (traceIndex,txAntennaNum, false);
-			rxSpatialMatrix = GenSpatialMatrix (traceIndex,rxAntennaNum, true);
+			txSpatialMatrix = GenSpatialMatrix (record,txAntennaNum, false);
+			rxSpatialMatrix = GenSpatialMatrix (record,rxAntennaNum, true);
 		}
 		doubleVector_t dopplerShift;
-		for (unsigned int i = 0; i < g_path.at(traceIndex); i++)
+		for (unsigned int i = 0; i < record->m_numPaths; i++)
 		{
 			dopplerShift.push_back(m_uniformRv->GetValue (0,1));
 		}
@@ -519,8 +413,8 @@ MmWaveChannelRaytracing::CalSnr (
 
 		channel->m_txSpatialMatrix = txSpatialMatrix;
 		channel->m_rxSpatialMatrix = rxSpatialMatrix;
-		channel->m_powerFraction = g_pathloss.at (traceIndex);
-		channel->m_delaySpread = g_delay.at (traceIndex);
+		channel->m_powerFraction = record->m_pathloss;
+		channel->m_delaySpread = record->m_delay;
 		channel->m_doppler = dopplerShift;
 
 
@@ -530,8 +424,8 @@ MmWaveChannelRaytracing::CalSnr (
 		Ptr<TraceParams> reverseChannel = Create<TraceParams> ();
 		reverseChannel->m_txSpatialMatrix = rxSpatialMatrix;
 		reverseChannel->m_rxSpatialMatrix = txSpatialMatrix;
-		reverseChannel->m_powerFraction = g_pathloss.at (traceIndex);;
-		reverseChannel->m_delaySpread = g_delay.at (traceIndex);
+		reverseChannel->m_powerFraction = record->m_pathloss;
+		reverseChannel->m_delaySpread = record->m_delay;
 		reverseChannel->m_doppler = dopplerShift;
 
 		m_channelMatrixMap.insert(std::make_pair(reverseKey,reverseChannel));
@@ -601,7 +495,7 @@ MmWaveChannelRaytracing::CalSnr (
 
 	SpectrumValue Sinr = (*bfPsd)/(*noisePsd);
 
-//	double pathLossDb = g_pathloss.at (traceIndex);
+//	double pathLossDb = record->m_pathloss;
 //	Sinr * std::pow (10.0, (pathLossDb) / 10.0);
 
 	return Sinr;
@@ -715,9 +609,9 @@ MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue>
 	}
 
 	static uint16_t currentIndex = m_startDistance;
-	if(traceIndex > g_numPdps)
+	if(traceIndex >= m_trace->GetNumRecords ())
 	{
-		NS_FATAL_ERROR ("The maximum trace index is " << g_numPdps);
+		NS_FATAL_ERROR ("The maximum trace index is " << m_trace->GetNumRecords () - 1);
 	}
 	if(time > m_transitory_time_seconds && traceIndex != currentIndex)
 	{
@@ -729,20 +623,21 @@ MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue>
 	std::map< key_t, Ptr<TraceParams> >::iterator it = m_channelMatrixMap.find (key);
 	if (it == m_channelMatrixMap.end ())
 	{
+		Ptr<const RaytracingTraceRecord> record = m_trace->GetRecord (traceIndex);
 		complex2DVector_t txSpatialMatrix;
 		complex2DVector_t rxSpatialMatrix;
 		if(dl)
 		{
-			txSpatialMatrix = GenSpatialMatrix (traceIndex,txAntennaNum, true);
-			rxSpatialMatrix = GenSpatialMatrix (traceIndex,rxAntennaNum, false);
+			txSpatialMatrix = GenSpatialMatrix (record,txAntennaNum, true);
+			rxSpatialMatrix = GenSpatialMatrix (record,rxAntennaNum, false);
 		}
 		else
 		{
-			txSpatialMatrix = GenSpatialMatrix (traceIndex,txAntennaNum, false);
-			rxSpatialMatrix = GenSpatialMatrix (traceIndex,rxAntennaNum, true);
+			txSpatialMatrix = GenSpatialMatrix (record,txAntennaNum, false);
+			rxSpatialMatrix = GenSpatialMatrix (record,rxAntennaNum, true);
 		}
 		doubleVector_t dopplerShift;
-		for (unsigned int i = 0; i < g_path.at(traceIndex); i++)
+		for (unsigned int i = 0; i < record->m_numPaths; i++)
 		{
 			dopplerShift.push_back(m_uniformRv->GetValue (0,1));
 		}
@@ -751,8 +646,8 @@ MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue>
 
 		channel->m_txSpatialMatrix = txSpatialMatrix;
 		channel->m_rxSpatialMatrix = rxSpatialMatrix;
-		channel->m_powerFraction = g_pathloss.at (traceIndex);
-		channel->m_delaySpread = g_delay.at (traceIndex);
+		channel->m_powerFraction = record->m_pathloss;
+		channel->m_delaySpread = record->m_delay;
 		channel->m_doppler = dopplerShift;
 
 
@@ -762,8 +657,8 @@ MmWaveChannelRaytracing::DoCalcRxPowerSpectralDensity (Ptr<const SpectrumValue>
 		Ptr<TraceParams> reverseChannel = Create<TraceParams> ();
 		reverseChannel->m_txSpatialMatrix = rxSpatialMatrix;
 		reverseChannel->m_rxSpatialMatrix = txSpatialMatrix;
-		reverseChannel->m_powerFraction = g_pathloss.at (traceIndex);
-		reverseChannel->m_delaySpread = g_delay.at (traceIndex);
+		reverseChannel->m_powerFraction = record->m_pathloss;
+		reverseChannel->m_delaySpread = record->m_delay;
 		reverseChannel->m_doppler = dopplerShift;
 
 		m_channelMatrixMap.insert(std::make_pair(reverseKey,reverseChannel));
@@ -909,23 +804,23 @@ MmWaveChannelRaytracing::CalcBeamformingVector(complex2DVector_t spatialMatrix,
 
 
 complex2DVector_t
-MmWaveChannelRaytracing::GenSpatialMatrix (uint64_t traceIndex, uint8_t* antennaNum, bool bs) const
+MmWaveChannelRaytracing::GenSpatialMatrix (Ptr<const RaytracingTraceRecord> record, uint8_t* antennaNum, bool bs) const
 {
 	complex2DVector_t spatialMatrix;
-	uint16_t pathNum = g_path.at (traceIndex);
+	uint16_t pathNum = record->m_numPaths;
 	for(unsigned int pathIndex = 0; pathIndex < pathNum; pathIndex++)
 	{
 		double azimuthAngle;
 		double verticalAngle;
 		if(bs)
 		{
-			azimuthAngle = g_aodAzimuth.at (traceIndex).at (pathIndex);
-			verticalAngle = g_aodElevation.at (traceIndex).at (pathIndex);
+			azimuthAngle = record->m_aodAzimuth.at (pathIndex);
+			verticalAngle = record->m_aodElevation.at (pathIndex);
 		}
 		else
 		{
-			azimuthAngle = g_aoaAzimuth.at (traceIndex).at (pathIndex);
-			verticalAngle = g_aoaElevation.at (traceIndex).at (pathIndex);
+			azimuthAngle = record->m_aoaAzimuth.at (pathIndex);
+			verticalAngle = record->m_aoaElevation.at (pathIndex);
 		}
 		complexVector_t singlePath;
 		singlePath = GenSinglePathKron (azimuthAngle*M_PI/180, verticalAngle*M_PI/180, antennaNum);
@@ -1037,60 +932,47 @@ MmWaveChannelRaytracing::GetChannelGain (Ptr<const SpectrumValue> txPsd, Ptr<mmW
 		noSpeed = true;
 	}
 
-	Values::iterator vit = tempPsd->ValuesBegin ();
-	uint16_t iSubband = 0;
-	while (vit != tempPsd->ValuesEnd ())
+	if(pathNum > 0 && (bfParams->m_txW.empty ()||bfParams->m_rxW.empty ()))
 	{
-		std::complex<double> subsbandGain (0.0,0.0);
-		if ((*vit) != 0.00)
-		{
-			double fsb = m_phyMacConfig->GetCentreFrequency () - GetSystemBandwidth ()/2 + m_phyMacConfig->GetChunkWidth ()*iSubband ;
-			for (unsigned int pathIndex = 0; pathIndex < pathNum; pathIndex++)
-			{
-				//need to convert ns to s
-				double temp_delay = -1e-9*2*M_PI*fsb*bfParams->m_channelParams->m_delaySpread.at (pathIndex);
-				std::complex<double> delay (cos (temp_delay), sin (temp_delay));
-
-				std::complex<double> doppler;
-				if (noSpeed)
-				{
-					doppler = std::complex<double> (1,0);
-				}
-				else
-				{
-					double f_d = speed*m_phyMacConfig->GetCentreFrequency ()/3e8;
-					double temp_Doppler = 2*M_PI*t*f_d*bfParams->m_channelParams->m_doppler.at (pathIndex);
-					doppler = std::complex<double> (cos (temp_Doppler), sin (temp_Doppler));
-				}
-				double pathPowerLinear = std::pow (10.0, (bfParams->m_channelParams->m_powerFraction. at(pathIndex)) / 10.0);
+		NS_FATAL_ERROR("antenna weights are empty");
+	}
 
-				std::complex<double> smallScaleFading = sqrt(pathPowerLinear)*doppler*delay;
-				NS_LOG_INFO(doppler<<delay);
+	// The beamforming gain, Doppler and power of each path do not depend on the subband,
+	// so they are folded into one coefficient per path and the kernel applies the delays.
+	MmWaveSubbandGain &kernel = MmWaveSubbandGain::GetThreadKernel ();
+	kernel.Clear ();
+	kernel.Reserve (pathNum);
+	double f_d = speed*m_phyMacConfig->GetCentreFrequency ()/3e8;
+	for (unsigned int pathIndex = 0; pathIndex < pathNum; pathIndex++)
+	{
+		std::complex<double> doppler;
+		if (noSpeed)
+		{
+			doppler = std::complex<double> (1,0);
+		}
+		else
+		{
+			double temp_Doppler = 2*M_PI*t*f_d*bfParams->m_channelParams->m_doppler.at (pathIndex);
+			doppler = std::complex<double> (cos (temp_Doppler), sin (temp_Doppler));
+		}
+		double pathPowerLinear = std::pow (10.0, (bfParams->m_channelParams->m_powerFraction. at(pathIndex)) / 10.0);
 
-				if(bfParams->m_txW.empty ()||bfParams->m_rxW.empty ())
-				{
-					NS_FATAL_ERROR("antenna weights are empty");
-				}
-				else
-				{
-					/* beam forming*/
-					std::complex<double> txSum, rxSum;
-					for (unsigned i = 0; i < bfParams->m_txW.size (); i++)
-					{
-						txSum += std::conj(bfParams->m_channelParams->m_txSpatialMatrix.at (pathIndex).at (i))*bfParams->m_txW.at (i);
-					}
-					for (unsigned i = 0; i < bfParams->m_rxW.size (); i++)
-					{
-						rxSum += bfParams->m_channelParams->m_rxSpatialMatrix.at (pathIndex). at (i)*std::conj(bfParams->m_rxW.at (i));
-					}
-					subsbandGain = subsbandGain + txSum*rxSum*smallScaleFading;
-				}
-			}
-			*vit = (*vit)*(norm (subsbandGain));
+		/* beam forming*/
+		std::complex<double> txSum, rxSum;
+		for (unsigned i = 0; i < bfParams->m_txW.size (); i++)
+		{
+			txSum += std::conj(bfParams->m_channelParams->m_txSpatialMatrix.at (pathIndex).at (i))*bfParams->m_txW.at (i);
+		}
+		for (unsigned i = 0; i < bfParams->m_rxW.size (); i++)
+		{
+			rxSum += bfParams->m_channelParams->m_rxSpatialMatrix.at (pathIndex). at (i)*std::conj(bfParams->m_rxW.at (i));
 		}
-		vit++;
-		iSubband++;
+		//need to convert ns to s
+		kernel.AddCluster (txSum*rxSum*sqrt(pathPowerLinear)*doppler,
+				1e-9*bfParams->m_channelParams->m_delaySpread.at (pathIndex));
 	}
+	double firstFrequency = m_phyMacConfig->GetCentreFrequency () - GetSystemBandwidth ()/2;
+	kernel.Apply (firstFrequency, m_phyMacConfig->GetChunkWidth (), *tempPsd);
 	return tempPsd;
 }
 
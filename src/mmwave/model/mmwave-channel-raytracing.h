@@ -38,6 +38,7 @@
 #include <ns3/net-device-container.h>
 #include <ns3/random-variable-stream.h>
 #include "mmwave-phy-mac-common.h"
+#include "mmwave-raytracing-trace.h"
 #include <ns3/mmwave-beam-management.h>
 
 
@@ -82,6 +83,8 @@ public:
 	void DoDispose ();
 	void SetTraceFilePath (std::string file_path);
 	void SetTraceIndex (uint16_t index);
+	void SetTracePrefetchWindow (uint32_t window);
+	uint32_t GetTracePrefetchWindow () const;
 	void LoadTraces();
 	void LoadTracesMod ();
 	void ConnectDevices (Ptr<NetDevice> dev1, Ptr<NetDevice> dev2);
@@ -118,13 +121,14 @@ private:
 														Ptr<const MobilityModel> a,
 														Ptr<const MobilityModel> b) const;
 
-	complex2DVector_t GenSpatialMatrix (uint64_t traceIndex, uint8_t* antennaNum, bool bs) const;
+	complex2DVector_t GenSpatialMatrix (Ptr<const RaytracingTraceRecord> record, uint8_t* antennaNum, bool bs) const;
 	complexVector_t GenSinglePath (double hAngle, double vAngle, uint8_t* antennaNum) const;
 	complexVector_t GenSinglePathKron (double hAngle, double vAngle, uint8_t* antennaNum) const;
 	complexVector_t KroneckerProductVector(complexVector_t a_h, complexVector_t a_v) const;
 	complexVector_t CalcBeamformingVector (complex2DVector_t SpatialMatrix, doubleVector_t powerFraction) const;
 	Ptr<SpectrumValue> GetChannelGain (Ptr<const SpectrumValue> txPsd, Ptr<mmWaveBeamFormingTraces> bfParams, double speed) const;
 	double GetSystemBandwidth () const;
+	void OpenTrace (std::string filename);
 
 	mutable std::map< key_t, int > m_connectedPair;
 	mutable std::map< key_t, Ptr<TraceParams> > m_channelMatrixMap;
@@ -135,6 +139,8 @@ private:
 	double m_speed;
 	std::string m_traceFileName;
 	uint16_t m_traceIndex;
+	Ptr<MmWaveRaytracingTraceReader> m_trace; // window of this channel on the trace shared by the channels that use the same file.
+	uint32_t m_tracePrefetchWindow;
 	Ptr<FingerprintingDatabase> m_fingerprinting;
 	double m_transitory_time_seconds;//Initial time in seconds the UT will not move so TCP traffic reaches the stationary rate
 };
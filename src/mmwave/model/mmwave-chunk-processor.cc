@@ -57,7 +57,6 @@ void
 mmWaveChunkProcessor::Start ()
 {
   NS_LOG_FUNCTION (this);
-  m_sumValues = 0;
   m_totDuration = MicroSeconds (0);
 }
 
@@ -66,11 +65,13 @@ void
 mmWaveChunkProcessor::EvaluateChunk (const SpectrumValue& sinr, Time duration)
 {
   NS_LOG_FUNCTION (this << sinr << duration);
-  if (m_sumValues == 0)
+  if (m_totDuration.IsZero ())
     {
-      m_sumValues = Create<SpectrumValue> (sinr.GetSpectrumModel ());
+      // first chunk since Start, the buffer is allocated by the first reception only
+      m_sumValues.Reserve (sinr.GetSpectrumModel ());
+      m_sumValues.SetZero ();
     }
-  (*m_sumValues) += sinr * duration.GetSeconds ();
+  m_sumValues.AddScaled (sinr, duration.GetSeconds ());
   m_totDuration += duration;
 }
 
@@ -80,10 +81,11 @@ mmWaveChunkProcessor::End ()
   NS_LOG_FUNCTION (this);
   if (m_totDuration.GetSeconds () > 0)
     {
+      m_average.AssignDivided (m_sumValues.Get (), m_totDuration.GetSeconds ());
       std::vector<mmWaveChunkProcessorCallback>::iterator it;
       for (it = m_mmWaveChunkProcessorCallbacks.begin (); it != m_mmWaveChunkProcessorCallbacks.end (); it++)
         {
-          (*it)((*m_sumValues) / m_totDuration.GetSeconds ());
+          (*it)(m_average.Get ());
         }
     }
   else
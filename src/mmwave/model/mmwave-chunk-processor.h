@@ -33,6 +33,7 @@
 #include <ns3/ptr.h>
 #include <ns3/nstime.h>
 #include <ns3/object.h>
+#include <ns3/mmwave-psd-buffer.h>
 
 namespace ns3 {
 
@@ -55,7 +56,8 @@ public:
   virtual void End ();
 
 private:
-  Ptr<SpectrumValue> m_sumValues;
+  MmWavePsdBuffer m_sumValues;
+  MmWavePsdBuffer m_average;
   Time m_totDuration;
 
   std::vector<mmWaveChunkProcessorCallback> m_mmWaveChunkProcessorCallbacks;
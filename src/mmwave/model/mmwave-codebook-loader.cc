@@ -0,0 +1,230 @@
+/*
+ * mmwave-codebook-loader.cc
+ *
+ *  Process-wide loader of the beamforming codebooks, shared by all the devices.
+ */
+
+#include "mmwave-codebook-loader.h"
+#include <ns3/log.h>
+#include <ns3/fatal-error.h>
+#include <fstream>
+#include <map>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveCodebookLoader");
+
+const char MmWaveCodebookLoader::MAGIC[8] = {'M','M','W','C','B','K','0','1'};
+
+static const size_t HEADER_SIZE = sizeof (MmWaveCodebookLoader::MAGIC) + 2*sizeof (uint32_t);
+static const size_t MAGIC_SIZE = 6; // the MAGIC string ends with the 2 digits of the version of the format
+
+/*
+ * @brief Codebooks loaded so far, indexed by path
+ */
+static std::map<std::string, Ptr<const MmWaveCodebook> > &
+GetCodebookCache ()
+{
+	static std::map<std::string, Ptr<const MmWaveCodebook> > cache;
+	return cache;
+}
+
+/*
+ * @brief Parse a complex value between begin and end, see MmWaveCodebookLoader::ParseComplex
+ */
+static std::complex<double>
+ParseComplexToken (const char *begin, const char *end)
+{
+	const char *imagUnit = (const char *) memchr (begin, 'i', end - begin);
+	if (imagUnit == 0)
+	{
+		return std::complex<double> (strtod (begin, 0), 0.0);
+	}
+	bool hasReal = false;
+	for (const char *c = begin + 1; c < imagUnit; c++)
+	{
+		// a sign that is not part of an exponent separates the real and the imaginary parts
+		if ((*c == '+' || *c == '-') && *(c - 1) != 'e' && *(c - 1) != 'E')
+		{
+			hasReal = true;
+			break;
+		}
+	}
+	char *next = 0;
+	double re = 0.0;
+	if (hasReal)
+	{
+		re = strtod (begin, &next);
+		begin = next;
+	}
+	double im = strtod (begin, 0);
+	return std::complex<double> (re, im);
+}
+
+Ptr<const MmWaveCodebook>
+MmWaveCodebookLoader::Load (std::string path)
+{
+	std::map<std::string, Ptr<const MmWaveCodebook> > &cache = GetCodebookCache ();
+	std::map<std::string, Ptr<const MmWaveCodebook> >::iterator it = cache.find (path);
+	if (it != cache.end ())
+	{
+		return it->second;
+	}
+	NS_LOG_INFO ("Loading codebook file " << path);
+	Ptr<MmWaveCodebook> codebook = Create<MmWaveCodebook> ();
+	if (IsBinaryFile (path))
+	{
+		codebook->m_codewords = ReadBinaryFile (path);
+	}
+	else
+	{
+		codebook->m_codewords = ParseTextFile (path);
+	}
+	cache[path] = codebook;
+	return codebook;
+}
+
+void
+MmWaveCodebookLoader::Clear ()
+{
+	GetCodebookCache ().clear ();
+}
+
+complex2DVector_t
+MmWaveCodebookLoader::ParseTextFile (std::string path)
+{
+	NS_LOG_FUNCTION (path);
+	std::ifstream singlefile (path.c_str (), std::ifstream::in);
+	if (!singlefile.good ())
+	{
+		NS_FATAL_ERROR (path << " file not found");
+	}
+
+	complex2DVector_t output;
+	std::string line;
+	while (std::getline (singlefile, line))
+	{
+		complexVector_t row;
+		const char *c = line.c_str ();
+		const char *lineEnd = c + line.size ();
+		while (c < lineEnd)
+		{
+			const char *tokenEnd = (const char *) memchr (c, ',', lineEnd - c);
+			if (tokenEnd == 0)
+			{
+				tokenEnd = lineEnd;
+			}
+			row.push_back (ParseComplexToken (c, tokenEnd));
+			c = tokenEnd + 1;
+		}
+		output.push_back (row);
+	}
+	return output;
+}
+
+complex2DVector_t
+MmWaveCodebookLoader::ReadBinaryFile (std::string path)
+{
+	NS_LOG_FUNCTION (path);
+	std::ifstream in (path.c_str (), std::ifstream::binary);
+	if (!in.good ())
+	{
+		NS_FATAL_ERROR (path << " file not found");
+	}
+	in.seekg (0, std::ifstream::end);
+	size_t size = in.tellg ();
+	in.seekg (0, std::ifstream::beg);
+	if (size < HEADER_SIZE)
+	{
+		NS_FATAL_ERROR (path << " is not a valid binary codebook");
+	}
+
+	char magic[sizeof (MAGIC)];
+	uint32_t numCodewords;
+	uint32_t numElements;
+	in.read (magic, sizeof (magic));
+	in.read ((char *) &numCodewords, sizeof (uint32_t));
+	in.read ((char *) &numElements, sizeof (uint32_t));
+	if (memcmp (magic, MAGIC, MAGIC_SIZE) != 0)
+	{
+		NS_FATAL_ERROR (path << " is not a binary codebook");
+	}
+	if (memcmp (magic + MAGIC_SIZE, MAGIC + MAGIC_SIZE, sizeof (MAGIC) - MAGIC_SIZE) != 0)
+	{
+		NS_FATAL_ERROR (path << " is a binary codebook of version " << std::string (magic + MAGIC_SIZE, sizeof (MAGIC) - MAGIC_SIZE)
+		                << ", version " << std::string (MAGIC + MAGIC_SIZE, sizeof (MAGIC) - MAGIC_SIZE) << " expected");
+	}
+	size_t payload = (size_t) numCodewords*numElements*2*sizeof (double);
+	if (size != HEADER_SIZE + payload)
+	{
+		NS_FATAL_ERROR (path << " has " << size << " bytes, " << HEADER_SIZE + payload << " expected");
+	}
+
+	// std::complex<double> is laid out as (real, imaginary): the codewords are read in place
+	complex2DVector_t output (numCodewords, complexVector_t (numElements));
+	for (uint32_t i = 0; i < numCodewords && numElements > 0; i++)
+	{
+		in.read ((char *) &output[i][0], numElements*2*sizeof (double));
+	}
+	if (!in.good ())
+	{
+		NS_FATAL_ERROR ("Unable to read " << path);
+	}
+	return output;
+}
+
+void
+MmWaveCodebookLoader::WriteBinaryFile (const complex2DVector_t &codebook, std::string path)
+{
+	NS_LOG_FUNCTION (path);
+	uint32_t numCodewords = codebook.size ();
+	uint32_t numElements = numCodewords ? codebook[0].size () : 0;
+	std::ofstream out (path.c_str (), std::ofstream::binary | std::ofstream::trunc);
+	if (!out.good ())
+	{
+		NS_FATAL_ERROR ("Unable to open " << path);
+	}
+	out.write (MAGIC, sizeof (MAGIC));
+	out.write ((const char *) &numCodewords, sizeof (uint32_t));
+	out.write ((const char *) &numElements, sizeof (uint32_t));
+	for (uint32_t i = 0; i < numCodewords; i++)
+	{
+		if (codebook[i].size () != numElements)
+		{
+			NS_FATAL_ERROR ("Codeword " << i << " has " << codebook[i].size () << " elements, " << numElements << " expected");
+		}
+		for (uint32_t j = 0; j < numElements; j++)
+		{
+			double value[2] = {codebook[i][j].real (), codebook[i][j].imag ()};
+			out.write ((const char *) value, sizeof (value));
+		}
+	}
+	if (!out.good ())
+	{
+		NS_FATAL_ERROR ("Unable to write " << path);
+	}
+}
+
+bool
+MmWaveCodebookLoader::IsBinaryFile (std::string path)
+{
+	std::ifstream in (path.c_str (), std::ifstream::binary);
+	if (!in.good ())
+	{
+		NS_FATAL_ERROR (path << " file not found");
+	}
+	char header[sizeof (MAGIC)];
+	in.read (header, sizeof (header));
+	return in.gcount () == (std::streamsize) sizeof (header) && memcmp (header, MAGIC, MAGIC_SIZE) == 0;
+}
+
+std::complex<double>
+MmWaveCodebookLoader::ParseComplex (std::string strCmplx)
+{
+	return ParseComplexToken (strCmplx.c_str (), strCmplx.c_str () + strCmplx.size ());
+}
+
+} // namespace ns3
@@ -0,0 +1,94 @@
+/*
+ * mmwave-codebook-loader.h
+ *
+ *  Process-wide loader of the beamforming codebooks, shared by all the devices.
+ */
+
+#ifndef MMWAVE_CODEBOOK_LOADER_H_
+#define MMWAVE_CODEBOOK_LOADER_H_
+
+#include <ns3/simple-ref-count.h>
+#include <ns3/ptr.h>
+#include <complex>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+typedef std::vector< std::complex<double> > complexVector_t;
+typedef std::vector<complexVector_t> complex2DVector_t;
+
+/**
+ * Immutable codebook: one beamforming vector (codeword) per row
+ */
+struct MmWaveCodebook : public SimpleRefCount<MmWaveCodebook>
+{
+	complex2DVector_t m_codewords;
+};
+
+/**
+ * \brief Loads the codebooks used for beam sweeping. Each file is read only once per process and the
+ * same MmWaveCodebook object is returned to all the devices that use that path.
+ *
+ * Two file formats are accepted and told apart by their content:
+ *  - text: one codeword per line, comma separated complex values such as 0.25-0.1i (the BeamFormingMatrix files);
+ *  - binary: the MAGIC string, the number of codewords and the number of elements per codeword as uint32_t,
+ *    followed by the (real, imaginary) doubles of every element, codeword after codeword, in host byte order.
+ *    Binary files are read straight into the codewords instead of parsed. They are created with WriteBinaryFile or with
+ *    the mmwave-codebook-converter program.
+ */
+class MmWaveCodebookLoader
+{
+public:
+	/**
+	 * Returns the codebook stored in a file, reading it only the first time the path is requested
+	 * @params the path of a text or binary codebook file
+	 * @returns the shared codebook
+	 */
+	static Ptr<const MmWaveCodebook> Load (std::string path);
+
+	/**
+	 * Drops all the codebooks loaded so far, the devices keep their references
+	 */
+	static void Clear ();
+
+	/**
+	 * Parse a text file with one row of comma separated complex values per line
+	 * @params the path of the file
+	 * @returns the rows of the file
+	 */
+	static complex2DVector_t ParseTextFile (std::string path);
+
+	/**
+	 * Read a binary codebook file
+	 * @params the path of the file
+	 * @returns the codewords of the file
+	 */
+	static complex2DVector_t ReadBinaryFile (std::string path);
+
+	/**
+	 * Write a codebook in the binary format, all the codewords must have the same length
+	 * @params the codebook
+	 * @params the path of the output file
+	 */
+	static void WriteBinaryFile (const complex2DVector_t &codebook, std::string path);
+
+	/**
+	 * @params the path of a codebook file
+	 * @returns true if the file starts with the MAGIC string of the binary format, of any version
+	 */
+	static bool IsBinaryFile (std::string path);
+
+	/**
+	 * Parse a complex value written as a+bi, a, or bi
+	 * @params the string to parse
+	 * @returns the complex value
+	 */
+	static std::complex<double> ParseComplex (std::string strCmplx);
+
+	static const char MAGIC[8]; // first bytes of a binary codebook file, MMWCBK and the 2 digits of the version.
+};
+
+} // namespace ns3
+
+#endif /* MMWAVE_CODEBOOK_LOADER_H_ */
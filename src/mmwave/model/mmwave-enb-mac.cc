@@ -207,7 +207,7 @@ class MmWaveMacMemberMacSchedSapUser : public MmWaveMacSchedSapUser
 {
 public:
 	MmWaveMacMemberMacSchedSapUser (MmWaveEnbMac* mac);
-	virtual void SchedConfigInd (const struct SchedConfigIndParameters& params);
+	virtual void SchedConfigInd (struct SchedConfigIndParameters& params);
 private:
 	MmWaveEnbMac* m_mac;
 };
@@ -219,7 +219,7 @@ MmWaveMacMemberMacSchedSapUser::MmWaveMacMemberMacSchedSapUser (MmWaveEnbMac* ma
 }
 
 void
-MmWaveMacMemberMacSchedSapUser::SchedConfigInd (const struct SchedConfigIndParameters& params)
+MmWaveMacMemberMacSchedSapUser::SchedConfigInd (struct SchedConfigIndParameters& params)
 {
 	m_mac->DoSchedConfigIndication (params);
 }
@@ -519,25 +519,19 @@ MmWaveEnbMac::DoSubframeIndication (SfnSf sfnSf)
 		  dlSchedSubframeNum = dlSchedSubframeNum + m_phyMacConfig->GetL1L2CtrlLatency();
 		}
 
-		MmWaveMacSchedSapProvider::SchedTriggerReqParameters params;
+		// the parameters are reused every subframe, so that their lists keep their memory
+		MmWaveMacSchedSapProvider::SchedTriggerReqParameters &params = m_schedTriggerReq;
 		SfnSf schedSfn (dlSchedframeNum, dlSchedSubframeNum, 0);
 		params.m_snfSf = schedSfn;
 
-		// Forward DL HARQ feebacks collected during last subframe TTI
-		if (m_dlHarqInfoReceived.size () > 0)
-		{
-			params.m_dlHarqInfoList = m_dlHarqInfoReceived;
-			// empty local buffer
-			m_dlHarqInfoReceived.clear ();
-		}
+		// Forward DL HARQ feebacks collected during last subframe TTI, and
+		// empty local buffer by swapping it with the list forwarded in the previous subframe
+		params.m_dlHarqInfoList.swap (m_dlHarqInfoReceived);
+		m_dlHarqInfoReceived.clear ();
 
 		// Forward UL HARQ feebacks collected during last TTI
-		if (m_ulHarqInfoReceived.size () > 0)
-		{
-			params.m_ulHarqInfoList = m_ulHarqInfoReceived;
-			// empty local buffer
-			m_ulHarqInfoReceived.clear ();
-		}
+		params.m_ulHarqInfoList.swap (m_ulHarqInfoReceived);
+		m_ulHarqInfoReceived.clear ();
 
 		params.m_ueList = m_associatedUe;
 		m_macSchedSapProvider->SchedTriggerReq (params);
@@ -801,11 +795,8 @@ MmWaveEnbMac::DoTransmitPdu (LteMacSapProvider::TransmitPduParameters params)
 }
 
 void
-MmWaveEnbMac::DoSchedConfigIndication (MmWaveMacSchedSapUser::SchedConfigIndParameters ind)
+MmWaveEnbMac::DoSchedConfigIndication (MmWaveMacSchedSapUser::SchedConfigIndParameters &ind)
 {
-	m_phySapProvider->SetDlSfAllocInfo (ind.m_sfAllocInfo);
-	//m_phySapProvider->SetUlSfAllocInfo (ind.m_ulSfAllocInfo);
-
 	for (unsigned islot = 0; islot < ind.m_sfAllocInfo.m_slotAllocInfo.size (); islot++)
 	{
 		SlotAllocInfo &slotAllocInfo = ind.m_sfAllocInfo.m_slotAllocInfo[islot];
@@ -916,6 +907,10 @@ MmWaveEnbMac::DoSchedConfigIndication (MmWaveMacSchedSapUser::SchedConfigIndPara
 			}
 		}
 	}
+
+	// the PHY takes the allocation and gives back the one of the previous frame to the scheduler
+	m_phySapProvider->SetDlSfAllocInfo (ind.m_sfAllocInfo);
+	//m_phySapProvider->SetUlSfAllocInfo (ind.m_ulSfAllocInfo);
 }
 
 uint8_t MmWaveEnbMac::AllocateTbUid (void)
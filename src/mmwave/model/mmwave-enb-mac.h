@@ -130,7 +130,7 @@ public:
 
 	void DoReceiveControlMessage  (Ptr<MmWaveControlMessage> msg);
 
-	void DoSchedConfigIndication (MmWaveMacSchedSapUser::SchedConfigIndParameters ind);
+	void DoSchedConfigIndication (MmWaveMacSchedSapUser::SchedConfigIndParameters &ind);
 
 	MmWaveEnbPhySapUser* GetPhySapUser ();
 	void SetPhySapProvider (MmWavePhySapProvider* ptr);
@@ -222,6 +222,7 @@ private:
 
 	std::vector <DlHarqInfo> m_dlHarqInfoReceived; // DL HARQ feedback received
 	std::vector <UlHarqInfo> m_ulHarqInfoReceived; // UL HARQ feedback received
+	MmWaveMacSchedSapProvider::SchedTriggerReqParameters m_schedTriggerReq; // reused every subframe
 	std::map <uint16_t, MmWaveDlHarqProcessesBuffer_t> m_miDlHarqProcessesPackets; // Packet under trasmission of the DL HARQ process
 	
 	/**
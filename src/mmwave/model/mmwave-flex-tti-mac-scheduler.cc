@@ -32,11 +32,14 @@
 #include "mmwave-flex-tti-mac-scheduler.h"
 #include <ns3/lte-common.h>
 #include <ns3/boolean.h>
+#include <ns3/trace-source-accessor.h>
 #include <stdlib.h>     /* abs */
 #include "mmwave-mac-pdu-header.h"
 #include "mmwave-mac-pdu-tag.h"
 #include "mmwave-spectrum-value-helper.h"
+#include <ns3/simulator.h>
 #include <cmath>
+#include <algorithm>
 
 namespace ns3 {
 
@@ -169,11 +172,13 @@ const unsigned MmWaveFlexTtiMacScheduler::m_rlcHdrSize = 3;
 const double MmWaveFlexTtiMacScheduler::m_berDl = 0.001;
 
 MmWaveFlexTtiMacScheduler::MmWaveFlexTtiMacScheduler ()
-: m_nextRnti (0),
+: m_startUe (0),
+  m_nextRnti (0),
   m_subframeNo (0),
   m_tbUid (0),
   m_macSchedSapUser (0),
-	m_macCschedSapUser (0)
+	m_macCschedSapUser (0),
+	m_reportBufferGrowth (false)
 {
 	NS_LOG_FUNCTION (this);
 	m_macSchedSapProvider = new MmWaveFlexTtiMacSchedSapProvider (this);
@@ -189,15 +194,17 @@ void
 MmWaveFlexTtiMacScheduler::DoDispose (void)
 {
 	NS_LOG_FUNCTION (this);
-	m_wbCqiRxed.clear();
-  m_dlHarqProcessesDciInfoMap.clear ();
-  m_dlHarqProcessesTimer.clear ();
-  m_dlHarqProcessesRlcPduMap.clear ();
+	m_ueTable.clear ();
+	m_createdUes.clear ();
+	m_activeUes.clear ();
   m_dlHarqInfoList.clear ();
-  m_ulHarqCurrentProcessId.clear ();
-  m_ulHarqProcessesStatus.clear ();
-  m_ulHarqProcessesTimer.clear ();
-  m_ulHarqProcessesDciInfoMap.clear ();
+	m_rlcPduPool.clear ();
+	m_csiDevices.clear ();
+	if (m_reportBufferGrowth)
+	{
+		NS_LOG_INFO ("Scheduling decisions of " << m_allocReport.m_numSubframes << " subframes, "
+		             << m_allocReport.m_numAllocSubframes << " grew the buffers by " << m_allocReport.m_allocBytes << " bytes");
+	}
   delete m_macCschedSapProvider;
   delete m_macSchedSapProvider;
 }
@@ -205,9 +212,17 @@ MmWaveFlexTtiMacScheduler::DoDispose (void)
 TypeId
 MmWaveFlexTtiMacScheduler::GetTypeId (void)
 {
-	static TypeId tid = TypeId ("ns3::MmWaveFlexTtiMacScheduler")
+	static TypeId tid = AddFlexTtiAttributes (TypeId ("ns3::MmWaveFlexTtiMacScheduler")
 	    .SetParent<MmWaveMacScheduler> ()
-		.AddConstructor<MmWaveFlexTtiMacScheduler> ()
+		.AddConstructor<MmWaveFlexTtiMacScheduler> ());
+
+	return tid;
+}
+
+TypeId
+MmWaveFlexTtiMacScheduler::AddFlexTtiAttributes (TypeId tid)
+{
+	return tid
     .AddAttribute ("CqiTimerThreshold",
                    "The number of TTIs a CQI is valid (default 1000 - 1 sec.)",
                    UintegerValue (100),
@@ -258,9 +273,17 @@ MmWaveFlexTtiMacScheduler::GetTypeId (void)
 								 UintegerValue (6),
 								 MakeUintegerAccessor (&MmWaveFlexTtiMacScheduler::m_symPerSlot),
 								 MakeUintegerChecker<uint8_t> ())
+	.AddAttribute ("ReportBufferGrowth",
+								 "Measure the capacity of the buffers of the scheduling decision before and after every subframe, "
+								 "for the SchedAllocation trace and GetAllocationReport (walks all the buffers, for testing)",
+								 BooleanValue (false),
+								 MakeBooleanAccessor (&MmWaveFlexTtiMacScheduler::m_reportBufferGrowth),
+								 MakeBooleanChecker ())
+	.AddTraceSource ("SchedAllocation",
+									 "Bytes the buffers of the scheduling decision of a subframe grew by, 0 in steady state; only fired with ReportBufferGrowth",
+									 MakeTraceSourceAccessor (&MmWaveFlexTtiMacScheduler::m_allocTrace),
+									 "ns3::MmWaveFlexTtiMacScheduler::AllocationTracedCallback")
 		;
-
-	return tid;
 }
 
 void
@@ -304,6 +327,7 @@ MmWaveFlexTtiMacScheduler::ConfigureCommonParameters (Ptr<MmWavePhyMacCommon> co
 	{
 		m_ulSfAllocInfo.push_back (SfAllocInfo (SfnSf (0, i, 0)));
 	}
+	m_ulSinr = SpectrumValue (MmWaveSpectrumValueHelper::GetSpectrumModel (m_phyMacConfig));
 }
 
 void
@@ -312,30 +336,34 @@ MmWaveFlexTtiMacScheduler::DoSchedDlRlcBufferReq (const struct MmWaveMacSchedSap
   NS_LOG_FUNCTION (this << params.m_rnti << (uint32_t) params.m_logicalChannelIdentity);
   // API generated by RLC for updating RLC parameters on a LC (tx and retx queues)
   std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator it = m_rlcBufferReq.begin ();
-  bool newLc = true;
-  while (it != m_rlcBufferReq.end ())
+  while (it != m_rlcBufferReq.end ()
+         && ((*it).m_rnti != params.m_rnti || (*it).m_logicalChannelIdentity != params.m_logicalChannelIdentity))
     {
-      // remove old entries of this UE-LC
-      if (((*it).m_rnti == params.m_rnti)&&((*it).m_logicalChannelIdentity == params.m_logicalChannelIdentity))
-        {
-          it = m_rlcBufferReq.erase (it);
-          newLc = false;
-        }
-      else
-        {
-          ++it;
-        }
+      ++it;
+    }
+  bool newLc = (it == m_rlcBufferReq.end ());
+  if (newLc)
+    {
+      // add the new parameters
+      m_rlcBufferReq.push_back (params);
+    }
+  else
+    {
+      // move the old entry of this UE-LC to the end and update it, without reallocating its node
+      m_rlcBufferReq.splice (m_rlcBufferReq.end (), m_rlcBufferReq, it);
+      m_rlcBufferReq.back () = params;
     }
-  // add the new parameters
-  m_rlcBufferReq.insert (it, params);
   NS_LOG_INFO ("BSR for RNTI " << params.m_rnti << " LC " << (uint16_t)params.m_logicalChannelIdentity << " RLC tx size " << params.m_rlcTransmissionQueueSize << " RLC retx size " << params.m_rlcRetransmissionQueueSize << " RLC stat size " <<  params.m_rlcStatusPduSize);
   // initialize statistics of the flow in case of new flows
-  if (newLc == true)
+  UeState &ue = GetUeState (params.m_rnti);
+  if (newLc == true && !ue.m_dlCqiValid)
   {
-  	m_wbCqiRxed.insert ( std::pair<uint16_t, uint8_t > (params.m_rnti, 1)); // only codeword 0 at this stage (SISO)
+  	ue.m_dlCqiValid = true;
+  	ue.m_dlCqi = 1; // only codeword 0 at this stage (SISO)
   	// initialized to 1 (i.e., the lowest value for transmitting a signal)
-  	m_wbCqiTimers.insert ( std::pair<uint16_t, uint32_t > (params.m_rnti, m_cqiTimersThreshold));
+  	ue.m_dlCqiTimer = m_cqiTimersThreshold;
   }
+  NotifyDlRlcBuffer (params);
 }
 
 void
@@ -343,31 +371,16 @@ MmWaveFlexTtiMacScheduler::DoSchedDlCqiInfoReq (const struct MmWaveMacSchedSapPr
 {
   NS_LOG_FUNCTION (this);
 
-  std::map <uint16_t,uint8_t>::iterator it;
   for (unsigned int i = 0; i < params.m_cqiList.size (); i++)
     {
       if ( params.m_cqiList.at (i).m_cqiType == DlCqiInfo::WB )
         {
-          // wideband CQI reporting
-          std::map <uint16_t,uint8_t>::iterator it;
-          uint16_t rnti = params.m_cqiList.at (i).m_rnti;
-          it = m_wbCqiRxed.find (rnti);
-          if (it == m_wbCqiRxed.end ())
-            {
-              // create the new entry
-              m_wbCqiRxed.insert ( std::pair<uint16_t, uint8_t > (rnti, params.m_cqiList.at (i).m_wbCqi) ); // only codeword 0 at this stage (SISO)
-              // generate correspondent timer
-              m_wbCqiTimers.insert ( std::pair<uint16_t, uint32_t > (rnti, m_cqiTimersThreshold));
-            }
-          else
-            {
-              // update the CQI value
-              (*it).second = params.m_cqiList.at (i).m_wbCqi;
-              // update correspondent timer
-              std::map <uint16_t,uint32_t>::iterator itTimers;
-              itTimers = m_wbCqiTimers.find (rnti);
-              (*itTimers).second = m_cqiTimersThreshold;
-            }
+          // wideband CQI reporting, create the entry or update the value
+          UeState &ue = GetUeState (params.m_cqiList.at (i).m_rnti);
+          ue.m_dlCqiValid = true;
+          ue.m_dlCqi = params.m_cqiList.at (i).m_wbCqi; // only codeword 0 at this stage (SISO)
+          // refresh correspondent timer
+          ue.m_dlCqiTimer = m_cqiTimersThreshold;
         }
       else if ( params.m_cqiList.at (i).m_cqiType == DlCqiInfo::SB )
         {
@@ -395,63 +408,42 @@ MmWaveFlexTtiMacScheduler::DoSchedUlCqiInfoReq (const struct MmWaveMacSchedSapPr
 	{
 		case UlCqiInfo::PUSCH:
 		{
-			std::map <uint32_t, struct AllocMapElem>::iterator itMap;
-			std::map <uint16_t, struct UlCqiMapElem>::iterator itCqi;
-			itMap = m_ulAllocationMap.find (params.m_sfnSf.Encode ());
-			if (itMap == m_ulAllocationMap.end ())
+			uint32_t sfn = params.m_sfnSf.Encode ();
+			unsigned iAlloc = 0;
+			while (iAlloc < m_ulAllocations.size () && m_ulAllocations[iAlloc].m_sfn != sfn)
+			{
+				iAlloc++;
+			}
+			if (iAlloc == m_ulAllocations.size ())
 			{
-				NS_LOG_INFO (this << " Does not find info on allocation, size : " << m_ulAllocationMap.size ());
+				NS_LOG_INFO (this << " Does not find info on allocation, size : " << m_ulAllocations.size ());
 				return;
 			}
-			NS_ASSERT_MSG (itMap->second.m_rntiPerChunk.size () == m_phyMacConfig->GetTotalNumChunk (), "SINR chunk map must cover full BW in TDMA mode");
-			for (unsigned i = 0; i < itMap->second.m_rntiPerChunk.size (); i++)
+			const AllocMapElem &alloc = m_ulAllocations[iAlloc];
+			for (unsigned i = 0; i < m_phyMacConfig->GetTotalNumChunk (); i++)
 			{
 				// convert from fixed point notation Sxxxxxxxxxxx.xxx to double
 				//double sinr = LteFfConverter::fpS11dot3toDouble (params.m_ulCqi.m_sinr.at (i));
-				itCqi = m_ueUlCqi.find (itMap->second.m_rntiPerChunk.at (i));
-				if (itCqi == m_ueUlCqi.end ())
-				{
-					// create a new entry
-					std::vector <double> newCqi;
-					for (unsigned j = 0; j < m_phyMacConfig->GetTotalNumChunk (); j++)
-					{
-						unsigned chunkInd = i;
-						if (chunkInd == j)
-						{
-							newCqi.push_back (params.m_ulCqi.m_sinr.at (i));
-							NS_LOG_INFO ("UL CQI report for RNTI " << itMap->second.m_rntiPerChunk.at (i) << " chunk " << i << " SINR " << params.m_ulCqi.m_sinr.at (i) << \
-							             " frame " << frameNum << " subframe " << subframeNum << " startSym " << startSymIdx);
-						}
-						else
-						{
-							// initialize with NO_SINR value.
-							newCqi.push_back (30.0);
-						}
-					}
-					m_ueUlCqi.insert (std::pair <uint16_t, struct UlCqiMapElem> (itMap->second.m_rntiPerChunk.at (i),
-					                                                             UlCqiMapElem (newCqi, itMap->second.m_numSym, itMap->second.m_tbSize)) );
-					// generate correspondent timer
-					m_ueCqiTimers.insert (std::pair <uint16_t, uint32_t > (itMap->second.m_rntiPerChunk.at (i), m_cqiTimersThreshold));
-				}
-				else
+				UeState &ue = GetUeState (alloc.m_rnti);
+				if (!ue.m_ulCqiValid)
 				{
-					// update the value
-					(*itCqi).second.m_ueUlCqi.at (i) = params.m_ulCqi.m_sinr.at (i);
-					(*itCqi).second.m_numSym = itMap->second.m_numSym;
-					(*itCqi).second.m_tbSize = itMap->second.m_tbSize;
-					// update correspondent timer
-					std::map <uint16_t, uint32_t>::iterator itTimers;
-					itTimers = m_ueCqiTimers.find (itMap->second.m_rntiPerChunk.at (i));
-					(*itTimers).second = m_cqiTimersThreshold;
-
-					NS_LOG_INFO ("UL CQI report for RNTI " << itMap->second.m_rntiPerChunk.at (i) << " chunk " << i << " SINR " << params.m_ulCqi.m_sinr.at (i) << \
-					             " frame " << frameNum << " subframe " << subframeNum << " startSym " << startSymIdx);
-
+					// create a new entry, initialized with NO_SINR value
+					ue.m_ulCqiValid = true;
+					ue.m_ulCqi.assign (m_phyMacConfig->GetTotalNumChunk (), 30.0);
 				}
-
+				// update the value
+				ue.m_ulCqi.at (i) = params.m_ulCqi.m_sinr.at (i);
+				ue.m_ulCqiNumSym = alloc.m_numSym;
+				ue.m_ulCqiTbSize = alloc.m_tbSize;
+				// update correspondent timer
+				ue.m_ulCqiTimer = m_cqiTimersThreshold;
+
+				NS_LOG_INFO ("UL CQI report for RNTI " << alloc.m_rnti << " chunk " << i << " SINR " << params.m_ulCqi.m_sinr.at (i) << \
+				             " frame " << frameNum << " subframe " << subframeNum << " startSym " << startSymIdx);
 			}
 			// remove obsolete info on allocation
-			m_ulAllocationMap.erase (itMap);
+			m_ulAllocations[iAlloc] = m_ulAllocations.back ();
+			m_ulAllocations.pop_back ();
 		}
 		break;
 		default:
@@ -466,48 +458,48 @@ MmWaveFlexTtiMacScheduler::RefreshHarqProcesses ()
 {
 	NS_LOG_FUNCTION (this);
 
-	std::map <uint16_t, DlHarqProcessesTimer_t>::iterator itTimers;
-	for (itTimers = m_dlHarqProcessesTimer.begin (); itTimers != m_dlHarqProcessesTimer.end (); itTimers++)
+	for (unsigned i = 0; i < m_createdUes.size (); i++)
 	{
+		uint16_t rnti = m_createdUes[i];
+		UeState &ue = m_ueTable[rnti];
+		if (!ue.m_harqValid)
+		{
+			continue;
+		}
 		for (uint16_t i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
 		{
-			if ((*itTimers).second.at (i) == m_phyMacConfig->GetHarqTimeout ())
+			if (ue.m_dlHarqTimer.at (i) == m_phyMacConfig->GetHarqTimeout ())
 			{ // reset HARQ process
-				NS_LOG_INFO (this << " Reset HARQ proc " << i << " for RNTI " << (*itTimers).first);
-				std::map <uint16_t, DlHarqProcessesStatus_t>::iterator itStat = m_dlHarqProcessesStatus.find ((*itTimers).first);
-				if (itStat == m_dlHarqProcessesStatus.end ())
-				{
-					NS_FATAL_ERROR ("No Process Id Status found for this RNTI " << (*itTimers).first);
-				}
-				(*itStat).second.at (i) = 0;
-				(*itTimers).second.at (i) = 0;
+				NS_LOG_INFO (this << " Reset HARQ proc " << i << " for RNTI " << rnti);
+				ue.m_dlHarqStatus.at (i) = 0;
+				ue.m_dlHarqTimer.at (i) = 0;
 			}
 			else
 			{
-				(*itTimers).second.at (i)++;
+				ue.m_dlHarqTimer.at (i)++;
 			}
 		}
 	}
 
-	std::map <uint16_t, UlHarqProcessesTimer_t>::iterator itTimers2;
-	for (itTimers2 = m_ulHarqProcessesTimer.begin (); itTimers2 != m_ulHarqProcessesTimer.end (); itTimers2++)
+	for (unsigned i = 0; i < m_createdUes.size (); i++)
 	{
+		uint16_t rnti = m_createdUes[i];
+		UeState &ue = m_ueTable[rnti];
+		if (!ue.m_harqValid)
+		{
+			continue;
+		}
 		for (uint16_t i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
 		{
-			if ((*itTimers2).second.at (i) == m_phyMacConfig->GetHarqTimeout ())
+			if (ue.m_ulHarqTimer.at (i) == m_phyMacConfig->GetHarqTimeout ())
 			{ // reset HARQ process
-				NS_LOG_INFO (this << " Reset HARQ proc " << i << " for RNTI " << (*itTimers2).first);
-				std::map <uint16_t, UlHarqProcessesStatus_t>::iterator itStat = m_ulHarqProcessesStatus.find ((*itTimers2).first);
-				if (itStat == m_ulHarqProcessesStatus.end ())
-				{
-					NS_FATAL_ERROR ("No Process Id Status found for this RNTI " << (*itTimers2).first);
-				}
-				(*itStat).second.at (i) = 0;
-				(*itTimers2).second.at (i) = 0;
+				NS_LOG_INFO (this << " Reset HARQ proc " << i << " for RNTI " << rnti);
+				ue.m_ulHarqStatus.at (i) = 0;
+				ue.m_ulHarqTimer.at (i) = 0;
 			}
 			else
 			{
-				(*itTimers2).second.at (i)++;
+				ue.m_ulHarqTimer.at (i)++;
 			}
 		}
 	}
@@ -532,8 +524,8 @@ MmWaveFlexTtiMacScheduler::UpdateDlHarqProcessId (uint16_t rnti)
 //	{
 //		NS_FATAL_ERROR ("No Process Id found for this RNTI " << rnti);
 //	}
-	std::map <uint16_t, DlHarqProcessesStatus_t>::iterator itStat = m_dlHarqProcessesStatus.find (rnti);
-	if (itStat == m_dlHarqProcessesStatus.end ())
+	UeState *ue = FindUeState (rnti);
+	if (ue == 0 || !ue->m_harqValid)
 	{
 		NS_FATAL_ERROR ("No Process Id Statusfound for this RNTI " << rnti);
 	}
@@ -542,9 +534,9 @@ MmWaveFlexTtiMacScheduler::UpdateDlHarqProcessId (uint16_t rnti)
 	uint8_t harqId = m_phyMacConfig->GetNumHarqProcess ();
 	for (unsigned i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
 	{
-		if(itStat->second[i] == 0)
+		if(ue->m_dlHarqStatus[i] == 0)
 		{
-			itStat->second[i] = 1;
+			ue->m_dlHarqStatus[i] = 1;
 			harqId = i;
 			break;
 		}
@@ -587,8 +579,8 @@ MmWaveFlexTtiMacScheduler::UpdateUlHarqProcessId (uint16_t rnti)
 //	{
 //		NS_FATAL_ERROR ("No Process Id found for this RNTI " << rnti);
 //	}
-	std::map <uint16_t, UlHarqProcessesStatus_t>::iterator itStat = m_ulHarqProcessesStatus.find (rnti);
-	if (itStat == m_ulHarqProcessesStatus.end ())
+	UeState *ue = FindUeState (rnti);
+	if (ue == 0 || !ue->m_harqValid)
 	{
 		NS_FATAL_ERROR ("No Process Id Statusfound for this RNTI " << rnti);
 	}
@@ -597,9 +589,9 @@ MmWaveFlexTtiMacScheduler::UpdateUlHarqProcessId (uint16_t rnti)
 	uint8_t harqId = m_phyMacConfig->GetNumHarqProcess ();
 	for (unsigned i = 0; i < m_phyMacConfig->GetNumHarqProcess (); i++)
 	{
-		if(itStat->second[i] == 0)
+		if(ue->m_ulHarqStatus[i] == 0)
 		{
-			itStat->second[i] = 1;
+			ue->m_ulHarqStatus[i] = 1;
 			harqId = i;
 			break;
 		}
@@ -658,9 +650,26 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 	uint8_t	sfNum = params.m_snfSf.m_sfNum;
 	//uint8_t slotNum = params.m_snfSf.m_slotNum;
 
-	MmWaveMacSchedSapUser::SchedConfigIndParameters ret;
+	uint64_t bufferCapacity = m_reportBufferGrowth ? GetBufferCapacity () : 0;
+
+	// the decision is written in the buffer that the PHY gave back, which is reset
+	// keeping the memory of its slots and of their RLC PDU lists
+	MmWaveMacSchedSapUser::SchedConfigIndParameters &ret = m_schedConfigInd;
+	std::vector <SlotAllocInfo> &slots = ret.m_sfAllocInfo.m_slotAllocInfo;
+	for (unsigned islot = 0; islot < slots.size (); islot++)
+	{
+		if (slots[islot].m_rlcPduInfo.capacity () > 0)
+		{
+			m_rlcPduPool.push_back (std::vector <RlcPduInfo> ());
+			m_rlcPduPool.back ().swap (slots[islot].m_rlcPduInfo);
+			m_rlcPduPool.back ().clear ();
+		}
+	}
+	slots.clear ();
 	ret.m_sfnSf = params.m_snfSf;
 	ret.m_sfAllocInfo.m_sfnSf = ret.m_sfnSf;
+	ret.m_sfAllocInfo.m_numSymAlloc = 0;
+	ret.m_sfAllocInfo.m_ulSymStart = 0;
 	SfnSf ulSfn = ret.m_sfnSf;
 	if (ret.m_sfnSf.m_sfNum + m_phyMacConfig->GetUlSchedDelay () >=  m_phyMacConfig->GetSubframesPerFrame ())
 	{
@@ -681,8 +690,8 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 		// Add resources for periodic CSI-RS if it is the right time (subframe) to do so
 		// Equivalent symbols occupied with CSI-RS
 		Time margin = MilliSeconds(1.0);
-		std::map <Ptr<NetDevice>,BeamTrackingParams> uesToAllocate = m_beamManager->GetDevicesMapToExpireTimer(margin);
-		if (!uesToAllocate.empty() && m_phyMacConfig->GetPeriodicCsiResourceAllocationCondition() == true)
+		m_beamManager->GetDevicesToExpireTimer (margin, m_csiDevices);
+		if (!m_csiDevices.empty() && m_phyMacConfig->GetPeriodicCsiResourceAllocationCondition() == true)
 		{
 			//FIXME: simplification. The scheduler should allocate the necessary RBs, not all the RBs in a symbol (time).
 	//		numSym += uesToAllocate.size() * 20; // Assume five symbol per UE, independently of the number of resources used.
@@ -690,8 +699,9 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 			uint16_t num_csi_resources = m_beamManager->GetCurrentNumBeamPairCandidates();
 			numSym += ceil((float)num_csi_resources*1*22.92/275); //
 			// Ask manager to update the last reporting timer (increase by the reporting period)
-			m_beamManager->IncreaseBeamReportingTimers(uesToAllocate);
+			m_beamManager->IncreaseBeamReportingTimers(m_csiDevices);
 		}
+		m_csiDevices.clear ();
 	}
 
 
@@ -700,7 +710,7 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 
 	dlCtrlSlot.m_dci.m_numSym = numSym; //4;
 	dlCtrlSlot.m_dci.m_symStart = 0;
-	ret.m_sfAllocInfo.m_slotAllocInfo.push_back (dlCtrlSlot);
+	slots.push_back (dlCtrlSlot);
 //	int resvCtrl = m_phyMacConfig->GetDlCtrlSymbols() + m_phyMacConfig->GetUlCtrlSymbols();
 	int resvCtrl = numSym + m_phyMacConfig->GetUlCtrlSymbols();
 	int symAvail = m_phyMacConfig->GetSymbolsPerSubframe() - resvCtrl;
@@ -719,27 +729,18 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 	// number of DL/UL flows for new transmissions (not HARQ RETX)
 	int nFlowsDl = 0;
 	int nFlowsUl = 0;
-	std::map <uint16_t, struct UeSchedInfo> ueInfo;
-	std::map <uint16_t, struct UeSchedInfo>::iterator itUeInfo;
 	std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator itRlcBuf;
 
-	// retrieve past HARQ retx buffered
-	if (m_dlHarqInfoList.size () > 0 && params.m_dlHarqInfoList.size () > 0)
-	{
-		m_dlHarqInfoList.insert (m_dlHarqInfoList.end (), params.m_dlHarqInfoList.begin (), params.m_dlHarqInfoList.end ());
-	}
-	else if (params.m_dlHarqInfoList.size () > 0)
-	{
-		m_dlHarqInfoList = params.m_dlHarqInfoList;
-	}
-	if (m_ulHarqInfoList.size () > 0 && params.m_ulHarqInfoList.size () > 0)
+	// deactivate the UEs of the previous subframe
+	for (unsigned i = 0; i < m_activeUes.size (); i++)
 	{
-		m_ulHarqInfoList.insert (m_ulHarqInfoList.end (), params.m_ulHarqInfoList.begin (), params.m_ulHarqInfoList.end ());
-	}
-	else if (params.m_ulHarqInfoList.size () > 0)
-	{
-		m_ulHarqInfoList = params.m_ulHarqInfoList;
+		m_ueTable[m_activeUes[i]].m_active = false;
 	}
+	m_activeUes.clear ();
+
+	// retrieve past HARQ retx buffered, and append the new feedback
+	m_dlHarqInfoList.insert (m_dlHarqInfoList.end (), params.m_dlHarqInfoList.begin (), params.m_dlHarqInfoList.end ());
+	m_ulHarqInfoList.insert (m_ulHarqInfoList.end (), params.m_ulHarqInfoList.begin (), params.m_ulHarqInfoList.end ());
 
 	if (m_harqOn == false)		// Ignore HARQ feedback
 	{
@@ -748,8 +749,8 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 	else
 	{
 		// Process DL HARQ feedback and assign slots for RETX if resources available
-		std::vector <struct DlHarqInfo> dlInfoListUntxed;  // TBs not able to be retransmitted in this sf
-		std::vector <struct UlHarqInfo> ulInfoListUntxed;
+		m_dlHarqInfoUntxed.clear ();  // TBs not able to be retransmitted in this sf
+		m_ulHarqInfoUntxed.clear ();
 
 		for (unsigned i = 0; i < m_dlHarqInfoList.size (); i++)
 		{
@@ -759,47 +760,30 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 			}
 			uint8_t harqId = m_dlHarqInfoList.at (i).m_harqProcessId;
 			uint16_t rnti = m_dlHarqInfoList.at (i).m_rnti;
-			itUeInfo = ueInfo.find (rnti);
-			std::map <uint16_t, UlHarqProcessesStatus_t>::iterator itStat = m_dlHarqProcessesStatus.find (rnti);
-			if (itStat == m_dlHarqProcessesStatus.end ())
+			UeState *ue = FindUeState (rnti);
+			if (ue == 0 || !ue->m_harqValid)
 			{
 				NS_FATAL_ERROR ("No HARQ status info found for UE " << rnti);
 			}
-			std::map <uint16_t, DlHarqRlcPduList_t>::iterator itRlcPdu =  m_dlHarqProcessesRlcPduMap.find (rnti);
-			if (itRlcPdu == m_dlHarqProcessesRlcPduMap.end ())
-			{
-				NS_FATAL_ERROR ("Unable to find RlcPdcList in HARQ buffer for RNTI " << m_dlHarqInfoList.at (i).m_rnti);
-			}
-			if(m_dlHarqInfoList.at (i).m_harqStatus == DlHarqInfo::ACK || itStat->second.at (harqId) == 0)
+			if(m_dlHarqInfoList.at (i).m_harqStatus == DlHarqInfo::ACK || ue->m_dlHarqStatus.at (harqId) == 0)
 			{ // acknowledgment or process timeout, reset process
 				//NS_LOG_DEBUG ("UE" << rnti << " DL harqId " << (unsigned)harqId << " HARQ-ACK received");
-				itStat->second.at (harqId) = 0;    // release process ID
-				for (uint16_t k = 0; k < itRlcPdu->second.size (); k++)		// clear RLC buffers
-				{
-					itRlcPdu->second.at (harqId).clear ();
-				}
+				ue->m_dlHarqStatus.at (harqId) = 0;    // release process ID
+				ue->m_dlHarqRlcPdu.at (harqId).clear ();		// clear RLC buffers
 				continue;
 			}
 			else if(m_dlHarqInfoList.at (i).m_harqStatus == DlHarqInfo::NACK)
 			{
-				std::map <uint16_t, DlHarqProcessesDciInfoList_t>::iterator itHarq = m_dlHarqProcessesDciInfoMap.find (rnti);
-				if (itHarq == m_dlHarqProcessesDciInfoMap.end ())
-				{
-					NS_FATAL_ERROR ("No DCI/HARQ buffer entry found for UE " << rnti);
-				}
-				DciInfoElementTdma dciInfoReTx = itHarq->second.at (harqId);
+				DciInfoElementTdma dciInfoReTx = ue->m_dlHarqDci.at (harqId);
 				//NS_LOG_DEBUG ("UE" << rnti << " DL harqId " << (unsigned)harqId << " HARQ-NACK received, rv " << (unsigned)dciInfoReTx.m_rv);
 				NS_ASSERT (harqId == dciInfoReTx.m_harqProcess);
 				//NS_ASSERT(itStat->second.at (harqId) > 0);
-				NS_ASSERT(itStat->second.at (harqId)-1 == dciInfoReTx.m_rv);
+				NS_ASSERT(ue->m_dlHarqStatus.at (harqId)-1 == dciInfoReTx.m_rv);
 				if (dciInfoReTx.m_rv == 3) // maximum number of retx reached -> drop process
 				{
 					NS_LOG_INFO ("Max number of retransmissions reached -> drop process");
-					itStat->second.at (harqId) = 0;
-					for (uint16_t k = 0; k < (*itRlcPdu).second.size (); k++)
-					{
-						itRlcPdu->second.at (harqId).clear ();
-					}
+					ue->m_dlHarqStatus.at (harqId) = 0;
+					ue->m_dlHarqRlcPdu.at (harqId).clear ();
 					continue;
 				}
 
@@ -857,7 +841,7 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 				}
 				if (numSymReq <= (m_phyMacConfig->GetSymbolsPerSubframe () - resvCtrl))
 				{	// not enough symbols to encode TB at required MCS, attempt in later SF
-					dlInfoListUntxed.push_back (m_dlHarqInfoList.at (i));
+					m_dlHarqInfoUntxed.push_back (m_dlHarqInfoList.at (i));
 					continue;
 				}*/
 
@@ -870,40 +854,28 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 					NS_ASSERT (symIdx <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
 					dciInfoReTx.m_rv++;
 					dciInfoReTx.m_ndi = 0;
-					itHarq->second.at (harqId) = dciInfoReTx;
-					itStat->second.at (harqId) = itStat->second.at (harqId) + 1;
-					SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::DL, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, itUeInfo->first);
+					ue->m_dlHarqDci.at (harqId) = dciInfoReTx;
+					ue->m_dlHarqStatus.at (harqId) = ue->m_dlHarqStatus.at (harqId) + 1;
+					SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::DL, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, rnti);
 					slotInfo.m_dci = dciInfoReTx;
 					NS_LOG_DEBUG ("UE" << dciInfoReTx.m_rnti << " gets DL slots " << (unsigned)dciInfoReTx.m_symStart << "-" << (unsigned)(dciInfoReTx.m_symStart+dciInfoReTx.m_numSym-1) <<
 							             " tbs " << dciInfoReTx.m_tbSize << " harqId " << (unsigned)dciInfoReTx.m_harqProcess << " harqId " << (unsigned)dciInfoReTx.m_harqProcess <<
 							             " rv " << (unsigned)dciInfoReTx.m_rv << " in frame " << ret.m_sfnSf.m_frameNum << " subframe " << (unsigned)ret.m_sfnSf.m_sfNum << " RETX");
-					std::map <uint16_t, DlHarqRlcPduList_t>::iterator itRlcList =  m_dlHarqProcessesRlcPduMap.find (rnti);
-					if (itRlcList == m_dlHarqProcessesRlcPduMap.end ())
-					{
-						NS_FATAL_ERROR ("Unable to find RlcPdcList in HARQ buffer for RNTI " << rnti);
-					}
-					for (uint16_t k = 0; k < (*itRlcList).second.at(dciInfoReTx.m_harqProcess).size (); k++)
-					{
-						slotInfo.m_rlcPduInfo.push_back ((*itRlcList).second.at (dciInfoReTx.m_harqProcess).at (k));
-					}
-					ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
+					TakePooledRlcPduList (slotInfo);
+					slotInfo.m_rlcPduInfo = ue->m_dlHarqRlcPdu.at (dciInfoReTx.m_harqProcess);
+					slots.push_back (std::move (slotInfo));
 					ret.m_sfAllocInfo.m_numSymAlloc += dciInfoReTx.m_numSym;
-					if (itUeInfo == ueInfo.end())
-					{
-						itUeInfo = ueInfo.insert (std::pair<uint16_t, struct UeSchedInfo> (rnti, UeSchedInfo () )).first;
-					}
-					itUeInfo->second.m_dlSymbolsRetx = dciInfoReTx.m_numSym;
+					ActivateUe (rnti).m_dlSymbolsRetx = dciInfoReTx.m_numSym;
 				}
 				else
 				{
 					NS_LOG_INFO ("No resource for this retx -> buffer it");
-					dlInfoListUntxed.push_back (m_dlHarqInfoList.at (i));
+					m_dlHarqInfoUntxed.push_back (m_dlHarqInfoList.at (i));
 				}
 			}
 		}
 
-		m_dlHarqInfoList.clear ();
-		m_dlHarqInfoList = dlInfoListUntxed;
+		m_dlHarqInfoList.swap (m_dlHarqInfoUntxed);
 
 		// Process UL HARQ feedback
 		for (uint16_t i = 0; i < m_ulHarqInfoList.size (); i++)
@@ -912,40 +884,32 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 			{
 				break;	// no symbols left to allocate
 			}
-			UlHarqInfo harqInfo = m_ulHarqInfoList.at (i);
+			const UlHarqInfo &harqInfo = m_ulHarqInfoList.at (i);
 			uint8_t harqId = harqInfo.m_harqProcessId;
 			uint16_t rnti = harqInfo.m_rnti;
-			itUeInfo = ueInfo.find (rnti);
-			std::map <uint16_t, UlHarqProcessesStatus_t>::iterator itStat = m_ulHarqProcessesStatus.find (rnti);
-			if (itStat == m_ulHarqProcessesStatus.end ())
+			UeState *ue = FindUeState (rnti);
+			if (ue == 0 || !ue->m_harqValid)
 			{
 				NS_LOG_ERROR ("No info found in HARQ buffer for UE (might have changed eNB) " << rnti);
+				continue;
 			}
-			if (harqInfo.m_receptionStatus == UlHarqInfo::Ok || itStat->second.at (harqId) == 0)
+			if (harqInfo.m_receptionStatus == UlHarqInfo::Ok || ue->m_ulHarqStatus.at (harqId) == 0)
 			{
 				//NS_LOG_DEBUG ("UE" << rnti << " UL harqId " << (unsigned)harqInfo.m_harqProcessId << " HARQ-ACK received");
-				if (itStat != m_ulHarqProcessesStatus.end ())
-				{
-					itStat->second.at (harqId) = 0;  // release process ID
-				}
+				ue->m_ulHarqStatus.at (harqId) = 0;  // release process ID
 			}
 			else if (harqInfo.m_receptionStatus == UlHarqInfo::NotOk)
 			{
-				std::map <uint16_t, UlHarqProcessesDciInfoList_t>::iterator itHarq = m_ulHarqProcessesDciInfoMap.find (rnti);
-				if (itHarq == m_ulHarqProcessesDciInfoMap.end ())
-				{
-					NS_LOG_ERROR ("No info found in UL-HARQ buffer for UE (might have changed eNB) " << rnti);
-				}
 				// retx correspondent block: retrieve the UL-DCI
-				DciInfoElementTdma dciInfoReTx = itHarq->second.at (harqId);
+				DciInfoElementTdma dciInfoReTx = ue->m_ulHarqDci.at (harqId);
 				//NS_LOG_DEBUG ("UE" << rnti << " UL harqId " << (unsigned)harqInfo.m_harqProcessId << " HARQ-NACK received, rv " << (unsigned)dciInfoReTx.m_rv);
 				NS_ASSERT (harqId == dciInfoReTx.m_harqProcess);
-				NS_ASSERT(itStat->second.at (harqId) > 0);
-				NS_ASSERT(itStat->second.at (harqId)-1 == dciInfoReTx.m_rv);
+				NS_ASSERT(ue->m_ulHarqStatus.at (harqId) > 0);
+				NS_ASSERT(ue->m_ulHarqStatus.at (harqId)-1 == dciInfoReTx.m_rv);
 				if (dciInfoReTx.m_rv == 3)
 				{
 					NS_LOG_INFO ("Max number of retransmissions reached (UL)-> drop process");
-					itStat->second.at (harqId) = 0;
+					ue->m_ulHarqStatus.at (harqId) = 0;
 					continue;
 				}
 
@@ -957,30 +921,25 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 					NS_ASSERT (symIdx <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
 					dciInfoReTx.m_rv++;
 					dciInfoReTx.m_ndi = 0;
-					itStat->second.at (harqId) = itStat->second.at (harqId) + 1;
-					itHarq->second.at (harqId) = dciInfoReTx;
+					ue->m_ulHarqStatus.at (harqId) = ue->m_ulHarqStatus.at (harqId) + 1;
+					ue->m_ulHarqDci.at (harqId) = dciInfoReTx;
 					SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::UL, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, rnti);
 					slotInfo.m_dci = dciInfoReTx;
 					NS_LOG_DEBUG ("UE" << dciInfoReTx.m_rnti << " gets UL slots " << (unsigned)dciInfoReTx.m_symStart << "-" << (unsigned)(dciInfoReTx.m_symStart+dciInfoReTx.m_numSym-1) <<
 											 " tbs " << dciInfoReTx.m_tbSize << " harqId " << (unsigned)dciInfoReTx.m_harqProcess << " rv " << (unsigned)dciInfoReTx.m_rv << " in frame " << ulSfn.m_frameNum << " subframe " << (unsigned)ulSfn.m_sfNum <<
 											 " RETX");
-					ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
+					slots.push_back (std::move (slotInfo));
 					ret.m_sfAllocInfo.m_numSymAlloc += dciInfoReTx.m_numSym;
-					if (itUeInfo == ueInfo.end())
-					{
-						itUeInfo = ueInfo.insert (std::pair<uint16_t, struct UeSchedInfo> (rnti, UeSchedInfo () )).first;
-					}
-					itUeInfo->second.m_ulSymbolsRetx = dciInfoReTx.m_numSym;
+					ActivateUe (rnti).m_ulSymbolsRetx = dciInfoReTx.m_numSym;
 				}
 				else
 				{
-					ulInfoListUntxed.push_back (m_ulHarqInfoList.at (i));
+					m_ulHarqInfoUntxed.push_back (m_ulHarqInfoList.at (i));
 				}
 			}
 		}
 
-		m_ulHarqInfoList.clear ();
-		m_ulHarqInfoList = ulInfoListUntxed;
+		m_ulHarqInfoList.swap (m_ulHarqInfoUntxed);
 	}
 
 	// ********************* END OF HARQ SECTION, START OF NEW DATA SCHEDULING ********************* //
@@ -990,22 +949,17 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 	{
 		for (itRlcBuf = m_rlcBufferReq.begin (); itRlcBuf != m_rlcBufferReq.end (); itRlcBuf++)
 		{
-			itUeInfo = ueInfo.find (itRlcBuf->m_rnti);
-			//		if (itUeInfo != ueInfo.end () && itUeInfo->second.m_dlSymbols > 0)
-			//		{
-			//			continue;
-			//		}
+			UeState &ue = GetUeState (itRlcBuf->m_rnti);
 
 			if ( (((*itRlcBuf).m_rlcTransmissionQueueSize > 0)
 					|| ((*itRlcBuf).m_rlcRetransmissionQueueSize > 0)
 					|| ((*itRlcBuf).m_rlcStatusPduSize > 0)) )
 			{
 				NS_LOG_INFO (this << " User " << itRlcBuf->m_rnti << " LC " << (uint16_t)itRlcBuf->m_logicalChannelIdentity << " is active, status  " << (*itRlcBuf).m_rlcStatusPduSize << " retx " << (*itRlcBuf).m_rlcRetransmissionQueueSize << " tx " << (*itRlcBuf).m_rlcTransmissionQueueSize);
-				std::map <uint16_t,uint8_t>::iterator itCqi = m_wbCqiRxed.find (itRlcBuf->m_rnti);
 				uint8_t cqi = 0;
-				if (itCqi != m_wbCqiRxed.end ())
+				if (ue.m_dlCqiValid)
 				{
-					cqi = itCqi->second;
+					cqi = ue.m_dlCqi;
 				}
 				else // no CQI available
 				{
@@ -1014,23 +968,26 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 				}
 				if (cqi != 0 || m_fixedMcsDl) 	// CQI == 0 means "out of range" (see table 7.2.3-1 of 36.213)
 				{
-					if (itUeInfo == ueInfo.end ())
+					if (!ue.m_active)
 					{
 						nFlowsDl++;  // for simplicity, all RLC LCs are considered as a single flow
-						itUeInfo = ueInfo.insert (std::pair<uint16_t, struct UeSchedInfo> (itRlcBuf->m_rnti, UeSchedInfo () )).first;
+						ActivateUe (itRlcBuf->m_rnti);
 					}
-					else if (itUeInfo->second.m_maxDlBufSize == 0)
+					else if (ue.m_sched.m_maxDlBufSize == 0)
 					{
 						nFlowsDl++;
 					}
+					UeSchedInfo &ueSchedInfo = ue.m_sched;
+					ueSchedInfo.m_dlHolDelay = std::max<double> (ueSchedInfo.m_dlHolDelay,
+							std::max (itRlcBuf->m_rlcTransmissionQueueHolDelay, itRlcBuf->m_rlcRetransmissionHolDelay));
 
 					if (m_fixedMcsDl)
 					{
-						itUeInfo->second.m_dlMcs = m_mcsDefaultDl;
+						ueSchedInfo.m_dlMcs = m_mcsDefaultDl;
 					}
 					else
 					{
-						itUeInfo->second.m_dlMcs = m_amc->GetMcsFromCqi (cqi);  // get MCS
+						ueSchedInfo.m_dlMcs = m_amc->GetMcsFromCqi (cqi);  // get MCS
 					}
 
 					// temporarily store the TX queue size
@@ -1039,8 +996,8 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 						RlcPduInfo newRlcStatusPdu;
 						newRlcStatusPdu.m_lcid = itRlcBuf->m_logicalChannelIdentity;
 						newRlcStatusPdu.m_size += itRlcBuf->m_rlcStatusPduSize + m_subHdrSize;
-						itUeInfo->second.m_rlcPduInfo.push_back (newRlcStatusPdu);
-						itUeInfo->second.m_maxDlBufSize += newRlcStatusPdu.m_size;  // add to total DL buffer size
+						ueSchedInfo.m_rlcPduInfo.push_back (newRlcStatusPdu);
+						ueSchedInfo.m_maxDlBufSize += newRlcStatusPdu.m_size;  // add to total DL buffer size
 					}
 
 					RlcPduInfo newRlcEl;
@@ -1061,8 +1018,8 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 							newRlcEl.m_size = 8;
 						}
 						newRlcEl.m_size += m_rlcHdrSize + m_subHdrSize + 10;
-						itUeInfo->second.m_rlcPduInfo.push_back (newRlcEl);
-						itUeInfo->second.m_maxDlBufSize += newRlcEl.m_size;  // add to total DL buffer size
+						ueSchedInfo.m_rlcPduInfo.push_back (newRlcEl);
+						ueSchedInfo.m_maxDlBufSize += newRlcEl.m_size;  // add to total DL buffer size
 					}
 				}
 				else
@@ -1076,37 +1033,36 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 	// get info on active UL flows
 	if (symAvail > 0 && !m_dlOnly)  // remaining symbols in future UL subframe after HARQ retx sched
 	{
-		std::map <uint16_t,uint32_t>::iterator ceBsrIt;
-		for (ceBsrIt = m_ceBsrRxed.begin (); ceBsrIt != m_ceBsrRxed.end (); ceBsrIt++)
+		for (unsigned i = 0; i < m_createdUes.size (); i++)
 		{
-			if (ceBsrIt->second > 0)  // UL buffer size > 0
+			uint16_t rnti = m_createdUes[i];
+			UeState &ue = m_ueTable[rnti];
+			if (ue.m_bsrValid && ue.m_bsr > 0)  // UL buffer size > 0
 			{
-				std::map <uint16_t, struct UlCqiMapElem>::iterator itCqi = m_ueUlCqi.find (ceBsrIt->first);
 				int cqi = 0;
 				int mcs = 0;
-				if (itCqi == m_ueUlCqi.end ()) // no cqi info for this UE
+				if (!ue.m_ulCqiValid) // no cqi info for this UE
 				{
-					NS_LOG_INFO (this << " UE " << ceBsrIt->first << " does not have UL-CQI");
+					NS_LOG_INFO (this << " UE " << rnti << " does not have UL-CQI");
 					cqi = 1;
 					mcs = 0;
 				}
 				else
 				{
 					cqi = 0;
-					SpectrumValue specVals (MmWaveSpectrumValueHelper::GetSpectrumModel (m_phyMacConfig));
-					Values::iterator specIt = specVals.ValuesBegin();
+					Values::iterator specIt = m_ulSinr.ValuesBegin();
 					for (unsigned ichunk = 0; ichunk < m_phyMacConfig->GetTotalNumChunk (); ichunk++)
 					{
 						//double sinrLin = std::pow (10, itCqi->second.m_ueUlCqi.at (ichunk) / 10);
 //						double se1 = log2 ( 1 + (std::pow (10, sinrLin / 10 )  /
 //								( (-std::log (5.0 * m_berDl )) / 1.5) ));
 //						cqi += m_amc->GetCqiFromSpectralEfficiency (se1);
-						NS_ASSERT (specIt != specVals.ValuesEnd());
-						*specIt = itCqi->second.m_ueUlCqi.at (ichunk); //sinrLin;
+						NS_ASSERT (specIt != m_ulSinr.ValuesEnd());
+						*specIt = ue.m_ulCqi.at (ichunk); //sinrLin;
 						specIt++;
 					}
 
-					cqi = m_amc->CreateCqiFeedbackWbTdma (specVals, itCqi->second.m_numSym, itCqi->second.m_tbSize, mcs);
+					cqi = m_amc->CreateCqiFeedbackWbTdma (m_ulSinr, ue.m_ulCqiNumSym, ue.m_ulCqiTbSize, mcs);
 //					for (unsigned i = 0; i < chunkCqi.size(); i++)
 //					{
 //						cqi += chunkCqi[i];
@@ -1132,242 +1088,103 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 					//				cqi = m_amc->GetCqiFromSpectralEfficiency (se);
 					if (cqi == 0 && !m_fixedMcsUl) // out of range (SINR too low)
 					{
-						NS_LOG_INFO ("*** RNTI " << ceBsrIt->first << " UL-CQI out of range, skipping allocation in UL");
+						NS_LOG_INFO ("*** RNTI " << rnti << " UL-CQI out of range, skipping allocation in UL");
 						break;  // do not allocate UE in uplink
 					}
 				}
-				itUeInfo = ueInfo.find (ceBsrIt->first);
-				if (itUeInfo == ueInfo.end ())
+				if (!ue.m_active)
 				{
-					itUeInfo = ueInfo.insert (std::pair<uint16_t, struct UeSchedInfo> (ceBsrIt->first, UeSchedInfo () )).first;
+					ActivateUe (rnti);
 					nFlowsUl++;
 				}
-				else if (itUeInfo->second.m_maxUlBufSize == 0)
+				else if (ue.m_sched.m_maxUlBufSize == 0)
 				{
 					nFlowsUl++;
 				}
+				UeSchedInfo &ueSchedInfo = ue.m_sched;
+				ueSchedInfo.m_ulHolDelay = (Simulator::Now () - ue.m_bsrTime).GetSeconds () * 1000;
 				if (m_fixedMcsUl)
 				{
-					itUeInfo->second.m_ulMcs = m_mcsDefaultUl;
+					ueSchedInfo.m_ulMcs = m_mcsDefaultUl;
 				}
 				else
 				{
-					itUeInfo->second.m_ulMcs = mcs;//m_amc->GetMcsFromCqi (cqi);  // get MCS
+					ueSchedInfo.m_ulMcs = mcs;//m_amc->GetMcsFromCqi (cqi);  // get MCS
 				}
-				itUeInfo->second.m_maxUlBufSize = ceBsrIt->second + m_rlcHdrSize + m_macHdrSize + 8;
+				ueSchedInfo.m_maxUlBufSize = ue.m_bsr + m_rlcHdrSize + m_macHdrSize + 8;
 			}
 		}
 	}
 
 	int nFlowsTot = nFlowsDl + nFlowsUl;
-	if (ueInfo.size () == 0)
+	if (m_activeUes.empty ())
 	{
 		SlotAllocInfo ulCtrlSlot (0xFF, SlotAllocInfo::UL, SlotAllocInfo::CTRL, SlotAllocInfo::DIGITAL, 0);
 		ulCtrlSlot.m_dci.m_numSym = 1;
 		ulCtrlSlot.m_dci.m_symStart = m_phyMacConfig->GetSymbolsPerSubframe()-1;
-		ret.m_sfAllocInfo.m_slotAllocInfo.push_back (ulCtrlSlot);
+		slots.push_back (ulCtrlSlot);
+		ReportAllocations (bufferCapacity);
 		m_macSchedSapUser->SchedConfigInd (ret);
 		return;
 	}
+	std::sort (m_activeUes.begin (), m_activeUes.end ());
 
 	// compute requested num slots and TB size based on MCS and DL buffer size
 	// final allocated slots may be less
 	int totDlSymReq = 0;
 	int totUlSymReq = 0;
-	for (itUeInfo = ueInfo.begin (); itUeInfo != ueInfo.end (); itUeInfo++)
+	for (unsigned i = 0; i < m_activeUes.size (); i++)
 	{
+		UeSchedInfo &ueSchedInfo = m_ueTable[m_activeUes[i]].m_sched;
 		uint32_t dlTbSize = 0;
 		uint32_t ulTbSize = 0;
-		if (itUeInfo->second.m_maxDlBufSize > 0)
+		if (ueSchedInfo.m_maxDlBufSize > 0)
 		{
-			itUeInfo->second.m_maxDlSymbols = CalcMinTbSizeNumSym (itUeInfo->second.m_dlMcs, itUeInfo->second.m_maxDlBufSize, dlTbSize);
-			itUeInfo->second.m_maxDlBufSize = dlTbSize;
+			ueSchedInfo.m_maxDlSymbols = CalcMinTbSizeNumSym (ueSchedInfo.m_dlMcs, ueSchedInfo.m_maxDlBufSize, dlTbSize);
+			ueSchedInfo.m_maxDlBufSize = dlTbSize;
 			if (m_fixedTti)
 			{
-				itUeInfo->second.m_maxDlSymbols = ceil((long double)itUeInfo->second.m_maxDlSymbols/(long double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
+				ueSchedInfo.m_maxDlSymbols = ceil((long double)ueSchedInfo.m_maxDlSymbols/(long double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
 			}
-			totDlSymReq += itUeInfo->second.m_maxDlSymbols;
+			totDlSymReq += ueSchedInfo.m_maxDlSymbols;
 		}
-		if (itUeInfo->second.m_maxUlBufSize > 0)
+		if (ueSchedInfo.m_maxUlBufSize > 0)
 		{
-			itUeInfo->second.m_maxUlSymbols = CalcMinTbSizeNumSym (itUeInfo->second.m_ulMcs, itUeInfo->second.m_maxUlBufSize+10, ulTbSize);
-			itUeInfo->second.m_maxUlBufSize = ulTbSize;
+			ueSchedInfo.m_maxUlSymbols = CalcMinTbSizeNumSym (ueSchedInfo.m_ulMcs, ueSchedInfo.m_maxUlBufSize+10, ulTbSize);
+			ueSchedInfo.m_maxUlBufSize = ulTbSize;
 			if (m_fixedTti)
 			{
-				itUeInfo->second.m_maxUlSymbols = ceil((double)itUeInfo->second.m_maxUlSymbols/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
+				ueSchedInfo.m_maxUlSymbols = ceil((double)ueSchedInfo.m_maxUlSymbols/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
 			}
-			totUlSymReq += itUeInfo->second.m_maxUlSymbols;
-		}
-	}
-
-	std::map <uint16_t, struct UeSchedInfo>::iterator itUeInfoStart;
-	if (m_nextRnti != 0) 	// start with RNTI at which the scheduler left off
-	{
-		itUeInfoStart = ueInfo.find (m_nextRnti);
-		if (itUeInfoStart == ueInfo.end ())
-		{
-			itUeInfoStart = ueInfo.begin ();
+			totUlSymReq += ueSchedInfo.m_maxUlSymbols;
 		}
 	}
-	else	// start with first active RNTI
-	{
-		itUeInfoStart = ueInfo.begin ();
-	}
-	itUeInfo = itUeInfoStart;
 
-	// divide OFDM symbols evenly between active UEs, which are then evenly divided between DL and UL flows
-	if (nFlowsTot > 0)
+	// start with RNTI at which the scheduler left off, or with first active RNTI
+	std::vector<uint16_t>::iterator itStart = std::lower_bound (m_activeUes.begin (), m_activeUes.end (), m_nextRnti);
+	if (m_nextRnti == 0 || itStart == m_activeUes.end () || *itStart != m_nextRnti)
 	{
-		int remSym = totDlSymReq + totUlSymReq;
-		if (remSym > symAvail)
-		{
-			remSym = symAvail;
-		}
-
-		int nSymPerFlow0 = remSym / nFlowsTot;  // initial average symbols per non-retx flow
-		if (nSymPerFlow0 == 0)	// minimum of 1
-		{
-			nSymPerFlow0 = 1;
-		}
-		if (m_fixedTti)
-		{
-			nSymPerFlow0 = ceil((double)nSymPerFlow0/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
-		}
-		bool allocated = true; // someone got allocated
-		while (remSym > 0 && allocated)
-		{
-			allocated = false;  // additional symbols allocated to this RNTI in this iteration
-			int nRemSymPerFlow = remSym / nFlowsTot;
-			if (nRemSymPerFlow == 0)
-			{
-				nRemSymPerFlow = 1;
-			}
-			if (m_fixedTti)
-			{
-				nRemSymPerFlow = ceil((double)nRemSymPerFlow/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
-			}
-			while (remSym > 0)
-			{
-				int addSym = 0;
-				// deficit = difference between requested and allocated symbols
-				int deficit = itUeInfo->second.m_maxDlSymbols - itUeInfo->second.m_dlSymbols;
-				NS_ASSERT (deficit >= 0);
-				if (m_fixedTti)
-				{
-					deficit = ceil((double)deficit/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
-				}
-				if (deficit > 0 && ((itUeInfo->second.m_dlSymbols+itUeInfo->second.m_dlSymbolsRetx) <= nSymPerFlow0))
-				{
-					if (deficit < nRemSymPerFlow)
-					{
-						if (deficit > remSym)
-						{
-							addSym = remSym;
-						}
-						else
-						{
-							addSym = deficit;
-							// add remaining symbols to average
-							nFlowsTot--;
-							int extra = (nRemSymPerFlow - addSym) / nFlowsTot;
-							nSymPerFlow0 += extra;  // add extra to average symbols
-							nRemSymPerFlow += extra;  // add extra to average symbols
-						}
-					}
-					else
-					{
-						if (nRemSymPerFlow > remSym)
-						{
-							addSym = remSym;
-						}
-						else
-						{
-							addSym = nRemSymPerFlow;
-						}
-					}
-					allocated = true;
-				}
-				itUeInfo->second.m_dlSymbols += addSym;
-				remSym -= addSym;
-				NS_ASSERT (remSym >= 0);
-
-				addSym = 0;
-				// deficit = difference between requested and allocated symbols
-				deficit = itUeInfo->second.m_maxUlSymbols - itUeInfo->second.m_ulSymbols;
-				NS_ASSERT (deficit >= 0);
-				if (m_fixedTti)
-				{
-					deficit = ceil((double)deficit/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
-				}
-				if (m_fixedTti)
-				{
-					nRemSymPerFlow = ceil((double)nRemSymPerFlow/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
-				}
-				if (remSym > 0 && deficit > 0 && ((itUeInfo->second.m_ulSymbols+itUeInfo->second.m_ulSymbolsRetx) <= nSymPerFlow0))
-				{
-					if (deficit < nRemSymPerFlow)
-					{
-						// add remaining symbols to average
-						if (deficit > remSym)
-						{
-							addSym = remSym;
-						}
-						else
-						{
-							addSym = deficit;
-							// add remaining symbols to average
-							nFlowsTot--;
-							int extra = (nRemSymPerFlow - addSym) / nFlowsTot;
-							nSymPerFlow0 += extra;  // add extra to average symbols
-							nRemSymPerFlow += extra;  // add extra to average symbols
-						}
-					}
-					else
-					{
-						if (nRemSymPerFlow > remSym)
-						{
-							addSym = remSym;
-						}
-						else
-						{
-							addSym = nRemSymPerFlow;
-						}
-						allocated = true;
-					}
-				}
-				itUeInfo->second.m_ulSymbols += addSym;
-				remSym -= addSym;
-				NS_ASSERT (remSym >= 0);
-
-				itUeInfo++;
-				if (itUeInfo == ueInfo.end ())
-				{ // loop around to first RNTI in map
-					itUeInfo = ueInfo.begin ();
-				}
-				if (itUeInfo == itUeInfoStart)
-				{ // break when looped back to initial RNTI or no symbols remain
-					break;
-				}
-			}
-		}
+		itStart = m_activeUes.begin ();
 	}
+	m_startUe = itStart - m_activeUes.begin ();
 
-	m_nextRnti = itUeInfo->first;
+	AllocateSymbols (symAvail, totDlSymReq + totUlSymReq, nFlowsTot);
 
 	// create DCI elements and assign symbol indices
 	// such that all DL slots are contiguous (at beginning of subframe)
 	// and all UL slots are contiguous (at end of subframe)
-	itUeInfo = itUeInfoStart;
 
 	//ulSymIdx -= totUlSymActual; // symbols reserved for control at end of subframe before UL ctrl
 	NS_ASSERT (symIdx > 0);
-	do
+	for (unsigned n = 0; n < m_activeUes.size (); n++)
 	{
-		UeSchedInfo &ueSchedInfo = itUeInfo->second;
+		uint16_t rnti = m_activeUes[(m_startUe + n) % m_activeUes.size ()];
+		UeState &ue = m_ueTable[rnti];
+		UeSchedInfo &ueSchedInfo = ue.m_sched;
 		if (ueSchedInfo.m_dlSymbols > 0)
 		{
 			DciInfoElementTdma dci;
-			dci.m_rnti = itUeInfo->first;
+			dci.m_rnti = rnti;
 			dci.m_format = 0;
 			dci.m_symStart = symIdx;
 			dci.m_numSym = ueSchedInfo.m_dlSymbols;
@@ -1382,29 +1199,20 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 			}*/
 			NS_ASSERT (symIdx <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
 			dci.m_rv = 0;
-			dci.m_harqProcess = UpdateDlHarqProcessId (itUeInfo->first);
+			dci.m_harqProcess = UpdateDlHarqProcessId (rnti);
 			NS_ASSERT (dci.m_harqProcess < m_phyMacConfig->GetNumHarqProcess ());
-			NS_LOG_DEBUG ("UE" << itUeInfo->first << " DL harqId " << (unsigned)dci.m_harqProcess << " HARQ process assigned");
-			SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::DL, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, itUeInfo->first);
+			NS_LOG_DEBUG ("UE" << rnti << " DL harqId " << (unsigned)dci.m_harqProcess << " HARQ process assigned");
+			SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::DL, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, rnti);
 			slotInfo.m_dci = dci;
+			TakePooledRlcPduList (slotInfo);
 			NS_LOG_DEBUG ("UE" << dci.m_rnti << " gets DL slots " << (unsigned)dci.m_symStart << "-" << (unsigned)(dci.m_symStart+dci.m_numSym-1) <<
 			             " tbs " << dci.m_tbSize << " mcs " << (unsigned)dci.m_mcs << " harqId " << (unsigned)dci.m_harqProcess << " rv " << (unsigned)dci.m_rv << " in frame " << ret.m_sfnSf.m_frameNum << " subframe " << (unsigned)ret.m_sfnSf.m_sfNum);
 
 			if (m_harqOn == true)
 			{	// store DCI for HARQ buffer
-				std::map <uint16_t, DlHarqProcessesDciInfoList_t>::iterator itDciInfo = m_dlHarqProcessesDciInfoMap.find (dci.m_rnti);
-				if (itDciInfo == m_dlHarqProcessesDciInfoMap.end ())
-				{
-					NS_FATAL_ERROR ("Unable to find RNTI entry in DCI HARQ buffer for RNTI " << dci.m_rnti);
-				}
-				(*itDciInfo).second.at (dci.m_harqProcess) = dci;
+				ue.m_dlHarqDci.at (dci.m_harqProcess) = dci;
 				// refresh timer
-				std::map <uint16_t, DlHarqProcessesTimer_t>::iterator itHarqTimer =  m_dlHarqProcessesTimer.find (dci.m_rnti);
-				if (itHarqTimer== m_dlHarqProcessesTimer.end ())
-				{
-					NS_FATAL_ERROR ("Unable to find HARQ timer for RNTI " << (uint16_t)dci.m_rnti);
-				}
-				(*itHarqTimer).second.at (dci.m_harqProcess) = 0;
+				ue.m_dlHarqTimer.at (dci.m_harqProcess) = 0;
 			}
 
 			// distribute bytes between active RLC queues
@@ -1437,7 +1245,7 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 				NS_ASSERT(ueSchedInfo.m_rlcPduInfo[i].m_size > 0);
 				/*for (itRlcBuf = m_rlcBufferReq.begin (); itRlcBuf != m_rlcBufferReq.end (); itRlcBuf++)
 				{
-					if(itRlcBuf->m_rnti == itUeInfo->first)
+					if(itRlcBuf->m_rnti == rnti)
 					{
 						if(itRlcBuf->m_rlcTransmissionQueueSize == 0)
 						{
@@ -1446,45 +1254,36 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 					}
 				}*/
 				// update RLC buffer info with expected queue size after scheduling
-				UpdateDlRlcBufferInfo (itUeInfo->first, ueSchedInfo.m_rlcPduInfo[i].m_lcid, ueSchedInfo.m_rlcPduInfo[i].m_size-m_subHdrSize);
+				UpdateDlRlcBufferInfo (rnti, ueSchedInfo.m_rlcPduInfo[i].m_lcid, ueSchedInfo.m_rlcPduInfo[i].m_size-m_subHdrSize);
 				//schedInfo.m_rlcPduList[schedInfo.m_rlcPduList.size ()-1].push_back (itRlcInfo->second[i]);
 				slotInfo.m_rlcPduInfo.push_back (ueSchedInfo.m_rlcPduInfo[i]);
 				if (m_harqOn == true)
 				{
 					// store RLC PDU list for HARQ
-					std::map <uint16_t, DlHarqRlcPduList_t>::iterator itRlcPdu =  m_dlHarqProcessesRlcPduMap.find (dci.m_rnti);
-					if (itRlcPdu == m_dlHarqProcessesRlcPduMap.end ())
-					{
-						NS_FATAL_ERROR ("Unable to find RlcPdcList in HARQ buffer for RNTI " << dci.m_rnti);
-					}
-					(*itRlcPdu).second.at (dci.m_harqProcess).push_back (ueSchedInfo.m_rlcPduInfo[i]);
+					ue.m_dlHarqRlcPdu.at (dci.m_harqProcess).push_back (ueSchedInfo.m_rlcPduInfo[i]);
 				}
 			}
 			// reorder/reindex slots to maintain DL before UL slot order
 			bool reordered = false;
-			std::deque <SlotAllocInfo>::iterator itSlot = ret.m_sfAllocInfo.m_slotAllocInfo.begin ();
-			for (unsigned islot = 0; islot < ret.m_sfAllocInfo.m_slotAllocInfo.size (); islot++)
+			for (unsigned islot = 0; islot < slots.size (); islot++)
 			{
-				if (ret.m_sfAllocInfo.m_slotAllocInfo [islot].m_tddMode == SlotAllocInfo::UL)
+				if (slots[islot].m_tddMode == SlotAllocInfo::UL)
 				{
-					slotInfo.m_slotIdx = ret.m_sfAllocInfo.m_slotAllocInfo [islot].m_slotIdx;
-					slotInfo.m_dci.m_symStart = ret.m_sfAllocInfo.m_slotAllocInfo [islot].m_dci.m_symStart;
-					ret.m_sfAllocInfo.m_slotAllocInfo.insert (itSlot, slotInfo);
-					for (unsigned jslot = islot+1; jslot < ret.m_sfAllocInfo.m_slotAllocInfo.size (); jslot++)
+					slotInfo.m_slotIdx = slots[islot].m_slotIdx;
+					slotInfo.m_dci.m_symStart = slots[islot].m_dci.m_symStart;
+					slots.insert (slots.begin () + islot, std::move (slotInfo));
+					for (unsigned jslot = islot+1; jslot < slots.size (); jslot++)
 					{
-						ret.m_sfAllocInfo.m_slotAllocInfo[jslot].m_slotIdx++;	// increase indices of UL slots
-						ret.m_sfAllocInfo.m_slotAllocInfo[jslot].m_dci.m_symStart =
-																	ret.m_sfAllocInfo.m_slotAllocInfo[jslot-1].m_dci.m_symStart +
-																	ret.m_sfAllocInfo.m_slotAllocInfo[jslot-1].m_dci.m_numSym;
+						slots[jslot].m_slotIdx++;	// increase indices of UL slots
+						slots[jslot].m_dci.m_symStart = slots[jslot-1].m_dci.m_symStart + slots[jslot-1].m_dci.m_numSym;
 					}
 					reordered = true;
 					break;
 				}
-				itSlot++;
 			}
 			if (!reordered)
 			{
-				ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);
+				slots.push_back (std::move (slotInfo));
 			}
 			ret.m_sfAllocInfo.m_numSymAlloc += dci.m_numSym;
 		}
@@ -1493,7 +1292,7 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 		if (ueSchedInfo.m_ulSymbols > 0)
 		{
 			DciInfoElementTdma dci;
-			dci.m_rnti = itUeInfo->first;
+			dci.m_rnti = rnti;
 			dci.m_format = 1;
 			NS_ASSERT (symIdx <= m_phyMacConfig->GetSymbolsPerSubframe () - m_phyMacConfig->GetUlCtrlSymbols ());
 			dci.m_numSym = ueSchedInfo.m_ulSymbols;
@@ -1507,54 +1306,32 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 				dci.m_mcs--;
 				dci.m_tbSize = m_amc->GetTbSizeFromMcsSymbols (dci.m_mcs, dci.m_numSym) / 8;
 			}*/
-			dci.m_harqProcess = UpdateUlHarqProcessId (itUeInfo->first);
-			NS_LOG_DEBUG ("UE" << itUeInfo->first << " UL harqId " << (unsigned)dci.m_harqProcess << " HARQ process assigned");
+			dci.m_harqProcess = UpdateUlHarqProcessId (rnti);
+			NS_LOG_DEBUG ("UE" << rnti << " UL harqId " << (unsigned)dci.m_harqProcess << " HARQ process assigned");
 			NS_ASSERT (dci.m_harqProcess < m_phyMacConfig->GetNumHarqProcess ());
-			SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::UL, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, itUeInfo->first);
+			SlotAllocInfo slotInfo (slotIdx++, SlotAllocInfo::UL, SlotAllocInfo::CTRL_DATA, SlotAllocInfo::DIGITAL, rnti);
 			slotInfo.m_dci = dci;
 			NS_LOG_DEBUG ("UE" << dci.m_rnti << " gets UL slots " << (unsigned)dci.m_symStart << "-" << (unsigned)(dci.m_symStart+dci.m_numSym-1) <<
 						             " tbs " << dci.m_tbSize << " mcs " << (unsigned)dci.m_mcs << " harqId " << (unsigned)dci.m_harqProcess << " rv " << (unsigned)dci.m_rv << " in frame " << ulSfn.m_frameNum << " subframe " << (unsigned)ulSfn.m_sfNum);
-			UpdateUlRlcBufferInfo (itUeInfo->first, dci.m_tbSize - m_subHdrSize);
-			ret.m_sfAllocInfo.m_slotAllocInfo.push_back (slotInfo);  // add to front
+			UpdateUlRlcBufferInfo (rnti, dci.m_tbSize - m_subHdrSize);
+			slots.push_back (std::move (slotInfo));  // add to front
 			ret.m_sfAllocInfo.m_numSymAlloc += dci.m_numSym;
-			std::vector<uint16_t> ueChunkMap;
-			for (unsigned i = 0; i < m_phyMacConfig->GetTotalNumChunk (); i++)
-			{
-				ueChunkMap.push_back (dci.m_rnti);
-			}
 			SfnSf slotSfn = ret.m_sfAllocInfo.m_sfnSf;
 			slotSfn.m_slotNum = dci.m_symStart;  // use the start symbol index of the slot because the absolute UL slot index depends on the future DL allocation
 			// insert into allocation map to recall previous allocations upon receiving UL-CQI
-			m_ulAllocationMap.insert ( std::pair<uint32_t, struct AllocMapElem> (slotSfn.Encode (), AllocMapElem(ueChunkMap, dci.m_numSym, dci.m_tbSize)) );
+			AddUlAllocation (slotSfn, dci.m_rnti, dci.m_numSym, dci.m_tbSize);
 
 			if (m_harqOn == true)
 			{
 				uint8_t harqId = dci.m_harqProcess;
-				std::map <uint16_t, UlHarqProcessesDciInfoList_t>::iterator itHarqTbInfo = m_ulHarqProcessesDciInfoMap.find (dci.m_rnti);
-				if (itHarqTbInfo == m_ulHarqProcessesDciInfoMap.end ())
-				{
-					NS_FATAL_ERROR ("Unable to find RNTI entry in UL DCI HARQ buffer for RNTI " << dci.m_rnti);
-				}
-				(*itHarqTbInfo).second.at (harqId) = dci;
+				ue.m_ulHarqDci.at (harqId) = dci;
 				// Update HARQ process status (RV 0)
-				std::map <uint16_t, UlHarqProcessesStatus_t>::iterator itStat = m_ulHarqProcessesStatus.find (dci.m_rnti);
-				NS_ASSERT (itStat->second[dci.m_harqProcess] > 0);
+				NS_ASSERT (ue.m_ulHarqStatus[dci.m_harqProcess] > 0);
 				// refresh timer
-				std::map <uint16_t, UlHarqProcessesTimer_t>::iterator itHarqTimer =  m_ulHarqProcessesTimer.find (dci.m_rnti);
-				if (itHarqTimer== m_ulHarqProcessesTimer.end ())
-				{
-					NS_FATAL_ERROR ("Unable to find HARQ timer for RNTI " << (uint16_t)dci.m_rnti);
-				}
-				(*itHarqTimer).second.at (dci.m_harqProcess) = 0;
+				ue.m_ulHarqTimer.at (dci.m_harqProcess) = 0;
 			}
 		}
-		itUeInfo++;
-		if (itUeInfo == ueInfo.end ())
-		{ // loop around to first RNTI in map
-			itUeInfo = ueInfo.begin ();
-		}
 	}
-	while (itUeInfo != itUeInfoStart); // break when looped back to initial RNTI
 
 
 	// FIXME: We add dummy slots (empty) to get the number of slots per subframe the 3GPP demands according the SCS
@@ -1574,19 +1351,266 @@ MmWaveFlexTtiMacScheduler::DoSchedTriggerReq (const struct MmWaveMacSchedSapProv
 	SlotAllocInfo ulCtrlSlot (0xFF, SlotAllocInfo::UL, SlotAllocInfo::CTRL, SlotAllocInfo::DIGITAL, 0);
 	ulCtrlSlot.m_dci.m_numSym = 1;
 	ulCtrlSlot.m_dci.m_symStart = m_phyMacConfig->GetSymbolsPerSubframe()-1;
-	ret.m_sfAllocInfo.m_slotAllocInfo.push_back (ulCtrlSlot);
+	slots.push_back (ulCtrlSlot);
 
+	ReportAllocations (bufferCapacity);
 	m_macSchedSapUser->SchedConfigInd (ret);
 	return;
 }
 
+void
+MmWaveFlexTtiMacScheduler::AllocateSymbols (int symAvail, int totSymReq, int nFlowsTot)
+{
+	// divide OFDM symbols evenly between active UEs, which are then evenly divided between DL and UL flows
+	unsigned index = m_startUe;
+	if (nFlowsTot > 0)
+	{
+		int remSym = totSymReq;
+		if (remSym > symAvail)
+		{
+			remSym = symAvail;
+		}
+
+		int nSymPerFlow0 = remSym / nFlowsTot;  // initial average symbols per non-retx flow
+		if (nSymPerFlow0 == 0)	// minimum of 1
+		{
+			nSymPerFlow0 = 1;
+		}
+		if (m_fixedTti)
+		{
+			nSymPerFlow0 = ceil((double)nSymPerFlow0/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
+		}
+		bool allocated = true; // someone got allocated
+		while (remSym > 0 && allocated)
+		{
+			allocated = false;  // additional symbols allocated to this RNTI in this iteration
+			int nRemSymPerFlow = remSym / nFlowsTot;
+			if (nRemSymPerFlow == 0)
+			{
+				nRemSymPerFlow = 1;
+			}
+			if (m_fixedTti)
+			{
+				nRemSymPerFlow = ceil((double)nRemSymPerFlow/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
+			}
+			while (remSym > 0)
+			{
+				UeSchedInfo &ueSchedInfo = m_ueTable[m_activeUes[index]].m_sched;
+				int addSym = 0;
+				// deficit = difference between requested and allocated symbols
+				int deficit = ueSchedInfo.m_maxDlSymbols - ueSchedInfo.m_dlSymbols;
+				NS_ASSERT (deficit >= 0);
+				if (m_fixedTti)
+				{
+					deficit = ceil((double)deficit/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
+				}
+				if (deficit > 0 && ((ueSchedInfo.m_dlSymbols+ueSchedInfo.m_dlSymbolsRetx) <= nSymPerFlow0))
+				{
+					if (deficit < nRemSymPerFlow)
+					{
+						if (deficit > remSym)
+						{
+							addSym = remSym;
+						}
+						else
+						{
+							addSym = deficit;
+							// add remaining symbols to average
+							nFlowsTot--;
+							int extra = (nRemSymPerFlow - addSym) / nFlowsTot;
+							nSymPerFlow0 += extra;  // add extra to average symbols
+							nRemSymPerFlow += extra;  // add extra to average symbols
+						}
+					}
+					else
+					{
+						if (nRemSymPerFlow > remSym)
+						{
+							addSym = remSym;
+						}
+						else
+						{
+							addSym = nRemSymPerFlow;
+						}
+					}
+					allocated = true;
+				}
+				ueSchedInfo.m_dlSymbols += addSym;
+				remSym -= addSym;
+				NS_ASSERT (remSym >= 0);
+
+				addSym = 0;
+				// deficit = difference between requested and allocated symbols
+				deficit = ueSchedInfo.m_maxUlSymbols - ueSchedInfo.m_ulSymbols;
+				NS_ASSERT (deficit >= 0);
+				if (m_fixedTti)
+				{
+					deficit = ceil((double)deficit/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
+				}
+				if (m_fixedTti)
+				{
+					nRemSymPerFlow = ceil((double)nRemSymPerFlow/(double)m_symPerSlot) * m_symPerSlot; // round up to nearest sym per TTI
+				}
+				if (remSym > 0 && deficit > 0 && ((ueSchedInfo.m_ulSymbols+ueSchedInfo.m_ulSymbolsRetx) <= nSymPerFlow0))
+				{
+					if (deficit < nRemSymPerFlow)
+					{
+						// add remaining symbols to average
+						if (deficit > remSym)
+						{
+							addSym = remSym;
+						}
+						else
+						{
+							addSym = deficit;
+							// add remaining symbols to average
+							nFlowsTot--;
+							int extra = (nRemSymPerFlow - addSym) / nFlowsTot;
+							nSymPerFlow0 += extra;  // add extra to average symbols
+							nRemSymPerFlow += extra;  // add extra to average symbols
+						}
+					}
+					else
+					{
+						if (nRemSymPerFlow > remSym)
+						{
+							addSym = remSym;
+						}
+						else
+						{
+							addSym = nRemSymPerFlow;
+						}
+						allocated = true;
+					}
+				}
+				ueSchedInfo.m_ulSymbols += addSym;
+				remSym -= addSym;
+				NS_ASSERT (remSym >= 0);
+
+				index = (index + 1) % m_activeUes.size (); // loop around to first active RNTI
+				if (index == m_startUe)
+				{ // break when looped back to initial RNTI or no symbols remain
+					break;
+				}
+			}
+		}
+	}
+
+
+	m_nextRnti = m_activeUes[index];
+}
+
+MmWaveFlexTtiMacScheduler::UeSchedInfo&
+MmWaveFlexTtiMacScheduler::ActivateUe (uint16_t rnti)
+{
+	UeState &ue = GetUeState (rnti);
+	if (!ue.m_active)
+	{
+		ue.m_active = true;
+		// reset, keeping the memory of the RLC PDU list
+		std::vector <RlcPduInfo> rlcPduInfo;
+		rlcPduInfo.swap (ue.m_sched.m_rlcPduInfo);
+		rlcPduInfo.clear ();
+		ue.m_sched = UeSchedInfo ();
+		ue.m_sched.m_rlcPduInfo.swap (rlcPduInfo);
+		m_activeUes.push_back (rnti);
+	}
+	return ue.m_sched;
+}
+
+void
+MmWaveFlexTtiMacScheduler::TakePooledRlcPduList (SlotAllocInfo &slot)
+{
+	if (!m_rlcPduPool.empty ())
+	{
+		slot.m_rlcPduInfo.swap (m_rlcPduPool.back ());
+		m_rlcPduPool.pop_back ();
+	}
+}
+
+void
+MmWaveFlexTtiMacScheduler::AddUlAllocation (SfnSf sfn, uint16_t rnti, uint8_t numSym, uint32_t tbSize)
+{
+	uint32_t key = sfn.Encode ();
+	AllocMapElem alloc;
+	alloc.m_sfn = key;
+	alloc.m_rnti = rnti;
+	alloc.m_numSym = numSym;
+	alloc.m_tbSize = tbSize;
+	for (unsigned i = 0; i < m_ulAllocations.size (); i++)
+	{
+		if (m_ulAllocations[i].m_sfn == key)
+		{
+			return;	// already allocated, as a map insert
+		}
+		if ((m_ulAllocations[i].m_sfn & 0xFFFF) == (key & 0xFFFF))
+		{
+			NS_LOG_INFO ("UL allocation of RNTI " << m_ulAllocations[i].m_rnti << " got no UL-CQI, replaced");
+			m_ulAllocations[i] = alloc;
+			return;
+		}
+	}
+	m_ulAllocations.push_back (alloc);
+}
+
+uint64_t
+MmWaveFlexTtiMacScheduler::GetBufferCapacity () const
+{
+	uint64_t bytes = m_ueTable.capacity () * sizeof (UeState)
+			+ (m_activeUes.capacity () + m_createdUes.capacity ()) * sizeof (uint16_t)
+			+ (m_dlHarqInfoList.capacity () + m_dlHarqInfoUntxed.capacity ()) * sizeof (DlHarqInfo)
+			+ (m_ulHarqInfoList.capacity () + m_ulHarqInfoUntxed.capacity ()) * sizeof (UlHarqInfo)
+			+ m_ulAllocations.capacity () * sizeof (AllocMapElem)
+			+ m_csiDevices.capacity () * sizeof (Ptr<NetDevice>)
+			+ m_rlcPduPool.capacity () * sizeof (std::vector<RlcPduInfo>);
+	for (unsigned i = 0; i < m_rlcPduPool.size (); i++)
+	{
+		bytes += m_rlcPduPool[i].capacity () * sizeof (RlcPduInfo);
+	}
+	const std::vector <SlotAllocInfo> &slots = m_schedConfigInd.m_sfAllocInfo.m_slotAllocInfo;
+	bytes += slots.capacity () * sizeof (SlotAllocInfo);
+	for (unsigned i = 0; i < slots.size (); i++)
+	{
+		bytes += slots[i].m_rlcPduInfo.capacity () * sizeof (RlcPduInfo);
+	}
+	for (unsigned i = 0; i < m_createdUes.size (); i++)
+	{
+		const UeState &ue = m_ueTable[m_createdUes[i]];
+		bytes += ue.m_sched.m_rlcPduInfo.capacity () * sizeof (RlcPduInfo);
+		for (unsigned i = 0; i < ue.m_dlHarqRlcPdu.size (); i++)
+		{
+			bytes += ue.m_dlHarqRlcPdu[i].capacity () * sizeof (RlcPduInfo);
+		}
+	}
+	return bytes;
+}
+
+void
+MmWaveFlexTtiMacScheduler::ReportAllocations (uint64_t bufferCapacity)
+{
+	if (!m_reportBufferGrowth)
+	{
+		return;
+	}
+	uint64_t capacity = GetBufferCapacity ();
+	uint32_t growth = capacity > bufferCapacity ? capacity - bufferCapacity : 0;
+	m_allocReport.m_numSubframes++;
+	if (growth > 0)
+	{
+		m_allocReport.m_numAllocSubframes++;
+		m_allocReport.m_allocBytes += growth;
+		m_allocReport.m_lastAllocSfn = m_schedConfigInd.m_sfnSf;
+		NS_LOG_LOGIC ("Frame " << m_schedConfigInd.m_sfnSf.m_frameNum << " subframe " << (unsigned) m_schedConfigInd.m_sfnSf.m_sfNum
+		              << ": scheduling buffers grew by " << growth << " bytes");
+	}
+	m_allocTrace (m_schedConfigInd.m_sfnSf.m_frameNum, m_schedConfigInd.m_sfnSf.m_sfNum, growth);
+}
+
 void
 MmWaveFlexTtiMacScheduler::DoSchedUlMacCtrlInfoReq (const struct MmWaveMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters& params)
 {
 	NS_LOG_FUNCTION (this);
 
-	std::map <uint16_t,uint32_t>::iterator it;
-
 	for (unsigned int i = 0; i < params.m_macCeList.size (); i++)
 	{
 		if ( params.m_macCeList.at (i).m_macCeType == MacCeElement::BSR )
@@ -1598,27 +1622,32 @@ MmWaveFlexTtiMacScheduler::DoSchedUlMacCtrlInfoReq (const struct MmWaveMacSchedS
 			// Hence the BSR of different LCGs are just summed up to get
 			// a total queue size that is used for allocation purposes.
 
+			uint16_t rnti = params.m_macCeList.at (i).m_rnti;
 			uint32_t buffer = 0;
 			for (uint8_t lcg = 0; lcg < 4; ++lcg)
 			{
 				uint8_t bsrId = params.m_macCeList.at (i).m_macCeValue.m_bufferStatus.at (lcg);
 				buffer += BsrId2BufferSize (bsrId);
+				NotifyUlBuffer (rnti, lcg, BsrId2BufferSize (bsrId));
 			}
 
-			uint16_t rnti = params.m_macCeList.at (i).m_rnti;
-			it = m_ceBsrRxed.find (rnti);
-			if (it == m_ceBsrRxed.end ())
+			UeState &ue = GetUeState (rnti);
+			if ((!ue.m_bsrValid || ue.m_bsr == 0) && buffer > 0)
+			{
+				ue.m_bsrTime = Simulator::Now ();
+			}
+			if (!ue.m_bsrValid)
 			{
 				// create the new entry
-				m_ceBsrRxed.insert ( std::pair<uint16_t, uint32_t > (rnti, buffer));
 				NS_LOG_INFO (this << " Insert RNTI " << rnti << " queue " << buffer);
 			}
 			else
 			{
 				// update the buffer size value
-				(*it).second = buffer;
 				NS_LOG_INFO (this << " Update RNTI " << rnti << " queue " << buffer);
 			}
+			ue.m_bsrValid = true;
+			ue.m_bsr = buffer;
 		}
 	}
 
@@ -1645,27 +1674,26 @@ MmWaveFlexTtiMacScheduler::SortRlcBufferReq (MmWaveMacSchedSapProvider::SchedDlR
 void
 MmWaveFlexTtiMacScheduler::RefreshDlCqiMaps (void)
 {
-  NS_LOG_FUNCTION (this << m_wbCqiTimers.size ());
+  NS_LOG_FUNCTION (this);
   // refresh DL CQI P01 Map
-  std::map <uint16_t,uint32_t>::iterator itP10 = m_wbCqiTimers.begin ();
-  while (itP10 != m_wbCqiTimers.end ())
+  for (unsigned i = 0; i < m_createdUes.size (); i++)
     {
-      NS_LOG_INFO (this << " P10-CQI for user " << (*itP10).first << " is " << (uint32_t)(*itP10).second << " thr " << (uint32_t)m_cqiTimersThreshold);
-      if ((*itP10).second == 0)
+      uint16_t rnti = m_createdUes[i];
+      UeState &ue = m_ueTable[rnti];
+      if (!ue.m_dlCqiValid)
+        {
+          continue;
+        }
+      NS_LOG_INFO (this << " P10-CQI for user " << rnti << " is " << (uint32_t)ue.m_dlCqiTimer << " thr " << (uint32_t)m_cqiTimersThreshold);
+      if (ue.m_dlCqiTimer == 0)
         {
           // delete correspondent entries
-          std::map <uint16_t,uint8_t>::iterator itMap = m_wbCqiRxed.find ((*itP10).first);
-          NS_ASSERT_MSG (itMap != m_wbCqiRxed.end (), " Does not find CQI report for user " << (*itP10).first);
-          NS_LOG_INFO (this << " P10-CQI exired for user " << (*itP10).first);
-          m_wbCqiRxed.erase (itMap);
-          std::map <uint16_t,uint32_t>::iterator temp = itP10;
-          itP10++;
-          m_wbCqiTimers.erase (temp);
+          NS_LOG_INFO (this << " P10-CQI exired for user " << rnti);
+          ue.m_dlCqiValid = false;
         }
       else
         {
-          (*itP10).second--;
-          itP10++;
+          ue.m_dlCqiTimer--;
         }
     }
 
@@ -1677,26 +1705,25 @@ void
 MmWaveFlexTtiMacScheduler::RefreshUlCqiMaps (void)
 {
   // refresh UL CQI  Map
-  std::map <uint16_t,uint32_t>::iterator itUl = m_ueCqiTimers.begin ();
-  while (itUl != m_ueCqiTimers.end ())
+  for (unsigned i = 0; i < m_createdUes.size (); i++)
     {
-      NS_LOG_INFO (this << " UL-CQI for user " << (*itUl).first << " is " << (uint32_t)(*itUl).second << " thr " << (uint32_t)m_cqiTimersThreshold);
-      if ((*itUl).second == 0)
+      uint16_t rnti = m_createdUes[i];
+      UeState &ue = m_ueTable[rnti];
+      if (!ue.m_ulCqiValid)
+        {
+          continue;
+        }
+      NS_LOG_INFO (this << " UL-CQI for user " << rnti << " is " << (uint32_t)ue.m_ulCqiTimer << " thr " << (uint32_t)m_cqiTimersThreshold);
+      if (ue.m_ulCqiTimer == 0)
         {
           // delete correspondent entries
-          std::map <uint16_t, struct UlCqiMapElem>::iterator itMap = m_ueUlCqi.find ((*itUl).first);
-          NS_ASSERT_MSG (itMap != m_ueUlCqi.end (), " Does not find CQI report for user " << (*itUl).first);
-          NS_LOG_INFO (this << " UL-CQI expired for user " << (*itUl).first);
-          itMap->second.m_ueUlCqi.clear ();
-          m_ueUlCqi.erase (itMap);
-          std::map <uint16_t,uint32_t>::iterator temp = itUl;
-          itUl++;
-          m_ueCqiTimers.erase (temp);
+          NS_LOG_INFO (this << " UL-CQI expired for user " << rnti);
+          ue.m_ulCqi.clear ();
+          ue.m_ulCqiValid = false;
         }
       else
         {
-          (*itUl).second--;
-          itUl++;
+          ue.m_ulCqiTimer--;
         }
     }
 
@@ -1767,17 +1794,17 @@ MmWaveFlexTtiMacScheduler::UpdateUlRlcBufferInfo (uint16_t rnti, uint32_t size)
 {
 
   size = size - 2; // remove the minimum RLC overhead
-  std::map <uint16_t,uint32_t>::iterator it = m_ceBsrRxed.find (rnti);
-  if (it != m_ceBsrRxed.end ())
+  UeState *ue = FindUeState (rnti);
+  if (ue != 0 && ue->m_bsrValid)
     {
-      NS_LOG_INFO (this << " Update RLC BSR UE " << rnti << " size " << size << " BSR " << (*it).second);
-      if ((*it).second >= size)
+      NS_LOG_INFO (this << " Update RLC BSR UE " << rnti << " size " << size << " BSR " << ue->m_bsr);
+      if (ue->m_bsr >= size)
         {
-          (*it).second -= size;
+          ue->m_bsr -= size;
         }
       else
         {
-          (*it).second = 0;
+          ue->m_bsr = 0;
         }
     }
   else
@@ -1806,35 +1833,17 @@ MmWaveFlexTtiMacScheduler::DoCschedUeConfigReq (const struct MmWaveMacCschedSapP
 {
   NS_LOG_FUNCTION (this << " RNTI " << params.m_rnti << " txMode " << (uint16_t)params.m_transmissionMode);
 
-  if (m_dlHarqProcessesStatus.find (params.m_rnti) == m_dlHarqProcessesStatus.end ())
+  UeState &ue = GetUeState (params.m_rnti);
+  if (!ue.m_harqValid)
   {
-  	//m_dlHarqCurrentProcessId.insert (std::pair <uint16_t,uint8_t > (params.m_rnti, 0));
-  	DlHarqProcessesStatus_t dlHarqPrcStatus;
-  	dlHarqPrcStatus.resize (m_phyMacConfig->GetNumHarqProcess (), 0);
-  	m_dlHarqProcessesStatus.insert (std::pair <uint16_t, DlHarqProcessesStatus_t> (params.m_rnti, dlHarqPrcStatus));
-  	DlHarqProcessesTimer_t dlHarqProcessesTimer;
-  	dlHarqProcessesTimer.resize (m_phyMacConfig->GetNumHarqProcess (),0);
-  	m_dlHarqProcessesTimer.insert (std::pair <uint16_t, DlHarqProcessesTimer_t> (params.m_rnti, dlHarqProcessesTimer));
-  	DlHarqProcessesDciInfoList_t dlHarqTbInfoList;
-  	dlHarqTbInfoList.resize (m_phyMacConfig->GetNumHarqProcess ());
-  	m_dlHarqProcessesDciInfoMap.insert (std::pair <uint16_t, DlHarqProcessesDciInfoList_t> (params.m_rnti, dlHarqTbInfoList));
-  	DlHarqRlcPduList_t dlHarqRlcPduList;
-  	dlHarqRlcPduList.resize (m_phyMacConfig->GetNumHarqProcess ());
-  	m_dlHarqProcessesRlcPduMap.insert (std::pair <uint16_t, DlHarqRlcPduList_t> (params.m_rnti, dlHarqRlcPduList));
-  }
-
-  if (m_ulHarqProcessesStatus.find (params.m_rnti) == m_ulHarqProcessesStatus.end ())
-  {
-  	//				m_ulHarqCurrentProcessId.insert (std::pair <uint16_t,uint8_t > (rnti, 0));
-  	UlHarqProcessesStatus_t ulHarqPrcStatus;
-  	ulHarqPrcStatus.resize (m_phyMacConfig->GetNumHarqProcess (), 0);
-  	m_ulHarqProcessesStatus.insert (std::pair <uint16_t, UlHarqProcessesStatus_t> (params.m_rnti, ulHarqPrcStatus));
-  	UlHarqProcessesTimer_t ulHarqProcessesTimer;
-  	ulHarqProcessesTimer.resize (m_phyMacConfig->GetNumHarqProcess (),0);
-  	m_ulHarqProcessesTimer.insert (std::pair <uint16_t, UlHarqProcessesTimer_t> (params.m_rnti, ulHarqProcessesTimer));
-  	UlHarqProcessesDciInfoList_t ulHarqTbInfoList;
-  	ulHarqTbInfoList.resize (m_phyMacConfig->GetNumHarqProcess ());
-  	m_ulHarqProcessesDciInfoMap.insert (std::pair <uint16_t, UlHarqProcessesDciInfoList_t> (params.m_rnti, ulHarqTbInfoList));
+  	ue.m_harqValid = true;
+  	ue.m_dlHarqStatus.assign (m_phyMacConfig->GetNumHarqProcess (), 0);
+  	ue.m_dlHarqTimer.assign (m_phyMacConfig->GetNumHarqProcess (), 0);
+  	ue.m_dlHarqDci.assign (m_phyMacConfig->GetNumHarqProcess (), DciInfoElementTdma ());
+  	ue.m_dlHarqRlcPdu.assign (m_phyMacConfig->GetNumHarqProcess (), std::vector <struct RlcPduInfo> ());
+  	ue.m_ulHarqStatus.assign (m_phyMacConfig->GetNumHarqProcess (), 0);
+  	ue.m_ulHarqTimer.assign (m_phyMacConfig->GetNumHarqProcess (), 0);
+  	ue.m_ulHarqDci.assign (m_phyMacConfig->GetNumHarqProcess (), DciInfoElementTdma ());
   }
 }
 
@@ -1842,7 +1851,11 @@ void
 MmWaveFlexTtiMacScheduler::DoCschedLcConfigReq (const struct MmWaveMacCschedSapProvider::CschedLcConfigReqParameters& params)
 {
   NS_LOG_FUNCTION (this);
-  // Not used at this stage (LCs updated by DoSchedDlRlcBufferReq)
+  // the queues of the LCs are updated by DoSchedDlRlcBufferReq
+  for (unsigned i = 0; i < params.m_logicalChannelConfigList.size (); i++)
+    {
+      NotifyLcConfig (params.m_rnti, params.m_logicalChannelConfigList[i]);
+    }
   return;
 }
 
@@ -1873,16 +1886,21 @@ MmWaveFlexTtiMacScheduler::DoCschedUeReleaseReq (const struct MmWaveMacCschedSap
 {
   NS_LOG_FUNCTION (this << " Release RNTI " << params.m_rnti);
 
-  //m_dlHarqCurrentProcessId.erase (params.m_rnti);
-  m_dlHarqProcessesStatus.erase  (params.m_rnti);
-  m_dlHarqProcessesTimer.erase (params.m_rnti);
-  m_dlHarqProcessesDciInfoMap.erase  (params.m_rnti);
-  m_dlHarqProcessesRlcPduMap.erase  (params.m_rnti);
-  //m_ulHarqCurrentProcessId.erase  (params.m_rnti);
-  m_ulHarqProcessesTimer.erase (params.m_rnti);
-  m_ulHarqProcessesStatus.erase  (params.m_rnti);
-  m_ulHarqProcessesDciInfoMap.erase  (params.m_rnti);
-  m_ceBsrRxed.erase (params.m_rnti);
+  UeState *ue = FindUeState (params.m_rnti);
+  if (ue != 0)
+    {
+      // the CQIs are kept until they expire
+      ue->m_harqValid = false;
+      ue->m_dlHarqStatus.clear ();
+      ue->m_dlHarqTimer.clear ();
+      ue->m_dlHarqDci.clear ();
+      ue->m_dlHarqRlcPdu.clear ();
+      ue->m_ulHarqStatus.clear ();
+      ue->m_ulHarqTimer.clear ();
+      ue->m_ulHarqDci.clear ();
+      ue->m_bsrValid = false;
+      ue->m_bsr = 0;
+    }
   std::list<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters>::iterator it = m_rlcBufferReq.begin ();
   while (it != m_rlcBufferReq.end ())
     {
@@ -1905,6 +1923,7 @@ MmWaveFlexTtiMacScheduler::DoCschedUeReleaseReq (const struct MmWaveMacCschedSap
     {
       m_nextRntiDl = 0;
     }
+  NotifyUeRelease (params.m_rnti);
 
   return;
 }
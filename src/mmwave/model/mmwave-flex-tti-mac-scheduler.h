@@ -27,16 +27,20 @@
 
 
 
-#ifndef SRC_MMWAVE_MODEL_MMWAVE_RR_MAC_SCHEDULER_H_
-#define SRC_MMWAVE_MODEL_MMWAVE_RR_MAC_SCHEDULER_H_
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_FLEX_TTI_MAC_SCHEDULER_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_FLEX_TTI_MAC_SCHEDULER_H_
 
 
 #include "mmwave-mac-sched-sap.h"
 #include "mmwave-mac-csched-sap.h"
 #include "mmwave-mac-scheduler.h"
 #include "mmwave-amc.h"
+#include <ns3/nstime.h>
+#include <ns3/spectrum-value.h>
+#include <ns3/traced-callback.h>
 #include "string"
 #include <vector>
+#include <algorithm>
 #include <set>
 
 namespace ns3 {
@@ -85,7 +89,45 @@ public:
 		m_beamManager = pManager;
 	}
 
-private:
+	/**
+	 * Growth of the buffers of the scheduling decisions, measured with ReportBufferGrowth. The buffers
+	 * are reused every subframe, so that in steady state they do not grow. Only the capacity of the
+	 * buffers of the scheduler is measured, not the heap allocations of the decision, which the
+	 * mmwave-flex-tti-mac-scheduler test suite counts
+	 */
+	struct AllocationReport
+	{
+		AllocationReport () :
+			m_numSubframes (0), m_numAllocSubframes (0), m_allocBytes (0)
+		{
+		}
+
+		uint64_t	m_numSubframes;			// subframes scheduled
+		uint64_t	m_numAllocSubframes;	// subframes whose scheduling decision grew the buffers
+		uint64_t	m_allocBytes;				// bytes the buffers grew by
+		SfnSf			m_lastAllocSfn;			// last subframe whose scheduling decision grew the buffers
+	};
+
+	/**
+	 * @returns the growth of the buffers of the scheduling decisions made so far, empty
+	 * unless ReportBufferGrowth is enabled
+	 */
+	const AllocationReport& GetAllocationReport () const
+	{
+		return m_allocReport;
+	}
+
+	/**
+	 * TracedCallback signature for the allocations of the scheduling decision of a subframe
+	 * @params [in] frame number
+	 * @params [in] subframe number
+	 * @params [in] bytes the buffers grew by, 0 in steady state
+	 */
+	typedef void (* AllocationTracedCallback) (uint16_t frameNum, uint8_t sfNum, uint32_t bytes);
+
+	/**
+	 * Symbols requested and allocated to a UE in the subframe being scheduled
+	 */
 	struct UeSchedInfo
 	{
 		UeSchedInfo () :
@@ -94,7 +136,10 @@ private:
 			m_dlSymbols (0), m_ulSymbols (0),
 			m_dlSymbolsRetx (0), m_ulSymbolsRetx (0),
 			m_dlTbSize (0), m_ulTbSize (0),
-			m_dlAllocDone (false), m_ulAllocDone (false)
+			m_dlAllocDone (false), m_ulAllocDone (false),
+			m_dlHolDelay (0), m_ulHolDelay (0),
+			m_currTputDl (0), m_currTputUl (0),
+			m_avgTputDl (0), m_avgTputUl (0)
 		{
 		}
 
@@ -113,8 +158,178 @@ private:
 		std::vector <struct RlcPduInfo> m_rlcPduInfo;
 		bool			m_dlAllocDone;
 		bool			m_ulAllocDone;
+		double		m_dlHolDelay;		// ms, head of line delay of the oldest DL RLC queue
+		double		m_ulHolDelay;		// ms, since the BSR went above 0
+		double		m_currTputDl;		// bytes/s, rate of the symbols allocated so far
+		double		m_currTputUl;
+		double		m_avgTputDl;		// bytes/s, average throughput with the symbols allocated so far
+		double		m_avgTputUl;
 	};
 
+	/**
+	 * Scheduler state of a UE, stored in a table indexed by RNTI. The valid flags tell whether
+	 * a CQI, BSR or HARQ entry exists for the UE
+	 */
+	struct UeState
+	{
+		UeState () :
+			m_dlCqiValid (false), m_dlCqi (0), m_dlCqiTimer (0),
+			m_ulCqiValid (false), m_ulCqiNumSym (0), m_ulCqiTbSize (0), m_ulCqiTimer (0),
+			m_bsrValid (false), m_bsr (0),
+			m_harqValid (false),
+			m_active (false),
+			m_lastAvgTputDl (0), m_lastAvgTputUl (0), m_allocUlLast (false),
+			m_created (false)
+		{
+		}
+
+		bool			m_dlCqiValid;
+		uint8_t		m_dlCqi;		// wideband DL CQI
+		uint32_t	m_dlCqiTimer;	// TTIs before the DL CQI expires
+
+		bool			m_ulCqiValid;
+		std::vector <double> m_ulCqi;	// UL SINR per chunk
+		uint8_t		m_ulCqiNumSym;	// symbols of the allocation the UL SINR was measured on
+		uint32_t	m_ulCqiTbSize;	// TB size of that allocation
+		uint32_t	m_ulCqiTimer;	// TTIs before the UL CQI expires
+
+		bool			m_bsrValid;
+		uint32_t	m_bsr;			// UL buffer size reported, minus what has been scheduled since
+		Time			m_bsrTime;		// time the UL buffer went above 0
+
+		bool			m_harqValid;	// HARQ processes created by CschedUeConfigReq
+		//HARQ status
+		// 0: process Id available
+		// x>0: process Id equal to `x` trasmission count
+		DlHarqProcessesStatus_t m_dlHarqStatus;
+		DlHarqProcessesTimer_t m_dlHarqTimer;
+		DlHarqProcessesDciInfoList_t m_dlHarqDci;
+		DlHarqRlcPduList_t m_dlHarqRlcPdu;
+		UlHarqProcessesStatus_t m_ulHarqStatus;
+		UlHarqProcessesTimer_t m_ulHarqTimer;
+		UlHarqProcessesDciInfoList_t m_ulHarqDci;
+
+		bool			m_active;		// scheduled (new data or HARQ retx) in the current subframe
+		UeSchedInfo m_sched;
+
+		double		m_lastAvgTputDl;	// average DL throughput when the DL buffer was last fully served
+		double		m_lastAvgTputUl;	// average UL throughput when the UL buffer was last fully served
+		bool			m_allocUlLast;	// last symbol given to the UE alone was UL
+
+		bool			m_created;	// created by GetUeState, listed in m_createdUes
+	};
+
+protected:
+	/**
+	 * Add the attributes and trace sources of the scheduler engine to a TypeId. The schedulers
+	 * built on this engine add them to their own TypeId, so that they can be set with their name
+	 * @params the TypeId
+	 * @returns the TypeId with the attributes
+	 */
+	static TypeId AddFlexTtiAttributes (TypeId tid);
+
+	/**
+	 * Divide the symbols left after the HARQ retransmissions between the DL and UL flows of the
+	 * active UEs (m_activeUes, from m_startUe on), setting m_dlSymbols and m_ulSymbols of their
+	 * UeSchedInfo, and set m_nextRnti. The flows requesting symbols have m_maxDlSymbols or
+	 * m_maxUlSymbols above 0. By default the symbols are shared evenly (round robin)
+	 * @params symbols available
+	 * @params symbols requested by all the flows
+	 * @params number of flows requesting symbols
+	 */
+	virtual void AllocateSymbols (int symAvail, int totSymReq, int nFlowsTot);
+
+	/**
+	 * @returns the bytes reserved by the buffers that the scheduling decision reuses every
+	 * subframe, whose growth is reported with ReportBufferGrowth. Schedulers with buffers of their own add them
+	 */
+	virtual uint64_t GetBufferCapacity () const;
+
+	/**
+	 * Notify the configuration of a logical channel, for schedulers keeping statistics per flow
+	 * @params the RNTI
+	 * @params the configuration of the logical channel
+	 */
+	virtual void NotifyLcConfig (uint16_t rnti, const struct LogicalChannelConfigListElement_s &lc)
+	{
+	}
+
+	/**
+	 * Notify a report of the RLC queues of a DL logical channel
+	 * @params the report
+	 */
+	virtual void NotifyDlRlcBuffer (const struct MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters &params)
+	{
+	}
+
+	/**
+	 * Notify the UL buffer of a logical channel group reported by a BSR
+	 * @params the RNTI
+	 * @params the logical channel group
+	 * @params the buffer size
+	 */
+	virtual void NotifyUlBuffer (uint16_t rnti, uint8_t lcg, uint32_t bufSize)
+	{
+	}
+
+	/**
+	 * Notify the release of a UE
+	 * @params the RNTI
+	 */
+	virtual void NotifyUeRelease (uint16_t rnti)
+	{
+	}
+
+	/**
+	 * @params the RNTI
+	 * @returns the state of the UE, created if it does not exist
+	 */
+	UeState& GetUeState (uint16_t rnti)
+	{
+		if (rnti >= m_ueTable.size ())
+		{
+			m_ueTable.resize (rnti + 1);
+		}
+		UeState &ue = m_ueTable[rnti];
+		if (!ue.m_created)
+		{
+			ue.m_created = true;
+			m_createdUes.insert (std::lower_bound (m_createdUes.begin (), m_createdUes.end (), rnti), rnti);
+		}
+		return ue;
+	}
+
+	/**
+	 * @params the RNTI
+	 * @returns the state of the UE, 0 if it was never created
+	 */
+	UeState* FindUeState (uint16_t rnti)
+	{
+		return rnti < m_ueTable.size () && m_ueTable[rnti].m_created ? &m_ueTable[rnti] : 0;
+	}
+
+	Ptr<MmWaveAmc> m_amc;
+
+	std::vector <UeState> m_ueTable;	// indexed by RNTI
+	std::vector <uint16_t> m_createdUes;	// RNTIs of the UEs created in m_ueTable, sorted
+	std::vector <uint16_t> m_activeUes;	// RNTIs of the active UEs of the current subframe, sorted
+	uint32_t m_startUe;		// index in m_activeUes of the first UE served in the current subframe
+	uint16_t m_nextRnti;		// first UE served in the next subframe
+
+	bool m_fixedTti;		// one slot per TTI
+	uint8_t	m_symPerSlot; // symbols per slot
+
+	static const unsigned m_subHdrSize;
+	static const unsigned m_rlcHdrSize;
+
+private:
+	/**
+	 * Mark a UE active in the current subframe
+	 * @params the RNTI
+	 * @returns its UeSchedInfo, reset if it was not active
+	 */
+	UeSchedInfo& ActivateUe (uint16_t rnti);
+
 	unsigned CalcMinTbSizeNumSym (unsigned mcs, unsigned bufSize, uint32_t &tbSize);
 
 	uint32_t
@@ -197,52 +412,37 @@ private:
    */
 	void RefreshHarqProcesses ();
 
-	TddSlotTypeList m_tddMap;
-
-	Ptr<MmWaveAmc> m_amc;
-
-	/*
-	 * Vectors of UE's RLC info
+	/**
+	 * Give a slot an empty RLC PDU list from the pool, if there is one
+	 * @params the slot
 	 */
-	std::list <MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters> m_rlcBufferReq;
+	void TakePooledRlcPduList (SlotAllocInfo &slot);
 
-	/*
-	 * Map of UE's DL CQI WB received
-	 */
-	std::map <uint16_t,uint8_t> m_wbCqiRxed;
-	/*
-	 * Map of UE's timers on DL CQI WB received
+	/**
+	 * Store an UL allocation, to retrieve it upon receiving the UL-CQI. An allocation of
+	 * the same subframe and slot of an older frame has not been answered and is replaced
+	 * @params the SfnSf of the slot, with its start symbol as slot number
+	 * @params the RNTI
+	 * @params the number of symbols
+	 * @params the TB size
 	 */
-	std::map <uint16_t,uint32_t> m_wbCqiTimers;
-
-	uint32_t m_cqiTimersThreshold; // # of TTIs for which a CQI can be considered valid
+	void AddUlAllocation (SfnSf sfn, uint16_t rnti, uint8_t numSym, uint32_t tbSize);
 
-	/*
-	 * Map of UEs' UL-CQI per RBG
+	/**
+	 * Update the allocation report with the growth of the buffers in the current subframe
+	 * @params the capacity of the buffers at the start of the subframe
 	 */
-	struct UlCqiMapElem
-	{
-		UlCqiMapElem (std::vector<double> ulCqi, uint8_t nSym, uint32_t tbs) :
-			m_ueUlCqi (ulCqi), m_numSym (nSym), m_tbSize (tbs)
-		{
-		}
-		std::vector <double> m_ueUlCqi;
-		uint8_t 	m_numSym;
-		uint32_t	m_tbSize;
-	};
+	void ReportAllocations (uint64_t bufferCapacity);
 
-	std::map <uint16_t, struct UlCqiMapElem> m_ueUlCqi;
-	/*
-	 * Map of UEs' timers on UL-CQI per RBG
-	 */
-	std::map <uint16_t, uint32_t> m_ueCqiTimers;
+	TddSlotTypeList m_tddMap;
 
 	/*
-	 * Map of UE's buffer status reports received
+	 * Vectors of UE's RLC info
 	 */
-	std::map <uint16_t,uint32_t> m_ceBsrRxed;
+	std::list <MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters> m_rlcBufferReq;
+
+	uint32_t m_cqiTimersThreshold; // # of TTIs for which a CQI can be considered valid
 
-	uint16_t m_nextRnti;
 	uint64_t m_nextRntiDl;
 	uint64_t m_nextRntiUl;
 
@@ -261,20 +461,16 @@ private:
 
 	struct AllocMapElem
 	{
-		AllocMapElem (std::vector<uint16_t> rntiMap, uint8_t nSym, uint32_t tbs) :
-			m_rntiPerChunk (rntiMap), m_numSym (nSym), m_tbSize (tbs)
-		{
-		}
-
-		std::vector <uint16_t> m_rntiPerChunk;
+		uint32_t m_sfn;		// encoded SfnSf of the slot, with its start symbol as slot number
+		uint16_t m_rnti;	// UE allocated in all the chunks (TDMA)
 		uint8_t m_numSym;
 		uint32_t m_tbSize;
 	};
 	/*
-	 * Map of previous allocated UE per RBG
-	 * (used to retrieve info from UL-CQI)
+	 * Previous UL allocations (used to retrieve info from UL-CQI). Only those of the last
+	 * subframes are pending, so they are searched in a vector that keeps its memory
 	 */
-	std::map <uint32_t, struct AllocMapElem> m_ulAllocationMap;
+	std::vector <struct AllocMapElem> m_ulAllocations;
 
 	// HARQ attributes
 	/**
@@ -284,31 +480,25 @@ private:
 	uint8_t m_numHarqProcess;
 	uint8_t m_harqTimeout;
 
-	std::map <uint16_t, uint8_t> m_dlHarqCurrentProcessId;
-	//HARQ status
-	// 0: process Id available
-	// x>0: process Id equal to `x` trasmission count
-	std::map <uint16_t, DlHarqProcessesStatus_t> m_dlHarqProcessesStatus;
-	std::map <uint16_t, DlHarqProcessesTimer_t> m_dlHarqProcessesTimer;
-	std::map <uint16_t, DlHarqProcessesDciInfoList_t> m_dlHarqProcessesDciInfoMap;
-	std::map <uint16_t, DlHarqRlcPduList_t> m_dlHarqProcessesRlcPduMap;
 	std::vector <DlHarqInfo> m_dlHarqInfoList; // HARQ retx buffered
 	std::vector <UlHarqInfo> m_ulHarqInfoList; // HARQ retx buffered
+	std::vector <DlHarqInfo> m_dlHarqInfoUntxed; // HARQ retx not scheduled in the current subframe
+	std::vector <UlHarqInfo> m_ulHarqInfoUntxed; // HARQ retx not scheduled in the current subframe
+
+	// scheduling decision, reused every subframe: the PHY gives back the SfAllocInfo of the previous frame
+	MmWaveMacSchedSapUser::SchedConfigIndParameters m_schedConfigInd;
+	std::vector <std::vector <RlcPduInfo> > m_rlcPduPool;	// RLC PDU lists of the slots of past decisions
+	std::vector <Ptr<NetDevice> > m_csiDevices;	// devices with CSI resources in the current subframe
+	SpectrumValue m_ulSinr;	// UL SINR of the UE whose UL CQI is computed
 
-	std::map <uint16_t, uint8_t> m_ulHarqCurrentProcessId;
-	//HARQ status
-	// 0: process Id available
-	// x>0: process Id equal to `x` trasmission count
-	std::map <uint16_t, UlHarqProcessesStatus_t> 	m_ulHarqProcessesStatus;
-	std::map <uint16_t, UlHarqProcessesTimer_t> 	m_ulHarqProcessesTimer;
-	std::map <uint16_t, UlHarqProcessesDciInfoList_t> m_ulHarqProcessesDciInfoMap;
+	bool m_reportBufferGrowth;	// measure the capacity of the buffers in every subframe
+	AllocationReport m_allocReport;
+	TracedCallback<uint16_t, uint8_t, uint32_t> m_allocTrace;
 
 	// needed to keep track of uplink allocations in later slots
 	std::list <struct SfAllocInfo> m_ulSfAllocInfo;
 
 	static const unsigned m_macHdrSize;
-	static const unsigned m_subHdrSize;
-	static const unsigned m_rlcHdrSize;
 
 	static const double m_berDl;
 	bool 		m_fixedMcsDl;
@@ -319,13 +509,10 @@ private:
 	bool m_dlOnly;
 	bool m_ulOnly; //for testing
 
-	bool m_fixedTti;		// one slot per TTI
-	uint8_t	m_symPerSlot; // symbols per slot
-
 	Ptr<MmWaveBeamManagement> m_beamManager;
 };
 
 }
 
 
-#endif /* SRC_MMWAVE_MODEL_MMWAVE_RR_MAC_SCHEDULER_H_ */
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_FLEX_TTI_MAC_SCHEDULER_H_ */
@@ -0,0 +1,172 @@
+/*
+ * mmwave-flex-tti-policy-mac-scheduler.h
+ *
+ *  Flex-TTI scheduler engine with the ranking of the UEs plugged in as a
+ *  compile-time policy, and the policies of the PF and MaxRate schedulers.
+ */
+
+#ifndef SRC_MMWAVE_MODEL_MMWAVE_FLEX_TTI_POLICY_MAC_SCHEDULER_H_
+#define SRC_MMWAVE_MODEL_MMWAVE_FLEX_TTI_POLICY_MAC_SCHEDULER_H_
+
+#include "mmwave-flex-tti-mac-scheduler.h"
+#include <algorithm>
+
+namespace ns3 {
+
+/**
+ * \brief Flex-TTI scheduler whose symbols for new data are given one at a time (one slot at a
+ * time with FixedTti) to the active UE with the highest metric of a policy, until the UEs have all
+ * the symbols they request. The UEs are ranked again after every symbol, and a UE with both DL and
+ * UL data alternates between them. HARQ retransmissions, CQI and buffer bookkeeping and DCI
+ * creation are those of MmWaveFlexTtiMacScheduler.
+ *
+ * The policy is a class with the method
+ *
+ *   double GetMetric (const MmWaveFlexTtiMacScheduler::UeSchedInfo &ueSchedInfo) const;
+ *
+ * Among the UEs with the same metric, the UE with the fewest symbols in the subframe is served
+ * first, then the UE with the lowest RNTI. The current throughput of a flow (UeSchedInfo::m_currTputDl
+ * and m_currTputUl) is the TB size in bits of the symbols allocated so far, or of one symbol before
+ * any, capped by its buffer in bytes, per second. Its average throughput (m_avgTputDl and m_avgTputUl) starts from 0 in every subframe
+ * and, once the flow has symbols, is a moving average over m_timeWindow subframes of the rate of its
+ * allocation, starting from the average kept when its buffer was last fully served
+ * (UeState::m_lastAvgTputDl and m_lastAvgTputUl), which is the average before its last allocation.
+ */
+template <class Policy>
+class MmWaveFlexTtiPolicyMacScheduler : public MmWaveFlexTtiMacScheduler
+{
+public:
+	MmWaveFlexTtiPolicyMacScheduler ()
+		: m_timeWindow (99.0)
+	{
+	}
+
+protected:
+	virtual void AllocateSymbols (int symAvail, int totSymReq, int nFlowsTot);
+
+	Policy m_policy;
+	double m_timeWindow;	// subframes of the throughput moving average
+};
+
+template <class Policy>
+void
+MmWaveFlexTtiPolicyMacScheduler<Policy>::AllocateSymbols (int symAvail, int totSymReq, int nFlowsTot)
+{
+	double sfPeriod = m_phyMacConfig->GetSubframePeriod () * 1E-6;
+	int symPerAlloc = m_fixedTti ? m_symPerSlot : 1;
+
+	for (unsigned i = 0; i < m_activeUes.size (); i++)
+	{
+		UeSchedInfo &ueSchedInfo = m_ueTable[m_activeUes[i]].m_sched;
+		ueSchedInfo.m_dlAllocDone = (ueSchedInfo.m_maxDlSymbols == 0);
+		ueSchedInfo.m_ulAllocDone = (ueSchedInfo.m_maxUlSymbols == 0);
+		if (!ueSchedInfo.m_dlAllocDone)
+		{
+			uint32_t tbSizeBits = m_amc->GetTbSizeFromMcsSymbols (ueSchedInfo.m_dlMcs, symPerAlloc);
+			ueSchedInfo.m_currTputDl = std::min (ueSchedInfo.m_maxDlBufSize, tbSizeBits) / sfPeriod;
+		}
+		if (!ueSchedInfo.m_ulAllocDone)
+		{
+			uint32_t tbSizeBits = m_amc->GetTbSizeFromMcsSymbols (ueSchedInfo.m_ulMcs, symPerAlloc);
+			ueSchedInfo.m_currTputUl = std::min (ueSchedInfo.m_maxUlBufSize, tbSizeBits) / sfPeriod;
+		}
+	}
+
+	while (symAvail > 0)
+	{
+		// rank the UEs requesting symbols, in RNTI order so that ties are broken the same way
+		UeState *ue = 0;
+		double maxMetric = 0;
+		for (unsigned i = 0; i < m_activeUes.size (); i++)
+		{
+			UeState &candidate = m_ueTable[m_activeUes[i]];
+			const UeSchedInfo &ueSchedInfo = candidate.m_sched;
+			if (ueSchedInfo.m_dlAllocDone && ueSchedInfo.m_ulAllocDone)
+			{
+				continue;
+			}
+			double metric = m_policy.GetMetric (ueSchedInfo);
+			if (ue == 0 || metric > maxMetric
+			    || (metric == maxMetric && ueSchedInfo.m_dlSymbols + ueSchedInfo.m_ulSymbols
+			                               < ue->m_sched.m_dlSymbols + ue->m_sched.m_ulSymbols))
+			{
+				ue = &candidate;
+				maxMetric = metric;
+			}
+		}
+		if (ue == 0)
+		{
+			break;	// all the flows have the symbols they request
+		}
+
+		UeSchedInfo &ueSchedInfo = ue->m_sched;
+		if ((ue->m_allocUlLast || ueSchedInfo.m_dlAllocDone) && !ueSchedInfo.m_ulAllocDone)
+		{
+			int numSym = std::min (std::min (symPerAlloc, symAvail), ueSchedInfo.m_maxUlSymbols - ueSchedInfo.m_ulSymbols);
+			ueSchedInfo.m_ulSymbols += numSym;
+			symAvail -= numSym;
+			ueSchedInfo.m_ulTbSize = m_amc->GetTbSizeFromMcsSymbols (ueSchedInfo.m_ulMcs, ueSchedInfo.m_ulSymbols) / 8;
+			if (ueSchedInfo.m_ulSymbols >= ueSchedInfo.m_maxUlSymbols)
+			{
+				// the average kept is the one before this allocation
+				ueSchedInfo.m_ulAllocDone = true;
+				ue->m_lastAvgTputUl = ueSchedInfo.m_avgTputUl;
+			}
+			ue->m_allocUlLast = true;
+			uint32_t tbSizeBits = m_amc->GetTbSizeFromMcsSymbols (ueSchedInfo.m_ulMcs, ueSchedInfo.m_ulSymbols);
+			ueSchedInfo.m_currTputUl = std::min (ueSchedInfo.m_maxUlBufSize, tbSizeBits) / sfPeriod;
+			ueSchedInfo.m_avgTputUl = ((1.0 - (1.0 / m_timeWindow)) * ue->m_lastAvgTputUl) +
+					((1.0 / m_timeWindow) * (ueSchedInfo.m_ulTbSize / sfPeriod));
+		}
+		else
+		{
+			int numSym = std::min (std::min (symPerAlloc, symAvail), ueSchedInfo.m_maxDlSymbols - ueSchedInfo.m_dlSymbols);
+			ueSchedInfo.m_dlSymbols += numSym;
+			symAvail -= numSym;
+			ueSchedInfo.m_dlTbSize = m_amc->GetTbSizeFromMcsSymbols (ueSchedInfo.m_dlMcs, ueSchedInfo.m_dlSymbols) / 8;
+			if (ueSchedInfo.m_dlSymbols >= ueSchedInfo.m_maxDlSymbols)
+			{
+				// the average kept is the one before this allocation
+				ueSchedInfo.m_dlAllocDone = true;
+				ue->m_lastAvgTputDl = ueSchedInfo.m_avgTputDl;
+			}
+			ue->m_allocUlLast = false;
+			uint32_t tbSizeBits = m_amc->GetTbSizeFromMcsSymbols (ueSchedInfo.m_dlMcs, ueSchedInfo.m_dlSymbols);
+			ueSchedInfo.m_currTputDl = std::min (ueSchedInfo.m_maxDlBufSize, tbSizeBits) / sfPeriod;
+			ueSchedInfo.m_avgTputDl = ((1.0 - (1.0 / m_timeWindow)) * ue->m_lastAvgTputDl) +
+					((1.0 / m_timeWindow) * (ueSchedInfo.m_dlTbSize / sfPeriod));
+		}
+	}
+
+	// the UEs are always served in RNTI order
+	m_nextRnti = 0;
+}
+
+/**
+ * Proportional fair: highest current throughput of the flows of the UE over its average
+ * throughput, the sum of the DL and UL averages
+ */
+struct MmWaveFlexTtiPfPolicy
+{
+	double GetMetric (const MmWaveFlexTtiMacScheduler::UeSchedInfo &ueSchedInfo) const
+	{
+		return std::max (ueSchedInfo.m_currTputDl, ueSchedInfo.m_currTputUl) /
+				std::max (1E-9, ueSchedInfo.m_avgTputDl + ueSchedInfo.m_avgTputUl);
+	}
+};
+
+/**
+ * Maximum rate: the UEs with the highest MCS are served first, and the UEs with the same MCS
+ * take a symbol in turn
+ */
+struct MmWaveFlexTtiMaxRatePolicy
+{
+	double GetMetric (const MmWaveFlexTtiMacScheduler::UeSchedInfo &ueSchedInfo) const
+	{
+		return std::max (ueSchedInfo.m_dlMcs, ueSchedInfo.m_ulMcs);
+	}
+};
+
+} // namespace ns3
+
+#endif /* SRC_MMWAVE_MODEL_MMWAVE_FLEX_TTI_POLICY_MAC_SCHEDULER_H_ */
@@ -59,7 +59,6 @@ mmWaveInterference::DoDispose ()
 	NS_LOG_FUNCTION (this);
 	m_PowerChunkProcessorList.clear ();
 	m_sinrChunkProcessorList.clear ();
-	m_rxSignal = 0;
 	m_allSignals = 0;
 	m_noise = 0;
 	Object::DoDispose ();
@@ -83,7 +82,7 @@ mmWaveInterference::StartRx (Ptr<const SpectrumValue> rxPsd)
 	if (m_receiving == false)
 	{
 		NS_LOG_LOGIC ("first signal");
-		m_rxSignal = rxPsd->Copy ();
+		m_rxSignal.Assign (*rxPsd);
 		m_lastChangeTime = Now ();
 		m_receiving = true;
 		for (std::list<Ptr<mmWaveChunkProcessor> >::const_iterator it = m_PowerChunkProcessorList.begin (); it != m_PowerChunkProcessorList.end (); ++it)
@@ -97,12 +96,12 @@ mmWaveInterference::StartRx (Ptr<const SpectrumValue> rxPsd)
     }
 	else
     {
-		NS_LOG_LOGIC ("additional signal" << *m_rxSignal);
+		NS_LOG_LOGIC ("additional signal" << m_rxSignal.Get ());
       	// receiving multiple simultaneous signals, make sure they are synchronized
       	NS_ASSERT (m_lastChangeTime == Now ());
      	// make sure they use orthogonal resource blocks
-     	NS_ASSERT (Sum ((*rxPsd) * (*m_rxSignal)) == 0.0);
-    	(*m_rxSignal) += (*rxPsd);
+     	NS_ASSERT (Sum ((*rxPsd) * m_rxSignal.Get ()) == 0.0);
+    	m_rxSignal.Add (*rxPsd);
     }
 }
 
@@ -186,17 +185,17 @@ mmWaveInterference::ConditionallyEvaluateChunk ()
 	NS_LOG_DEBUG (this << " now "  << Now () << " last " << m_lastChangeTime);
 	if (m_receiving && (Now () > m_lastChangeTime))
     {
-		NS_LOG_LOGIC (this << " signal = " << *m_rxSignal << " allSignals = " << *m_allSignals << " noise = " << *m_noise);
-		SpectrumValue interf =  (*m_allSignals) - (*m_rxSignal) + (*m_noise);
-		SpectrumValue sinr = (*m_rxSignal) / interf;
+		NS_LOG_LOGIC (this << " signal = " << m_rxSignal.Get () << " allSignals = " << *m_allSignals << " noise = " << *m_noise);
+		// sinr = signal / (allSignals - signal + noise), in the buffer kept across the chunks
+		m_sinr.AssignSinr (m_rxSignal.Get (), *m_allSignals, *m_noise);
 		Time duration = Now () - m_lastChangeTime;
 		for (std::list<Ptr<mmWaveChunkProcessor> >::const_iterator it = m_PowerChunkProcessorList.begin (); it != m_PowerChunkProcessorList.end (); ++it)
 		{
-		  (*it)->EvaluateChunk (*m_rxSignal, duration);
+		  (*it)->EvaluateChunk (m_rxSignal.Get (), duration);
 		}
 		for (std::list<Ptr<mmWaveChunkProcessor> >::const_iterator it = m_sinrChunkProcessorList.begin (); it != m_sinrChunkProcessorList.end (); ++it)
 		{
-		  (*it)->EvaluateChunk (sinr, duration);
+		  (*it)->EvaluateChunk (m_sinr.Get (), duration);
 		}
 		m_lastChangeTime = Now ();
     }
@@ -36,6 +36,7 @@
 #include <ns3/spectrum-value.h>
 #include <string.h>
 #include <ns3/mmwave-chunk-processor.h>
+#include <ns3/mmwave-psd-buffer.h>
 
 
 namespace ns3 {
@@ -64,9 +65,10 @@ private:
 
 	bool m_receiving;
 
-	Ptr<SpectrumValue> m_rxSignal;
+	MmWavePsdBuffer m_rxSignal;
 	Ptr<SpectrumValue> m_allSignals;
 	Ptr<const SpectrumValue> m_noise;
+	MmWavePsdBuffer m_sinr;			// SINR of the last chunk
 
 	Time m_lastChangeTime;
 
@@ -118,7 +118,12 @@ public:
 		std::map<uint16_t, SchedInfo> m_schedInfoMap;
 	};
 
-	virtual void SchedConfigInd (const struct SchedConfigIndParameters& params) = 0;
+	/**
+	 * Indicate the scheduling decision of a subframe. The parameters are a buffer the scheduler
+	 * reuses every subframe: the user can take params.m_sfAllocInfo by swapping it with a buffer
+	 * it no longer needs, which the scheduler clears and fills in a later subframe
+	 */
+	virtual void SchedConfigInd (struct SchedConfigIndParameters& params) = 0;
 private:
 };
 
@@ -46,88 +46,95 @@ namespace ns3 {
 
 
 
+/*
+ * @brief MI map of a modulation, with the constants of the lookup precomputed
+ */
+struct MiMapTable
+{
+  const double *mi;       // MI of the SINRs of the axis
+  double axisBegin;       // first SINR of the axis
+  double axisEnd;         // last SINR of the axis, the MI is 1 above it
+  double scalingCoeff;    // (size - 1) / (axisEnd - axisBegin), the axis is uniformly spaced
+  uint16_t size;
+};
+
+/*
+ * @brief MI maps of QPSK, 16-QAM and 64-QAM, indexed by MmWaveMiErrorModel::GetModulationIndex
+ */
+static const MiMapTable MiMapTables[MI_NUM_MODULATIONS] = {
+  {MI_map_qpsk, MI_map_qpsk_axis[0], MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1],
+   (MI_MAP_QPSK_SIZE - 1) / (MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1] - MI_map_qpsk_axis[0]), MI_MAP_QPSK_SIZE},
+  {MI_map_16qam, MI_map_16qam_axis[0], MI_map_16qam_axis[MI_MAP_16QAM_SIZE-1],
+   (MI_MAP_16QAM_SIZE - 1) / (MI_map_16qam_axis[MI_MAP_16QAM_SIZE-1] - MI_map_16qam_axis[0]), MI_MAP_16QAM_SIZE},
+  {MI_map_64qam, MI_map_64qam_axis[0], MI_map_64qam_axis[MI_MAP_64QAM_SIZE-1],
+   (MI_MAP_64QAM_SIZE - 1) / (MI_map_64qam_axis[MI_MAP_64QAM_SIZE-1] - MI_map_64qam_axis[0]), MI_MAP_64QAM_SIZE}
+};
+
+/*
+ * @brief MI of a chunk from the map of its modulation
+ */
+static inline double
+LookupMi (const MiMapTable &table, double sinrLin)
+{
+  if (sinrLin > table.axisEnd)
+    {
+      return 1;
+    }
+  // since the values of the axis are uniformly spaced, we have
+  // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
+  double sinrIndexDouble = (sinrLin - table.axisBegin) * table.scalingCoeff + 1;
+  uint32_t sinrIndex = std::max (0.0, std::floor (sinrIndexDouble));
+  NS_ASSERT_MSG (sinrIndex < table.size, "MI map out of data");
+  return table.mi[sinrIndex];
+}
+
+uint8_t
+MmWaveMiErrorModel::GetModulationIndex (uint8_t mcs)
+{
+  return (mcs <= MI_QPSK_MAX_ID) ? 0 : ((mcs <= MI_16QAM_MAX_ID) ? 1 : 2);
+}
+
 double 
 MmWaveMiErrorModel::Mib (const SpectrumValue& sinr, const std::vector<int>& map, uint8_t mcs)
 {
   NS_LOG_FUNCTION (sinr << &map << (uint32_t) mcs);
-  
-  double MI;
+
+  const MiMapTable &table = MiMapTables[GetModulationIndex (mcs)];
+  Values::const_iterator sinrBegin = sinr.ConstValuesBegin ();
   double MIsum = 0.0;
-  SpectrumValue sinrCopy = sinr;
-  
   for (uint32_t i = 0; i < map.size (); i++)
     {
-      double sinrLin = sinrCopy[map.at (i)];
-      if (mcs <= MI_QPSK_MAX_ID) // QPSK
-        {
+      MIsum += LookupMi (table, *(sinrBegin + map[i]));
+    }
+  double MI = MIsum / map.size ();
+  NS_LOG_LOGIC (" MCS = " << (uint16_t)mcs << ", MI = " << MI);
+  return MI;
+}
 
-          if (sinrLin > MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1])
-            {
-              MI = 1;
-            }
-          else 
-            { 
-              // since the values in MI_map_qpsk_axis are uniformly spaced, we have
-              // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
-              // the scaling coefficient is always the same, so we use a static const
-              // to speed up the calculation
-              static const double scalingCoeffQpsk = 
-                (MI_MAP_QPSK_SIZE - 1) / (MI_map_qpsk_axis[MI_MAP_QPSK_SIZE-1] - MI_map_qpsk_axis[0]);
-              double sinrIndexDouble = (sinrLin -  MI_map_qpsk_axis[0]) * scalingCoeffQpsk + 1;
-              uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
-              NS_ASSERT_MSG (sinrIndex < MI_MAP_QPSK_SIZE, "MI map out of data");
-              MI = MI_map_qpsk[sinrIndex];
-            }
-        }
-      else
+void
+MmWaveMiErrorModel::MibAllModulations (const SpectrumValue& sinr, const std::vector<int>& map, double mib[MI_NUM_MODULATIONS])
+{
+  NS_LOG_FUNCTION (sinr << &map);
+
+  // SINRs of the chunks of the TB, contiguous for the loops over the maps
+  static thread_local std::vector<double> chunkSinr;
+  chunkSinr.resize (map.size ());
+  Values::const_iterator sinrBegin = sinr.ConstValuesBegin ();
+  for (uint32_t i = 0; i < map.size (); i++)
+    {
+      chunkSinr[i] = *(sinrBegin + map[i]);
+    }
+  for (uint8_t m = 0; m < MI_NUM_MODULATIONS; m++)
+    {
+      const MiMapTable &table = MiMapTables[m];
+      double MIsum = 0.0;
+      for (uint32_t i = 0; i < chunkSinr.size (); i++)
         {
-          if (mcs > MI_QPSK_MAX_ID && mcs <= MI_16QAM_MAX_ID )	// 16-QAM
-            {
-              if (sinrLin > MI_map_16qam_axis[MI_MAP_16QAM_SIZE-1])
-                {
-                  MI = 1;
-                }
-              else 
-                {
-                  // since the values in MI_map_16QAM_axis are uniformly spaced, we have
-                  // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
-                  // the scaling coefficient is always the same, so we use a static const
-                  // to speed up the calculation
-                  static const double scalingCoeff16qam = 
-                    (MI_MAP_16QAM_SIZE - 1) / (MI_map_16qam_axis[MI_MAP_16QAM_SIZE-1] - MI_map_16qam_axis[0]);
-                  double sinrIndexDouble = (sinrLin -  MI_map_16qam_axis[0]) * scalingCoeff16qam + 1;
-                  uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
-                  NS_ASSERT_MSG (sinrIndex < MI_MAP_16QAM_SIZE, "MI map out of data");
-                  MI = MI_map_16qam[sinrIndex];
-                }
-            }
-          else // 64-QAM
-            {
-              if (sinrLin > MI_map_64qam_axis[MI_MAP_64QAM_SIZE-1])
-                {
-                  MI = 1;
-                }
-              else
-                {
-                  // since the values in MI_map_64QAM_axis are uniformly spaced, we have
-                  // index = ((sinrLin - value[0]) / (value[SIZE-1] - value[0])) * (SIZE-1)
-                  // the scaling coefficient is always the same, so we use a static const
-                  // to speed up the calculation
-                  static const double scalingCoeff64qam = 
-                    (MI_MAP_64QAM_SIZE - 1) / (MI_map_64qam_axis[MI_MAP_64QAM_SIZE-1] - MI_map_64qam_axis[0]);
-                  double sinrIndexDouble = (sinrLin -  MI_map_64qam_axis[0]) * scalingCoeff64qam + 1;
-                  uint32_t sinrIndex = std::max(0.0, std::floor (sinrIndexDouble));
-                  NS_ASSERT_MSG (sinrIndex < MI_MAP_64QAM_SIZE, "MI map out of data");
-                  MI = MI_map_64qam[sinrIndex];
-                }
-            }
+          MIsum += LookupMi (table, chunkSinr[i]);
         }
-      NS_LOG_LOGIC (" RB " << map.at (i) << "Minimum SNR = " << 10 * std::log10 (sinrLin) << " dB, " << sinrLin << " V, MCS = " << (uint16_t)mcs << ", MI = " << MI);
-      MIsum += MI;
+      mib[m] = MIsum / map.size ();
+      NS_LOG_LOGIC (" modulation " << (uint16_t)m << ", MI = " << mib[m]);
     }
-  MI = MIsum / map.size ();
-  NS_LOG_LOGIC (" MI = " << MI);
-  return MI;
 }
 
 
@@ -176,11 +183,19 @@ MmWaveMiErrorModel::MappingMiBler (double mib, uint8_t ecrId, uint32_t cbSize)
 }
 
 TbStats_t
-MmWaveMiErrorModel::GetTbDecodificationStats (const SpectrumValue& sinr, const std::vector<int>& map, uint32_t size, uint8_t mcs, MmWaveHarqProcessInfoList_t miHistory)
+MmWaveMiErrorModel::GetTbDecodificationStats (const SpectrumValue& sinr, const std::vector<int>& map, uint32_t size, uint8_t mcs, const MmWaveHarqProcessInfoList_t& miHistory)
 {
   NS_LOG_FUNCTION (sinr << &map << (uint32_t) size << (uint32_t) mcs);
 
   double tbMi = Mib(sinr, map, mcs);
+  return GetTbDecodificationStatsFromMib (tbMi, size, mcs, miHistory);
+}
+
+TbStats_t
+MmWaveMiErrorModel::GetTbDecodificationStatsFromMib (double tbMi, uint32_t size, uint8_t mcs, const MmWaveHarqProcessInfoList_t& miHistory)
+{
+  NS_LOG_FUNCTION (tbMi << (uint32_t) size << (uint32_t) mcs);
+
   double MI = 0.0;
   double Reff = 0.0;
   NS_ASSERT (mcs < 29);
@@ -51,6 +51,7 @@ namespace ns3 {
   const uint16_t MI_QPSK_BLER_MAX_ID = 12; // MI_QPSK_MAX_ID + 3 RETX
   const uint16_t MI_16QAM_BLER_MAX_ID = 22;
   const uint16_t MI_64QAM_BLER_MAX_ID = 37;
+  const uint16_t MI_NUM_MODULATIONS = 3; // QPSK, 16-QAM and 64-QAM
 
 struct TbStats_t
 {
@@ -328,6 +329,20 @@ public:
    * \return the mmib
    */
   static double Mib (const SpectrumValue& sinr, const std::vector<int>& map, uint8_t mcs);
+  /**
+   * \brief find the mmib of the specified TB for all the modulations at once, e.g. to evaluate
+   * several MCSs: the SINRs of the chunks are gathered once and each MI map is looked up in a
+   * single loop over them. The results are the same as those of Mib
+   * \param sinr the perceived sinrs in the whole bandwidth
+   * \param map the actives RBs for the TB
+   * \param mib the mmib for each modulation, indexed by GetModulationIndex
+   */
+  static void MibAllModulations (const SpectrumValue& sinr, const std::vector<int>& map, double mib[MI_NUM_MODULATIONS]);
+  /**
+   * \param mcs the MCS
+   * \return the index of the modulation of the MCS: 0 for QPSK, 1 for 16-QAM and 2 for 64-QAM
+   */
+  static uint8_t GetModulationIndex (uint8_t mcs);
   /** 
    * \brief map the mmib (mean mutual information per bit) for different MCS
    * \param mib mean mutual information per bit of a code-block
@@ -345,7 +360,16 @@ public:
    * \param mcs the MCS of the TB
    * \return the TB error rate and MI
    */
-  static TbStats_t GetTbDecodificationStats (const SpectrumValue& sinr, const std::vector<int>& map, uint32_t size, uint8_t mcs, MmWaveHarqProcessInfoList_t miHistory);
+  static TbStats_t GetTbDecodificationStats (const SpectrumValue& sinr, const std::vector<int>& map, uint32_t size, uint8_t mcs, const MmWaveHarqProcessInfoList_t& miHistory);
+
+  /**
+   * \brief run the error-model algorithm for the specified TB once its mmib is known
+   * \param tbMi the mmib of the TB, as returned by Mib for the modulation of the MCS
+   * \param size the size in bytes of the TB
+   * \param mcs the MCS of the TB
+   * \return the TB error rate and MI
+   */
+  static TbStats_t GetTbDecodificationStatsFromMib (double tbMi, uint32_t size, uint8_t mcs, const MmWaveHarqProcessInfoList_t& miHistory);
 
 
 //private:
@@ -33,7 +33,6 @@
 #include <vector>
 #include <list>
 #include <map>
-#include <deque>
 #include <ns3/object.h>
 #include <ns3/packet.h>
 #include <ns3/string.h>
@@ -302,9 +301,10 @@ struct SfAllocInfo
 	uint32_t m_numSymAlloc;  // number of allocated slots
 	uint32_t m_ulSymStart;		 // start of UL region
 	//std::vector <SlotAllocInfo::TddMode> m_tddPattern;
-	std::deque <SlotAllocInfo> m_dlSlotAllocInfo;
-	std::deque <SlotAllocInfo> m_ulSlotAllocInfo;
-	std::deque <SlotAllocInfo> m_slotAllocInfo;
+	// vectors, so that a cleared SfAllocInfo keeps its memory when reused in a later subframe
+	std::vector <SlotAllocInfo> m_dlSlotAllocInfo;
+	std::vector <SlotAllocInfo> m_ulSlotAllocInfo;
+	std::vector <SlotAllocInfo> m_slotAllocInfo;
 };
 
 
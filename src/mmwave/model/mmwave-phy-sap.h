@@ -49,7 +49,11 @@ public:
 
 	virtual void SendRachPreamble(uint8_t PreambleId, uint8_t Rnti) = 0;
 
-	virtual void SetDlSfAllocInfo (SfAllocInfo sfAllocInfo) = 0;
+	/**
+	 * Set the allocation of a subframe, by swapping it with the one the PHY stored for the same
+	 * subframe number in the previous frame, which is returned in sfAllocInfo
+	 */
+	virtual void SetDlSfAllocInfo (SfAllocInfo &sfAllocInfo) = 0;
 
 	virtual void SetUlSfAllocInfo (SfAllocInfo sfAllocInfo) = 0;
 };
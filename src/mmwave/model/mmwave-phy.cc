@@ -36,6 +36,7 @@
 #include "mmwave-mac-pdu-tag.h"
 #include "mmwave-mac-pdu-header.h"
 #include <sstream>
+#include <utility>
 #include <vector>
 
 namespace ns3{
@@ -56,7 +57,7 @@ public:
 
 	virtual void SendRachPreamble(uint8_t PreambleId, uint8_t Rnti);
 
-	virtual void SetDlSfAllocInfo (SfAllocInfo sfAllocInfo);
+	virtual void SetDlSfAllocInfo (SfAllocInfo &sfAllocInfo);
 
 	virtual void SetUlSfAllocInfo (SfAllocInfo sfAllocInfo);
 
@@ -89,7 +90,7 @@ MmWaveMemberPhySapProvider::SendRachPreamble(uint8_t PreambleId, uint8_t Rnti)
 }
 
 void
-MmWaveMemberPhySapProvider::SetDlSfAllocInfo (SfAllocInfo sfAllocInfo)
+MmWaveMemberPhySapProvider::SetDlSfAllocInfo (SfAllocInfo &sfAllocInfo)
 {
 	m_phy->SetDlSfAllocInfo (sfAllocInfo);
 }
@@ -319,13 +320,14 @@ MmWavePhy::GetSfAllocInfo (uint8_t subframeNum)
 }
 
 void
-MmWavePhy::SetDlSfAllocInfo (SfAllocInfo sfAllocInfo)
+MmWavePhy::SetDlSfAllocInfo (SfAllocInfo &sfAllocInfo)
 {
 	// get previously enqueued SfAllocInfo and set DL slot allocations
 	//SfAllocInfo &sf = m_sfAllocInfo[sfAllocInfo.m_sfnSf.m_sfNum];
 	// merge slot lists
 	//sf.m_dlSlotAllocInfo = sfAllocInfo.m_dlSlotAllocInfo;
-	m_sfAllocInfo[sfAllocInfo.m_sfnSf.m_sfNum] = sfAllocInfo;
+	// the allocation of the previous frame goes back to the caller, which reuses its memory
+	std::swap (m_sfAllocInfo[sfAllocInfo.m_sfnSf.m_sfNum], sfAllocInfo);
 	//m_sfAllocInfoUpdated = true;
 }
 
@@ -119,7 +119,7 @@ public:
 	void UpdateCurrentAllocationAndSchedule (uint32_t frame, uint32_t sf);
 
 	SfAllocInfo GetSfAllocInfo (uint8_t subframeNum);
-	void SetDlSfAllocInfo (SfAllocInfo sfAllocInfo);
+	void SetDlSfAllocInfo (SfAllocInfo &sfAllocInfo);
 	void SetUlSfAllocInfo (SfAllocInfo sfAllocInfo);
 
 	// Carlos modification
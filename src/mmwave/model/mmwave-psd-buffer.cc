@@ -0,0 +1,109 @@
+/*
+ * mmwave-psd-buffer.cc
+ *
+ *  PSD of the chunks of the band plan, allocated once and reused, with the
+ *  in-place and fused operations of the SINR and interference computations.
+ */
+
+#include "mmwave-psd-buffer.h"
+#include <ns3/assert.h>
+#include <algorithm>
+
+namespace ns3 {
+
+MmWavePsdBuffer::MmWavePsdBuffer ()
+{
+}
+
+void
+MmWavePsdBuffer::Reserve (Ptr<const SpectrumModel> model)
+{
+	if (m_psd == 0 || m_psd->GetSpectrumModelUid () != model->GetUid ())
+	{
+		m_psd = Create<SpectrumValue> (model);
+	}
+}
+
+bool
+MmWavePsdBuffer::IsEmpty () const
+{
+	return m_psd == 0;
+}
+
+const SpectrumValue&
+MmWavePsdBuffer::Get () const
+{
+	NS_ASSERT_MSG (m_psd != 0, "the PSD buffer is not allocated");
+	return *m_psd;
+}
+
+SpectrumValue&
+MmWavePsdBuffer::Get ()
+{
+	NS_ASSERT_MSG (m_psd != 0, "the PSD buffer is not allocated");
+	return *m_psd;
+}
+
+void
+MmWavePsdBuffer::Assign (const SpectrumValue &psd)
+{
+	Reserve (psd.GetSpectrumModel ());
+	std::copy (psd.ConstValuesBegin (), psd.ConstValuesEnd (), m_psd->ValuesBegin ());
+}
+
+void
+MmWavePsdBuffer::SetZero ()
+{
+	NS_ASSERT_MSG (m_psd != 0, "the PSD buffer is not allocated");
+	std::fill (m_psd->ValuesBegin (), m_psd->ValuesEnd (), 0.0);
+}
+
+void
+MmWavePsdBuffer::Add (const SpectrumValue &psd)
+{
+	NS_ASSERT_MSG (m_psd != 0 && m_psd->GetSpectrumModelUid () == psd.GetSpectrumModelUid (), "different spectrum models");
+	Values::const_iterator in = psd.ConstValuesBegin ();
+	for (Values::iterator out = m_psd->ValuesBegin (); out != m_psd->ValuesEnd (); ++out, ++in)
+	{
+		*out += *in;
+	}
+}
+
+void
+MmWavePsdBuffer::AddScaled (const SpectrumValue &psd, double factor)
+{
+	NS_ASSERT_MSG (m_psd != 0 && m_psd->GetSpectrumModelUid () == psd.GetSpectrumModelUid (), "different spectrum models");
+	Values::const_iterator in = psd.ConstValuesBegin ();
+	for (Values::iterator out = m_psd->ValuesBegin (); out != m_psd->ValuesEnd (); ++out, ++in)
+	{
+		*out += (*in)*factor;
+	}
+}
+
+void
+MmWavePsdBuffer::AssignDivided (const SpectrumValue &psd, double divisor)
+{
+	Reserve (psd.GetSpectrumModel ());
+	Values::const_iterator in = psd.ConstValuesBegin ();
+	for (Values::iterator out = m_psd->ValuesBegin (); out != m_psd->ValuesEnd (); ++out, ++in)
+	{
+		*out = (*in)/divisor;
+	}
+}
+
+void
+MmWavePsdBuffer::AssignSinr (const SpectrumValue &signal, const SpectrumValue &all, const SpectrumValue &noise)
+{
+	NS_ASSERT_MSG (signal.GetSpectrumModelUid () == all.GetSpectrumModelUid ()
+			&& signal.GetSpectrumModelUid () == noise.GetSpectrumModelUid (), "different spectrum models");
+	Reserve (signal.GetSpectrumModel ());
+	Values::const_iterator s = signal.ConstValuesBegin ();
+	Values::const_iterator a = all.ConstValuesBegin ();
+	Values::const_iterator n = noise.ConstValuesBegin ();
+	for (Values::iterator out = m_psd->ValuesBegin (); out != m_psd->ValuesEnd (); ++out, ++s, ++a, ++n)
+	{
+		*out = (*s)/(((*a) - (*s)) + (*n));
+	}
+}
+
+} // namespace ns3
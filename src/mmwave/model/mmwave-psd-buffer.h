@@ -0,0 +1,93 @@
+/*
+ * mmwave-psd-buffer.h
+ *
+ *  PSD of the chunks of the band plan, allocated once and reused, with the
+ *  in-place and fused operations of the SINR and interference computations.
+ */
+
+#ifndef MMWAVE_PSD_BUFFER_H_
+#define MMWAVE_PSD_BUFFER_H_
+
+#include <ns3/spectrum-value.h>
+#include <ns3/ptr.h>
+
+namespace ns3 {
+
+/**
+ * \brief PSD held in a SpectrumValue that is allocated for the first spectrum model it is used
+ * with and then reused, so the per-chunk computations of the PHY do not allocate. The mmWave
+ * band plan (MmWaveSpectrumValueHelper::GetSpectrumModel) is fixed when MmWavePhyMacCommon is
+ * configured, so the buffer is allocated once per owner.
+ *
+ * The operations are done value by value in the same order as the SpectrumValue operators,
+ * so their results are identical. Get returns the SpectrumValue, e.g. for the callbacks that
+ * take a const SpectrumValue&; it is overwritten by the next operation.
+ */
+class MmWavePsdBuffer
+{
+public:
+	MmWavePsdBuffer ();
+
+	/**
+	 * Allocate the buffer for a spectrum model, unless it is already allocated for it.
+	 * The values are undefined until they are set by an operation
+	 * @params the spectrum model
+	 */
+	void Reserve (Ptr<const SpectrumModel> model);
+
+	/**
+	 * @returns true if the buffer has not been allocated yet
+	 */
+	bool IsEmpty () const;
+
+	/**
+	 * @returns the PSD in the buffer
+	 */
+	const SpectrumValue& Get () const;
+
+	/**
+	 * @returns the PSD in the buffer, e.g. for the traces that take a SpectrumValue&
+	 */
+	SpectrumValue& Get ();
+
+	/**
+	 * this = psd
+	 */
+	void Assign (const SpectrumValue &psd);
+
+	/**
+	 * this = 0, the buffer must be allocated
+	 */
+	void SetZero ();
+
+	/**
+	 * this += psd
+	 */
+	void Add (const SpectrumValue &psd);
+
+	/**
+	 * this += psd*factor, without the temporary of psd*factor
+	 */
+	void AddScaled (const SpectrumValue &psd, double factor);
+
+	/**
+	 * this = psd/divisor
+	 */
+	void AssignDivided (const SpectrumValue &psd, double divisor);
+
+	/**
+	 * this = signal/(all - signal + noise), the SINR of a signal among all the received ones,
+	 * in one pass and without the temporaries of the interference and of the SINR
+	 * @params the PSD of the signal
+	 * @params the PSD of all the signals, including the one of interest
+	 * @params the PSD of the noise
+	 */
+	void AssignSinr (const SpectrumValue &signal, const SpectrumValue &all, const SpectrumValue &noise);
+
+private:
+	Ptr<SpectrumValue> m_psd;
+};
+
+} // namespace ns3
+
+#endif /* MMWAVE_PSD_BUFFER_H_ */
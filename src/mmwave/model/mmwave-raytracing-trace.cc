@@ -0,0 +1,358 @@
+/*
+ * mmwave-raytracing-trace.cc
+ *
+ *  Indexed ray-tracing trace file, read on demand and shared by all the
+ *  MmWaveChannelRaytracing instances that use the same file.
+ */
+
+#include "mmwave-raytracing-trace.h"
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <ns3/fatal-error.h>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveRaytracingTrace");
+
+const char MmWaveRaytracingTrace::MAGIC[8] = {'M','M','W','R','T','R','0','1'};
+
+static const uint32_t LINES_PER_RECORD = 8;
+static const size_t READ_CHUNK_SIZE = 1 << 20;
+
+RaytracingTraceRecord::RaytracingTraceRecord ()
+	: m_numPaths (0)
+{
+}
+
+/*
+ * @brief Traces opened so far, indexed by path
+ */
+static std::map<std::string, Ptr<MmWaveRaytracingTrace> > &
+GetTraceCache ()
+{
+	static std::map<std::string, Ptr<MmWaveRaytracingTrace> > cache;
+	return cache;
+}
+
+/*
+ * @brief Parse the comma separated values between begin and end, an invalid value is read as 0
+ */
+static doubleVector_t
+ParseTraceLine (const char *begin, const char *end)
+{
+	doubleVector_t values;
+	while (begin < end)
+	{
+		values.push_back (strtod (begin, 0));
+		const char *comma = (const char *) memchr (begin, ',', end - begin);
+		begin = comma ? comma + 1 : end;
+	}
+	return values;
+}
+
+Ptr<MmWaveRaytracingTrace>
+MmWaveRaytracingTrace::Open (std::string path)
+{
+	std::map<std::string, Ptr<MmWaveRaytracingTrace> > &cache = GetTraceCache ();
+	std::map<std::string, Ptr<MmWaveRaytracingTrace> >::iterator it = cache.find (path);
+	if (it != cache.end ())
+	{
+		return it->second;
+	}
+	Ptr<MmWaveRaytracingTrace> trace = Create<MmWaveRaytracingTrace> (path);
+	cache[path] = trace;
+	return trace;
+}
+
+void
+MmWaveRaytracingTrace::Clear ()
+{
+	GetTraceCache ().clear ();
+}
+
+MmWaveRaytracingTrace::MmWaveRaytracingTrace (std::string path)
+	: m_path (path),
+	  m_binary (false),
+	  m_fileSize (0)
+{
+	NS_LOG_FUNCTION (this << path);
+	m_binary = IsBinaryFile (path);
+	m_file.open (path.c_str (), std::ifstream::in | std::ifstream::binary);
+	if (!m_file.good ())
+	{
+		NS_FATAL_ERROR (path << " Raytracing file not found");
+	}
+	m_file.seekg (0, std::ios::end);
+	m_fileSize = m_file.tellg ();
+	m_file.seekg (0, std::ios::beg);
+	if (m_binary)
+	{
+		ReadBinaryIndex ();
+	}
+	else
+	{
+		BuildTextIndex ();
+	}
+	NS_LOG_INFO ("Raytracing trace " << path << " has " << m_offsets.size () << " records");
+}
+
+void
+MmWaveRaytracingTrace::BuildTextIndex ()
+{
+	// a record starts every LINES_PER_RECORD lines; lines are delimited as std::getline does
+	std::vector<char> buffer (READ_CHUNK_SIZE);
+	uint64_t position = 0;
+	uint64_t lineNum = 0;
+	bool lineStart = true;
+	while (m_file)
+	{
+		m_file.read (&buffer[0], buffer.size ());
+		std::streamsize readBytes = m_file.gcount ();
+		const char *c = &buffer[0];
+		const char *end = c + readBytes;
+		while (c < end)
+		{
+			if (lineStart)
+			{
+				if (lineNum % LINES_PER_RECORD == 0)
+				{
+					m_offsets.push_back (position + (c - &buffer[0]));
+				}
+				lineNum++;
+				lineStart = false;
+			}
+			const char *newLine = (const char *) memchr (c, '\n', end - c);
+			if (newLine == 0)
+			{
+				break;
+			}
+			c = newLine + 1;
+			lineStart = true;
+		}
+		position += readBytes;
+	}
+	m_file.clear ();
+}
+
+void
+MmWaveRaytracingTrace::ReadBinaryIndex ()
+{
+	uint32_t numRecords = 0;
+	m_file.seekg (sizeof (MAGIC));
+	m_file.read ((char *) &numRecords, sizeof (uint32_t));
+	m_offsets.resize (numRecords);
+	if (numRecords > 0)
+	{
+		m_file.read ((char *) &m_offsets[0], numRecords*sizeof (uint64_t));
+	}
+	if (!m_file.good ())
+	{
+		NS_FATAL_ERROR (m_path << " is not a valid binary raytracing trace");
+	}
+}
+
+uint32_t
+MmWaveRaytracingTrace::GetNumRecords () const
+{
+	return m_offsets.size ();
+}
+
+Ptr<RaytracingTraceRecord>
+MmWaveRaytracingTrace::ReadRecord (uint32_t index)
+{
+	NS_ASSERT_MSG (index < m_offsets.size (), "Record " << index << " requested, the trace has " << m_offsets.size ());
+	return m_binary ? ReadBinaryRecord (index) : ReadTextRecord (index);
+}
+
+Ptr<RaytracingTraceRecord>
+MmWaveRaytracingTrace::ReadTextRecord (uint32_t index)
+{
+	uint64_t begin = m_offsets[index];
+	uint64_t end = index + 1 < m_offsets.size () ? m_offsets[index + 1] : m_fileSize;
+	std::string text (end - begin, '\0');
+	m_file.seekg (begin);
+	m_file.read (&text[0], text.size ());
+	if (!m_file.good ())
+	{
+		NS_FATAL_ERROR ("Unable to read record " << index << " of " << m_path);
+	}
+
+	Ptr<RaytracingTraceRecord> record = Create<RaytracingTraceRecord> ();
+	doubleVector_t *rows[LINES_PER_RECORD - 1] = {&record->m_delay, &record->m_pathloss, &record->m_phase,
+			&record->m_aodElevation, &record->m_aodAzimuth, &record->m_aoaElevation, &record->m_aoaAzimuth};
+	const char *c = text.c_str ();
+	const char *textEnd = c + text.size ();
+	for (uint32_t line = 0; line < LINES_PER_RECORD && c < textEnd; line++)
+	{
+		const char *lineEnd = (const char *) memchr (c, '\n', textEnd - c);
+		if (lineEnd == 0)
+		{
+			lineEnd = textEnd;
+		}
+		doubleVector_t values = ParseTraceLine (c, lineEnd);
+		if (line == 0)
+		{
+			if (values.empty ())
+			{
+				NS_FATAL_ERROR (m_path << ":" << (uint64_t) index * LINES_PER_RECORD + 1 << ": record " << index
+				                << " has no number of paths");
+			}
+			record->m_numPaths = values[0];
+		}
+		else
+		{
+			rows[line - 1]->swap (values);
+		}
+		c = lineEnd + 1;
+	}
+	return record;
+}
+
+Ptr<RaytracingTraceRecord>
+MmWaveRaytracingTrace::ReadBinaryRecord (uint32_t index)
+{
+	Ptr<RaytracingTraceRecord> record = Create<RaytracingTraceRecord> ();
+	doubleVector_t *rows[LINES_PER_RECORD - 1] = {&record->m_delay, &record->m_pathloss, &record->m_phase,
+			&record->m_aodElevation, &record->m_aodAzimuth, &record->m_aoaElevation, &record->m_aoaAzimuth};
+	m_file.seekg (m_offsets[index]);
+	m_file.read ((char *) &record->m_numPaths, sizeof (double));
+	for (uint32_t row = 0; row < LINES_PER_RECORD - 1; row++)
+	{
+		uint32_t numValues = 0;
+		m_file.read ((char *) &numValues, sizeof (uint32_t));
+		rows[row]->resize (numValues);
+		if (numValues > 0)
+		{
+			m_file.read ((char *) &(*rows[row])[0], numValues*sizeof (double));
+		}
+	}
+	if (!m_file.good ())
+	{
+		NS_FATAL_ERROR ("Unable to read record " << index << " of " << m_path);
+	}
+	return record;
+}
+
+void
+MmWaveRaytracingTrace::WriteBinaryFile (std::string path)
+{
+	NS_LOG_FUNCTION (this << path);
+	NS_ASSERT_MSG (path != m_path, "The binary trace cannot overwrite its source " << m_path);
+	std::ofstream out (path.c_str (), std::ofstream::binary | std::ofstream::trunc);
+	NS_ASSERT_MSG (out.good (), "Unable to open " << path);
+
+	uint32_t numRecords = m_offsets.size ();
+	std::vector<uint64_t> offsets (numRecords, 0);
+	out.write (MAGIC, sizeof (MAGIC));
+	out.write ((const char *) &numRecords, sizeof (uint32_t));
+	if (numRecords > 0)
+	{
+		// placeholder, the offsets are known once the records are written
+		out.write ((const char *) &offsets[0], numRecords*sizeof (uint64_t));
+	}
+	for (uint32_t i = 0; i < numRecords; i++)
+	{
+		// records are streamed one by one
+		Ptr<RaytracingTraceRecord> record = ReadRecord (i);
+		const doubleVector_t *rows[LINES_PER_RECORD - 1] = {&record->m_delay, &record->m_pathloss, &record->m_phase,
+				&record->m_aodElevation, &record->m_aodAzimuth, &record->m_aoaElevation, &record->m_aoaAzimuth};
+		offsets[i] = out.tellp ();
+		out.write ((const char *) &record->m_numPaths, sizeof (double));
+		for (uint32_t row = 0; row < LINES_PER_RECORD - 1; row++)
+		{
+			uint32_t numValues = rows[row]->size ();
+			out.write ((const char *) &numValues, sizeof (uint32_t));
+			if (numValues > 0)
+			{
+				out.write ((const char *) &(*rows[row])[0], numValues*sizeof (double));
+			}
+		}
+	}
+	if (numRecords > 0)
+	{
+		out.seekp (sizeof (MAGIC) + sizeof (uint32_t));
+		out.write ((const char *) &offsets[0], numRecords*sizeof (uint64_t));
+	}
+	NS_ASSERT_MSG (out.good (), "Unable to write " << path);
+}
+
+bool
+MmWaveRaytracingTrace::IsBinaryFile (std::string path)
+{
+	std::ifstream in (path.c_str (), std::ifstream::binary);
+	NS_ASSERT_MSG (in.good (), path << " Raytracing file not found");
+	char header[sizeof (MAGIC)];
+	in.read (header, sizeof (header));
+	return in.gcount () == (std::streamsize) sizeof (header) && memcmp (header, MAGIC, sizeof (MAGIC)) == 0;
+}
+
+MmWaveRaytracingTraceReader::MmWaveRaytracingTraceReader (Ptr<MmWaveRaytracingTrace> trace, uint32_t window)
+	: m_trace (trace),
+	  m_window (window)
+{
+}
+
+uint32_t
+MmWaveRaytracingTraceReader::GetNumRecords () const
+{
+	return m_trace->GetNumRecords ();
+}
+
+Ptr<const RaytracingTraceRecord>
+MmWaveRaytracingTraceReader::GetRecord (uint32_t index)
+{
+	NS_ASSERT_MSG (index < m_trace->GetNumRecords (), "Record " << index << " requested, the trace has " << m_trace->GetNumRecords ());
+	std::map<uint32_t, Ptr<const RaytracingTraceRecord> >::iterator it = m_records.find (index);
+	if (it == m_records.end ())
+	{
+		Prefetch (index);
+		it = m_records.find (index);
+	}
+	Ptr<const RaytracingTraceRecord> record = it->second;
+
+	// evict the records out of the window
+	uint32_t first = index > m_window ? index - m_window : 0;
+	m_records.erase (m_records.begin (), m_records.lower_bound (first));
+	if ((uint64_t) index + m_window + 1 < m_trace->GetNumRecords ())
+	{
+		m_records.erase (m_records.lower_bound (index + m_window + 1), m_records.end ());
+	}
+	return record;
+}
+
+void
+MmWaveRaytracingTraceReader::Prefetch (uint32_t index)
+{
+	NS_LOG_FUNCTION (this << index);
+	uint32_t last = std::min<uint64_t> ((uint64_t) index + m_window + 1, m_trace->GetNumRecords ());
+	for (uint32_t i = index; i < last; i++)
+	{
+		if (m_records.find (i) == m_records.end ())
+		{
+			m_records[i] = m_trace->ReadRecord (i);
+		}
+	}
+}
+
+void
+MmWaveRaytracingTraceReader::SetPrefetchWindow (uint32_t window)
+{
+	m_window = window;
+}
+
+uint32_t
+MmWaveRaytracingTraceReader::GetPrefetchWindow () const
+{
+	return m_window;
+}
+
+uint32_t
+MmWaveRaytracingTraceReader::GetNumResidentRecords () const
+{
+	return m_records.size ();
+}
+
+} // namespace ns3
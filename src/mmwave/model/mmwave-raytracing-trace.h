@@ -0,0 +1,162 @@
+/*
+ * mmwave-raytracing-trace.h
+ *
+ *  Indexed ray-tracing trace file, read on demand and shared by all the
+ *  MmWaveChannelRaytracing instances that use the same file.
+ */
+
+#ifndef MMWAVE_RAYTRACING_TRACE_H_
+#define MMWAVE_RAYTRACING_TRACE_H_
+
+#include <ns3/simple-ref-count.h>
+#include <ns3/ptr.h>
+#include <stdint.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+typedef std::vector<double> doubleVector_t;
+
+/**
+ * One measurement point (PDP) of a ray-tracing trace
+ */
+struct RaytracingTraceRecord : public SimpleRefCount<RaytracingTraceRecord>
+{
+	double m_numPaths;					// number of multipath components
+	doubleVector_t m_delay;				// delay spread in ns
+	doubleVector_t m_pathloss;			// pathloss in dB
+	doubleVector_t m_phase;
+	doubleVector_t m_aodElevation;		// degree
+	doubleVector_t m_aodAzimuth;		// degree
+	doubleVector_t m_aoaElevation;		// degree
+	doubleVector_t m_aoaAzimuth;		// degree
+
+	RaytracingTraceRecord ();
+};
+
+/**
+ * \brief Ray-tracing trace with an offset index. Only the index is built when the file is opened;
+ * the records are read when requested, by the MmWaveRaytracingTraceReader of each channel, so long
+ * drive-test traces do not need to be resident in memory.
+ *
+ * Two file formats are accepted and told apart by their content:
+ *  - text: 8 lines per record (number of paths, delay, pathloss, phase, AoD elevation, AoD azimuth,
+ *    AoA elevation, AoA azimuth) with comma separated values. The index is built by scanning the line breaks.
+ *  - binary: the MAGIC string, the number of records as uint32_t, the uint64_t offset of every record,
+ *    and then the records: the number of paths as a double followed, for each of the 7 other rows,
+ *    by the number of values as uint32_t and the values as doubles, in host byte order.
+ *    The index is read from the header. Binary traces are created with WriteBinaryFile or with the
+ *    mmwave-raytracing-trace-converter program.
+ */
+class MmWaveRaytracingTrace : public SimpleRefCount<MmWaveRaytracingTrace>
+{
+public:
+	/**
+	 * Returns the trace stored in a file, indexing it only the first time the path is requested
+	 * @params the path of a text or binary trace file
+	 * @returns the shared trace
+	 */
+	static Ptr<MmWaveRaytracingTrace> Open (std::string path);
+
+	/**
+	 * Drops all the traces opened so far, the channels keep their references
+	 */
+	static void Clear ();
+
+	MmWaveRaytracingTrace (std::string path);
+
+	/**
+	 * @returns the number of records of the trace
+	 */
+	uint32_t GetNumRecords () const;
+
+	/**
+	 * Reads a record from the file
+	 * @params the index of the record
+	 * @returns the record
+	 */
+	Ptr<RaytracingTraceRecord> ReadRecord (uint32_t index);
+
+	/**
+	 * Write the trace in the binary format
+	 * @params the path of the output file
+	 */
+	void WriteBinaryFile (std::string path);
+
+	/**
+	 * @params the path of a trace file
+	 * @returns true if the file starts with the MAGIC string of the binary format
+	 */
+	static bool IsBinaryFile (std::string path);
+
+	static const char MAGIC[8]; // first bytes of a binary trace file.
+
+private:
+	void BuildTextIndex ();
+	void ReadBinaryIndex ();
+	Ptr<RaytracingTraceRecord> ReadTextRecord (uint32_t index);
+	Ptr<RaytracingTraceRecord> ReadBinaryRecord (uint32_t index);
+
+	std::string m_path;
+	bool m_binary;
+	std::ifstream m_file;
+	std::vector<uint64_t> m_offsets; // offset of the first byte of every record.
+	uint64_t m_fileSize;
+};
+
+/**
+ * \brief Records of a shared MmWaveRaytracingTrace kept in memory for one reader, in a window
+ * around the last record it requested. Each reader has its own window, so the readers of a trace
+ * do not evict each other's records.
+ */
+class MmWaveRaytracingTraceReader : public SimpleRefCount<MmWaveRaytracingTraceReader>
+{
+public:
+	/**
+	 * @params the trace
+	 * @params number of records kept before and after the last requested one, also the number of records read in advance
+	 */
+	MmWaveRaytracingTraceReader (Ptr<MmWaveRaytracingTrace> trace, uint32_t window);
+
+	/**
+	 * @returns the number of records of the trace
+	 */
+	uint32_t GetNumRecords () const;
+
+	/**
+	 * Returns a record, reading it and the following ones from the file if it is not in the window
+	 * @params the index of the record
+	 * @returns the record
+	 */
+	Ptr<const RaytracingTraceRecord> GetRecord (uint32_t index);
+
+	/**
+	 * Read in advance the records of the window around an index
+	 * @params the index of the record
+	 */
+	void Prefetch (uint32_t index);
+
+	/**
+	 * @params number of records kept before and after the last requested one, also the number of records read in advance
+	 */
+	void SetPrefetchWindow (uint32_t window);
+
+	uint32_t GetPrefetchWindow () const;
+
+	/**
+	 * @returns the number of records currently in memory
+	 */
+	uint32_t GetNumResidentRecords () const;
+
+private:
+	Ptr<MmWaveRaytracingTrace> m_trace;
+	uint32_t m_window;
+	std::map<uint32_t, Ptr<const RaytracingTraceRecord> > m_records; // records in memory, indexed by position in the trace.
+};
+
+} // namespace ns3
+
+#endif /* MMWAVE_RAYTRACING_TRACE_H_ */
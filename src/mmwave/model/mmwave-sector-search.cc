@@ -0,0 +1,285 @@
+/*
+ * mmwave-sector-search.cc
+ *
+ *  Search engine of the best pair of tx and rx sectors of a 3GPP channel
+ *  realization, used by MmWave3gppChannel::BeamSearchBeamforming.
+ */
+
+#include "mmwave-sector-search.h"
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveSectorSearch");
+
+/*
+ * @brief Order of the coarse (gain, pair index) candidates: descending gain, ties go to the lowest index
+ */
+static bool
+IsBetterCandidate (const std::pair<double, uint32_t> &a, const std::pair<double, uint32_t> &b)
+{
+	return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+MmWaveSectorSearch::MmWaveSectorSearch ()
+	: m_channel (0),
+	  m_numClusters (0),
+	  m_projectedTable (0)
+{
+}
+
+void
+MmWaveSectorSearch::SetChannel (const complex3DVector_t &channel, const doubleVector_t &delay, const SpectrumValue &txPsd,
+		double firstFrequency, double frequencySpacing)
+{
+	m_channel = &channel;
+	m_numClusters = delay.size ();
+	m_projectedTable = 0;
+	m_txProjection.clear ();
+
+	// gram matrix of the subband phasors of the clusters, over the subbands with power
+	uint32_t numBands = txPsd.GetSpectrumModel ()->GetNumBands ();
+	std::vector<double> frequencies;
+	for (uint32_t band = 0; band < numBands; band++)
+	{
+		if (txPsd[band] != 0)
+		{
+			frequencies.push_back (firstFrequency + band*frequencySpacing);
+		}
+	}
+	m_gram.assign (m_numClusters*m_numClusters, std::complex<double> (0,0));
+	if (frequencies.empty ())
+	{
+		return;
+	}
+	for (uint32_t n = 0; n < m_numClusters; n++)
+	{
+		m_gram[n*m_numClusters + n] = 1;
+		for (uint32_t m = n + 1; m < m_numClusters; m++)
+		{
+			double re = 0;
+			double im = 0;
+			for (uint32_t f = 0; f < frequencies.size (); f++)
+			{
+				double phase = 2*M_PI*frequencies[f]*(delay[n] - delay[m]);
+				re += cos (phase);
+				im += sin (phase);
+			}
+			std::complex<double> value (re/frequencies.size (), im/frequencies.size ());
+			m_gram[n*m_numClusters + m] = value;
+			m_gram[m*m_numClusters + n] = std::conj (value);
+		}
+	}
+}
+
+const complexVector_t&
+MmWaveSectorSearch::GetTxProjection (const MmWaveSteeringTable &tx, uint32_t txBeam)
+{
+	if (m_projectedTable != &tx)
+	{
+		m_projectedTable = &tx;
+		m_txProjection.assign (tx.GetNumBeams (), complexVector_t ());
+	}
+	complexVector_t &projection = m_txProjection[txBeam];
+	if (projection.empty ())
+	{
+		const complex3DVector_t &channel = *m_channel;
+		const complexVector_t &txW = tx.m_steering[txBeam];
+		projection.assign (channel.size ()*m_numClusters, std::complex<double> (0,0));
+		for (uint32_t rxIndex = 0; rxIndex < channel.size (); rxIndex++)
+		{
+			for (uint32_t txIndex = 0; txIndex < txW.size (); txIndex++)
+			{
+				const complexVector_t &h = channel[rxIndex][txIndex];
+				for (uint32_t cIndex = 0; cIndex < m_numClusters; cIndex++)
+				{
+					projection[rxIndex*m_numClusters+cIndex] += txW[txIndex]*h[cIndex];
+				}
+			}
+		}
+	}
+	return projection;
+}
+
+double
+MmWaveSectorSearch::GetPairGain (const MmWaveSteeringTable &tx, const MmWaveSteeringTable &rx, uint32_t txBeam, uint32_t rxBeam)
+{
+	const complexVector_t &projection = GetTxProjection (tx, txBeam);
+	const complexVector_t &rxW = rx.m_steering[rxBeam];
+	m_longTerm.assign (m_numClusters, std::complex<double> (0,0));
+	for (uint32_t rxIndex = 0; rxIndex < rxW.size (); rxIndex++)
+	{
+		std::complex<double> rxConj = std::conj (rxW[rxIndex]);
+		for (uint32_t cIndex = 0; cIndex < m_numClusters; cIndex++)
+		{
+			m_longTerm[cIndex] += rxConj*projection[rxIndex*m_numClusters+cIndex];
+		}
+	}
+	// a^H*G*a
+	double gain = 0;
+	for (uint32_t n = 0; n < m_numClusters; n++)
+	{
+		std::complex<double> row (0,0);
+		for (uint32_t m = 0; m < m_numClusters; m++)
+		{
+			row += m_gram[n*m_numClusters + m]*m_longTerm[m];
+		}
+		gain += (std::conj (m_longTerm[n])*row).real ();
+	}
+	return gain;
+}
+
+MmWaveSectorSearchResult
+MmWaveSectorSearch::Search (const MmWaveSteeringTable &tx, const MmWaveSteeringTable &rx)
+{
+	NS_ASSERT_MSG (m_channel != 0, "SetChannel has not been called");
+	const complex3DVector_t &channel = *m_channel;
+	uint32_t rxAntenna = channel.size ();
+	NS_ASSERT_MSG (rx.GetNumBeams () > 0 && rx.m_steering[0].size () == rxAntenna, "the rx table does not match the channel");
+	NS_ASSERT_MSG (tx.GetNumBeams () > 0 && tx.m_steering[0].size () == channel[0].size (), "the tx table does not match the channel");
+
+	// project the channel onto all the tx steering vectors at once, H[(u,n)][s]*W[s][t]
+	m_projectedTable = &tx;
+	m_txProjection.assign (tx.GetNumBeams (), complexVector_t (rxAntenna*m_numClusters, std::complex<double> (0,0)));
+	for (uint32_t rxIndex = 0; rxIndex < rxAntenna; rxIndex++)
+	{
+		for (uint32_t txIndex = 0; txIndex < channel[rxIndex].size (); txIndex++)
+		{
+			const complexVector_t &h = channel[rxIndex][txIndex];
+			for (uint32_t txBeam = 0; txBeam < tx.GetNumBeams (); txBeam++)
+			{
+				std::complex<double> txW = tx.m_steering[txBeam][txIndex];
+				std::complex<double> *projection = &m_txProjection[txBeam][rxIndex*m_numClusters];
+				for (uint32_t cIndex = 0; cIndex < m_numClusters; cIndex++)
+				{
+					projection[cIndex] += txW*h[cIndex];
+				}
+			}
+		}
+	}
+
+	MmWaveSectorSearchResult result;
+	result.m_txBeam = 0;
+	result.m_rxBeam = 0;
+	result.m_gain = 0;
+	result.m_numPairs = 0;
+	for (uint32_t txBeam = 0; txBeam < tx.GetNumBeams (); txBeam++)
+	{
+		for (uint32_t rxBeam = 0; rxBeam < rx.GetNumBeams (); rxBeam++)
+		{
+			double gain = GetPairGain (tx, rx, txBeam, rxBeam);
+			result.m_numPairs++;
+			if (result.m_gain < gain)
+			{
+				result.m_gain = gain;
+				result.m_txBeam = txBeam;
+				result.m_rxBeam = rxBeam;
+			}
+		}
+	}
+	return result;
+}
+
+void
+MmWaveSectorSearch::GetNeighbours (const MmWaveSteeringTable &table, uint32_t beam, std::vector<uint32_t> &neighbours) const
+{
+	int numElevations = table.m_elevation.size ();
+	int numSectors = table.m_numSectors;
+	int elevation = beam/numSectors;
+	int sector = beam%numSectors;
+	for (int e = std::max (elevation - 1, 0); e <= std::min (elevation + 1, numElevations - 1); e++)
+	{
+		for (int s = std::max (sector - 1, 0); s <= std::min (sector + 1, numSectors - 1); s++)
+		{
+			neighbours.push_back (e*numSectors + s);
+		}
+	}
+}
+
+MmWaveSectorSearchResult
+MmWaveSectorSearch::SearchHierarchical (const MmWaveSteeringTable &tx, const MmWaveSteeringTable &rx,
+		uint32_t numCandidates)
+{
+	NS_ASSERT_MSG (m_channel != 0, "SetChannel has not been called");
+	NS_ASSERT_MSG (numCandidates > 0, "at least one candidate must be refined");
+
+	// coarse grid: every other elevation and sector
+	std::vector<uint32_t> txCoarse;
+	std::vector<uint32_t> rxCoarse;
+	for (uint32_t beam = 0; beam < tx.GetNumBeams (); beam++)
+	{
+		if ((beam/tx.m_numSectors)%2 == 0 && (beam%tx.m_numSectors)%2 == 0)
+		{
+			txCoarse.push_back (beam);
+		}
+	}
+	for (uint32_t beam = 0; beam < rx.GetNumBeams (); beam++)
+	{
+		if ((beam/rx.m_numSectors)%2 == 0 && (beam%rx.m_numSectors)%2 == 0)
+		{
+			rxCoarse.push_back (beam);
+		}
+	}
+
+	MmWaveSectorSearchResult result;
+	result.m_txBeam = 0;
+	result.m_rxBeam = 0;
+	result.m_gain = 0;
+	result.m_numPairs = 0;
+
+	// evaluated pairs, indexed by txBeam*numRxBeams + rxBeam
+	uint32_t numRxBeams = rx.GetNumBeams ();
+	std::map<uint32_t, double> evaluated;
+	std::vector<std::pair<double, uint32_t> > coarse;
+	for (uint32_t i = 0; i < txCoarse.size (); i++)
+	{
+		for (uint32_t j = 0; j < rxCoarse.size (); j++)
+		{
+			uint32_t pair = txCoarse[i]*numRxBeams + rxCoarse[j];
+			double gain = GetPairGain (tx, rx, txCoarse[i], rxCoarse[j]);
+			evaluated[pair] = gain;
+			coarse.push_back (std::make_pair (gain, pair));
+		}
+	}
+	numCandidates = std::min<uint32_t> (numCandidates, coarse.size ());
+	std::partial_sort (coarse.begin (), coarse.begin () + numCandidates, coarse.end (), IsBetterCandidate);
+
+	// refine around the best coarse pairs
+	for (uint32_t c = 0; c < numCandidates; c++)
+	{
+		std::vector<uint32_t> txNeighbours;
+		std::vector<uint32_t> rxNeighbours;
+		GetNeighbours (tx, coarse[c].second/numRxBeams, txNeighbours);
+		GetNeighbours (rx, coarse[c].second%numRxBeams, rxNeighbours);
+		for (uint32_t i = 0; i < txNeighbours.size (); i++)
+		{
+			for (uint32_t j = 0; j < rxNeighbours.size (); j++)
+			{
+				uint32_t pair = txNeighbours[i]*numRxBeams + rxNeighbours[j];
+				if (evaluated.find (pair) == evaluated.end ())
+				{
+					evaluated[pair] = GetPairGain (tx, rx, txNeighbours[i], rxNeighbours[j]);
+				}
+			}
+		}
+	}
+
+	for (std::map<uint32_t, double>::iterator it = evaluated.begin (); it != evaluated.end (); it++)
+	{
+		if (result.m_gain < it->second)
+		{
+			result.m_gain = it->second;
+			result.m_txBeam = it->first/numRxBeams;
+			result.m_rxBeam = it->first%numRxBeams;
+		}
+	}
+	result.m_numPairs = evaluated.size ();
+	NS_LOG_LOGIC ("Hierarchical search evaluated " << result.m_numPairs << " of " << tx.GetNumBeams ()*numRxBeams << " pairs");
+	return result;
+}
+
+} // namespace ns3
@@ -0,0 +1,110 @@
+/*
+ * mmwave-sector-search.h
+ *
+ *  Search engine of the best pair of tx and rx sectors of a 3GPP channel
+ *  realization, used by MmWave3gppChannel::BeamSearchBeamforming.
+ */
+
+#ifndef MMWAVE_SECTOR_SEARCH_H_
+#define MMWAVE_SECTOR_SEARCH_H_
+
+#include <ns3/spectrum-value.h>
+#include <ns3/antenna-array-model.h>
+#include <complex>
+#include <vector>
+
+namespace ns3 {
+
+typedef std::vector<double> doubleVector_t;
+typedef std::vector< std::complex<double> > complexVector_t;
+typedef std::vector<complexVector_t> complex2DVector_t;
+typedef std::vector<complex2DVector_t> complex3DVector_t;
+
+/**
+ * Result of a sector search
+ */
+struct MmWaveSectorSearchResult
+{
+	uint32_t m_txBeam;		// beam index in the tx steering table
+	uint32_t m_rxBeam;		// beam index in the rx steering table
+	double m_gain;			// beamforming gain averaged over the subbands
+	uint32_t m_numPairs;	// number of sector pairs evaluated
+};
+
+/**
+ * \brief Finds the pair of tx and rx sectors with the highest beamforming gain averaged over
+ * the active subbands of a PSD.
+ *
+ * The steering vectors are computed once per array geometry (AntennaArrayModel::GetSteeringTable).
+ * The channel H[rx][tx][cluster] is projected onto all the tx steering vectors with a single
+ * matrix product, and then onto the rx ones, which gives the long term component a of every
+ * sector pair.
+ * The average gain over the subbands, mean_b |sum_n a_n*exp(-j*2*pi*f_b*tau_n)|^2, is the
+ * quadratic form a^H*G*a, where G only depends on the cluster delays and the subbands, so it
+ * is computed once per channel instead of evaluating every subband of every pair.
+ *
+ * The hierarchical search first evaluates a coarse grid (every other elevation and sector) and
+ * then the full resolution neighbours of its best candidates only.
+ */
+class MmWaveSectorSearch
+{
+public:
+	MmWaveSectorSearch ();
+
+	/**
+	 * Set the channel realization to be searched
+	 * @params the channel matrix H[rx][tx][cluster]
+	 * @params the cluster delays in s
+	 * @params the PSD whose non-zero subbands are averaged
+	 * @params the frequency of the first subband in Hz
+	 * @params the spacing between subbands in Hz
+	 */
+	void SetChannel (const complex3DVector_t &channel, const doubleVector_t &delay, const SpectrumValue &txPsd,
+			double firstFrequency, double frequencySpacing);
+
+	/**
+	 * Search every pair of sectors, ties go to the lowest tx and then rx beam index
+	 * @params the tx steering table
+	 * @params the rx steering table
+	 * @returns the best pair
+	 */
+	MmWaveSectorSearchResult Search (const MmWaveSteeringTable &tx, const MmWaveSteeringTable &rx);
+
+	/**
+	 * Search the coarse grid, then the neighbours of its best pairs
+	 * @params the tx steering table
+	 * @params the rx steering table
+	 * @params the number of coarse pairs refined
+	 * @returns the best pair evaluated
+	 */
+	MmWaveSectorSearchResult SearchHierarchical (const MmWaveSteeringTable &tx, const MmWaveSteeringTable &rx,
+			uint32_t numCandidates);
+
+private:
+	/**
+	 * Project the channel onto a tx steering vector, if it has not been done yet
+	 * @returns the projection, [rx element*numClusters + cluster]
+	 */
+	const complexVector_t& GetTxProjection (const MmWaveSteeringTable &tx, uint32_t txBeam);
+
+	/**
+	 * @returns the average gain of a pair of sectors
+	 */
+	double GetPairGain (const MmWaveSteeringTable &tx, const MmWaveSteeringTable &rx, uint32_t txBeam, uint32_t rxBeam);
+
+	/**
+	 * Append the beams of the grid adjacent to a beam, including itself
+	 */
+	void GetNeighbours (const MmWaveSteeringTable &table, uint32_t beam, std::vector<uint32_t> &neighbours) const;
+
+	const complex3DVector_t *m_channel;
+	uint32_t m_numClusters;
+	complexVector_t m_gram; // G[n*numClusters + m] = mean_b exp(j*2*pi*f_b*(tau_n-tau_m)).
+	const MmWaveSteeringTable *m_projectedTable; // tx table of m_txProjection.
+	complex2DVector_t m_txProjection; // projection onto every tx beam, empty if not computed yet.
+	complexVector_t m_longTerm; // scratch buffer.
+};
+
+} // namespace ns3
+
+#endif /* MMWAVE_SECTOR_SEARCH_H_ */
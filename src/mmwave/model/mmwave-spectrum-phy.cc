@@ -499,9 +499,10 @@ MmWaveSpectrumPhy::EndRxData ()
 {
 	m_interferenceData->EndRx();
 
-	double sinrAvg = Sum(m_sinrPerceived)/(m_sinrPerceived.GetSpectrumModel()->GetNumBands());
+	const SpectrumValue &sinrPerceived = m_sinrPerceived.Get ();
+	double sinrAvg = Sum(sinrPerceived)/(sinrPerceived.GetSpectrumModel()->GetNumBands());
 	double sinrMin = 99999999999;
-	for (Values::const_iterator it = m_sinrPerceived.ConstValuesBegin (); it != m_sinrPerceived.ConstValuesEnd (); it++)
+	for (Values::const_iterator it = sinrPerceived.ConstValuesBegin (); it != sinrPerceived.ConstValuesEnd (); it++)
 	{
 		if (*it < sinrMin)
 		{
@@ -537,7 +538,7 @@ MmWaveSpectrumPhy::EndRxData ()
 				}
 			}
 
-			TbStats_t tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (m_sinrPerceived,
+			TbStats_t tbStats = MmWaveMiErrorModel::GetTbDecodificationStats (sinrPerceived,
 					itTb->second.rbBitmap, itTb->second.size, itTb->second.mcs, harqInfoList);
 			itTb->second.tbler = tbStats.tbler;
 			itTb->second.mi = tbStats.miTotal;
@@ -880,7 +881,7 @@ void
 MmWaveSpectrumPhy::UpdateSinrPerceived (const SpectrumValue& sinr)
 {
 	NS_LOG_FUNCTION (this << sinr);
-	m_sinrPerceived = sinr;
+	m_sinrPerceived.Assign (sinr);
 }
 
 void
@@ -48,6 +48,7 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/mmwave-beamforming.h"
 #include "mmwave-interference.h"
+#include "mmwave-psd-buffer.h"
 #include "mmwave-control-messages.h"
 #include "mmwave-harq-phy.h"
 
@@ -181,7 +182,7 @@ private:
 	TracedCallback<RxPacketTraceParams> m_rxPacketTraceEnb;
 	TracedCallback<RxPacketTraceParams> m_rxPacketTraceUe;
 
-	SpectrumValue m_sinrPerceived;
+	MmWavePsdBuffer m_sinrPerceived;	// SINR of the current reception
 
 	ExpectedTbMap_t m_expectedTbs;
 
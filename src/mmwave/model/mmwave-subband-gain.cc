@@ -0,0 +1,278 @@
+/*
+ * mmwave-subband-gain.cc
+ *
+ *  Kernel that evaluates the frequency selective gain of a set of
+ *  clusters (or ray-tracing paths) over all the subbands of a SpectrumValue.
+ */
+
+#include "mmwave-subband-gain.h"
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MmWaveSubbandGain");
+
+const uint32_t MmWaveSubbandGain::ANCHOR_PERIOD;
+
+/*
+ * @brief Adds the phasors of the clusters to the sums and rotates them to the next subband
+ * @params the real and imaginary parts of the phasors, padded to a multiple of the SIMD width
+ * @params the real and imaginary parts of the rotations
+ * @params the number of padded clusters
+ * @params the sums, real and imaginary parts
+ */
+typedef void (*RotateFunction) (double *sRe, double *sIm, const double *rRe, const double *rIm, uint32_t padded,
+		double &sumRe, double &sumIm);
+
+static void
+RotateScalar (double *sRe, double *sIm, const double *rRe, const double *rIm, uint32_t padded,
+		double &sumRe, double &sumIm)
+{
+	sumRe = 0;
+	sumIm = 0;
+	for (uint32_t cIndex = 0; cIndex < padded; cIndex++)
+	{
+		double re = sRe[cIndex];
+		double im = sIm[cIndex];
+		sumRe += re;
+		sumIm += im;
+		sRe[cIndex] = re*rRe[cIndex] - im*rIm[cIndex];
+		sIm[cIndex] = re*rIm[cIndex] + im*rRe[cIndex];
+	}
+}
+
+#if defined(__SSE2__)
+static void
+RotateSse2 (double *sRe, double *sIm, const double *rRe, const double *rIm, uint32_t padded,
+		double &sumRe, double &sumIm)
+{
+	__m128d accRe = _mm_setzero_pd ();
+	__m128d accIm = _mm_setzero_pd ();
+	for (uint32_t cIndex = 0; cIndex < padded; cIndex += 2)
+	{
+		__m128d re = _mm_loadu_pd (sRe + cIndex);
+		__m128d im = _mm_loadu_pd (sIm + cIndex);
+		__m128d rotRe = _mm_loadu_pd (rRe + cIndex);
+		__m128d rotIm = _mm_loadu_pd (rIm + cIndex);
+		accRe = _mm_add_pd (accRe, re);
+		accIm = _mm_add_pd (accIm, im);
+		_mm_storeu_pd (sRe + cIndex, _mm_sub_pd (_mm_mul_pd (re, rotRe), _mm_mul_pd (im, rotIm)));
+		_mm_storeu_pd (sIm + cIndex, _mm_add_pd (_mm_mul_pd (re, rotIm), _mm_mul_pd (im, rotRe)));
+	}
+	double lanes[2];
+	_mm_storeu_pd (lanes, accRe);
+	sumRe = lanes[0] + lanes[1];
+	_mm_storeu_pd (lanes, accIm);
+	sumIm = lanes[0] + lanes[1];
+}
+#endif
+
+#if defined(__AVX__)
+static void
+RotateAvx (double *sRe, double *sIm, const double *rRe, const double *rIm, uint32_t padded,
+		double &sumRe, double &sumIm)
+{
+	__m256d accRe = _mm256_setzero_pd ();
+	__m256d accIm = _mm256_setzero_pd ();
+	for (uint32_t cIndex = 0; cIndex < padded; cIndex += 4)
+	{
+		__m256d re = _mm256_loadu_pd (sRe + cIndex);
+		__m256d im = _mm256_loadu_pd (sIm + cIndex);
+		__m256d rotRe = _mm256_loadu_pd (rRe + cIndex);
+		__m256d rotIm = _mm256_loadu_pd (rIm + cIndex);
+		accRe = _mm256_add_pd (accRe, re);
+		accIm = _mm256_add_pd (accIm, im);
+		_mm256_storeu_pd (sRe + cIndex, _mm256_sub_pd (_mm256_mul_pd (re, rotRe), _mm256_mul_pd (im, rotIm)));
+		_mm256_storeu_pd (sIm + cIndex, _mm256_add_pd (_mm256_mul_pd (re, rotIm), _mm256_mul_pd (im, rotRe)));
+	}
+	double lanes[4];
+	_mm256_storeu_pd (lanes, accRe);
+	sumRe = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	_mm256_storeu_pd (lanes, accIm);
+	sumIm = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+#endif
+
+MmWaveSubbandGain::MmWaveSubbandGain ()
+{
+}
+
+MmWaveSubbandGain&
+MmWaveSubbandGain::GetThreadKernel ()
+{
+	static thread_local MmWaveSubbandGain kernel;
+	return kernel;
+}
+
+bool
+MmWaveSubbandGain::IsIsaAvailable (Isa isa)
+{
+	switch (isa)
+	{
+	case ISA_SCALAR:
+		return true;
+	case ISA_SSE2:
+#if defined(__SSE2__)
+		return true;
+#else
+		return false;
+#endif
+	case ISA_AVX:
+#if defined(__AVX__)
+		return true;
+#else
+		return false;
+#endif
+	}
+	return false;
+}
+
+MmWaveSubbandGain::Isa
+MmWaveSubbandGain::GetDefaultIsa ()
+{
+#if defined(__AVX__)
+	return ISA_AVX;
+#elif defined(__SSE2__)
+	return ISA_SSE2;
+#else
+	return ISA_SCALAR;
+#endif
+}
+
+void
+MmWaveSubbandGain::Clear ()
+{
+	m_coefRe.clear ();
+	m_coefIm.clear ();
+	m_delay.clear ();
+}
+
+void
+MmWaveSubbandGain::Reserve (uint32_t numClusters)
+{
+	m_coefRe.reserve (numClusters);
+	m_coefIm.reserve (numClusters);
+	m_delay.reserve (numClusters);
+}
+
+void
+MmWaveSubbandGain::AddCluster (std::complex<double> coefficient, double delay)
+{
+	m_coefRe.push_back (coefficient.real ());
+	m_coefIm.push_back (coefficient.imag ());
+	m_delay.push_back (delay);
+}
+
+uint32_t
+MmWaveSubbandGain::GetNumClusters () const
+{
+	return m_delay.size ();
+}
+
+void
+MmWaveSubbandGain::Apply (double firstFrequency, double frequencySpacing, SpectrumValue &psd) const
+{
+	uint32_t numBands = psd.GetSpectrumModel ()->GetNumBands ();
+	if (numBands == 0)
+	{
+		return;
+	}
+	m_gain.resize (numBands);
+	Evaluate (firstFrequency, frequencySpacing, numBands, &m_gain[0]);
+	Scale (&m_gain[0], psd);
+}
+
+void
+MmWaveSubbandGain::Scale (const double *gain, SpectrumValue &psd)
+{
+	uint32_t iSubband = 0;
+	for (Values::iterator vit = psd.ValuesBegin (); vit != psd.ValuesEnd (); ++vit, ++iSubband)
+	{
+		if ((*vit) != 0.00)
+		{
+			*vit = (*vit)*gain[iSubband];
+		}
+	}
+}
+
+void
+MmWaveSubbandGain::Evaluate (double firstFrequency, double frequencySpacing, uint32_t numBands, double *gain) const
+{
+	Evaluate (firstFrequency, frequencySpacing, numBands, gain, GetDefaultIsa ());
+}
+
+void
+MmWaveSubbandGain::Evaluate (double firstFrequency, double frequencySpacing, uint32_t numBands, double *gain, Isa isa) const
+{
+	NS_LOG_FUNCTION (this << firstFrequency << frequencySpacing << numBands << isa);
+	NS_ASSERT_MSG (IsIsaAvailable (isa), "Instruction set " << isa << " not targeted by the compiler");
+
+	RotateFunction rotate = RotateScalar;
+	uint32_t simdWidth = 1;
+#if defined(__SSE2__)
+	if (isa == ISA_SSE2)
+	{
+		rotate = RotateSse2;
+		simdWidth = 2;
+	}
+#endif
+#if defined(__AVX__)
+	if (isa == ISA_AVX)
+	{
+		rotate = RotateAvx;
+		simdWidth = 4;
+	}
+#endif
+
+	uint32_t numClusters = m_delay.size ();
+	uint32_t padded = (numClusters + simdWidth - 1)/simdWidth*simdWidth;
+
+	// the padding clusters have a null state and a unit rotation, so they never contribute.
+	m_stateRe.assign (padded, 0.0);
+	m_stateIm.assign (padded, 0.0);
+	m_rotRe.assign (padded, 1.0);
+	m_rotIm.assign (padded, 0.0);
+	for (uint32_t cIndex = 0; cIndex < numClusters; cIndex++)
+	{
+		double step = -2*M_PI*frequencySpacing*m_delay[cIndex];
+		m_rotRe[cIndex] = std::cos (step);
+		m_rotIm[cIndex] = std::sin (step);
+	}
+
+	double *sRe = padded ? &m_stateRe[0] : 0;
+	double *sIm = padded ? &m_stateIm[0] : 0;
+	const double *rRe = padded ? &m_rotRe[0] : 0;
+	const double *rIm = padded ? &m_rotIm[0] : 0;
+
+	for (uint32_t blockStart = 0; blockStart < numBands; blockStart += ANCHOR_PERIOD)
+	{
+		// exact phasors at the first subband of the block
+		double fsb = firstFrequency + frequencySpacing*blockStart;
+		for (uint32_t cIndex = 0; cIndex < numClusters; cIndex++)
+		{
+			double phase = -2*M_PI*fsb*m_delay[cIndex];
+			double c = std::cos (phase);
+			double s = std::sin (phase);
+			sRe[cIndex] = m_coefRe[cIndex]*c - m_coefIm[cIndex]*s;
+			sIm[cIndex] = m_coefRe[cIndex]*s + m_coefIm[cIndex]*c;
+		}
+
+		uint32_t blockEnd = std::min (numBands, blockStart + ANCHOR_PERIOD);
+		for (uint32_t iSubband = blockStart; iSubband < blockEnd; iSubband++)
+		{
+			double sumRe;
+			double sumIm;
+			rotate (sRe, sIm, rRe, rIm, padded, sumRe, sumIm);
+			gain[iSubband] = sumRe*sumRe + sumIm*sumIm;
+		}
+	}
+}
+
+} // namespace ns3
@@ -0,0 +1,137 @@
+/*
+ * mmwave-subband-gain.h
+ *
+ *  Kernel that evaluates the frequency selective gain of a set of
+ *  clusters (or ray-tracing paths) over all the subbands of a SpectrumValue.
+ */
+
+#ifndef MMWAVE_SUBBAND_GAIN_H_
+#define MMWAVE_SUBBAND_GAIN_H_
+
+#include <ns3/spectrum-value.h>
+#include <complex>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Computes |sum_n a_n*exp(-j*2*pi*f_b*tau_n)|^2 on the equally spaced subbands
+ * f_b = f_0 + b*df of a SpectrumValue, where a_n is the complex coefficient of cluster n
+ * (long term component, Doppler and path power already included) and tau_n its delay.
+ *
+ * The clusters are stored in structure-of-arrays form. The per-subband phasors are generated
+ * with the phase-rotation recurrence s_n(b+1) = s_n(b)*exp(-j*2*pi*df*tau_n), so only a few
+ * transcendental functions per cluster are needed instead of one per cluster and subband.
+ * The recurrence is re-anchored every ANCHOR_PERIOD subbands to bound the rounding drift.
+ * The clusters are processed with AVX or SSE2 when the compiler targets them, with a scalar
+ * fallback otherwise.
+ *
+ * The buffers of a kernel are reused by its calls, so a kernel must not be used by two threads
+ * at once: the channels use the kernel of their thread, GetThreadKernel.
+ */
+class MmWaveSubbandGain
+{
+public:
+	/**
+	 * Instruction sets of the rotation of the phasors
+	 */
+	enum Isa
+	{
+		ISA_SCALAR,
+		ISA_SSE2,
+		ISA_AVX
+	};
+
+	MmWaveSubbandGain ();
+
+	/**
+	 * @returns the kernel of the calling thread
+	 */
+	static MmWaveSubbandGain& GetThreadKernel ();
+
+	/**
+	 * @params an instruction set
+	 * @returns true if the compiler targets it, so that Evaluate can use it
+	 */
+	static bool IsIsaAvailable (Isa isa);
+
+	/**
+	 * @returns the widest instruction set available, used by Apply and Evaluate
+	 */
+	static Isa GetDefaultIsa ();
+
+	/**
+	 * Remove all the clusters, keeping the allocated memory
+	 */
+	void Clear ();
+
+	/**
+	 * Reserve memory for a number of clusters
+	 * @params the number of clusters
+	 */
+	void Reserve (uint32_t numClusters);
+
+	/**
+	 * Add a cluster to the kernel
+	 * @params the complex coefficient of the cluster
+	 * @params the delay of the cluster in s
+	 */
+	void AddCluster (std::complex<double> coefficient, double delay);
+
+	/**
+	 * @returns the number of clusters added since the last Clear ()
+	 */
+	uint32_t GetNumClusters () const;
+
+	/**
+	 * Scale every non-zero value of the PSD by the gain of its subband
+	 * @params the frequency of the first subband in Hz
+	 * @params the spacing between subbands in Hz
+	 * @params the PSD to be scaled
+	 */
+	void Apply (double firstFrequency, double frequencySpacing, SpectrumValue &psd) const;
+
+	/**
+	 * Compute the gain of a number of subbands
+	 * @params the frequency of the first subband in Hz
+	 * @params the spacing between subbands in Hz
+	 * @params the number of subbands
+	 * @params the output buffer, it must have room for numBands values
+	 */
+	void Evaluate (double firstFrequency, double frequencySpacing, uint32_t numBands, double *gain) const;
+
+	/**
+	 * Compute the gain of a number of subbands with a given instruction set
+	 * @params the frequency of the first subband in Hz
+	 * @params the spacing between subbands in Hz
+	 * @params the number of subbands
+	 * @params the output buffer, it must have room for numBands values
+	 * @params the instruction set, which must be available
+	 */
+	void Evaluate (double firstFrequency, double frequencySpacing, uint32_t numBands, double *gain, Isa isa) const;
+
+	/**
+	 * Scale every non-zero value of the PSD by a gain, e.g. computed earlier with Evaluate
+	 * @params the gain of each subband of the PSD
+	 * @params the PSD to be scaled
+	 */
+	static void Scale (const double *gain, SpectrumValue &psd);
+
+	static const uint32_t ANCHOR_PERIOD = 64; // number of subbands between two exact evaluations of the phasors.
+
+private:
+	std::vector<double> m_coefRe; // real part of the cluster coefficients.
+	std::vector<double> m_coefIm; // imaginary part of the cluster coefficients.
+	std::vector<double> m_delay; // cluster delays.
+
+	// scratch buffers, padded to a multiple of the SIMD width.
+	mutable std::vector<double> m_stateRe;
+	mutable std::vector<double> m_stateIm;
+	mutable std::vector<double> m_rotRe;
+	mutable std::vector<double> m_rotIm;
+	mutable std::vector<double> m_gain;
+};
+
+} // namespace ns3
+
+#endif /* MMWAVE_SUBBAND_GAIN_H_ */
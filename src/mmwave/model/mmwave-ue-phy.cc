@@ -58,6 +58,7 @@ MmWaveUePhy::MmWaveUePhy (Ptr<MmWaveSpectrumPhy> dlPhy, Ptr<MmWaveSpectrumPhy> u
   m_rnti (0)
 {
 	NS_LOG_FUNCTION (this);
+	m_txPsdValid = false;
 	m_wbCqiLast = Simulator::Now ();
 	m_ueCphySapProvider = new MemberLteUeCphySapProvider<MmWaveUePhy> (this);
 	Simulator::ScheduleNow (&MmWaveUePhy::SubframeIndication, this, 0, 0);
@@ -198,6 +199,7 @@ void
 MmWaveUePhy::SetTxPower (double pow)
 {
 	m_txPower = pow;
+	m_txPsdValid = false;
 }
 double
 MmWaveUePhy::GetTxPower () const
@@ -263,10 +265,17 @@ MmWaveUePhy::GetSubChannelsForReception(void)
 void
 MmWaveUePhy::SetSubChannelsForTransmission(std::vector <int> mask)
 {
+	// called for every UL slot, mostly with the same chunks: the PSD already set is reused,
+	// the channel only reads it
+	if (m_txPsdValid && mask == m_subChannelsForTx)
+	{
+		return;
+	}
 	m_subChannelsForTx = mask;
 	Ptr<SpectrumValue> txPsd = CreateTxPowerSpectralDensity ();
 	NS_ASSERT (txPsd);
 	m_downlinkSpectrumPhy->SetTxPowerSpectralDensity (txPsd);
+	m_txPsdValid = true;
 }
 
 std::vector <int>
@@ -292,6 +301,7 @@ MmWaveUePhy::RegisterToEnb (uint16_t cellId, Ptr<MmWavePhyMacCommon> config)
 	//TBD how to assign bandwitdh and earfcn
 	m_noiseFigure = 5.0;
 	m_phyMacConfig = config;
+	m_txPsdValid = false;
 
 	Ptr<SpectrumValue> noisePsd =
 			MmWaveSpectrumValueHelper::CreateNoisePowerSpectralDensity (m_phyMacConfig, m_noiseFigure);
@@ -354,7 +364,7 @@ MmWaveUePhy::ReceiveControlMessageList (std::list<Ptr<MmWaveControlMessage> > ms
 				slotInfo.m_tddMode = SlotAllocInfo::DL;
 				slotInfo.m_dci = dciInfoElem;
 				slotInfo.m_slotIdx = 0;
-				std::deque <SlotAllocInfo>::iterator itSlot;
+				std::vector <SlotAllocInfo>::iterator itSlot;
 				for (itSlot = m_currSfAllocInfo.m_slotAllocInfo.begin ();
 						itSlot != m_currSfAllocInfo.m_slotAllocInfo.end (); itSlot++)
 				{
@@ -492,7 +502,7 @@ MmWaveUePhy::SubframeIndication (uint16_t frameNum, uint8_t sfNum)
 	ulCtrlSlot.m_slotIdx = 0xFF;
 	ulCtrlSlot.m_dci.m_numSym = 1;
 	ulCtrlSlot.m_dci.m_symStart = m_phyMacConfig->GetSymbolsPerSubframe()-1;
-	m_sfAllocInfo[m_sfNum].m_slotAllocInfo.push_front (dlCtrlSlot);
+	m_sfAllocInfo[m_sfNum].m_slotAllocInfo.insert (m_sfAllocInfo[m_sfNum].m_slotAllocInfo.begin (), dlCtrlSlot);
 //	for (unsigned i = 1; i < m_phyMacConfig->GetSlotsPerSubframe()-1; i++)
 //	{
 //		dummySlot.m_slotIdx = i;
@@ -1052,7 +1062,6 @@ MmWaveUePhy::CreateDlCqiFeedbackMessage (const SpectrumValue& sinr)
 		m_amc = CreateObject <MmWaveAmc> (m_phyMacConfig);
 	}
 	NS_LOG_FUNCTION (this);
-	SpectrumValue newSinr = sinr;
 	//SpectrumValue newSinr = m_beamManagement->GetBestScannedBeamPair().m_sinrPsd;
 	// CREATE DlCqiLteControlMessage
 	Ptr<MmWaveDlCqiMessage> msg = Create<MmWaveDlCqiMessage> ();
@@ -1066,7 +1075,7 @@ MmWaveUePhy::CreateDlCqiFeedbackMessage (const SpectrumValue& sinr)
 	//uint8_t dlBandwidth = m_phyMacConfig->GetNumChunkPerRb () * m_phyMacConfig->GetNumRb ();
 	NS_ASSERT (m_currSlot.m_dci.m_format==0);
 	int mcs;
-	dlcqi.m_wbCqi = m_amc->CreateCqiFeedbackWbTdma (newSinr, m_currSlot.m_dci.m_numSym, m_currSlot.m_dci.m_tbSize, mcs);
+	dlcqi.m_wbCqi = m_amc->CreateCqiFeedbackWbTdma (sinr, m_currSlot.m_dci.m_numSym, m_currSlot.m_dci.m_tbSize, mcs);
 
 //	int activeSubChannels = newSinr.GetSpectrumModel()->GetNumBands ();
 	/*cqi = m_amc->CreateCqiFeedbacksTdma (newSinr, m_currNumSym);
@@ -1102,9 +1111,11 @@ MmWaveUePhy::GenerateDlCqiReport (const SpectrumValue& sinr)
 	{
 		if (Simulator::Now () > m_wbCqiLast + m_wbCqiPeriod)
 		{
-			SpectrumValue newSinr = sinr;
+			// the trace takes a SpectrumValue&, so it gets a copy, kept in a reused buffer
+			m_wbCqiSinr.Assign (sinr);
+			SpectrumValue &newSinr = m_wbCqiSinr.Get ();
 			//SpectrumValue newSinr = m_beamManagement->GetBestScannedBeamPair().m_sinrPsd;
-			Ptr<MmWaveDlCqiMessage> msg = CreateDlCqiFeedbackMessage (newSinr);
+			Ptr<MmWaveDlCqiMessage> msg = CreateDlCqiFeedbackMessage (sinr);
 
 			if (msg)
 			{
@@ -1456,13 +1467,15 @@ MmWaveUePhy::GetBeamGainForCsi(Ptr<NetDevice> enb)
 
 	m_beamManagement->ClearAllSinrMapEntries(); //FIXME: This is to test memoryless tracking
 
-	for (uint16_t i = 0; i < BeamPairs.m_numBeamPairs; i++)
+	// The 3GPP channel evaluates all the tracked beam pairs of this gNB at once
+	BeamPairSinrBatch sinrBatch;
+	if (p3gpp)
 	{
-		complexVector_t beamformingTx =
-				enbBeamMng->GetBeamSweepVector(BeamPairs.m_beamPairList.at(i).m_txBeamId);
-		complexVector_t beamformingRx =
-				m_beamManagement->GetBeamSweepVector(BeamPairs.m_beamPairList.at(i).m_rxBeamId);
+		sinrBatch = p3gpp->GetSinrForBeamPairs(m_netDevice,enb,BeamPairs);
+	}
 
+	for (uint16_t i = 0; i < BeamPairs.m_numBeamPairs; i++)
+	{
 		if (bf)
 		{
 			std::cout << "ERROR. Not implemented for beamforming channel class" << std::endl;
@@ -1470,10 +1483,14 @@ MmWaveUePhy::GetBeamGainForCsi(Ptr<NetDevice> enb)
 		}
 		else if (p3gpp)
 		{
-			sinr = p3gpp->GetSinrForBeamPairs(m_netDevice,enb,beamformingTx,beamformingRx);
+			sinr = sinrBatch.GetSinrPsd(i);
 		}
 		else if (pRaytracing)
 		{
+			complexVector_t beamformingTx =
+					enbBeamMng->GetBeamSweepVector(BeamPairs.m_beamPairList.at(i).m_txBeamId);
+			complexVector_t beamformingRx =
+					m_beamManagement->GetBeamSweepVector(BeamPairs.m_beamPairList.at(i).m_rxBeamId);
 			sinr = pRaytracing->GetSinrForBeamPairs(m_netDevice,enb,beamformingTx,beamformingRx);
 		}
 		else
@@ -38,6 +38,7 @@
 #include <ns3/lte-ue-cphy-sap.h>
 #include <ns3/mmwave-harq-phy.h>
 #include "mmwave-beam-management.h"
+#include "mmwave-psd-buffer.h"
 
 namespace ns3{
 
@@ -200,12 +201,14 @@ private:
 
 	Ptr<MmWaveAmc> m_amc;
 	std::vector <int> m_subChannelsForTx;
+	bool m_txPsdValid;	// true if the tx PSD of m_subChannelsForTx and m_txPower is set in the spectrum phy
 	std::vector <int> m_subChannelsforRx;
 
 	uint32_t m_numRbg;
 
 	Time m_wbCqiPeriod; /**< Wideband Periodic CQI: 2, 5, 10, 16, 20, 32, 40, 64, 80 or 160 ms */
 	Time m_wbCqiLast;
+	MmWavePsdBuffer m_wbCqiSinr;	// SINR of the last CQI report, passed to m_reportCurrentCellRsrpSinrTrace
 
 	SlotAllocInfo::TddMode m_prevSlotDir;
 
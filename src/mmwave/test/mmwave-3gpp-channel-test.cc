@@ -0,0 +1,757 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/mmwave-helper.h"
+#include "ns3/mmwave-3gpp-channel.h"
+#include "ns3/mmwave-enb-net-device.h"
+#include "ns3/mmwave-enb-phy.h"
+#include "ns3/mmwave-ue-net-device.h"
+#include "ns3/mmwave-ue-phy.h"
+#include "ns3/mmwave-spectrum-phy.h"
+#include "ns3/mmwave-spectrum-value-helper.h"
+#include "ns3/multi-model-spectrum-channel.h"
+#include "ns3/spectrum-phy.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/abort.h"
+#include "ns3/config.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \param [in] helper The helper of the devices, with the 3GPP channel model.
+ * \param [in] enbNodes The nodes of the 2 eNBs.
+ * \param [in] ueNodes The nodes of the 5 UEs.
+ * \param [in] ueSpeed The speed of the UEs along the x axis, in m/s.
+ * \param [out] enbDevices The eNB devices installed.
+ * \param [out] ueDevices The UE devices installed, not attached yet.
+ * \returns The channel model of the devices.
+ */
+static Ptr<MmWave3gppChannel>
+InstallDevices (Ptr<MmWaveHelper> helper, NodeContainer enbNodes, NodeContainer ueNodes, double ueSpeed,
+                NetDeviceContainer &enbDevices, NetDeviceContainer &ueDevices)
+{
+  Ptr<ListPositionAllocator> enbPositionAlloc = CreateObject<ListPositionAllocator> ();
+  enbPositionAlloc->Add (Vector (0, 0, 10));
+  enbPositionAlloc->Add (Vector (120, 0, 10));
+  Ptr<ListPositionAllocator> uePositionAlloc = CreateObject<ListPositionAllocator> ();
+  uePositionAlloc->Add (Vector (30, 10, 1.5));
+  uePositionAlloc->Add (Vector (45, -25, 1.5));
+  uePositionAlloc->Add (Vector (20, 60, 1.5));
+  uePositionAlloc->Add (Vector (100, 30, 1.5));
+  uePositionAlloc->Add (Vector (140, -40, 1.5));
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.SetPositionAllocator (enbPositionAlloc);
+  mobility.Install (enbNodes);
+  mobility.SetMobilityModel ("ns3::ConstantVelocityMobilityModel");
+  mobility.SetPositionAllocator (uePositionAlloc);
+  mobility.Install (ueNodes);
+  for (uint32_t u = 0; u < ueNodes.GetN (); u++)
+    {
+      ueNodes.Get (u)->GetObject<ConstantVelocityMobilityModel> ()->SetVelocity (Vector (ueSpeed, 0, 0));
+    }
+
+  enbDevices = helper->InstallEnbDevice (enbNodes);
+  ueDevices = helper->InstallUeDevice (ueNodes);
+
+  Ptr<MmWaveEnbNetDevice> enbDevice = DynamicCast<MmWaveEnbNetDevice> (enbDevices.Get (0));
+  Ptr<MultiModelSpectrumChannel> spectrumChannel =
+    DynamicCast<MultiModelSpectrumChannel> (enbDevice->GetPhy ()->GetDlSpectrumPhy ()->GetSpectrumChannel ());
+  Ptr<MmWave3gppChannel> channel = DynamicCast<MmWave3gppChannel> (spectrumChannel->GetSpectrumPropagationLossModel ());
+  NS_ABORT_MSG_IF (channel == 0, "the spectrum channel has no MmWave3gppChannel");
+  return channel;
+}
+
+/**
+ * \param [in] channel The channel model.
+ * \param [in] enbDevices The eNB devices.
+ * \param [in] ueDevices The UE devices, attached.
+ * \returns The PSDs received by the UEs from their eNB and by the eNBs from their UEs.
+ */
+static std::vector<SpectrumValue>
+GetServingLinkRxPsds (Ptr<MmWave3gppChannel> channel, NetDeviceContainer enbDevices, NetDeviceContainer ueDevices)
+{
+  std::vector<int> subchannels;
+  for (uint32_t i = 0; i < channel->GetConfigurationParameters ()->GetTotalNumChunk (); i++)
+    {
+      subchannels.push_back (i);
+    }
+  Ptr<const SpectrumValue> txPsd =
+    MmWaveSpectrumValueHelper::CreateTxPowerSpectralDensity (channel->GetConfigurationParameters (), 30, subchannels);
+  std::vector<SpectrumValue> rxPsds;
+  for (uint32_t u = 0; u < ueDevices.GetN (); u++)
+    {
+      Ptr<MobilityModel> ueMobility = ueDevices.Get (u)->GetNode ()->GetObject<MobilityModel> ();
+      for (uint32_t e = 0; e < enbDevices.GetN (); e++)
+        {
+          if (DynamicCast<MmWaveUeNetDevice> (ueDevices.Get (u))->GetTargetEnb () != enbDevices.Get (e))
+            {
+              continue;
+            }
+          Ptr<MobilityModel> enbMobility = enbDevices.Get (e)->GetNode ()->GetObject<MobilityModel> ();
+          rxPsds.push_back (*channel->CalcRxPowerSpectralDensity (txPsd, enbMobility, ueMobility));
+          rxPsds.push_back (*channel->CalcRxPowerSpectralDensity (txPsd, ueMobility, enbMobility));
+        }
+    }
+  return rxPsds;
+}
+
+/**
+ * \brief Checks that the initial channel realizations generated by InitialChannelThreads
+ * threads are those generated on the simulator thread: the same seeded topology is built
+ * with 0 and with more threads, and the PSDs received on the links connected by Initial
+ * are compared.
+ *
+ * The LOS condition is fixed and the shadowing disabled, so that the pathloss model draws
+ * nothing from its random variables, whose streams can not be assigned.
+ */
+class MmWaveInitialChannelThreadsTestCase : public TestCase
+{
+public:
+  MmWaveInitialChannelThreadsTestCase ();
+  virtual ~MmWaveInitialChannelThreadsTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \param [in] numThreads The InitialChannelThreads of the channel model.
+   * \returns The PSDs received on the links of the UEs after Initial.
+   */
+  std::vector<SpectrumValue> GetInitialRxPsds (uint32_t numThreads) const;
+};
+
+MmWaveInitialChannelThreadsTestCase::MmWaveInitialChannelThreadsTestCase ()
+  : TestCase ("Initial channel realizations with and without InitialChannelThreads")
+{
+}
+
+MmWaveInitialChannelThreadsTestCase::~MmWaveInitialChannelThreadsTestCase ()
+{
+}
+
+std::vector<SpectrumValue>
+MmWaveInitialChannelThreadsTestCase::GetInitialRxPsds (uint32_t numThreads) const
+{
+  Ptr<MmWaveHelper> mmWaveHelper = CreateObject<MmWaveHelper> ();
+  mmWaveHelper->SetAttribute ("PathlossModel", StringValue ("ns3::MmWave3gppPropagationLossModel"));
+  mmWaveHelper->SetAttribute ("ChannelModel", StringValue ("ns3::MmWave3gppChannel"));
+  NodeContainer enbNodes;
+  enbNodes.Create (2);
+  NodeContainer ueNodes;
+  ueNodes.Create (5);
+  NetDeviceContainer enbDevices;
+  NetDeviceContainer ueDevices;
+  Ptr<MmWave3gppChannel> channel = InstallDevices (mmWaveHelper, enbNodes, ueNodes, 0, enbDevices, ueDevices);
+
+  // the automatic streams differ from a topology to the next one, the streams are assigned
+  channel->SetAttribute ("InitialChannelThreads", UintegerValue (numThreads));
+  channel->AssignStreams (100);
+  mmWaveHelper->AttachToClosestEnb (ueDevices, enbDevices);
+
+  std::vector<SpectrumValue> rxPsds = GetServingLinkRxPsds (channel, enbDevices, ueDevices);
+  Simulator::Destroy ();
+  return rxPsds;
+}
+
+void
+MmWaveInitialChannelThreadsTestCase::DoRun (void)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  Config::SetDefault ("ns3::MmWave3gppPropagationLossModel::ChannelCondition", StringValue ("l"));
+  Config::SetDefault ("ns3::MmWave3gppPropagationLossModel::Shadowing", BooleanValue (false));
+  Config::SetDefault ("ns3::MmWave3gppChannel::Blockage", BooleanValue (true));
+
+  std::vector<SpectrumValue> expected = GetInitialRxPsds (0);
+  NS_TEST_ASSERT_MSG_EQ (expected.size (), 10, "Wrong number of links of the UEs");
+  uint32_t threads[] = {1, 3, 8};
+  for (uint32_t t = 0; t < 3; t++)
+    {
+      std::vector<SpectrumValue> rxPsds = GetInitialRxPsds (threads[t]);
+      NS_TEST_ASSERT_MSG_EQ (rxPsds.size (), expected.size (), "Wrong number of links with " << threads[t] << " threads");
+      for (uint32_t link = 0; link < rxPsds.size () && link < expected.size (); link++)
+        {
+          for (uint32_t i = 0; i < expected[link].GetSpectrumModel ()->GetNumBands (); i++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (rxPsds[link][i], expected[link][i], "Different PSD of link " << link
+                                     << " in band " << i << " with " << threads[t] << " threads");
+            }
+        }
+    }
+  Config::Reset ();
+}
+
+/**
+ * \brief Checks that the beamforming gains taken from the GainCache are those computed without
+ * the cache, on links of moving UEs whose Doppler phases change between the checks: at
+ * several times of the simulation the PSDs received on the links of the UEs are computed
+ * without the cache, then twice with it, the first time filling the cache and the second
+ * time reading it.
+ */
+class MmWaveGainCacheTestCase : public TestCase
+{
+public:
+  MmWaveGainCacheTestCase ();
+  virtual ~MmWaveGainCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Compare the PSDs received with and without the cache at the current time.
+   */
+  void CheckGains ();
+
+  Ptr<MmWave3gppChannel> m_channel;
+  NetDeviceContainer m_enbDevices;
+  NetDeviceContainer m_ueDevices;
+  uint32_t m_numChecks;
+};
+
+MmWaveGainCacheTestCase::MmWaveGainCacheTestCase ()
+  : TestCase ("Beamforming gains of the GainCache on links of moving UEs"),
+    m_numChecks (0)
+{
+}
+
+MmWaveGainCacheTestCase::~MmWaveGainCacheTestCase ()
+{
+}
+
+void
+MmWaveGainCacheTestCase::CheckGains ()
+{
+  m_channel->SetAttribute ("GainCache", BooleanValue (false));
+  std::vector<SpectrumValue> expected = GetServingLinkRxPsds (m_channel, m_enbDevices, m_ueDevices);
+  m_channel->SetAttribute ("GainCache", BooleanValue (true));
+  UintegerValue hits;
+  m_channel->GetAttribute ("GainCacheHits", hits);
+  for (uint32_t pass = 0; pass < 2; pass++)
+    {
+      std::vector<SpectrumValue> rxPsds = GetServingLinkRxPsds (m_channel, m_enbDevices, m_ueDevices);
+      NS_TEST_ASSERT_MSG_EQ (rxPsds.size (), expected.size (), "Wrong number of links");
+      for (uint32_t link = 0; link < rxPsds.size () && link < expected.size (); link++)
+        {
+          for (uint32_t i = 0; i < expected[link].GetSpectrumModel ()->GetNumBands (); i++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (rxPsds[link][i], expected[link][i], "Different PSD of link " << link << " in band " << i
+                                     << " at " << Simulator::Now ().GetSeconds () << " s, pass " << pass);
+            }
+        }
+    }
+  UintegerValue newHits;
+  m_channel->GetAttribute ("GainCacheHits", newHits);
+  NS_TEST_ASSERT_MSG_EQ (newHits.Get (), hits.Get () + expected.size (), "The second pass did not read the cache");
+  m_numChecks++;
+}
+
+void
+MmWaveGainCacheTestCase::DoRun (void)
+{
+  Ptr<MmWaveHelper> mmWaveHelper = CreateObject<MmWaveHelper> ();
+  mmWaveHelper->SetAttribute ("PathlossModel", StringValue ("ns3::MmWave3gppPropagationLossModel"));
+  mmWaveHelper->SetAttribute ("ChannelModel", StringValue ("ns3::MmWave3gppChannel"));
+  NodeContainer enbNodes;
+  enbNodes.Create (2);
+  NodeContainer ueNodes;
+  ueNodes.Create (5);
+  m_channel = InstallDevices (mmWaveHelper, enbNodes, ueNodes, 20, m_enbDevices, m_ueDevices);
+  mmWaveHelper->AttachToClosestEnb (m_ueDevices, m_enbDevices);
+
+  Simulator::Schedule (MicroSeconds (100), &MmWaveGainCacheTestCase::CheckGains, this);
+  Simulator::Schedule (MicroSeconds (1100), &MmWaveGainCacheTestCase::CheckGains, this);
+  Simulator::Schedule (MicroSeconds (1700), &MmWaveGainCacheTestCase::CheckGains, this);
+  Simulator::Stop (MilliSeconds (2));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_numChecks, 3, "The gains were not checked");
+  m_channel = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Receiver that keeps the PSDs of the signals received by a node, to compare the PSDs
+ * computed by the spectrum channel for the same signals in different configurations.
+ */
+class MmWaveRxPsdRecorder : public SpectrumPhy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  virtual void SetDevice (Ptr<NetDevice> d);
+  virtual Ptr<NetDevice> GetDevice () const;
+  virtual void SetMobility (Ptr<MobilityModel> m);
+  virtual Ptr<MobilityModel> GetMobility ();
+  virtual void SetChannel (Ptr<SpectrumChannel> c);
+  virtual Ptr<const SpectrumModel> GetRxSpectrumModel () const;
+  virtual Ptr<AntennaModel> GetRxAntenna ();
+  virtual void StartRx (Ptr<SpectrumSignalParameters> params);
+
+  /**
+   * \param [in] model The spectrum model of the received PSDs.
+   */
+  void SetRxSpectrumModel (Ptr<const SpectrumModel> model);
+
+  std::vector<SpectrumValue> m_rxPsds; // in the order of reception
+
+private:
+  virtual void DoDispose (void);
+
+  Ptr<NetDevice> m_device;
+  Ptr<MobilityModel> m_mobility;
+  Ptr<const SpectrumModel> m_rxSpectrumModel;
+};
+
+TypeId
+MmWaveRxPsdRecorder::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MmWaveRxPsdRecorder")
+    .SetParent<SpectrumPhy> ()
+    .SetGroupName ("Mmwave")
+  ;
+  return tid;
+}
+
+void
+MmWaveRxPsdRecorder::DoDispose (void)
+{
+  m_device = 0;
+  m_mobility = 0;
+  SpectrumPhy::DoDispose ();
+}
+
+void
+MmWaveRxPsdRecorder::SetDevice (Ptr<NetDevice> d)
+{
+  m_device = d;
+}
+
+Ptr<NetDevice>
+MmWaveRxPsdRecorder::GetDevice () const
+{
+  return m_device;
+}
+
+void
+MmWaveRxPsdRecorder::SetMobility (Ptr<MobilityModel> m)
+{
+  m_mobility = m;
+}
+
+Ptr<MobilityModel>
+MmWaveRxPsdRecorder::GetMobility ()
+{
+  return m_mobility;
+}
+
+void
+MmWaveRxPsdRecorder::SetChannel (Ptr<SpectrumChannel> c)
+{
+}
+
+Ptr<const SpectrumModel>
+MmWaveRxPsdRecorder::GetRxSpectrumModel () const
+{
+  return m_rxSpectrumModel;
+}
+
+Ptr<AntennaModel>
+MmWaveRxPsdRecorder::GetRxAntenna ()
+{
+  return 0;
+}
+
+void
+MmWaveRxPsdRecorder::StartRx (Ptr<SpectrumSignalParameters> params)
+{
+  m_rxPsds.push_back (*params->psd);
+}
+
+void
+MmWaveRxPsdRecorder::SetRxSpectrumModel (Ptr<const SpectrumModel> model)
+{
+  m_rxSpectrumModel = model;
+}
+
+/**
+ * \brief Checks that the PSDs received through MultiModelSpectrumChannel do not depend on its
+ * RxThreads: at several times of the simulation, every node of a topology with moving UEs
+ * sends a signal that is received by a recorder on every other node, first with RxThreads
+ * threads completing the beamforming gains of the GainCache that are out of date, then with
+ * RxThreads 0 and without the cache.
+ *
+ * The signals are not data or control frames, so the mmWave PHYs ignore them. The two passes
+ * are made at the same time and in the same topology because the order of the receivers of
+ * the channel, and thus of the interference sums and of the beamforming vectors of the links
+ * created at time 0, depends on the addresses of their PHYs.
+ */
+class MmWaveRxThreadsTestCase : public TestCase
+{
+public:
+  /**
+   * \param [in] name The name of the test case.
+   * \param [in] rxThreads The RxThreads compared with 0.
+   */
+  MmWaveRxThreadsTestCase (std::string name, uint32_t rxThreads);
+  virtual ~MmWaveRxThreadsTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Send a signal from every node.
+   */
+  void Transmit ();
+
+  /**
+   * Send the signals with RxThreads threads and the GainCache, then schedule the second pass.
+   */
+  void TransmitWithThreads ();
+
+  /**
+   * Send the signals on the simulator thread without the GainCache, then schedule the comparison.
+   */
+  void TransmitWithoutThreads ();
+
+  /**
+   * Compare the PSDs received in the two passes.
+   */
+  void CheckRxPsds ();
+
+  uint32_t m_rxThreads;
+  Ptr<MultiModelSpectrumChannel> m_spectrumChannel;
+  Ptr<MmWave3gppChannel> m_channel;
+  std::vector<Ptr<SpectrumPhy> > m_txPhys;
+  std::vector<Ptr<MmWaveRxPsdRecorder> > m_recorders;
+  Ptr<const SpectrumValue> m_txPsd;
+  uint32_t m_numChecks;
+};
+
+MmWaveRxThreadsTestCase::MmWaveRxThreadsTestCase (std::string name, uint32_t rxThreads)
+  : TestCase (name),
+    m_rxThreads (rxThreads),
+    m_numChecks (0)
+{
+}
+
+MmWaveRxThreadsTestCase::~MmWaveRxThreadsTestCase ()
+{
+}
+
+void
+MmWaveRxThreadsTestCase::Transmit ()
+{
+  for (uint32_t i = 0; i < m_txPhys.size (); i++)
+    {
+      Ptr<SpectrumSignalParameters> params = Create<SpectrumSignalParameters> ();
+      params->duration = MicroSeconds (1);
+      params->txPhy = m_txPhys[i];
+      params->psd = Copy<SpectrumValue> (m_txPsd);
+      m_spectrumChannel->StartTx (params);
+    }
+}
+
+void
+MmWaveRxThreadsTestCase::TransmitWithThreads ()
+{
+  // the recorders also receive the signals of the PHYs
+  for (uint32_t r = 0; r < m_recorders.size (); r++)
+    {
+      m_recorders[r]->m_rxPsds.clear ();
+    }
+  m_spectrumChannel->SetAttribute ("RxThreads", UintegerValue (m_rxThreads));
+  m_channel->SetAttribute ("GainCache", BooleanValue (true));
+  UintegerValue misses;
+  m_channel->GetAttribute ("GainCacheMisses", misses);
+  Transmit ();
+  UintegerValue newMisses;
+  m_channel->GetAttribute ("GainCacheMisses", newMisses);
+  NS_TEST_ASSERT_MSG_GT (newMisses.Get (), misses.Get (), "No beamforming gain was completed by the threads");
+  // the receptions are scheduled now, before the second pass
+  Simulator::ScheduleNow (&MmWaveRxThreadsTestCase::TransmitWithoutThreads, this);
+}
+
+void
+MmWaveRxThreadsTestCase::TransmitWithoutThreads ()
+{
+  m_spectrumChannel->SetAttribute ("RxThreads", UintegerValue (0));
+  m_channel->SetAttribute ("GainCache", BooleanValue (false));
+  Transmit ();
+  m_channel->SetAttribute ("GainCache", BooleanValue (true));
+  Simulator::ScheduleNow (&MmWaveRxThreadsTestCase::CheckRxPsds, this);
+}
+
+void
+MmWaveRxThreadsTestCase::CheckRxPsds ()
+{
+  for (uint32_t r = 0; r < m_recorders.size (); r++)
+    {
+      // the same signals are received in the same order in each pass
+      std::vector<SpectrumValue> &rxPsds = m_recorders[r]->m_rxPsds;
+      uint32_t numSignals = rxPsds.size () / 2;
+      NS_TEST_ASSERT_MSG_GT (numSignals, 0, "No signal received by node " << r);
+      NS_TEST_ASSERT_MSG_EQ (rxPsds.size (), 2 * numSignals, "Different number of signals received by node " << r);
+      for (uint32_t s = 0; s < numSignals; s++)
+        {
+          const SpectrumValue &expected = rxPsds[numSignals + s];
+          for (uint32_t i = 0; i < expected.GetSpectrumModel ()->GetNumBands (); i++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (rxPsds[s][i], expected[i], "Different PSD of signal " << s << " at node " << r << " in band " << i
+                                     << " at " << Simulator::Now ().GetSeconds () << " s");
+            }
+        }
+    }
+  m_numChecks++;
+}
+
+void
+MmWaveRxThreadsTestCase::DoRun (void)
+{
+  Ptr<MmWaveHelper> mmWaveHelper = CreateObject<MmWaveHelper> ();
+  mmWaveHelper->SetAttribute ("PathlossModel", StringValue ("ns3::MmWave3gppPropagationLossModel"));
+  mmWaveHelper->SetAttribute ("ChannelModel", StringValue ("ns3::MmWave3gppChannel"));
+  NodeContainer enbNodes;
+  enbNodes.Create (2);
+  NodeContainer ueNodes;
+  ueNodes.Create (5);
+  NetDeviceContainer enbDevices;
+  NetDeviceContainer ueDevices;
+  m_channel = InstallDevices (mmWaveHelper, enbNodes, ueNodes, 20, enbDevices, ueDevices);
+  mmWaveHelper->AttachToClosestEnb (ueDevices, enbDevices);
+
+  Ptr<MmWaveSpectrumPhy> enbPhy = DynamicCast<MmWaveEnbNetDevice> (enbDevices.Get (0))->GetPhy ()->GetDlSpectrumPhy ();
+  m_spectrumChannel = DynamicCast<MultiModelSpectrumChannel> (enbPhy->GetSpectrumChannel ());
+  std::vector<int> subchannels;
+  for (uint32_t i = 0; i < m_channel->GetConfigurationParameters ()->GetTotalNumChunk (); i++)
+    {
+      subchannels.push_back (i);
+    }
+  m_txPsd = MmWaveSpectrumValueHelper::CreateTxPowerSpectralDensity (m_channel->GetConfigurationParameters (), 30, subchannels);
+
+  NetDeviceContainer devices (enbDevices, ueDevices);
+  for (uint32_t d = 0; d < devices.GetN (); d++)
+    {
+      Ptr<MmWaveEnbNetDevice> enbDevice = DynamicCast<MmWaveEnbNetDevice> (devices.Get (d));
+      Ptr<MmWaveUeNetDevice> ueDevice = DynamicCast<MmWaveUeNetDevice> (devices.Get (d));
+      m_txPhys.push_back (enbDevice != 0 ? enbDevice->GetPhy ()->GetDlSpectrumPhy () : ueDevice->GetPhy ()->GetUlSpectrumPhy ());
+      Ptr<MmWaveRxPsdRecorder> recorder = CreateObject<MmWaveRxPsdRecorder> ();
+      recorder->SetDevice (devices.Get (d));
+      recorder->SetMobility (devices.Get (d)->GetNode ()->GetObject<MobilityModel> ());
+      recorder->SetRxSpectrumModel (enbPhy->GetRxSpectrumModel ());
+      m_spectrumChannel->AddRx (recorder);
+      m_recorders.push_back (recorder);
+    }
+
+  // times out of the symbol boundaries, so that the signals of the PHYs do not interleave with the passes
+  Simulator::Schedule (NanoSeconds (100003), &MmWaveRxThreadsTestCase::TransmitWithThreads, this);
+  Simulator::Schedule (NanoSeconds (1100007), &MmWaveRxThreadsTestCase::TransmitWithThreads, this);
+  Simulator::Schedule (NanoSeconds (1700011), &MmWaveRxThreadsTestCase::TransmitWithThreads, this);
+  Simulator::Stop (MilliSeconds (2));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_numChecks, 3, "The PSDs were not checked");
+  m_channel = 0;
+  m_spectrumChannel = 0;
+  m_txPhys.clear ();
+  m_recorders.clear ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Checks the per-link memory report of the channel with CompactChannels: the serving
+ * links store their channel matrix, the other links their rays only, and the links sum to the
+ * ChannelMemory total. The beam sweeping reads the realization of the serving link itself, so
+ * it also checks that computing the SINR of other beams leaves the received PSDs and the
+ * beamforming gains of the GainCache of the serving links unchanged.
+ */
+class MmWaveChannelMemoryTestCase : public TestCase
+{
+public:
+  MmWaveChannelMemoryTestCase ();
+  virtual ~MmWaveChannelMemoryTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Sweep the beams of the serving links, then check the PSDs and the memory of the links.
+   */
+  void CheckMemory ();
+
+  Ptr<MmWave3gppChannel> m_channel;
+  NetDeviceContainer m_enbDevices;
+  NetDeviceContainer m_ueDevices;
+  uint32_t m_numChecks;
+};
+
+MmWaveChannelMemoryTestCase::MmWaveChannelMemoryTestCase ()
+  : TestCase ("Per-link memory of the channel realizations with CompactChannels"),
+    m_numChecks (0)
+{
+}
+
+MmWaveChannelMemoryTestCase::~MmWaveChannelMemoryTestCase ()
+{
+}
+
+void
+MmWaveChannelMemoryTestCase::CheckMemory ()
+{
+  std::vector<SpectrumValue> expected = GetServingLinkRxPsds (m_channel, m_enbDevices, m_ueDevices);
+  for (uint32_t u = 0; u < m_ueDevices.GetN (); u++)
+    {
+      Ptr<MmWaveUeNetDevice> ueDevice = DynamicCast<MmWaveUeNetDevice> (m_ueDevices.Get (u));
+      Ptr<MmWaveEnbNetDevice> enbDevice = ueDevice->GetTargetEnb ();
+      BeamPairSinrBatch batch = m_channel->GetSinrForCodebook (ueDevice, enbDevice);
+      NS_TEST_ASSERT_MSG_GT (batch.m_beamPairs.size (), 1, "No beam pair swept for UE " << u);
+      m_channel->GetSinrForBeamPairs (ueDevice, enbDevice,
+                                      enbDevice->GetPhy ()->GetBeamManagement ()->GetBeamSweepCodebook ().at (1),
+                                      ueDevice->GetPhy ()->GetBeamManagement ()->GetBeamSweepCodebook ().at (1));
+    }
+  UintegerValue hits;
+  m_channel->GetAttribute ("GainCacheHits", hits);
+  std::vector<SpectrumValue> rxPsds = GetServingLinkRxPsds (m_channel, m_enbDevices, m_ueDevices);
+  UintegerValue newHits;
+  m_channel->GetAttribute ("GainCacheHits", newHits);
+  NS_TEST_ASSERT_MSG_EQ (newHits.Get (), hits.Get () + expected.size (), "The beam sweeping changed the gains of the serving links");
+  NS_TEST_ASSERT_MSG_EQ (rxPsds.size (), expected.size (), "Wrong number of links");
+  for (uint32_t link = 0; link < rxPsds.size () && link < expected.size (); link++)
+    {
+      for (uint32_t i = 0; i < expected[link].GetSpectrumModel ()->GetNumBands (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (rxPsds[link][i], expected[link][i], "The beam sweeping changed the PSD of link " << link << " in band " << i);
+        }
+    }
+
+  ChannelMemoryUsage usage = m_channel->GetChannelMemoryUsage ();
+  uint64_t total = usage.m_staleMatrixCacheBytes;
+  uint32_t numServing = 0;
+  uint32_t numCompact = 0;
+  for (std::map<ns3::key_t, ChannelLinkMemory>::const_iterator it = usage.m_links.begin (); it != usage.m_links.end (); it++)
+    {
+      const ChannelLinkMemory &link = it->second;
+      total += link.m_realizationBytes + link.m_matrixCacheBytes + link.m_gainCacheBytes;
+      NS_TEST_ASSERT_MSG_GT_OR_EQ (link.m_realizationBytes, link.m_channelBytes + link.m_codebookBytes,
+                                   "The realization is smaller than its channel matrix and codebook cache");
+      Ptr<MmWaveUeNetDevice> ueDevice = DynamicCast<MmWaveUeNetDevice> (it->first.first);
+      Ptr<NetDevice> enbDevice = it->first.second;
+      if (ueDevice == 0)
+        {
+          ueDevice = DynamicCast<MmWaveUeNetDevice> (it->first.second);
+          enbDevice = it->first.first;
+        }
+      if (ueDevice == 0 || link.m_realizationBytes == 0)
+        {
+          continue;
+        }
+      if (ueDevice->GetTargetEnb () == enbDevice)
+        {
+          numServing++;
+          NS_TEST_ASSERT_MSG_EQ (link.m_compact, false, "A serving link stores its rays only");
+          NS_TEST_ASSERT_MSG_GT (link.m_channelBytes, 0, "A serving link has no channel matrix");
+          NS_TEST_ASSERT_MSG_EQ (link.m_matrixCacheBytes, 0, "A serving link has a matrix in the cache");
+        }
+      else
+        {
+          numCompact++;
+          NS_TEST_ASSERT_MSG_EQ (link.m_compact, true, "A link that is not a serving one stores its channel matrix");
+          NS_TEST_ASSERT_MSG_EQ (link.m_channelBytes, 0, "A compact link stores its channel matrix");
+        }
+    }
+  NS_TEST_ASSERT_MSG_GT (numServing, 0, "No serving link");
+  NS_TEST_ASSERT_MSG_GT (numCompact, 0, "No compact link");
+  NS_TEST_ASSERT_MSG_EQ (m_channel->GetChannelMemory (), total, "The links do not sum to the total");
+  UintegerValue memory;
+  m_channel->GetAttribute ("ChannelMemory", memory);
+  NS_TEST_ASSERT_MSG_EQ (memory.Get (), total, "The links do not sum to the ChannelMemory attribute");
+
+  // the codebook cache of the beam sweeping is counted in the serving link
+  for (uint32_t u = 0; u < m_ueDevices.GetN (); u++)
+    {
+      Ptr<MmWaveUeNetDevice> ueDevice = DynamicCast<MmWaveUeNetDevice> (m_ueDevices.Get (u));
+      Ptr<NetDevice> enbDevice = ueDevice->GetTargetEnb ();
+      uint64_t codebookBytes = usage.m_links[std::make_pair (enbDevice, Ptr<NetDevice> (ueDevice))].m_codebookBytes
+        + usage.m_links[std::make_pair (Ptr<NetDevice> (ueDevice), enbDevice)].m_codebookBytes;
+      NS_TEST_ASSERT_MSG_GT (codebookBytes, 0, "The codebook cache of UE " << u << " is not in its serving link");
+    }
+
+  std::ostringstream report;
+  m_channel->PrintChannelMemory (report);
+  uint32_t numLines = 0;
+  std::string line;
+  std::istringstream lines (report.str ());
+  while (std::getline (lines, line))
+    {
+      numLines++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (numLines, usage.m_links.size () + 2, "The report does not have a line per link");
+  m_numChecks++;
+}
+
+void
+MmWaveChannelMemoryTestCase::DoRun (void)
+{
+  Config::SetDefault ("ns3::MmWave3gppChannel::CompactChannels", BooleanValue (true));
+  Ptr<MmWaveHelper> mmWaveHelper = CreateObject<MmWaveHelper> ();
+  mmWaveHelper->SetAttribute ("PathlossModel", StringValue ("ns3::MmWave3gppPropagationLossModel"));
+  mmWaveHelper->SetAttribute ("ChannelModel", StringValue ("ns3::MmWave3gppChannel"));
+  NodeContainer enbNodes;
+  enbNodes.Create (2);
+  NodeContainer ueNodes;
+  ueNodes.Create (5);
+  m_channel = InstallDevices (mmWaveHelper, enbNodes, ueNodes, 0, m_enbDevices, m_ueDevices);
+  mmWaveHelper->AttachToClosestEnb (m_ueDevices, m_enbDevices);
+
+  Simulator::Schedule (MicroSeconds (100), &MmWaveChannelMemoryTestCase::CheckMemory, this);
+  Simulator::Stop (MicroSeconds (200));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_numChecks, 1, "The memory was not checked");
+  m_channel = 0;
+  Simulator::Destroy ();
+  Config::Reset ();
+}
+
+/**
+ * \brief Test suite of the MmWave3gppChannel.
+ */
+class MmWave3gppChannelTestSuite : public TestSuite
+{
+public:
+  MmWave3gppChannelTestSuite ();
+};
+
+MmWave3gppChannelTestSuite::MmWave3gppChannelTestSuite ()
+  : TestSuite ("mmwave-3gpp-channel", UNIT)
+{
+  AddTestCase (new MmWaveInitialChannelThreadsTestCase, TestCase::QUICK);
+  AddTestCase (new MmWaveGainCacheTestCase, TestCase::QUICK);
+  AddTestCase (new MmWaveRxThreadsTestCase ("Received PSDs with 1 RxThreads against the simulator thread", 1), TestCase::QUICK);
+  AddTestCase (new MmWaveRxThreadsTestCase ("Received PSDs with 4 RxThreads against the simulator thread", 4), TestCase::QUICK);
+  AddTestCase (new MmWaveChannelMemoryTestCase, TestCase::QUICK);
+}
+
+static MmWave3gppChannelTestSuite mmwave3gppChannelTestSuite;
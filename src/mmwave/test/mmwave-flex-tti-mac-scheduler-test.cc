@@ -0,0 +1,480 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/mmwave-flex-tti-mac-scheduler.h"
+#include "ns3/mmwave-beam-management.h"
+#include "ns3/lte-common.h"
+#include "ns3/eps-bearer.h"
+#include "ns3/object-factory.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+using namespace ns3;
+
+static bool g_countAllocations = false; //!< Whether operator new counts the allocations.
+static uint64_t g_numAllocations = 0;   //!< Allocations counted by operator new.
+
+/**
+ * Replaces the global operator new of the test runner, to count the heap allocations of the
+ * schedulers. operator new[] and the deallocation functions of the library call it or free.
+ * \param [in] size The size of the allocation.
+ * \returns The allocated memory.
+ */
+void *
+operator new (std::size_t size)
+{
+  if (g_countAllocations)
+    {
+      g_numAllocations++;
+    }
+  void *p = std::malloc (size > 0 ? size : 1);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+/**
+ * \brief Traffic of a UE of the scheduler tests.
+ */
+struct MmWaveSchedulerTestUe
+{
+  uint16_t rnti;          //!< RNTI of the UE.
+  uint8_t dlCqi;          //!< Wideband DL CQI, 0 for no report.
+  uint32_t dlBuffer;      //!< Bytes of the DL RLC transmission queue, reported once.
+  double dlHolDelay;      //!< Head of line delay of the DL queue, in ms.
+  uint32_t ulBuffer;      //!< Bytes of the UL buffer, reported once by a BSR.
+  double ulSinr;          //!< Linear UL SINR of every chunk, reported for each UL allocation.
+};
+
+/**
+ * \brief SAP user of the scheduler that keeps the last scheduling decision. The decision is
+ * not copied: it stays in the buffer of the scheduler until the next SchedTriggerReq.
+ */
+class MmWaveSchedulerTestSapUser : public MmWaveMacSchedSapUser
+{
+public:
+  MmWaveSchedulerTestSapUser ()
+    : m_decision (0)
+  {
+  }
+  virtual void SchedConfigInd (struct SchedConfigIndParameters& params)
+  {
+    m_decision = &params;
+  }
+
+  const SchedConfigIndParameters *m_decision; //!< Last scheduling decision.
+};
+
+/**
+ * \brief CSCHED SAP user of the scheduler, which ignores the confirmations.
+ */
+class MmWaveSchedulerTestCschedSapUser : public MmWaveMacCschedSapUser
+{
+public:
+  virtual void CschedCellConfigCnf (const struct CschedCellConfigCnfParameters& params)
+  {
+  }
+  virtual void CschedUeConfigCnf (const struct CschedUeConfigCnfParameters& params)
+  {
+  }
+  virtual void CschedLcConfigCnf (const struct CschedLcConfigCnfParameters& params)
+  {
+  }
+  virtual void CschedLcReleaseCnf (const struct CschedLcReleaseCnfParameters& params)
+  {
+  }
+  virtual void CschedUeReleaseCnf (const struct CschedUeReleaseCnfParameters& params)
+  {
+  }
+  virtual void CschedUeConfigUpdateInd (const struct CschedUeConfigUpdateIndParameters& params)
+  {
+  }
+  virtual void CschedCellConfigUpdateInd (const struct CschedCellConfigUpdateIndParameters& params)
+  {
+  }
+};
+
+/**
+ * \brief Scheduler under test, with its SAP users, its UEs and their reports. The reports are
+ * built once, so that sending them does not allocate.
+ */
+class MmWaveSchedulerTestBench
+{
+public:
+  /**
+   * Creates the scheduler and configures the UEs and their logical channel 3.
+   * \param [in] scheduler The TypeId name of the scheduler.
+   * \param [in] fixedTti The FixedTti attribute of the scheduler.
+   * \param [in] ues The UEs and their traffic.
+   */
+  MmWaveSchedulerTestBench (std::string scheduler, bool fixedTti, const std::vector<MmWaveSchedulerTestUe> &ues);
+  ~MmWaveSchedulerTestBench ();
+
+  /**
+   * Reports the DL buffers, the UL buffers and the DL CQIs of the UEs.
+   */
+  void SendReports ();
+  /**
+   * Schedules a subframe and reports the UL SINR of each UL allocation.
+   * \param [in] sf The number of the subframe, from 0.
+   */
+  void Schedule (unsigned sf);
+  /**
+   * \returns The data slots of the last decision, e.g. "DL1x5 UL4x3" for 5 DL symbols of RNTI 1
+   * followed by 3 UL symbols of RNTI 4.
+   */
+  std::string GetDecision () const;
+
+private:
+  Ptr<MmWavePhyMacCommon> m_config;
+  Ptr<MmWaveFlexTtiMacScheduler> m_scheduler;
+  MmWaveSchedulerTestSapUser m_sapUser;
+  MmWaveSchedulerTestCschedSapUser m_cschedSapUser;
+  std::vector<MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters> m_dlBuffers;
+  MmWaveMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters m_bsrs;
+  MmWaveMacSchedSapProvider::SchedDlCqiInfoReqParameters m_dlCqis;
+  std::vector<MmWaveMacSchedSapProvider::SchedUlCqiInfoReqParameters> m_ulCqis; //!< UL CQI of each UE.
+};
+
+MmWaveSchedulerTestBench::MmWaveSchedulerTestBench (std::string scheduler, bool fixedTti,
+                                                    const std::vector<MmWaveSchedulerTestUe> &ues)
+{
+  m_config = CreateObject<MmWavePhyMacCommon> ();
+  ObjectFactory factory;
+  factory.SetTypeId (scheduler);
+  factory.Set ("FixedTti", BooleanValue (fixedTti));
+  m_scheduler = factory.Create<MmWaveFlexTtiMacScheduler> ();
+  m_scheduler->SetMacSchedSapUser (&m_sapUser);
+  m_scheduler->SetMacCschedSapUser (&m_cschedSapUser);
+  m_scheduler->ConfigureCommonParameters (m_config);
+  // one symbol of DL control, without the beam tracking overhead
+  Ptr<MmWaveBeamManagement> beamManager = CreateObject<MmWaveBeamManagement> ();
+  beamManager->SetCandidateBeamAlternative (0, 0, 0, true);
+  m_scheduler->SetBeamManager (beamManager);
+
+  for (unsigned u = 0; u < ues.size (); u++)
+    {
+      const MmWaveSchedulerTestUe &ue = ues[u];
+      MmWaveMacCschedSapProvider::CschedUeConfigReqParameters ueParams;
+      ueParams.m_rnti = ue.rnti;
+      ueParams.m_transmissionMode = 0;
+      m_scheduler->GetMacCschedSapProvider ()->CschedUeConfigReq (ueParams);
+
+      LogicalChannelConfigListElement_s lc;
+      lc.m_logicalChannelIdentity = 3;
+      lc.m_logicalChannelGroup = 1;
+      lc.m_direction = LogicalChannelConfigListElement_s::DIR_BOTH;
+      lc.m_qosBearerType = LogicalChannelConfigListElement_s::QBT_NON_GBR;
+      lc.m_qci = EpsBearer::NGBR_VIDEO_TCP_DEFAULT;
+      MmWaveMacCschedSapProvider::CschedLcConfigReqParameters lcParams;
+      lcParams.m_rnti = ue.rnti;
+      lcParams.m_reconfigureFlag = false;
+      lcParams.m_logicalChannelConfigList.push_back (lc);
+      m_scheduler->GetMacCschedSapProvider ()->CschedLcConfigReq (lcParams);
+
+      if (ue.dlCqi > 0)
+        {
+          DlCqiInfo cqi;
+          cqi.m_rnti = ue.rnti;
+          cqi.m_cqiType = DlCqiInfo::WB;
+          cqi.m_wbCqi = ue.dlCqi;
+          m_dlCqis.m_cqiList.push_back (cqi);
+        }
+      if (ue.dlBuffer > 0)
+        {
+          MmWaveMacSchedSapProvider::SchedDlRlcBufferReqParameters bufferParams;
+          bufferParams.m_rnti = ue.rnti;
+          bufferParams.m_logicalChannelIdentity = 3;
+          bufferParams.m_rlcTransmissionQueueSize = ue.dlBuffer;
+          bufferParams.m_rlcTransmissionQueueHolDelay = ue.dlHolDelay;
+          bufferParams.m_rlcRetransmissionQueueSize = 0;
+          bufferParams.m_rlcRetransmissionHolDelay = 0;
+          bufferParams.m_rlcStatusPduSize = 0;
+          bufferParams.m_arrivalRate = 0;
+          m_dlBuffers.push_back (bufferParams);
+        }
+      if (ue.ulBuffer > 0)
+        {
+          MacCeElement bsr;
+          bsr.m_rnti = ue.rnti;
+          bsr.m_macCeType = MacCeElement::BSR;
+          bsr.m_macCeValue.m_bufferStatus.assign (4, 0);
+          bsr.m_macCeValue.m_bufferStatus[1] = BufferSizeLevelBsr::BufferSize2BsrId (ue.ulBuffer);
+          m_bsrs.m_macCeList.push_back (bsr);
+        }
+      MmWaveMacSchedSapProvider::SchedUlCqiInfoReqParameters ulCqi;
+      ulCqi.m_ulCqi.m_type = UlCqiInfo::PUSCH;
+      ulCqi.m_ulCqi.m_sinr.assign (m_config->GetTotalNumChunk (), ue.ulSinr);
+      ulCqi.m_sfnSf.m_frameNum = ue.rnti; // the RNTI, until the UL CQI is sent
+      m_ulCqis.push_back (ulCqi);
+    }
+}
+
+MmWaveSchedulerTestBench::~MmWaveSchedulerTestBench ()
+{
+  m_scheduler->Dispose ();
+}
+
+void
+MmWaveSchedulerTestBench::SendReports ()
+{
+  for (unsigned i = 0; i < m_dlBuffers.size (); i++)
+    {
+      m_scheduler->GetMacSchedSapProvider ()->SchedDlRlcBufferReq (m_dlBuffers[i]);
+    }
+  m_scheduler->GetMacSchedSapProvider ()->SchedUlMacCtrlInfoReq (m_bsrs);
+  m_scheduler->GetMacSchedSapProvider ()->SchedDlCqiInfoReq (m_dlCqis);
+}
+
+void
+MmWaveSchedulerTestBench::Schedule (unsigned sf)
+{
+  MmWaveMacSchedSapProvider::SchedTriggerReqParameters triggerParams;
+  triggerParams.m_snfSf = SfnSf (1 + sf / m_config->GetSubframesPerFrame (), sf % m_config->GetSubframesPerFrame (), 0);
+  m_scheduler->GetMacSchedSapProvider ()->SchedTriggerReq (triggerParams);
+
+  const std::vector<SlotAllocInfo> &slots = m_sapUser.m_decision->m_sfAllocInfo.m_slotAllocInfo;
+  for (unsigned i = 0; i < slots.size (); i++)
+    {
+      if (slots[i].m_slotType != SlotAllocInfo::CTRL_DATA || slots[i].m_tddMode != SlotAllocInfo::UL)
+        {
+          continue;
+        }
+      for (unsigned u = 0; u < m_ulCqis.size (); u++)
+        {
+          MmWaveMacSchedSapProvider::SchedUlCqiInfoReqParameters &ulCqi = m_ulCqis[u];
+          if (ulCqi.m_sfnSf.m_frameNum == slots[i].m_dci.m_rnti)
+            {
+              SfnSf rntiSfn = ulCqi.m_sfnSf;
+              ulCqi.m_sfnSf = m_sapUser.m_decision->m_sfnSf;
+              ulCqi.m_sfnSf.m_slotNum = slots[i].m_dci.m_symStart;
+              m_scheduler->GetMacSchedSapProvider ()->SchedUlCqiInfoReq (ulCqi);
+              ulCqi.m_sfnSf = rntiSfn;
+            }
+        }
+    }
+}
+
+std::string
+MmWaveSchedulerTestBench::GetDecision () const
+{
+  std::ostringstream decision;
+  const std::vector<SlotAllocInfo> &slots = m_sapUser.m_decision->m_sfAllocInfo.m_slotAllocInfo;
+  for (unsigned i = 0; i < slots.size (); i++)
+    {
+      if (slots[i].m_slotType == SlotAllocInfo::CTRL_DATA)
+        {
+          decision << (decision.tellp () > 0 ? " " : "") << (slots[i].m_tddMode == SlotAllocInfo::DL ? "DL" : "UL")
+                   << slots[i].m_dci.m_rnti << "x" << (unsigned) slots[i].m_dci.m_numSym;
+        }
+    }
+  return decision.str ();
+}
+
+/**
+ * \brief Checks the symbols that a Flex-TTI scheduler gives to the UEs in consecutive subframes,
+ * for fixed CQIs and buffers. The UEs, their logical channel 3 and their CQIs are configured,
+ * the buffers are reported once before the first subframe and the scheduler drains them; the UL
+ * SINR of each UL allocation is reported after its subframe.
+ */
+class MmWaveFlexTtiSchedulerTestCase : public TestCase
+{
+public:
+  /**
+   * \param [in] name The name of the test case.
+   * \param [in] scheduler The TypeId name of the scheduler.
+   * \param [in] fixedTti The FixedTti attribute of the scheduler.
+   * \param [in] ues The UEs and their traffic.
+   * \param [in] expected The decisions expected in the first subframes, as written by
+   * MmWaveSchedulerTestBench::GetDecision.
+   */
+  MmWaveFlexTtiSchedulerTestCase (std::string name, std::string scheduler, bool fixedTti,
+                                  const std::vector<MmWaveSchedulerTestUe> &ues,
+                                  const std::vector<std::string> &expected);
+  virtual ~MmWaveFlexTtiSchedulerTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  std::string m_scheduler;
+  bool m_fixedTti;
+  std::vector<MmWaveSchedulerTestUe> m_ues;
+  std::vector<std::string> m_expected;
+};
+
+MmWaveFlexTtiSchedulerTestCase::MmWaveFlexTtiSchedulerTestCase (std::string name, std::string scheduler, bool fixedTti,
+                                                                const std::vector<MmWaveSchedulerTestUe> &ues,
+                                                                const std::vector<std::string> &expected)
+  : TestCase (name),
+    m_scheduler (scheduler),
+    m_fixedTti (fixedTti),
+    m_ues (ues),
+    m_expected (expected)
+{
+}
+
+MmWaveFlexTtiSchedulerTestCase::~MmWaveFlexTtiSchedulerTestCase ()
+{
+}
+
+void
+MmWaveFlexTtiSchedulerTestCase::DoRun (void)
+{
+  MmWaveSchedulerTestBench bench (m_scheduler, m_fixedTti, m_ues);
+  bench.SendReports ();
+  for (unsigned sf = 0; sf < m_expected.size (); sf++)
+    {
+      bench.Schedule (sf);
+      NS_TEST_ASSERT_MSG_EQ (bench.GetDecision (), m_expected[sf], m_scheduler << " subframe " << sf);
+    }
+}
+
+/**
+ * \brief Counts the heap allocations of the scheduler in steady state. The buffers of the UEs
+ * are reported again before every subframe, so that they never drain, and after a warm-up every
+ * call to the scheduler of a subframe (buffer and CQI reports, SchedTriggerReq and the UL CQIs
+ * of the decision) must not allocate. The warm-up is long enough for the UL packet queues of
+ * MaxWeight, estimated from the BSRs, to reach their longest.
+ */
+class MmWaveFlexTtiSchedulerAllocationTestCase : public TestCase
+{
+public:
+  /**
+   * \param [in] scheduler The TypeId name of the scheduler.
+   * \param [in] ues The UEs and their traffic.
+   */
+  MmWaveFlexTtiSchedulerAllocationTestCase (std::string scheduler, const std::vector<MmWaveSchedulerTestUe> &ues);
+  virtual ~MmWaveFlexTtiSchedulerAllocationTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Sends the reports of a subframe, schedules it and counts its allocations.
+   * \param [in] bench The scheduler under test.
+   * \param [in] sf The number of the subframe, from 0.
+   */
+  void DoSubframe (MmWaveSchedulerTestBench *bench, unsigned sf);
+
+  std::string m_scheduler;
+  std::vector<MmWaveSchedulerTestUe> m_ues;
+  unsigned m_warmUp;          //!< Subframes whose allocations are not counted.
+  uint64_t m_allocations;     //!< Allocations after the warm-up.
+  uint64_t m_allocSubframes;  //!< Subframes that allocated after the warm-up.
+};
+
+MmWaveFlexTtiSchedulerAllocationTestCase::MmWaveFlexTtiSchedulerAllocationTestCase (std::string scheduler,
+                                                                                    const std::vector<MmWaveSchedulerTestUe> &ues)
+  : TestCase ("Allocations per subframe of " + scheduler),
+    m_scheduler (scheduler),
+    m_ues (ues),
+    m_warmUp (200),
+    m_allocations (0),
+    m_allocSubframes (0)
+{
+}
+
+MmWaveFlexTtiSchedulerAllocationTestCase::~MmWaveFlexTtiSchedulerAllocationTestCase ()
+{
+}
+
+void
+MmWaveFlexTtiSchedulerAllocationTestCase::DoSubframe (MmWaveSchedulerTestBench *bench, unsigned sf)
+{
+  g_numAllocations = 0;
+  g_countAllocations = true;
+  bench->SendReports ();
+  bench->Schedule (sf);
+  g_countAllocations = false;
+  NS_TEST_ASSERT_MSG_NE (bench->GetDecision (), "", "Nothing scheduled in subframe " << sf);
+  if (sf >= m_warmUp && g_numAllocations > 0)
+    {
+      m_allocations += g_numAllocations;
+      m_allocSubframes++;
+    }
+}
+
+void
+MmWaveFlexTtiSchedulerAllocationTestCase::DoRun (void)
+{
+  // the subframes are simulator events, as in the MAC: before Simulator::Run, Simulator::Now
+  // allocates to record the times whose resolution may still change
+  MmWaveSchedulerTestBench bench (m_scheduler, false, m_ues);
+  unsigned numSubframes = 1000;
+  m_allocations = 0;
+  m_allocSubframes = 0;
+  for (unsigned sf = 0; sf < m_warmUp + numSubframes; sf++)
+    {
+      Simulator::Schedule (MilliSeconds (sf), &MmWaveFlexTtiSchedulerAllocationTestCase::DoSubframe, this, &bench, sf);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  NS_TEST_ASSERT_MSG_EQ (m_allocations, 0, m_scheduler << " allocated in " << m_allocSubframes << " of " << numSubframes << " subframes");
+}
+
+/**
+ * \brief Test suite of the symbol allocation of the Flex-TTI schedulers.
+ */
+class MmWaveFlexTtiSchedulerTestSuite : public TestSuite
+{
+public:
+  MmWaveFlexTtiSchedulerTestSuite ();
+};
+
+MmWaveFlexTtiSchedulerTestSuite::MmWaveFlexTtiSchedulerTestSuite ()
+  : TestSuite ("mmwave-flex-tti-mac-scheduler", UNIT)
+{
+  // RNTI 1 has the best CQI, RNTI 2 a small DL buffer and UL data, RNTI 3 the worst CQI and
+  // RNTI 4 UL data only
+  MmWaveSchedulerTestUe ues[] = {
+    {1, 15, 20000, 2, 0, 0},
+    {2, 9, 3000, 6, 5000, 100},
+    {3, 4, 20000, 4, 0, 0},
+    {4, 0, 0, 0, 20000, 3},
+  };
+  std::vector<MmWaveSchedulerTestUe> mixed (ues, ues + 4);
+
+  const char *flexTti[] = {"DL1x12 DL2x5 DL3x31 UL2x31 UL4x31", "DL3x37 UL2x37 UL4x36", "DL3x43 UL4x12 UL2x44", "UL2x2", "", ""};
+  AddTestCase (new MmWaveFlexTtiSchedulerTestCase ("Even share", "ns3::MmWaveFlexTtiMacScheduler", false, mixed,
+                                                   std::vector<std::string> (flexTti, flexTti + 6)), TestCase::QUICK);
+  // counting the DL average twice, as the baseline did, the UL only RNTI 4 keeps a zero average
+  // and it takes 107 of the 110 symbols of the first subframe
+  const char *pf[] = {"DL1x6 DL2x3 DL3x50 UL4x51", "DL1x6 DL2x2 DL3x59 UL4x43", "DL3x2 UL2x106 UL4x2", "UL2x8", "", ""};
+  AddTestCase (new MmWaveFlexTtiSchedulerTestCase ("Proportional fair", "ns3::MmWaveFlexTtiPfMacScheduler", false, mixed,
+                                                   std::vector<std::string> (pf, pf + 6)), TestCase::QUICK);
+  const char *pfFixedTti[] = {"DL1x6 DL2x6 DL3x48 UL4x50", "DL1x6 DL3x30 UL2x50 UL4x24", "DL3x30 UL2x56 UL4x24", "DL3x6 UL2x12", "", ""};
+  AddTestCase (new MmWaveFlexTtiSchedulerTestCase ("Proportional fair with FixedTti", "ns3::MmWaveFlexTtiPfMacScheduler", true, mixed,
+                                                   std::vector<std::string> (pfFixedTti, pfFixedTti + 6)), TestCase::QUICK);
+  const char *maxRate[] = {"DL1x12 DL2x5 UL2x93", "DL3x109 UL2x1", "DL3x2 UL4x108", "UL4x39", "", ""};
+  AddTestCase (new MmWaveFlexTtiSchedulerTestCase ("Maximum rate", "ns3::MmWaveFlexTtiMaxRateMacScheduler", false, mixed,
+                                                   std::vector<std::string> (maxRate, maxRate + 6)), TestCase::QUICK);
+  const char *maxWeight[] = {"DL2x5 DL3x105", "DL1x12 DL3x6 UL2x92", "UL2x22 UL4x88", "UL4x41", "", ""};
+  AddTestCase (new MmWaveFlexTtiSchedulerTestCase ("Maximum weight, EDF", "ns3::MmWaveFlexTtiMaxWeightMacScheduler", false, mixed,
+                                                   std::vector<std::string> (maxWeight, maxWeight + 6)), TestCase::QUICK);
+
+  // saturated buffers, in steady state
+  AddTestCase (new MmWaveFlexTtiSchedulerAllocationTestCase ("ns3::MmWaveFlexTtiMacScheduler", mixed), TestCase::QUICK);
+  AddTestCase (new MmWaveFlexTtiSchedulerAllocationTestCase ("ns3::MmWaveFlexTtiPfMacScheduler", mixed), TestCase::QUICK);
+  AddTestCase (new MmWaveFlexTtiSchedulerAllocationTestCase ("ns3::MmWaveFlexTtiMaxRateMacScheduler", mixed), TestCase::QUICK);
+  AddTestCase (new MmWaveFlexTtiSchedulerAllocationTestCase ("ns3::MmWaveFlexTtiMaxWeightMacScheduler", mixed), TestCase::QUICK);
+}
+
+static MmWaveFlexTtiSchedulerTestSuite mmwaveFlexTtiSchedulerTestSuite;
@@ -0,0 +1,228 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/mmwave-mi-error-model.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/double.h"
+#include "ns3/test.h"
+#include <cmath>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \param [in] sinr The linear SINR of each chunk.
+ * \param [in] map The chunks of the TB.
+ * \param [in] mcs The MCS of the TB.
+ * \returns The mmib of the TB with the per-chunk lookup of the modulation of the MCS, as
+ * computed before MmWaveMiErrorModel::Mib and MibAllModulations.
+ */
+static double
+GetReferenceMib (const SpectrumValue &sinr, const std::vector<int> &map, uint8_t mcs)
+{
+  double MI;
+  double MIsum = 0.0;
+  Values::const_iterator sinrBegin = sinr.ConstValuesBegin ();
+  for (uint32_t i = 0; i < map.size (); i++)
+    {
+      double sinrLin = *(sinrBegin + map.at (i));
+      if (mcs <= MI_QPSK_MAX_ID)
+        {
+          if (sinrLin > MI_map_qpsk_axis[MI_MAP_QPSK_SIZE - 1])
+            {
+              MI = 1;
+            }
+          else
+            {
+              static const double scalingCoeffQpsk =
+                (MI_MAP_QPSK_SIZE - 1) / (MI_map_qpsk_axis[MI_MAP_QPSK_SIZE - 1] - MI_map_qpsk_axis[0]);
+              double sinrIndexDouble = (sinrLin - MI_map_qpsk_axis[0]) * scalingCoeffQpsk + 1;
+              uint32_t sinrIndex = std::max (0.0, std::floor (sinrIndexDouble));
+              MI = MI_map_qpsk[sinrIndex];
+            }
+        }
+      else if (mcs <= MI_16QAM_MAX_ID)
+        {
+          if (sinrLin > MI_map_16qam_axis[MI_MAP_16QAM_SIZE - 1])
+            {
+              MI = 1;
+            }
+          else
+            {
+              static const double scalingCoeff16qam =
+                (MI_MAP_16QAM_SIZE - 1) / (MI_map_16qam_axis[MI_MAP_16QAM_SIZE - 1] - MI_map_16qam_axis[0]);
+              double sinrIndexDouble = (sinrLin - MI_map_16qam_axis[0]) * scalingCoeff16qam + 1;
+              uint32_t sinrIndex = std::max (0.0, std::floor (sinrIndexDouble));
+              MI = MI_map_16qam[sinrIndex];
+            }
+        }
+      else
+        {
+          if (sinrLin > MI_map_64qam_axis[MI_MAP_64QAM_SIZE - 1])
+            {
+              MI = 1;
+            }
+          else
+            {
+              static const double scalingCoeff64qam =
+                (MI_MAP_64QAM_SIZE - 1) / (MI_map_64qam_axis[MI_MAP_64QAM_SIZE - 1] - MI_map_64qam_axis[0]);
+              double sinrIndexDouble = (sinrLin - MI_map_64qam_axis[0]) * scalingCoeff64qam + 1;
+              uint32_t sinrIndex = std::max (0.0, std::floor (sinrIndexDouble));
+              MI = MI_map_64qam[sinrIndex];
+            }
+        }
+      MIsum += MI;
+    }
+  return MIsum / map.size ();
+}
+
+/**
+ * \brief Compares MmWaveMiErrorModel::Mib and MibAllModulations, and the TBLER of the 29 MCSs
+ * computed from them, with the per-chunk lookup they replace. The results must be exactly the
+ * same.
+ *
+ * The TBs are sent over random sets of consecutive chunks of random SINRs, plus a TB whose
+ * chunks are on the ends of the axes of the three MI maps.
+ */
+class MmWaveMiErrorModelTestCase : public TestCase
+{
+public:
+  /**
+   * \param [in] name The name of the test case.
+   * \param [in] run The run number of the random TBs.
+   * \param [in] numTbs The number of random TBs.
+   */
+  MmWaveMiErrorModelTestCase (std::string name, uint32_t run, uint32_t numTbs);
+  virtual ~MmWaveMiErrorModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \param [in] sinr The linear SINR of each chunk.
+   * \param [in] map The chunks of the TB.
+   * \param [in] tb The number of the TB, for the messages.
+   */
+  void CheckTb (const SpectrumValue &sinr, const std::vector<int> &map, uint32_t tb);
+
+  uint32_t m_run;
+  uint32_t m_numTbs;
+};
+
+MmWaveMiErrorModelTestCase::MmWaveMiErrorModelTestCase (std::string name, uint32_t run, uint32_t numTbs)
+  : TestCase (name),
+    m_run (run),
+    m_numTbs (numTbs)
+{
+}
+
+MmWaveMiErrorModelTestCase::~MmWaveMiErrorModelTestCase ()
+{
+}
+
+void
+MmWaveMiErrorModelTestCase::CheckTb (const SpectrumValue &sinr, const std::vector<int> &map, uint32_t tb)
+{
+  MmWaveHarqProcessInfoList_t harqInfoList;
+  uint32_t tbSize = 1000;
+  double mib[MI_NUM_MODULATIONS];
+  MmWaveMiErrorModel::MibAllModulations (sinr, map, mib);
+  for (uint8_t mcs = 0; mcs <= 28; mcs++)
+    {
+      double referenceMib = GetReferenceMib (sinr, map, mcs);
+      NS_TEST_ASSERT_MSG_EQ (MmWaveMiErrorModel::Mib (sinr, map, mcs), referenceMib,
+                             "Mib differs from the per-chunk lookup, TB " << tb << " MCS " << (uint16_t) mcs);
+      NS_TEST_ASSERT_MSG_EQ (mib[MmWaveMiErrorModel::GetModulationIndex (mcs)], referenceMib,
+                             "MibAllModulations differs from the per-chunk lookup, TB " << tb << " MCS " << (uint16_t) mcs);
+
+      double referenceTbler = MmWaveMiErrorModel::GetTbDecodificationStatsFromMib (referenceMib, tbSize, mcs, harqInfoList).tbler;
+      NS_TEST_ASSERT_MSG_EQ (MmWaveMiErrorModel::GetTbDecodificationStats (sinr, map, tbSize, mcs, harqInfoList).tbler,
+                             referenceTbler, "TBLER of Mib differs, TB " << tb << " MCS " << (uint16_t) mcs);
+      NS_TEST_ASSERT_MSG_EQ (MmWaveMiErrorModel::GetTbDecodificationStatsFromMib (mib[MmWaveMiErrorModel::GetModulationIndex (mcs)],
+                                                                                  tbSize, mcs, harqInfoList).tbler,
+                             referenceTbler, "TBLER of MibAllModulations differs, TB " << tb << " MCS " << (uint16_t) mcs);
+    }
+}
+
+void
+MmWaveMiErrorModelTestCase::DoRun (void)
+{
+  uint32_t numChunks = 72;
+  Ptr<SpectrumModel> model = Create<SpectrumModel> (std::vector<double> (numChunks, 1.0));
+
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (m_run);
+  Ptr<UniformRandomVariable> sinrDb = CreateObject<UniformRandomVariable> ();
+  sinrDb->SetStream (0);
+  sinrDb->SetAttribute ("Min", DoubleValue (-10.0));
+  sinrDb->SetAttribute ("Max", DoubleValue (40.0));
+  Ptr<UniformRandomVariable> chunk = CreateObject<UniformRandomVariable> ();
+  chunk->SetStream (1);
+
+  for (uint32_t tb = 0; tb < m_numTbs; tb++)
+    {
+      SpectrumValue sinr (model);
+      for (uint32_t c = 0; c < numChunks; c++)
+        {
+          sinr[c] = std::pow (10.0, sinrDb->GetValue () / 10.0);
+        }
+      uint32_t first = chunk->GetInteger (0, numChunks - 1);
+      uint32_t last = chunk->GetInteger (first, numChunks - 1);
+      std::vector<int> map;
+      for (uint32_t c = first; c <= last; c++)
+        {
+          map.push_back (c);
+        }
+      CheckTb (sinr, map, tb);
+    }
+
+  // the ends of the axes, and just below and above them
+  double axisEnds[6] = {MI_map_qpsk_axis[0], MI_map_qpsk_axis[MI_MAP_QPSK_SIZE - 1],
+                        MI_map_16qam_axis[0], MI_map_16qam_axis[MI_MAP_16QAM_SIZE - 1],
+                        MI_map_64qam_axis[0], MI_map_64qam_axis[MI_MAP_64QAM_SIZE - 1]};
+  SpectrumValue sinr (model);
+  std::vector<int> map;
+  for (uint32_t c = 0; c < 18; c++)
+    {
+      double scale[3] = {0.999, 1.0, 1.001};
+      sinr[c] = axisEnds[c / 3] * scale[c % 3];
+      map.push_back (c);
+    }
+  CheckTb (sinr, map, m_numTbs);
+}
+
+/**
+ * \brief Test suite of the mmib lookup of the MI error model.
+ */
+class MmWaveMiErrorModelTestSuite : public TestSuite
+{
+public:
+  MmWaveMiErrorModelTestSuite ();
+};
+
+MmWaveMiErrorModelTestSuite::MmWaveMiErrorModelTestSuite ()
+  : TestSuite ("mmwave-mi-error-model", UNIT)
+{
+  for (uint32_t run = 1; run <= 3; run++)
+    {
+      std::ostringstream name;
+      name << "Mib and MibAllModulations against the per-chunk lookup, run " << run;
+      AddTestCase (new MmWaveMiErrorModelTestCase (name.str (), run, 500), TestCase::QUICK);
+    }
+}
+
+static MmWaveMiErrorModelTestSuite mmwaveMiErrorModelTestSuite;
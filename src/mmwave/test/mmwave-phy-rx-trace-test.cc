@@ -0,0 +1,175 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/mmwave-phy-rx-trace.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/test.h"
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \brief Writes the same PHY traces with a text and a binary MmWavePhyRxTrace, converts the
+ * binary files with MmWavePhyRxTrace::ConvertBinaryFile and checks that the result is the text
+ * trace, byte for byte.
+ *
+ * The traces are written to the files of the current directory, so the test case moves to its
+ * temporary directory while it runs.
+ */
+class MmWavePhyRxTraceTestCase : public TestCase
+{
+public:
+  MmWavePhyRxTraceTestCase ();
+  virtual ~MmWavePhyRxTraceTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Reports one event of every trace
+   * \param [in] trace The trace the events are reported to.
+   * \param [in] i The number of the events, which sets their values.
+   */
+  static void Report (Ptr<MmWavePhyRxTrace> trace, uint32_t i);
+
+  /**
+   * \param [in] path The path of the file.
+   * \returns The content of the file.
+   */
+  static std::string ReadFile (std::string path);
+};
+
+MmWavePhyRxTraceTestCase::MmWavePhyRxTraceTestCase ()
+  : TestCase ("Binary PHY traces converted to the text format")
+{
+}
+
+MmWavePhyRxTraceTestCase::~MmWavePhyRxTraceTestCase ()
+{
+}
+
+void
+MmWavePhyRxTraceTestCase::Report (Ptr<MmWavePhyRxTrace> trace, uint32_t i)
+{
+  RxPacketTraceParams params;
+  params.m_cellId = 1;
+  params.m_rnti = 2 + i % 3;
+  params.m_frameNum = i / 10;
+  params.m_sfNum = i % 10;
+  params.m_slotNum = 0;
+  params.m_symStart = 1 + i % 5;
+  params.m_numSym = 4 + i % 7;
+  params.m_tbSize = 100 + 37 * i;
+  params.m_mcs = i % 29;
+  params.m_rv = i % 4;
+  params.m_sinr = 0.5 + 3.1 * i;
+  params.m_sinrMin = params.m_sinr;
+  params.m_tbler = 1.0 / (i + 3);
+  params.m_corrupt = (i % 4 == 1);
+  MmWavePhyRxTrace::RxPacketTraceUeCallback (trace, "", params);
+  params.m_rnti++;
+  MmWavePhyRxTrace::RxPacketTraceEnbCallback (trace, "", params);
+
+  Ptr<SpectrumModel> model = Create<SpectrumModel> (std::vector<double> (4, 1.0));
+  SpectrumValue sinr (model);
+  for (uint32_t rb = 0; rb < 4; rb++)
+    {
+      sinr[rb] = 0.25 + 1.7 * i + rb;
+    }
+  MmWavePhyRxTrace::ReportCurrentCellRsrpSinrCallback (trace, "", 1, sinr, sinr);
+  MmWavePhyRxTrace::UlSinrTraceCallback (trace, "", 1, sinr, sinr);
+
+  UePhyPacketCountParameter ueCount;
+  ueCount.m_imsi = 1;
+  ueCount.m_noBytes = 1000 + i;
+  ueCount.m_isTx = (i % 2 == 0);
+  ueCount.m_subframeno = i;
+  MmWavePhyRxTrace::ReportPacketCountUeCallback (trace, "", ueCount);
+  EnbPhyPacketCountParameter enbCount;
+  enbCount.m_cellId = 1;
+  enbCount.m_noBytes = 2000 + i;
+  enbCount.m_isTx = (i % 2 == 1);
+  enbCount.m_subframeno = i;
+  MmWavePhyRxTrace::ReportPacketCountEnbCallback (trace, "", enbCount);
+
+  MmWavePhyRxTrace::ReportDownLinkTBSize (trace, "", 1, 500 + 11 * i);
+}
+
+std::string
+MmWavePhyRxTraceTestCase::ReadFile (std::string path)
+{
+  std::ifstream file (path.c_str (), std::ifstream::binary);
+  std::ostringstream content;
+  content << file.rdbuf ();
+  return content.str ();
+}
+
+void
+MmWavePhyRxTraceTestCase::DoRun (void)
+{
+  std::string tempDir = CreateTempDirFilename ("");
+  char cwd[4096];
+  NS_TEST_ASSERT_MSG_NE (getcwd (cwd, sizeof (cwd)), 0, "Unable to get the current directory");
+  NS_TEST_ASSERT_MSG_EQ (chdir (tempDir.c_str ()), 0, "Unable to move to " << tempDir);
+
+  Ptr<MmWavePhyRxTrace> text = CreateObject<MmWavePhyRxTrace> ();
+  Ptr<MmWavePhyRxTrace> binary = CreateObject<MmWavePhyRxTrace> ();
+  binary->SetAttribute ("BinaryFormat", BooleanValue (true));
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Simulator::Schedule (MicroSeconds (125 * i), &MmWavePhyRxTraceTestCase::Report, text, i);
+      Simulator::Schedule (MicroSeconds (125 * i), &MmWavePhyRxTraceTestCase::Report, binary, i);
+    }
+  Simulator::Run ();
+  // the sinks are flushed and closed
+  Simulator::Destroy ();
+
+  const char *files[] = {"RxPacketTraceUe", "UE_1_SINR_dB", "UE_1_UL_SINR_dB", "UE_1_Packet_Trace",
+                         "BS_1_Packet_Trace", "UE_1_Tb_Size"};
+  // the RxPacketTrace file has a header, both sinks a record per event
+  uint64_t records[] = {1 + 2 * 20, 20, 20, 20, 20, 20};
+  for (uint32_t f = 0; f < 6; f++)
+    {
+      std::string name = files[f];
+      uint64_t converted = MmWavePhyRxTrace::ConvertBinaryFile (name + ".bin", name + ".converted.txt");
+      NS_TEST_EXPECT_MSG_EQ (converted, records[f], "Records converted from " << name);
+      std::string expected = ReadFile (name + ".txt");
+      NS_TEST_EXPECT_MSG_NE (expected.size (), 0, "Empty text trace " << name);
+      NS_TEST_EXPECT_MSG_EQ (ReadFile (name + ".converted.txt"), expected, "Converted trace differs from the text trace " << name);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (chdir (cwd), 0, "Unable to move back to " << cwd);
+}
+
+/**
+ * \brief Test suite of the PHY traces.
+ */
+class MmWavePhyRxTraceTestSuite : public TestSuite
+{
+public:
+  MmWavePhyRxTraceTestSuite ();
+};
+
+MmWavePhyRxTraceTestSuite::MmWavePhyRxTraceTestSuite ()
+  : TestSuite ("mmwave-phy-rx-trace", UNIT)
+{
+  AddTestCase (new MmWavePhyRxTraceTestCase, TestCase::QUICK);
+}
+
+static MmWavePhyRxTraceTestSuite mmwavePhyRxTraceTestSuite;
@@ -0,0 +1,413 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/mmwave-sector-search.h"
+#include "ns3/antenna-array-model.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/double.h"
+#include "ns3/test.h"
+#include <cmath>
+#include <sstream>
+
+using namespace ns3;
+
+// Same subbands as a 1 GHz carrier at 28 GHz split in 72 chunks
+static const double g_centreFrequency = 28e9;
+static const double g_chunkWidth = 13.889e6;
+static const uint32_t g_numChunks = 72;
+
+/**
+ * \param [in] antennaNum The number of antennas in each direction.
+ * \param [in] sector The horizontal sector.
+ * \param [in] elevation The elevation, in degrees.
+ * \returns The steering vector of AntennaArrayModel::SetSector, computed from its definition.
+ */
+static complexVector_t
+GetSteeringVector (uint8_t *antennaNum, uint16_t sector, double elevation)
+{
+  double hAngle = M_PI * sector / antennaNum[1] - 0.5 * M_PI;
+  double vAngle = elevation * M_PI / 180;
+  uint16_t size = antennaNum[0] * antennaNum[1];
+  complexVector_t steering;
+  for (uint16_t ind = 0; ind < size; ind++)
+    {
+      // element locations of AntennaArrayModel::GetAntennaLocation, half a wavelength apart
+      double y = 0.5 * (ind % antennaNum[0]);
+      double z = 0.5 * floor (ind / antennaNum[0]);
+      double phase = -2 * M_PI * (sin (vAngle) * sin (hAngle) * y + cos (vAngle) * z);
+      steering.push_back (std::exp (std::complex<double> (0, phase)) / sqrt (size));
+    }
+  return steering;
+}
+
+/**
+ * Direction of arrival or departure of a cluster
+ */
+struct ClusterDirection
+{
+  double m_elevation; // degree
+  double m_azimuth; // degree
+};
+
+/**
+ * \brief Compares MmWaveSectorSearch with the loop MmWave3gppChannel::BeamSearchBeamforming
+ * used before the search engine: every pair of sectors of the grid with elevations 60, 70, ...,
+ * 120 degrees, the gain of each pair computed subband by subband with the steering vectors of
+ * SetSector, the first pair with the highest gain kept.
+ *
+ * The channels are a sum of plane waves, one per cluster, plus a small diffuse part, drawn
+ * from seeded random variables.
+ */
+class MmWaveSectorSearchTestCase : public TestCase
+{
+public:
+  /**
+   * \param [in] name The name of the test case.
+   * \param [in] run The run number of the random channel.
+   * \param [in] numClusters The number of clusters of the channel.
+   */
+  MmWaveSectorSearchTestCase (std::string name, uint32_t run, uint32_t numClusters);
+  virtual ~MmWaveSectorSearchTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \param [in] antennaNum The number of antennas in each direction.
+   * \param [in] direction The direction of the plane wave.
+   * \returns The response of the array to a plane wave, matched by the steering vectors.
+   */
+  complexVector_t GetArrayResponse (uint8_t *antennaNum, ClusterDirection direction) const;
+
+  /**
+   * \param [in] txW The tx beamforming vector.
+   * \param [in] rxW The rx beamforming vector.
+   * \returns The beamforming gain averaged over the subbands, as computed by CalLongTerm and
+   * CalBeamformingGain.
+   */
+  double GetReferenceGain (const complexVector_t &txW, const complexVector_t &rxW) const;
+
+  uint32_t m_run;
+  uint32_t m_numClusters;
+  complex3DVector_t m_channel; // H[rx][tx][cluster]
+  doubleVector_t m_delay; // s
+};
+
+MmWaveSectorSearchTestCase::MmWaveSectorSearchTestCase (std::string name, uint32_t run, uint32_t numClusters)
+  : TestCase (name),
+    m_run (run),
+    m_numClusters (numClusters)
+{
+}
+
+MmWaveSectorSearchTestCase::~MmWaveSectorSearchTestCase ()
+{
+}
+
+complexVector_t
+MmWaveSectorSearchTestCase::GetArrayResponse (uint8_t *antennaNum, ClusterDirection direction) const
+{
+  double hAngle = direction.m_azimuth * M_PI / 180;
+  double vAngle = direction.m_elevation * M_PI / 180;
+  uint16_t size = antennaNum[0] * antennaNum[1];
+  complexVector_t response;
+  for (uint16_t ind = 0; ind < size; ind++)
+    {
+      double y = 0.5 * (ind % antennaNum[0]);
+      double z = 0.5 * floor (ind / antennaNum[0]);
+      double phase = 2 * M_PI * (sin (vAngle) * sin (hAngle) * y + cos (vAngle) * z);
+      response.push_back (std::exp (std::complex<double> (0, phase)));
+    }
+  return response;
+}
+
+double
+MmWaveSectorSearchTestCase::GetReferenceGain (const complexVector_t &txW, const complexVector_t &rxW) const
+{
+  complexVector_t longTerm;
+  for (uint32_t cIndex = 0; cIndex < m_numClusters; cIndex++)
+    {
+      std::complex<double> txSum (0, 0);
+      for (uint32_t txIndex = 0; txIndex < txW.size (); txIndex++)
+        {
+          std::complex<double> rxSum (0, 0);
+          for (uint32_t rxIndex = 0; rxIndex < rxW.size (); rxIndex++)
+            {
+              rxSum = rxSum + std::conj (rxW[rxIndex]) * m_channel[rxIndex][txIndex][cIndex];
+            }
+          txSum = txSum + txW[txIndex] * rxSum;
+        }
+      longTerm.push_back (txSum);
+    }
+  double sum = 0;
+  for (uint32_t iSubband = 0; iSubband < g_numChunks; iSubband++)
+    {
+      double fsb = g_centreFrequency - g_chunkWidth * g_numChunks / 2 + g_chunkWidth * iSubband;
+      std::complex<double> subbandGain (0, 0);
+      for (uint32_t cIndex = 0; cIndex < m_numClusters; cIndex++)
+        {
+          double delay = -2 * M_PI * fsb * m_delay[cIndex];
+          subbandGain = subbandGain + longTerm[cIndex] * std::exp (std::complex<double> (0, delay));
+        }
+      sum += norm (subbandGain);
+    }
+  return sum / g_numChunks;
+}
+
+void
+MmWaveSectorSearchTestCase::DoRun (void)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (m_run);
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  uniform->SetStream (0);
+  Ptr<NormalRandomVariable> normal = CreateObject<NormalRandomVariable> ();
+  normal->SetStream (1);
+
+  uint8_t txAntennaNum[2] = {8, 8};
+  uint8_t rxAntennaNum[2] = {4, 4};
+  uint16_t txSize = txAntennaNum[0] * txAntennaNum[1];
+  uint16_t rxSize = rxAntennaNum[0] * rxAntennaNum[1];
+
+  // the first cluster is the strongest one and points to sectors of the grid, odd ones
+  // for odd runs, which are not in the coarse grid of the hierarchical search
+  std::vector<ClusterDirection> txDirection;
+  std::vector<ClusterDirection> rxDirection;
+  std::vector<std::complex<double> > clusterGain;
+  for (uint32_t cIndex = 0; cIndex < m_numClusters; cIndex++)
+    {
+      ClusterDirection tx;
+      ClusterDirection rx;
+      if (cIndex == 0)
+        {
+          uint16_t txSector = 2 * (m_run % 4) + m_run % 2;
+          uint16_t rxSector = 2 - m_run % 2;
+          tx.m_elevation = 80 - 10 * (m_run % 2);
+          tx.m_azimuth = 180.0 * txSector / txAntennaNum[1] - 90;
+          rx.m_elevation = 100 + 10 * (m_run % 2);
+          rx.m_azimuth = 180.0 * rxSector / rxAntennaNum[1] - 90;
+        }
+      else
+        {
+          tx.m_elevation = uniform->GetValue (60, 120);
+          tx.m_azimuth = uniform->GetValue (-90, 90);
+          rx.m_elevation = uniform->GetValue (60, 120);
+          rx.m_azimuth = uniform->GetValue (-90, 90);
+        }
+      txDirection.push_back (tx);
+      rxDirection.push_back (rx);
+      double power = cIndex == 0 ? 1 : 0.5 * exp (-0.3 * cIndex);
+      clusterGain.push_back (sqrt (power) * std::exp (std::complex<double> (0, uniform->GetValue (0, 2 * M_PI))));
+      m_delay.push_back (cIndex == 0 ? 0 : uniform->GetValue (0, 300e-9));
+    }
+
+  m_channel.assign (rxSize, complex2DVector_t (txSize, complexVector_t (m_numClusters)));
+  for (uint32_t cIndex = 0; cIndex < m_numClusters; cIndex++)
+    {
+      complexVector_t txResponse = GetArrayResponse (txAntennaNum, txDirection[cIndex]);
+      // the conjugate rx response is matched by the conjugate rx beamforming vector
+      complexVector_t rxResponse = GetArrayResponse (rxAntennaNum, rxDirection[cIndex]);
+      for (uint16_t rxIndex = 0; rxIndex < rxSize; rxIndex++)
+        {
+          for (uint16_t txIndex = 0; txIndex < txSize; txIndex++)
+            {
+              std::complex<double> diffuse (normal->GetValue (0, 0.01), normal->GetValue (0, 0.01));
+              m_channel[rxIndex][txIndex][cIndex] = clusterGain[cIndex] * std::conj (rxResponse[rxIndex])
+                * txResponse[txIndex] + diffuse;
+            }
+        }
+    }
+
+  // reference loop over the sectors
+  double maxGain = 0;
+  uint32_t maxTxBeam = 0;
+  uint32_t maxRxBeam = 0;
+  std::vector<double> referenceGain;
+  uint32_t numTxSectors = txAntennaNum[1] + 1;
+  uint32_t numRxSectors = rxAntennaNum[1] + 1;
+  for (uint16_t txTheta = 60; txTheta < 121; txTheta = txTheta + 10)
+    {
+      for (uint16_t tx = 0; tx <= txAntennaNum[1]; tx++)
+        {
+          complexVector_t txW = GetSteeringVector (txAntennaNum, tx, txTheta);
+          for (uint16_t rxTheta = 60; rxTheta < 121; rxTheta = rxTheta + 10)
+            {
+              for (uint16_t rx = 0; rx <= rxAntennaNum[1]; rx++)
+                {
+                  double gain = GetReferenceGain (txW, GetSteeringVector (rxAntennaNum, rx, rxTheta));
+                  referenceGain.push_back (gain);
+                  if (maxGain < gain)
+                    {
+                      maxGain = gain;
+                      maxTxBeam = (txTheta - 60) / 10 * numTxSectors + tx;
+                      maxRxBeam = (rxTheta - 60) / 10 * numRxSectors + rx;
+                    }
+                }
+            }
+        }
+    }
+
+  Ptr<AntennaArrayModel> txArray = CreateObject<AntennaArrayModel> ();
+  Ptr<AntennaArrayModel> rxArray = CreateObject<AntennaArrayModel> ();
+  Ptr<const MmWaveSteeringTable> txTable = txArray->GetSteeringTable (txAntennaNum);
+  Ptr<const MmWaveSteeringTable> rxTable = rxArray->GetSteeringTable (rxAntennaNum);
+  uint32_t numRxBeams = rxTable->GetNumBeams ();
+  NS_TEST_ASSERT_MSG_EQ (txTable->GetNumBeams (), 7 * numTxSectors, "Wrong number of tx beams");
+  NS_TEST_ASSERT_MSG_EQ (numRxBeams, 7 * numRxSectors, "Wrong number of rx beams");
+
+  std::vector<double> frequencies;
+  for (uint32_t iSubband = 0; iSubband < g_numChunks; iSubband++)
+    {
+      frequencies.push_back (g_centreFrequency - g_chunkWidth * g_numChunks / 2 + g_chunkWidth * iSubband);
+    }
+  Ptr<SpectrumModel> model = Create<SpectrumModel> (frequencies);
+  SpectrumValue txPsd (model);
+  txPsd = 1e-9;
+
+  MmWaveSectorSearch search;
+  search.SetChannel (m_channel, m_delay, txPsd, frequencies[0], g_chunkWidth);
+  MmWaveSectorSearchResult exhaustive = search.Search (*txTable, *rxTable);
+  NS_TEST_ASSERT_MSG_EQ (exhaustive.m_txBeam, maxTxBeam, "Exhaustive search found a different tx beam");
+  NS_TEST_ASSERT_MSG_EQ (exhaustive.m_rxBeam, maxRxBeam, "Exhaustive search found a different rx beam");
+  NS_TEST_ASSERT_MSG_EQ_TOL (exhaustive.m_gain, maxGain, maxGain * 1e-9, "Exhaustive search found a different gain");
+  NS_TEST_ASSERT_MSG_EQ (exhaustive.m_numPairs, referenceGain.size (), "Exhaustive search skipped pairs");
+
+  MmWaveSectorSearchResult hierarchical = search.SearchHierarchical (*txTable, *rxTable, 4);
+  double pairGain = referenceGain[hierarchical.m_txBeam * numRxBeams + hierarchical.m_rxBeam];
+  NS_TEST_ASSERT_MSG_EQ_TOL (hierarchical.m_gain, pairGain, pairGain * 1e-9, "Hierarchical search reports a wrong gain");
+  NS_TEST_ASSERT_MSG_LT (hierarchical.m_numPairs, exhaustive.m_numPairs, "Hierarchical search evaluated every pair");
+  // the dominant cluster makes the best pair the peak of the neighbourhood of a coarse pair
+  NS_TEST_ASSERT_MSG_EQ (hierarchical.m_txBeam, maxTxBeam, "Hierarchical search found a different tx beam");
+  NS_TEST_ASSERT_MSG_EQ (hierarchical.m_rxBeam, maxRxBeam, "Hierarchical search found a different rx beam");
+}
+
+/**
+ * \brief Checks the steering tables of AntennaArrayModel against the steering vectors computed
+ * from their definition, on a grid whose elevations can not be reached by accumulating the step.
+ */
+class MmWaveSteeringTableTestCase : public TestCase
+{
+public:
+  MmWaveSteeringTableTestCase ();
+  virtual ~MmWaveSteeringTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \param [in] actual The beamforming vector under test.
+   * \param [in] expected The steering vector computed from its definition.
+   * \param [in] what The description of the vector.
+   */
+  void CheckVector (const complexVector_t &actual, const complexVector_t &expected, std::string what);
+};
+
+MmWaveSteeringTableTestCase::MmWaveSteeringTableTestCase ()
+  : TestCase ("Steering tables against the direct computation of the steering vectors")
+{
+}
+
+MmWaveSteeringTableTestCase::~MmWaveSteeringTableTestCase ()
+{
+}
+
+void
+MmWaveSteeringTableTestCase::CheckVector (const complexVector_t &actual, const complexVector_t &expected, std::string what)
+{
+  NS_TEST_ASSERT_MSG_EQ (actual.size (), expected.size (), "Wrong size of the " << what);
+  for (uint32_t ind = 0; ind < actual.size () && ind < expected.size (); ind++)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (actual[ind].real (), expected[ind].real (), 1e-9, "Wrong element " << ind << " of the " << what);
+      NS_TEST_ASSERT_MSG_EQ_TOL (actual[ind].imag (), expected[ind].imag (), 1e-9, "Wrong element " << ind << " of the " << what);
+    }
+}
+
+void
+MmWaveSteeringTableTestCase::DoRun (void)
+{
+  uint8_t antennaNum[2] = {4, 4};
+  double minElevation = 60;
+  double maxElevation = 61;
+  double step = 0.1;
+  Ptr<AntennaArrayModel> array = CreateObject<AntennaArrayModel> ();
+  array->SetAttribute ("SteeringMinElevation", DoubleValue (minElevation));
+  array->SetAttribute ("SteeringMaxElevation", DoubleValue (maxElevation));
+  array->SetAttribute ("SteeringElevationStep", DoubleValue (step));
+  Ptr<const MmWaveSteeringTable> table = array->GetSteeringTable (antennaNum);
+  uint32_t numSectors = antennaNum[1] + 1;
+  NS_TEST_ASSERT_MSG_EQ (table->m_numSectors, numSectors, "Wrong number of sectors");
+  NS_TEST_ASSERT_MSG_EQ (table->m_elevation.size (), 11, "Wrong number of elevations");
+  NS_TEST_ASSERT_MSG_EQ (table->GetNumBeams (), 11 * numSectors, "Wrong number of beams");
+
+  // the elevations of the callers, accumulated like the loops of the beam searches
+  double accumulated = minElevation;
+  for (uint32_t index = 0; index < table->m_elevation.size (); index++, accumulated += step)
+    {
+      double elevation = minElevation + index * step;
+      NS_TEST_ASSERT_MSG_EQ (table->m_elevation[index], elevation, "Wrong elevation " << index << " of the grid");
+      for (uint16_t sector = 0; sector < numSectors; sector++)
+        {
+          std::ostringstream what;
+          what << "steering vector of sector " << sector << " at " << elevation << " degrees";
+          uint32_t beam = index * numSectors + sector;
+          complexVector_t expected = GetSteeringVector (antennaNum, sector, elevation);
+          CheckVector (table->m_steering[beam], expected, what.str ());
+          NS_TEST_ASSERT_MSG_EQ (table->FindBeam (sector, elevation), beam, "Beam not found for the " << what.str ());
+          NS_TEST_ASSERT_MSG_EQ (table->FindBeam (sector, accumulated), beam, "Beam not found for the accumulated elevation "
+                                 << accumulated << " of the " << what.str ());
+          array->SetSector (sector, antennaNum, accumulated);
+          CheckVector (array->GetBeamformingVector (), expected, "beamforming vector of the " + what.str ());
+        }
+    }
+
+  // the elevations out of the grid fall back on the direct computation of SetSector
+  NS_TEST_ASSERT_MSG_EQ (table->FindBeam (0, 60.05), table->GetNumBeams (), "Elevation out of the grid found");
+  NS_TEST_ASSERT_MSG_EQ (table->FindBeam (0, 61.1), table->GetNumBeams (), "Elevation above the grid found");
+  NS_TEST_ASSERT_MSG_EQ (table->FindBeam (numSectors, 60), table->GetNumBeams (), "Sector out of the grid found");
+  array->SetSector (2, antennaNum, 60.05);
+  CheckVector (array->GetBeamformingVector (), GetSteeringVector (antennaNum, 2, 60.05), "beamforming vector out of the grid");
+
+  // the arrays with the same geometry and grid share the table
+  Ptr<AntennaArrayModel> other = CreateObject<AntennaArrayModel> ();
+  other->SetAttribute ("SteeringMinElevation", DoubleValue (minElevation));
+  other->SetAttribute ("SteeringMaxElevation", DoubleValue (maxElevation));
+  other->SetAttribute ("SteeringElevationStep", DoubleValue (step));
+  NS_TEST_ASSERT_MSG_EQ (other->GetSteeringTable (antennaNum), table, "The table is not shared");
+}
+
+/**
+ * \brief Test suite of the search of the best pair of sectors.
+ */
+class MmWaveSectorSearchTestSuite : public TestSuite
+{
+public:
+  MmWaveSectorSearchTestSuite ();
+};
+
+MmWaveSectorSearchTestSuite::MmWaveSectorSearchTestSuite ()
+  : TestSuite ("mmwave-sector-search", UNIT)
+{
+  AddTestCase (new MmWaveSteeringTableTestCase, TestCase::QUICK);
+  for (uint32_t run = 1; run <= 4; run++)
+    {
+      std::ostringstream name;
+      name << "Sector search against the reference loop, run " << run;
+      AddTestCase (new MmWaveSectorSearchTestCase (name.str (), run, run == 4 ? 1 : 12), TestCase::QUICK);
+    }
+}
+
+static MmWaveSectorSearchTestSuite mmwaveSectorSearchTestSuite;
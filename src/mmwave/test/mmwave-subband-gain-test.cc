@@ -0,0 +1,146 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/mmwave-subband-gain.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/double.h"
+#include "ns3/test.h"
+#include <complex>
+#include <cmath>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \brief Compares the gain computed by MmWaveSubbandGain::Evaluate, with each instruction set
+ * the compiler targets, with the exact per-subband evaluation it replaces,
+ * |sum_n a_n exp(-j 2 pi f_b tau_n)|^2.
+ *
+ * The error of each subband must be below 1e-9 times (sum_n |a_n|)^2, the largest gain the
+ * clusters can reach. The clusters have random coefficients and delays of up to 2 us, their
+ * number is not a multiple of the SIMD width, and the subbands span several anchor periods.
+ */
+class MmWaveSubbandGainTestCase : public TestCase
+{
+public:
+  /**
+   * \param [in] name The name of the test case.
+   * \param [in] isa The instruction set of the kernel.
+   * \param [in] run The run number of the random clusters.
+   */
+  MmWaveSubbandGainTestCase (std::string name, MmWaveSubbandGain::Isa isa, uint32_t run);
+  virtual ~MmWaveSubbandGainTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  MmWaveSubbandGain::Isa m_isa;
+  uint32_t m_run;
+};
+
+MmWaveSubbandGainTestCase::MmWaveSubbandGainTestCase (std::string name, MmWaveSubbandGain::Isa isa, uint32_t run)
+  : TestCase (name),
+    m_isa (isa),
+    m_run (run)
+{
+}
+
+MmWaveSubbandGainTestCase::~MmWaveSubbandGainTestCase ()
+{
+}
+
+void
+MmWaveSubbandGainTestCase::DoRun (void)
+{
+  const double tolerance = 1e-9;
+  double firstFrequency = 28e9 - 0.5e9;
+  double frequencySpacing = 13.889e6;
+  uint32_t numBands = 5 * MmWaveSubbandGain::ANCHOR_PERIOD + 7;
+
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (m_run);
+  Ptr<NormalRandomVariable> coef = CreateObject<NormalRandomVariable> ();
+  coef->SetStream (0);
+  Ptr<UniformRandomVariable> delay = CreateObject<UniformRandomVariable> ();
+  delay->SetStream (1);
+  delay->SetAttribute ("Min", DoubleValue (0.0));
+  delay->SetAttribute ("Max", DoubleValue (2e-6));
+
+  MmWaveSubbandGain kernel;
+  std::vector<double> gain (numBands);
+  for (uint32_t numClusters = 0; numClusters <= 23; numClusters++)
+    {
+      std::vector<std::complex<double> > coefs;
+      std::vector<double> delays;
+      double amplitudeSum = 0;
+      kernel.Clear ();
+      for (uint32_t c = 0; c < numClusters; c++)
+        {
+          coefs.push_back (std::complex<double> (coef->GetValue (), coef->GetValue ()));
+          delays.push_back (delay->GetValue ());
+          amplitudeSum += std::abs (coefs.back ());
+          kernel.AddCluster (coefs.back (), delays.back ());
+        }
+      kernel.Evaluate (firstFrequency, frequencySpacing, numBands, &gain[0], m_isa);
+
+      for (uint32_t b = 0; b < numBands; b++)
+        {
+          std::complex<double> sum;
+          double f = firstFrequency + frequencySpacing * b;
+          for (uint32_t c = 0; c < numClusters; c++)
+            {
+              sum += coefs[c] * std::exp (std::complex<double> (0, -2 * M_PI * f * delays[c]));
+            }
+          NS_TEST_ASSERT_MSG_EQ_TOL (gain[b], std::norm (sum), tolerance * amplitudeSum * amplitudeSum,
+                                     "gain differs from the exact evaluation, " << numClusters
+                                     << " clusters, subband " << b);
+        }
+    }
+}
+
+/**
+ * \brief Test suite of the subband gain kernel.
+ */
+class MmWaveSubbandGainTestSuite : public TestSuite
+{
+public:
+  MmWaveSubbandGainTestSuite ();
+};
+
+MmWaveSubbandGainTestSuite::MmWaveSubbandGainTestSuite ()
+  : TestSuite ("mmwave-subband-gain", UNIT)
+{
+  MmWaveSubbandGain::Isa isas[3] = {MmWaveSubbandGain::ISA_SCALAR, MmWaveSubbandGain::ISA_SSE2,
+                                    MmWaveSubbandGain::ISA_AVX};
+  const char *isaNames[3] = {"scalar", "SSE2", "AVX"};
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      // an instruction set the compiler does not target cannot be evaluated
+      if (!MmWaveSubbandGain::IsIsaAvailable (isas[i]))
+        {
+          continue;
+        }
+      for (uint32_t run = 1; run <= 2; run++)
+        {
+          std::ostringstream name;
+          name << "Subband gain with " << isaNames[i] << " against the exact evaluation, run " << run;
+          AddTestCase (new MmWaveSubbandGainTestCase (name.str (), isas[i], run), TestCase::QUICK);
+        }
+    }
+}
+
+static MmWaveSubbandGainTestSuite mmwaveSubbandGainTestSuite;
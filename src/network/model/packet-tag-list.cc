@@ -34,6 +34,9 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
+const uint32_t PacketTagList::INLINE_TAGS;
+const uint32_t PacketTagList::INLINE_SIZE;
+
 PacketTagList::TagData *
 PacketTagList::CreateTagData (size_t dataSize)
 {
@@ -51,6 +54,17 @@ PacketTagList::CreateTagData (size_t dataSize)
   return tag;
 }
 
+void
+PacketTagList::RemoveInline (uint32_t i)
+{
+  NS_ASSERT (i < m_nInline);
+  m_nInline--;
+  for (; i < m_nInline; i++)
+    {
+      m_inline[i] = m_inline[i + 1];
+    }
+}
+
 bool
 PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 {
@@ -175,6 +189,16 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 bool
 PacketTagList::Remove (Tag & tag)
 {
+  TypeId tid = tag.GetInstanceTypeId ();
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          tag.Deserialize (TagBuffer (m_inline[i].data, m_inline[i].data + m_inline[i].size));
+          RemoveInline (i);
+          return true;
+        }
+    }
   return COWTraverse (tag, &PacketTagList::RemoveWriter);
 }
 
@@ -214,6 +238,27 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 bool
 PacketTagList::Replace (Tag & tag)
 {
+  TypeId tid = tag.GetInstanceTypeId ();
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          uint32_t size = tag.GetSerializedSize ();
+          if (size <= INLINE_SIZE)
+            {
+              // rewrite in place
+              m_inline[i].size = size;
+              tag.Serialize (TagBuffer (m_inline[i].data, m_inline[i].data + size));
+            }
+          else
+            {
+              // the new value is too large to be inline
+              RemoveInline (i);
+              Add (tag);
+            }
+          return true;
+        }
+    }
   bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
   if (!found)
     {
@@ -261,12 +306,28 @@ PacketTagList::Add (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   // ensure this id was not yet added
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      NS_ASSERT_MSG (m_inline[i].tid != tag.GetInstanceTypeId (),
+                     "Error: cannot add the same kind of tag twice.");
+    }
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (),
                      "Error: cannot add the same kind of tag twice.");
     }
-  struct TagData * head = CreateTagData (tag.GetSerializedSize ());
+  uint32_t size = tag.GetSerializedSize ();
+  if (size <= INLINE_SIZE && m_nInline < INLINE_TAGS)
+    {
+      PacketTagList *self = const_cast<PacketTagList *> (this);
+      struct InlineTag &inlineTag = self->m_inline[self->m_nInline];
+      inlineTag.tid = tag.GetInstanceTypeId ();
+      inlineTag.size = size;
+      tag.Serialize (TagBuffer (inlineTag.data, inlineTag.data + size));
+      self->m_nInline++;
+      return;
+    }
+  struct TagData * head = CreateTagData (size);
   head->count = 1;
   head->next = 0;
   head->tid = tag.GetInstanceTypeId ();
@@ -281,6 +342,15 @@ PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          tag.Deserialize (TagBuffer (const_cast<uint8_t *> (m_inline[i].data),
+                                      const_cast<uint8_t *> (m_inline[i].data) + m_inline[i].size));
+          return true;
+        }
+    }
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
@@ -119,6 +119,20 @@ class Tag;
  *       The portion of the list between the first branch and the target is
  *       shared. This portion is copied before the #Remove or #Replace is
  *       performed.
+ *
+ * \par <b> Inline tags </b>
+ *
+ *   Most packets carry a few small tags, which are added and removed
+ *   at every layer (e.g. the MAC PDU, radio bearer, RLC and PDCP tags of
+ *   the LTE and mmWave stacks). The first #INLINE_TAGS tags of up to
+ *   #INLINE_SIZE bytes are stored in the PacketTagList itself, in an
+ *   array of InlineTag, and only the other tags are stored in the tree:
+ *
+ *   - #Add, #Peek, #Remove and #Replace of an inline tag do not allocate
+ *     nor traverse the tree, and #Replace rewrites the tag in place.
+ *
+ *   - Copies copy the inline tags, instead of sharing them, so an inline
+ *     tag never needs to be copied on write.
  */
 class PacketTagList 
 {
@@ -147,6 +161,23 @@ public:
     uint8_t data[1];            /**< Serialization buffer */
   };  /* struct TagData */
 
+  /** Maximum number of tags stored in the PacketTagList itself. */
+  static const uint32_t INLINE_TAGS = 5;
+  /** Maximum serialized size of a tag stored in the PacketTagList itself. */
+  static const uint32_t INLINE_SIZE = 21;
+
+  /**
+   * A serialized tag stored in the PacketTagList itself.
+   *
+   * See PacketTagList for a discussion of the data structure.
+   */
+  struct InlineTag
+  {
+    TypeId tid;                 /**< Type of the tag serialized into #data */
+    uint8_t size;               /**< Size of the serialized tag */
+    uint8_t data[INLINE_SIZE];  /**< Serialization buffer */
+  };  /* struct InlineTag */
+
   /**
    * Create a new PacketTagList.
    */
@@ -156,8 +187,9 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This copies the inline tags of \pname{o}, then makes a
+   * light-weight copy of its other tags by pointing to the same
+   * \ref TagData as \pname{o}.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -167,7 +199,8 @@ public:
    * \returns the copied object
    *
    * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * copying the inline tags of \pname{o} and pointing to the same
+   * \ref TagData as \pname{o}.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
@@ -178,7 +211,8 @@ public:
   inline ~PacketTagList ();
 
   /**
-   * Add a tag to the head of this branch.
+   * Add a tag to the inline tags, or to the head of this branch if
+   * the inline tags are full or the tag is larger than #INLINE_SIZE.
    *
    * \param [in] tag The tag to add
    */
@@ -214,7 +248,16 @@ public:
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns the number of inline tags
+   */
+  inline uint32_t GetNInlineTags (void) const;
+  /**
+   * \param [in] i The index of the inline tag, in the order they were added.
+   * \returns the inline tag
+   */
+  inline const struct PacketTagList::InlineTag *GetInlineTag (uint32_t i) const;
+  /**
+   * \returns pointer to head of the list of the tags which are not inline
    */
   const struct PacketTagList::TagData *Head (void) const;
 
@@ -228,6 +271,12 @@ private:
    */
   static
   TagData * CreateTagData (size_t dataSize);
+  /**
+   * Remove an inline tag, keeping the order of the others.
+   *
+   * \param [in] i The index of the inline tag.
+   */
+  void RemoveInline (uint32_t i);
   
   /**
    * Typedef of method function pointer for copy-on-write operations
@@ -278,6 +327,14 @@ private:
   bool ReplaceWriter (Tag & tag, bool preMerge,
                       struct TagData * cur, struct TagData ** prevNext);
 
+  /**
+   * The inline tags, in the order they were added
+   */
+  struct InlineTag m_inline[INLINE_TAGS];
+  /**
+   * Number of inline tags
+   */
+  uint8_t m_nInline;
   /**
    * Pointer to first \ref TagData on the list
    */
@@ -293,13 +350,19 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_nInline (0),
+    m_next ()
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_nInline (o.m_nInline),
+    m_next (o.m_next)
 {
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      m_inline[i] = o.m_inline[i];
+    }
   if (m_next != 0)
     {
       m_next->count++;
@@ -310,15 +373,23 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o)
     {
       return *this;
     }
-  RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  if (m_next != o.m_next)
     {
-      m_next->count++;
+      RemoveAll ();
+      m_next = o.m_next;
+      if (m_next != 0)
+        {
+          m_next->count++;
+        }
+    }
+  m_nInline = o.m_nInline;
+  for (uint32_t i = 0; i < m_nInline; i++)
+    {
+      m_inline[i] = o.m_inline[i];
     }
   return *this;
 }
@@ -331,6 +402,7 @@ PacketTagList::~PacketTagList ()
 void
 PacketTagList::RemoveAll (void)
 {
+  m_nInline = 0;
   struct TagData *prev = 0;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
     {
@@ -354,6 +426,18 @@ PacketTagList::RemoveAll (void)
   m_next = 0;
 }
 
+uint32_t
+PacketTagList::GetNInlineTags (void) const
+{
+  return m_nInline;
+}
+
+const struct PacketTagList::InlineTag *
+PacketTagList::GetInlineTag (uint32_t i) const
+{
+  return &m_inline[i];
+}
+
 } // namespace ns3
 
 #endif /* PACKET_TAG_LIST_H */
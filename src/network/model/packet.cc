@@ -81,39 +81,50 @@ ByteTagIterator::ByteTagIterator (ByteTagList::Iterator i)
 }
 
 
-PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *head)
-  : m_current (head)
+PacketTagIterator::PacketTagIterator (const PacketTagList &list)
+  : m_list (&list),
+    m_current (list.Head ()),
+    m_inline (list.GetNInlineTags ())
 {
 }
 bool
 PacketTagIterator::HasNext (void) const
 {
-  return m_current != 0;
+  return m_inline > 0 || m_current != 0;
 }
 PacketTagIterator::Item
 PacketTagIterator::Next (void)
 {
   NS_ASSERT (HasNext ());
-  const struct PacketTagList::TagData *prev = m_current;
-  m_current = m_current->next;
-  return PacketTagIterator::Item (prev);
+  // the tags which overflowed the inline tags are the most recent ones
+  if (m_current != 0)
+    {
+      const struct PacketTagList::TagData *prev = m_current;
+      m_current = m_current->next;
+      return PacketTagIterator::Item (prev->tid, prev->data, prev->size);
+    }
+  m_inline--;
+  const struct PacketTagList::InlineTag *tag = m_list->GetInlineTag (m_inline);
+  return PacketTagIterator::Item (tag->tid, tag->data, tag->size);
 }
 
-PacketTagIterator::Item::Item (const struct PacketTagList::TagData *data)
-  : m_data (data)
+PacketTagIterator::Item::Item (TypeId tid, const uint8_t *data, uint32_t size)
+  : m_tid (tid),
+    m_data (data),
+    m_size (size)
 {
 }
 TypeId
 PacketTagIterator::Item::GetTypeId (void) const
 {
-  return m_data->tid;
+  return m_tid;
 }
 void
 PacketTagIterator::Item::GetTag (Tag &tag) const
 {
-  NS_ASSERT (tag.GetInstanceTypeId () == m_data->tid);
-  tag.Deserialize (TagBuffer ((uint8_t*)m_data->data,
-                              (uint8_t*)m_data->data + m_data->size));
+  NS_ASSERT (tag.GetInstanceTypeId () == m_tid);
+  tag.Deserialize (TagBuffer ((uint8_t*)m_data,
+                              (uint8_t*)m_data + m_size));
 }
 
 
@@ -871,7 +882,7 @@ Packet::PrintPacketTags (std::ostream &os) const
 PacketTagIterator 
 Packet::GetPacketTagIterator (void) const
 {
-  return PacketTagIterator (m_packetTagList.Head ());
+  return PacketTagIterator (m_packetTagList);
 }
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet)
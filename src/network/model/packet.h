@@ -127,6 +127,11 @@ private:
  * \brief Iterator over the set of packet tags in a packet
  *
  * This is a java-style iterator.
+ *
+ * The tags are visited from the most recent one. The tags stored in
+ * the PacketTagList itself are visited after the other ones, so a tag
+ * larger than PacketTagList::INLINE_SIZE added before the inline tags,
+ * or an inline tag added after a removal, is visited out of that order.
  */
 class PacketTagIterator
 {
@@ -155,10 +160,14 @@ private:
     friend class PacketTagIterator;
     /**
      * Constructor
-     * \param data the data to copy.
+     * \param tid the ns3::TypeId of the tag.
+     * \param data the serialized tag.
+     * \param size the size of the serialized tag.
      */
-    Item (const struct PacketTagList::TagData *data);
-    const struct PacketTagList::TagData *m_data; //!< the tag data
+    Item (TypeId tid, const uint8_t *data, uint32_t size);
+    TypeId m_tid;          //!< the ns3::TypeId of the tag
+    const uint8_t *m_data; //!< the serialized tag
+    uint32_t m_size;       //!< the size of the serialized tag
   };
   /**
    * \returns true if calling Next is safe, false otherwise.
@@ -173,10 +182,12 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param list the tags of the packet
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const PacketTagList &list);
+  const PacketTagList *m_list;  //!< the tags of the packet
+  const struct PacketTagList::TagData *m_current;  //!< actual position over the tags which are not inline
+  uint32_t m_inline;  //!< number of inline tags left, iterated from the last one
 };
 
 /**
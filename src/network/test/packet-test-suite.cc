@@ -1035,6 +1035,131 @@ PacketTagListTest::DoRun (void)
     
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Packet Tag list inline tags unit tests.
+ */
+class PacketTagListInlineTest : public TestCase
+{
+public:
+  PacketTagListInlineTest ();
+  virtual ~PacketTagListInlineTest ();
+private:
+  void DoRun (void);
+};
+
+PacketTagListInlineTest::PacketTagListInlineTest ()
+  : TestCase ("PacketTagListInlineTest: ")
+{
+}
+
+PacketTagListInlineTest::~PacketTagListInlineTest ()
+{
+}
+
+void
+PacketTagListInlineTest::DoRun (void)
+{
+  MAKE_TEST_TAGS ;
+  ATestTag<30> big (1);  // larger than PacketTagList::INLINE_SIZE
+
+  PacketTagList ref;
+  ref.Add (t1);
+  ref.Add (big);
+  ref.Add (t2);
+  ref.Add (t3);
+  ref.Add (t4);
+  ref.Add (t5);
+  ref.Add (t6);
+  ref.Add (t7);
+  NS_TEST_EXPECT_MSG_EQ (ref.GetNInlineTags (), PacketTagList::INLINE_TAGS, "inline tags");
+  NS_TEST_EXPECT_MSG_EQ (ref.GetInlineTag (0)->tid, t1.GetTypeId (), "first inline tag");
+  NS_TEST_EXPECT_MSG_EQ (ref.GetInlineTag (4)->tid, t5.GetTypeId (), "last inline tag");
+  NS_TEST_EXPECT_MSG_EQ (ref.Head ()->tid, t7.GetTypeId (), "head of the other tags");
+
+  { // Remove an inline tag: the others keep their order
+    PacketTagList ptl = ref;
+    ATestTag<2> t (0);
+    NS_TEST_EXPECT_MSG_EQ (ptl.Remove (t), true, "remove inline tag");
+    NS_TEST_EXPECT_MSG_EQ (t.GetData (), 1, "removed inline tag value");
+    NS_TEST_EXPECT_MSG_EQ (ptl.GetNInlineTags (), PacketTagList::INLINE_TAGS - 1, "inline tags after removal");
+    NS_TEST_EXPECT_MSG_EQ (ptl.GetInlineTag (1)->tid, t3.GetTypeId (), "inline tag after removal");
+    NS_TEST_EXPECT_MSG_EQ (ref.Peek (t), true, "removal changed the original");
+
+    // the free slot is reused, the big tag is still in the list
+    ptl.Add (t);
+    NS_TEST_EXPECT_MSG_EQ (ptl.GetNInlineTags (), PacketTagList::INLINE_TAGS, "inline tags after add");
+    ATestTag<30> b;
+    NS_TEST_EXPECT_MSG_EQ (ptl.Peek (b), true, "big tag");
+    NS_TEST_EXPECT_MSG_EQ (b.m_error, false, "big tag data");
+  }
+
+  { // Replace an inline tag in place, in a copy
+    PacketTagList ptl = ref;
+    ATestTag<3> t (2);
+    NS_TEST_EXPECT_MSG_EQ (ptl.Replace (t), true, "replace inline tag");
+    NS_TEST_EXPECT_MSG_EQ (ptl.GetNInlineTags (), PacketTagList::INLINE_TAGS, "inline tags after replace");
+    ATestTag<3> o;
+    NS_TEST_EXPECT_MSG_EQ (ptl.Peek (o), true, "replaced copy");
+    NS_TEST_EXPECT_MSG_EQ (o.GetData (), 2, "replaced copy value");
+    NS_TEST_EXPECT_MSG_EQ (ref.Peek (o), true, "replace original");
+    NS_TEST_EXPECT_MSG_EQ (o.GetData (), 1, "replace changed the original");
+  }
+
+  { // Iterate over the inline and the other tags
+    Ptr<Packet> p = Create<Packet> (10);
+    p->AddPacketTag (t1);
+    p->AddPacketTag (big);
+    p->AddPacketTag (t2);
+    p->AddPacketTag (t3);
+    p->AddPacketTag (t4);
+    p->AddPacketTag (t5);
+    p->AddPacketTag (t6);
+    p->AddPacketTag (t7);
+    Ptr<Packet> q = p->Copy ();
+    q->RemovePacketTag (t1);
+    q->RemovePacketTag (t6);
+    uint32_t items = 0;
+    PacketTagIterator i = q->GetPacketTagIterator ();
+    while (i.HasNext ())
+      {
+        PacketTagIterator::Item item = i.Next ();
+        Callback<ObjectBase *> constructor = item.GetTypeId ().GetConstructor ();
+        ATestTagBase *tag = dynamic_cast<ATestTagBase *> (constructor ());
+        item.GetTag (*tag);
+        NS_TEST_EXPECT_MSG_EQ (tag->m_error, false, "iterated tag data");
+        NS_TEST_EXPECT_MSG_EQ (tag->GetData (), 1, "iterated tag value");
+        delete tag;
+        items++;
+      }
+    NS_TEST_EXPECT_MSG_EQ (items, 6, "iterated tags");
+  }
+
+  { // Iterate, most recent first, over more tags than the inline tags
+    Ptr<Packet> p = Create<Packet> (10);
+    p->AddPacketTag (t1);
+    p->AddPacketTag (t2);
+    p->AddPacketTag (t3);
+    p->AddPacketTag (t4);
+    p->AddPacketTag (t5);
+    p->AddPacketTag (t6);
+    p->AddPacketTag (t7);
+    TypeId order[7] = {t7.GetTypeId (), t6.GetTypeId (), t5.GetTypeId (), t4.GetTypeId (),
+                       t3.GetTypeId (), t2.GetTypeId (), t1.GetTypeId ()};
+    uint32_t items = 0;
+    PacketTagIterator i = p->GetPacketTagIterator ();
+    while (i.HasNext () && items < 7)
+      {
+        NS_TEST_EXPECT_MSG_EQ (i.Next ().GetTypeId (), order[items], "iterated tag " << items);
+        items++;
+      }
+    NS_TEST_EXPECT_MSG_EQ (i.HasNext (), false, "more iterated tags than added");
+    NS_TEST_EXPECT_MSG_EQ (items, 7, "iterated tags");
+  }
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1052,6 +1177,7 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketTagListInlineTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite; //!< Static variable for test initialization
@@ -26,6 +26,8 @@
 #include <ns3/net-device.h>
 #include <ns3/node.h>
 #include <ns3/double.h>
+#include <ns3/uinteger.h>
+#include <ns3/core-config.h>
 #include <ns3/mobility-model.h>
 #include <ns3/spectrum-phy.h>
 #include <ns3/spectrum-converter.h>
@@ -38,6 +40,12 @@
 #include <utility>
 #include "multi-model-spectrum-channel.h"
 
+#ifdef HAVE_PTHREAD_H
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
 
 namespace ns3 {
 
@@ -81,7 +89,158 @@ RxSpectrumModelInfo::RxSpectrumModelInfo (Ptr<const SpectrumModel> rxSpectrumMod
 }
 
 
+/**
+ * \ingroup spectrum
+ * Pool of threads running the completions of the received PSDs of a
+ * signal. The simulator thread runs completions too while it waits.
+ */
+class SpectrumRxWorkers : public SimpleRefCount<SpectrumRxWorkers>
+{
+public:
+  /// Completion and the PSD it scales.
+  typedef std::pair<SpectrumPropagationLossModel::Completion *, SpectrumValue *> Job;
+
+  /**
+   * Start the threads.
+   * \param numThreads the number of threads
+   */
+  SpectrumRxWorkers (uint32_t numThreads);
+
+  /**
+   * Stop and join the threads.
+   */
+  ~SpectrumRxWorkers ();
+
+  /**
+   * Run all the jobs and wait for them.
+   * \param jobs the jobs
+   */
+  void Run (const std::vector<Job> &jobs);
+
+#ifdef HAVE_PTHREAD_H
+private:
+  /**
+   * Loop of a thread of the pool.
+   */
+  void Work ();
+
+  /**
+   * Run jobs of the current batch until none is left.
+   * \param lock the lock of m_mutex, held on entry and on return
+   */
+  void RunJobs (std::unique_lock<std::mutex> &lock);
+
+  std::vector<std::thread> m_threads;   //!< Threads of the pool.
+  std::mutex m_mutex;                   //!< Protects the members below.
+  std::condition_variable m_start;      //!< Notified when a batch starts or the pool stops.
+  std::condition_variable m_done;       //!< Notified when a thread leaves a batch.
+  const std::vector<Job> *m_jobs;       //!< Jobs of the current batch, 0 between batches.
+  uint32_t m_nextJob;                   //!< First job not started yet.
+  uint32_t m_busy;                      //!< Threads running jobs of the current batch.
+  uint64_t m_batch;                     //!< Number of batches started.
+  bool m_stop;                          //!< Set by the destructor.
+#endif
+};
+
+#ifdef HAVE_PTHREAD_H
+SpectrumRxWorkers::SpectrumRxWorkers (uint32_t numThreads)
+  : m_jobs (0),
+    m_nextJob (0),
+    m_busy (0),
+    m_batch (0),
+    m_stop (false)
+{
+  for (uint32_t i = 0; i < numThreads; i++)
+    {
+      m_threads.push_back (std::thread (&SpectrumRxWorkers::Work, this));
+    }
+}
+
+SpectrumRxWorkers::~SpectrumRxWorkers ()
+{
+  {
+    std::unique_lock<std::mutex> lock (m_mutex);
+    m_stop = true;
+  }
+  m_start.notify_all ();
+  for (uint32_t i = 0; i < m_threads.size (); i++)
+    {
+      m_threads[i].join ();
+    }
+}
+
+void
+SpectrumRxWorkers::Run (const std::vector<Job> &jobs)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  m_jobs = &jobs;
+  m_nextJob = 0;
+  m_batch++;
+  m_start.notify_all ();
+  RunJobs (lock);
+  while (m_busy > 0)
+    {
+      m_done.wait (lock);
+    }
+  m_jobs = 0;
+}
+
+void
+SpectrumRxWorkers::Work ()
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  uint64_t batch = 0;
+  while (true)
+    {
+      while (!m_stop && m_batch == batch)
+        {
+          m_start.wait (lock);
+        }
+      if (m_stop)
+        {
+          return;
+        }
+      batch = m_batch;
+      m_busy++;
+      RunJobs (lock);
+      m_busy--;
+      m_done.notify_one ();
+    }
+}
+
+void
+SpectrumRxWorkers::RunJobs (std::unique_lock<std::mutex> &lock)
+{
+  while (m_jobs != 0 && m_nextJob < m_jobs->size ())
+    {
+      const Job &job = (*m_jobs)[m_nextJob++];
+      lock.unlock ();
+      job.first->Complete (*job.second);
+      lock.lock ();
+    }
+}
+#else
+SpectrumRxWorkers::SpectrumRxWorkers (uint32_t numThreads)
+{
+}
+
+SpectrumRxWorkers::~SpectrumRxWorkers ()
+{
+}
+
+void
+SpectrumRxWorkers::Run (const std::vector<Job> &jobs)
+{
+  for (uint32_t i = 0; i < jobs.size (); i++)
+    {
+      jobs[i].first->Complete (*jobs[i].second);
+    }
+}
+#endif
+
+
 MultiModelSpectrumChannel::MultiModelSpectrumChannel ()
+  : m_rxThreads (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -95,6 +254,7 @@ MultiModelSpectrumChannel::DoDispose ()
   m_spectrumPropagationLoss = 0;
   m_txSpectrumModelInfoMap.clear ();
   m_rxSpectrumModelInfoMap.clear ();
+  m_rxWorkers = 0;
   SpectrumChannel::DoDispose ();
 }
 
@@ -119,6 +279,15 @@ MultiModelSpectrumChannel::GetTypeId (void)
                    DoubleValue (1.0e9),
                    MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxLossDb),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("RxThreads",
+                   "Number of threads, in addition to the simulator one, "
+                   "that complete the received PSDs of a signal when the "
+                   "SpectrumPropagationLossModel supports the computation "
+                   "in two steps. 0 computes them on the simulator thread "
+                   "only. The results do not depend on this value.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultiModelSpectrumChannel::m_rxThreads),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("PathLoss",
                      "This trace is fired whenever a new path loss value "
                      "is calculated. The first and second parameters "
@@ -275,6 +444,12 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
   NS_LOG_LOGIC ("converter map size: " << txInfoIteratorerator->second.m_spectrumConverterMap.size ());
   NS_LOG_LOGIC ("converter map first element: " << txInfoIteratorerator->second.m_spectrumConverterMap.begin ()->first);
 
+  bool prepareRx = m_rxThreads > 0 && m_spectrumPropagationLoss;
+  if (prepareRx && m_rxWorkers == 0)
+    {
+      m_rxWorkers = Create<SpectrumRxWorkers> (m_rxThreads);
+    }
+
   for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
        rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
        ++rxInfoIterator)
@@ -351,7 +526,16 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
                   double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
                   *(rxParams->psd) *= pathGainLinear;              
 
-                  if (m_spectrumPropagationLoss)
+                  SpectrumPropagationLossModel::Completion *completion = 0;
+                  if (prepareRx && m_spectrumPropagationLoss->PrepareRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility, completion))
+                    {
+                      // rxParams->psd is completed before this method returns, so StartRx can be scheduled already
+                      if (completion != 0)
+                        {
+                          m_completions.push_back (std::make_pair (completion, PeekPointer (rxParams->psd)));
+                        }
+                    }
+                  else if (m_spectrumPropagationLoss)
                     {
                       rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
                     }
@@ -381,6 +565,12 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
     }
 
+  if (!m_completions.empty ())
+    {
+      NS_LOG_LOGIC ("completing " << m_completions.size () << " received PSDs");
+      m_rxWorkers->Run (m_completions);
+      m_completions.clear ();
+    }
 }
 
 void
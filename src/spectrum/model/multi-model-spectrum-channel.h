@@ -29,9 +29,12 @@
 #include <ns3/propagation-delay-model.h>
 #include <map>
 #include <set>
+#include <vector>
 
 namespace ns3 {
 
+class SpectrumRxWorkers;
+
 
 /**
  * \ingroup spectrum
@@ -102,6 +105,14 @@ typedef std::map<SpectrumModelUid_t, RxSpectrumModelInfo> RxSpectrumModelInfoMap
  * for this to work is that, after the SpectrumPhy switched its
  * SpectrumModel,  MultiModelSpectrumChannel::AddRx () is
  * called again passing the pointer to that SpectrumPhy.
+ *
+ * \note With the RxThreads attribute, the received PSDs of a signal are
+ * computed in two steps when the SpectrumPropagationLossModel supports it
+ * (see SpectrumPropagationLossModel::PrepareRxPowerSpectralDensity): the
+ * receivers are prepared and their reception is scheduled on the
+ * simulator thread, in receiver order, then the completions of the PSDs
+ * run on a pool of threads before StartTx returns. The results are the
+ * same as with a single thread.
  */
 class MultiModelSpectrumChannel : public SpectrumChannel
 {
@@ -207,6 +218,23 @@ private:
    * in a future release.
    */
   TracedCallback<Ptr<SpectrumPhy>, Ptr<SpectrumPhy>, double > m_pathLossTrace;
+
+  /**
+   * Number of threads completing the received PSDs, in addition to the
+   * simulator thread. 0 computes them on the simulator thread only.
+   */
+  uint32_t m_rxThreads;
+
+  /**
+   * Pool of m_rxThreads threads, created by the first StartTx.
+   */
+  Ptr<SpectrumRxWorkers> m_rxWorkers;
+
+  /**
+   * Completions of the received PSDs of the signal being transmitted,
+   * with the PSD each one scales.
+   */
+  std::vector<std::pair<SpectrumPropagationLossModel::Completion *, SpectrumValue *> > m_completions;
 };
 
 
@@ -73,4 +73,31 @@ SpectrumPropagationLossModel::CalcRxPowerSpectralDensity (Ptr<const SpectrumValu
   return rxPsd;
 }
 
+bool
+SpectrumPropagationLossModel::PrepareRxPowerSpectralDensity (Ptr<SpectrumValue> rxPsd,
+                                                             Ptr<const MobilityModel> a,
+                                                             Ptr<const MobilityModel> b,
+                                                             Completion *&completion) const
+{
+  completion = 0;
+  if (m_next != 0)
+    {
+      return false;
+    }
+  return DoPrepareRxPowerSpectralDensity (rxPsd, a, b, completion);
+}
+
+bool
+SpectrumPropagationLossModel::DoPrepareRxPowerSpectralDensity (Ptr<SpectrumValue> rxPsd,
+                                                               Ptr<const MobilityModel> a,
+                                                               Ptr<const MobilityModel> b,
+                                                               Completion *&completion) const
+{
+  return false;
+}
+
+SpectrumPropagationLossModel::Completion::~Completion ()
+{
+}
+
 } // namespace ns3
@@ -44,6 +44,24 @@ namespace ns3 {
 class SpectrumPropagationLossModel : public Object
 {
 public:
+  /**
+   * \brief Remaining work of a received PSD prepared by PrepareRxPowerSpectralDensity
+   */
+  class Completion
+  {
+  public:
+    virtual ~Completion ();
+
+    /**
+     * Scale the received PSD in place. It may run on any thread, concurrently with
+     * the completions of the other receivers of the same signal, so it must only
+     * access the state of its own link and must not copy Ptrs to shared objects.
+     *
+     * \param rxPsd the PSD passed to PrepareRxPowerSpectralDensity
+     */
+    virtual void Complete (SpectrumValue &rxPsd) = 0;
+  };
+
   SpectrumPropagationLossModel ();
   virtual ~SpectrumPropagationLossModel ();
 
@@ -78,6 +96,35 @@ public:
                                                  Ptr<const MobilityModel> a,
                                                  Ptr<const MobilityModel> b) const;
 
+  /**
+   * First step of the computation of CalcRxPowerSpectralDensity in two
+   * steps, used by the channels that complete the received PSDs of a
+   * signal on several threads. It runs on the simulator thread, in the
+   * order in which CalcRxPowerSpectralDensity would be called, and does
+   * everything that touches state shared by several links: random
+   * variables, maps, events and reference counts. The rest is returned
+   * as a completion, which must be run before rxPsd is used and before
+   * the model is called again for another signal. The result must be
+   * the same as with CalcRxPowerSpectralDensity.
+   *
+   * The computation in two steps is not supported by chained models.
+   *
+   * @param rxPsd the PSD to be scaled in place, a copy of the
+   * transmitted PSD owned by the caller
+   * @param a sender mobility
+   * @param b receiver mobility
+   * @param completion set to the remaining work, or to 0 if rxPsd is
+   * already final
+   *
+   * @return false if the computation in two steps is not supported, in
+   * which case nothing has been done and CalcRxPowerSpectralDensity has
+   * to be used instead
+   */
+  bool PrepareRxPowerSpectralDensity (Ptr<SpectrumValue> rxPsd,
+                                      Ptr<const MobilityModel> a,
+                                      Ptr<const MobilityModel> b,
+                                      Completion *&completion) const;
+
 protected:
   virtual void DoDispose ();
 
@@ -97,6 +144,23 @@ private:
                                                            Ptr<const MobilityModel> a,
                                                            Ptr<const MobilityModel> b) const = 0;
 
+  /**
+   * Implements PrepareRxPowerSpectralDensity. The default implementation
+   * does not support the computation in two steps.
+   *
+   * @param rxPsd the PSD to be scaled in place
+   * @param a sender mobility
+   * @param b receiver mobility
+   * @param completion set to the remaining work, or to 0 if rxPsd is
+   * already final
+   *
+   * @return true if the computation in two steps is supported
+   */
+  virtual bool DoPrepareRxPowerSpectralDensity (Ptr<SpectrumValue> rxPsd,
+                                                Ptr<const MobilityModel> a,
+                                                Ptr<const MobilityModel> b,
+                                                Completion *&completion) const;
+
   Ptr<SpectrumPropagationLossModel> m_next; //!< SpectrumPropagationLossModel chained to this one.
 };
 
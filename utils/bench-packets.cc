@@ -328,6 +328,94 @@ benchByteTags (uint32_t n)
     }
 }
 
+// The packet tags of a mmWave MAC PDU: MAC PDU, radio bearer, RLC SDU
+// status and PDCP tags
+static void
+benchPacketTagsAddRemove (uint32_t n)
+{
+  BenchTag<6> macTag;
+  BenchTag<4> bearerTag;
+  BenchTag<1> statusTag;
+  BenchTag<8> pdcpTag;
+
+  Ptr<Packet> p = Create<Packet> (1000);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      p->AddPacketTag (pdcpTag);
+      p->AddPacketTag (statusTag);
+      p->AddPacketTag (bearerTag);
+      p->AddPacketTag (macTag);
+      p->RemovePacketTag (macTag);
+      p->RemovePacketTag (bearerTag);
+      p->RemovePacketTag (statusTag);
+      p->RemovePacketTag (pdcpTag);
+    }
+}
+
+static void
+benchPacketTagsPeek (uint32_t n)
+{
+  BenchTag<6> macTag;
+  BenchTag<4> bearerTag;
+  BenchTag<1> statusTag;
+  BenchTag<8> pdcpTag;
+
+  Ptr<Packet> p = Create<Packet> (1000);
+  p->AddPacketTag (pdcpTag);
+  p->AddPacketTag (statusTag);
+  p->AddPacketTag (bearerTag);
+  p->AddPacketTag (macTag);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      p->PeekPacketTag (macTag);
+      p->PeekPacketTag (bearerTag);
+      p->PeekPacketTag (statusTag);
+      p->PeekPacketTag (pdcpTag);
+    }
+}
+
+// The retransmission of a MAC PDU: copy, then remove and add its MAC tag
+static void
+benchPacketTagsCopyRemoveAdd (uint32_t n)
+{
+  BenchTag<6> macTag;
+  BenchTag<4> bearerTag;
+  BenchTag<1> statusTag;
+  BenchTag<8> pdcpTag;
+
+  Ptr<Packet> p = Create<Packet> (1000);
+  p->AddPacketTag (pdcpTag);
+  p->AddPacketTag (statusTag);
+  p->AddPacketTag (bearerTag);
+  p->AddPacketTag (macTag);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> q = p->Copy ();
+      q->RemovePacketTag (macTag);
+      q->AddPacketTag (macTag);
+    }
+}
+
+static void
+benchPacketTagsCopyReplace (uint32_t n)
+{
+  BenchTag<6> macTag;
+  BenchTag<4> bearerTag;
+  BenchTag<1> statusTag;
+  BenchTag<8> pdcpTag;
+
+  Ptr<Packet> p = Create<Packet> (1000);
+  p->AddPacketTag (pdcpTag);
+  p->AddPacketTag (statusTag);
+  p->AddPacketTag (bearerTag);
+  p->AddPacketTag (macTag);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> q = p->Copy ();
+      q->ReplacePacketTag (macTag);
+    }
+}
+
 static uint64_t
 runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 {
@@ -385,6 +473,10 @@ int main (int argc, char *argv[])
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  runBench (&benchPacketTagsAddRemove, n, minIterations, "Add and remove 4 packet tags");
+  runBench (&benchPacketTagsPeek, n, minIterations, "Peek 4 packet tags");
+  runBench (&benchPacketTagsCopyRemoveAdd, n, minIterations, "Copy, remove and add a packet tag");
+  runBench (&benchPacketTagsCopyReplace, n, minIterations, "Copy and replace a packet tag");
 
   return 0;
 }
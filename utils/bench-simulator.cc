@@ -205,6 +205,7 @@ int main (int argc, char *argv[])
 
   bool schedCal  = false;
   bool schedHeap = false;
+  bool schedLadder = false;
   bool schedList = false;
   bool schedMap  = true;
 
@@ -224,6 +225,7 @@ int main (int argc, char *argv[])
              "to be ascii, giving the relative event times in ns.");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
@@ -249,6 +251,10 @@ int main (int argc, char *argv[])
     {
       factory.SetTypeId ("ns3::ListScheduler");
     }
+  if (schedLadder)
+    {
+      factory.SetTypeId ("ns3::LadderScheduler");
+    }
   Simulator::SetScheduler (factory);
 
   LOGME (std::setprecision (g_fwidth - 6));